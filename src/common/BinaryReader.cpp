@@ -0,0 +1,107 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "BinaryReader.h"
+#include "VFileIO.h"
+#include "helpers/VExcept.h"
+
+BinaryReader::BinaryReader() {
+  m_pfh = NULL;
+  m_data = NULL;
+  m_size = 0;
+  m_pos = 0;
+}
+
+BinaryReader::~BinaryReader() {
+  close();
+}
+
+void BinaryReader::close() {
+  if (m_pfh != NULL) {
+    XMFS::closeFile(m_pfh);
+    m_pfh = NULL;
+  }
+  m_data = NULL;
+  m_size = 0;
+}
+
+bool BinaryReader::open(FileDataType i_fdt,
+                        const std::string &i_path,
+                        bool i_includeCurrentDir) {
+  FileHandle *pfh;
+  const char *v_view;
+  int v_size;
+
+  close();
+  pfh = XMFS::openIFile(i_fdt, i_path, i_includeCurrentDir);
+  if (pfh == NULL) {
+    return false;
+  }
+
+  m_name = i_path;
+  m_pos = 0;
+  m_buffer.clear();
+
+  // the view is valid while the file is open
+  v_view = XMFS::getFileView(pfh, v_size);
+  if (v_view != NULL) {
+    m_pfh = pfh;
+    m_data = v_view;
+    m_size = v_size;
+    return true;
+  }
+
+  m_buffer.resize(XMFS::getLength(pfh));
+  if (m_buffer.empty() == false &&
+      XMFS::readBuf(pfh, &m_buffer[0], m_buffer.size()) == false) {
+    XMFS::closeFile(pfh);
+    m_buffer.clear();
+    m_data = NULL;
+    m_size = 0;
+    throw Exception(m_name + " (I): open -> read failed");
+  }
+  m_data = m_buffer.empty() ? NULL : &m_buffer[0];
+  m_size = m_buffer.size();
+
+  XMFS::closeFile(pfh);
+  return true;
+}
+
+void BinaryReader::openView(const std::string &i_name,
+                            const char *i_data,
+                            int i_size) {
+  close();
+  m_name = i_name;
+  m_buffer.clear();
+  m_data = i_data;
+  m_size = i_size;
+  m_pos = 0;
+}
+
+void BinaryReader::setOffset(int i_offset) {
+  if (i_offset < 0 || i_offset > m_size) {
+    throwError("setOffset");
+  }
+  m_pos = i_offset;
+}
+
+void BinaryReader::throwError(const std::string &i_function) {
+  throw Exception(m_name + " (I): " + i_function + " -> failed");
+}
@@ -0,0 +1,138 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __BINARYREADER_H__
+#define __BINARYREADER_H__
+
+#include "VFileIO_types.h"
+#include "helpers/SwapEndian.h"
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct FileHandle;
+
+/*
+  binary file (level cache, replay) read at once : a packaged file is read in
+  place, a real file with one read ; the values are then decoded from memory,
+  with the encoding of the XMFS::read* functions
+*/
+class BinaryReader {
+public:
+  BinaryReader();
+  ~BinaryReader();
+
+  // return false if the file doesn't exist
+  bool open(FileDataType i_fdt,
+            const std::string &i_path,
+            bool i_includeCurrentDir = false);
+  // read from memory which stays valid while reading
+  void openView(const std::string &i_name, const char *i_data, int i_size);
+  std::string name() const { return m_name; }
+
+  int getOffset() const { return m_pos; }
+  int getLength() const { return m_size; }
+  bool isEnd() const { return m_pos >= m_size; }
+  void setOffset(int i_offset);
+
+  void readBuf(char *o_buf, int i_size) {
+    need(i_size, "readBuf");
+    memcpy(o_buf, m_data + m_pos, i_size);
+    m_pos += i_size;
+  }
+
+  int readByte() {
+    need(1, "readByte");
+    return (signed char)m_data[m_pos++];
+  }
+
+  bool readBool() { return readByte() != 0; }
+
+  int readShort_LE() { return SwapEndian::LittleShort(readRaw<int16_t>()); }
+  int readInt_LE() { return SwapEndian::LittleLong(readRaw<int32_t>()); }
+  float readFloat_LE() { return SwapEndian::LittleFloat(readRaw<float>()); }
+  // low then high int, as XMFS::writeInt64_LE
+  long long readInt64_LE() {
+    long long v_low = (unsigned int)readInt_LE();
+
+    return v_low | ((long long)readInt_LE() << 32);
+  }
+
+  int readShort_MaybeLE(bool big) {
+    int16_t v = readRaw<int16_t>();
+    return big ? SwapEndian::BigShort(v) : SwapEndian::LittleShort(v);
+  }
+  int readInt_MaybeLE(bool big) {
+    int32_t v = readRaw<int32_t>();
+    return big ? SwapEndian::BigLong(v) : SwapEndian::LittleLong(v);
+  }
+  float readFloat_MaybeLE(bool big) {
+    float v = readRaw<float>();
+    return big ? SwapEndian::BigFloat(v) : SwapEndian::LittleFloat(v);
+  }
+
+  std::string readString() {
+    int v_len;
+
+    need(1, "readString");
+    v_len = (unsigned char)m_data[m_pos++];
+    need(v_len, "readString");
+    m_pos += v_len;
+    return std::string(m_data + m_pos - v_len, v_len);
+  }
+
+  std::string readLongString() {
+    int v_len = (unsigned short)readShort_LE();
+
+    need(v_len, "readLongString");
+    m_pos += v_len;
+    return std::string(m_data + m_pos - v_len, v_len);
+  }
+
+private:
+  template<typename T>
+  T readRaw() {
+    T v;
+
+    need(sizeof(T), "read");
+    memcpy(&v, m_data + m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return v;
+  }
+
+  void need(int i_size, const char *i_function) {
+    if (i_size < 0 || i_size > m_size - m_pos) {
+      throwError(i_function);
+    }
+  }
+  void throwError(const std::string &i_function);
+
+  void close();
+
+  std::string m_name;
+  FileHandle *m_pfh; // packaged files : open while their view is read
+  std::vector<char> m_buffer; // real files only
+  const char *m_data;
+  int m_size;
+  int m_pos;
+};
+
+#endif
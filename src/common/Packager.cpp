@@ -18,11 +18,20 @@ along with XMOTO; if not, write to the Free Software
 Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 =============================================================================*/
 
+/* the package can be larger than what a 32 bits off_t can address */
+#define _FILE_OFFSET_BITS 64
+
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
 #include <vector>
+#if defined(WIN32)
+#include "zlib.h"
+#else
+#include <zlib.h>
+#endif
 
 #include "Packager.h"
 #include "VCommon.h"
@@ -30,6 +39,67 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "helpers/SwapEndian.h"
 #include "md5sum/md5file.h"
 
+/* the offsets of a package don't always fit in a long (windows) */
+static int seekTo(FILE *fp, long long i_offset) {
+#if defined(WIN32)
+  return _fseeki64(fp, i_offset, SEEK_SET);
+#else
+  return fseeko(fp, (off_t)i_offset, SEEK_SET);
+#endif
+}
+
+static void writeString(FILE *fp, const std::string &i_str) {
+  unsigned char c = i_str.length();
+
+  fputc(c, fp);
+  fwrite(i_str.c_str(), c, 1, fp);
+}
+
+static void writeInt(FILE *fp, unsigned int i_value) {
+  unsigned char v_buf[4];
+
+  v_buf[0] = i_value & 0xFF;
+  v_buf[1] = (i_value >> 8) & 0xFF;
+  v_buf[2] = (i_value >> 16) & 0xFF;
+  v_buf[3] = (i_value >> 24) & 0xFF;
+  fwrite(v_buf, 4, 1, fp);
+}
+
+static std::string readString(FILE *fp) {
+  char cBuf[256];
+  int nLen = fgetc(fp);
+
+  if (nLen < 0 || fread(cBuf, 1, nLen, fp) != (size_t)nLen) {
+    return "";
+  }
+  return std::string(cBuf, nLen);
+}
+
+static unsigned int readInt(FILE *fp) {
+  unsigned char v_buf[4];
+
+  if (fread(v_buf, 4, 1, fp) != 1) {
+    return 0;
+  }
+  return v_buf[0] | v_buf[1] << 8 | v_buf[2] << 16 |
+         (unsigned int)v_buf[3] << 24;
+}
+
+static void writeDirectory(FILE *fp, const std::vector<PackFile> &i_files) {
+  writeInt(fp, i_files.size());
+
+  for (unsigned int i = 0; i < i_files.size(); i++) {
+    writeString(fp, i_files[i].Name);
+    writeString(fp, i_files[i].md5sum);
+    writeInt(fp, i_files[i].nOffset & 0xFFFFFFFF);
+    writeInt(fp, i_files[i].nOffset >> 32);
+    writeInt(fp, i_files[i].nSize);
+    writeInt(fp, i_files[i].nPackedSize);
+    writeInt(fp, i_files[i].nCRC);
+    fputc(i_files[i].Compression, fp);
+  }
+}
+
 /*===========================================================================
 Unpackager
 ===========================================================================*/
@@ -124,6 +194,8 @@ void Packager::goUnpack(const std::string &BinFile,
           fseek(fp, nSize, SEEK_CUR); /* skip file */
         }
       }
+    } else if (!strncmp(cBuf, "XBI4", 4)) {
+      unpackXBI4(fp, OutPath, fp_lst);
     } else
       printf("!!! NOT VALID .bin FILE: %s\n", BinFile.c_str());
 
@@ -135,6 +207,80 @@ void Packager::goUnpack(const std::string &BinFile,
     fclose(fp_lst);
 }
 
+void Packager::unpackXBI4(FILE *fp,
+                          const std::string &OutPath,
+                          FILE *fp_lst) {
+  std::vector<PackFile> v_files;
+  unsigned int v_nbFiles;
+
+  /* get bin sum */
+  readString(fp); /* this is not useful for unpack */
+
+  v_nbFiles = readInt(fp);
+  for (unsigned int i = 0; i < v_nbFiles && !feof(fp); i++) {
+    PackFile v_file;
+
+    v_file.Name = readString(fp);
+    v_file.md5sum = readString(fp);
+    v_file.nOffset = readInt(fp);
+    v_file.nOffset |= (long long)readInt(fp) << 32;
+    v_file.nSize = readInt(fp);
+    v_file.nPackedSize = readInt(fp);
+    v_file.nCRC = readInt(fp);
+    v_file.Compression = (PackCompression)fgetc(fp);
+    v_files.push_back(v_file);
+  }
+  if (feof(fp)) {
+    printf("!!! NOT VALID .bin FILE\n");
+    return;
+  }
+
+  for (unsigned int i = 0; i < v_files.size(); i++) {
+    const PackFile &v_file = v_files[i];
+    std::vector<unsigned char> v_packed(v_file.nPackedSize + 1);
+    std::vector<unsigned char> v_data(v_file.nSize + 1);
+    uLongf v_size = v_file.nSize;
+
+    /* Write name to package.lst file */
+    if (fp_lst != NULL)
+      fprintf(fp_lst, "%s\n", v_file.Name.c_str());
+
+    printf("Extracting: %s\n", v_file.Name.c_str());
+
+    if (seekTo(fp, v_file.nOffset) != 0 ||
+        fread(&v_packed[0], 1, v_file.nPackedSize, fp) !=
+          (size_t)v_file.nPackedSize) {
+      printf("(Warning: failed to read the file)\n");
+      continue;
+    }
+
+    if (v_file.Compression == PACK_ZLIB) {
+      if (uncompress(
+            &v_data[0], &v_size, &v_packed[0], v_file.nPackedSize) != Z_OK ||
+          v_size != (uLongf)v_file.nSize) {
+        printf("(Warning: failed to uncompress the file)\n");
+        continue;
+      }
+    } else {
+      v_data.swap(v_packed);
+    }
+
+    if (crc32(0L, &v_data[0], v_file.nSize) != v_file.nCRC) {
+      printf("(Warning: the file is corrupted)\n");
+      continue;
+    }
+
+    /* Open target file for output */
+    FILE *fp_out = createFile(OutPath, v_file.Name);
+    if (fp_out != NULL) {
+      fwrite(&v_data[0], 1, v_file.nSize, fp_out);
+      fclose(fp_out);
+    } else {
+      printf("(Warning: failed to open file for output)\n");
+    }
+  }
+}
+
 FILE *Packager::createFile(const std::string &TargetDir,
                            const std::string &Path) {
   /* Create sub-dirs first */
@@ -197,10 +343,30 @@ void Packager::go(const std::string &BinFile, const std::string &DataDir) {
   }
   fclose(fp);
 
+  /* the directory is sorted, with the first file of a name */
+  std::sort(FileList.begin(), FileList.end());
+  FileList.erase(std::unique(FileList.begin(), FileList.end()), FileList.end());
+
   /* Info */
   printf("%lu files scheduled for packaging!\n", FileList.size());
   printf("Creating package '%s'...\n", BinFile.c_str());
 
+  std::vector<PackFile> v_packFiles;
+  for (unsigned int i = 0; i < FileList.size(); i++) {
+    std::string v_path = DataDir + "/" + FileList[i];
+    PackFile v_packFile;
+
+    FILE *in = fopen(v_path.c_str(), "rb");
+    if (in == NULL) {
+      printf("!!! FAILED TO ADD '%s'\n", FileList[i].c_str());
+      continue;
+    }
+    fclose(in);
+    v_packFile.Name = FileList[i];
+    v_packFile.md5sum = md5file(v_path);
+    v_packFiles.push_back(v_packFile);
+  }
+
   /* Do it */
   fp = fopen(BinFile.c_str(), "wb");
 
@@ -208,45 +374,68 @@ void Packager::go(const std::string &BinFile, const std::string &DataDir) {
     throw Exception("Cannot open " + BinFile);
     return;
   }
-  fwrite("XBI3", 4, 1, fp);
+  fwrite("XBI4", 4, 1, fp);
 
   /* control sum */
-  unsigned char c;
-  std::string sum = md5file(pkglist);
-  c = sum.length();
-  fputc(c, fp);
-  fwrite(sum.c_str(), c, 1, fp);
+  writeString(fp, md5file(pkglist));
+
+  /* directory, written again once the files are packaged */
+  long v_directoryOffset = ftell(fp);
+  writeDirectory(fp, v_packFiles);
+
+  long long v_offset = ftell(fp);
+  long long v_totalSize = 0;
+
+  for (unsigned int i = 0; i < v_packFiles.size(); i++) {
+    PackFile &v_packFile = v_packFiles[i];
 
-  for (unsigned int i = 0; i < FileList.size(); i++) {
     /* Open and load entire file into memory (yikes!! (but all files a pretty
      * small :P)) */
-    FILE *in = fopen((DataDir + "/" + FileList[i]).c_str(), "rb");
-    if (in != NULL) {
-      fseek(in, 0, SEEK_END);
-      int nSize = ftell(in);
-      fseek(in, 0, SEEK_SET);
-      unsigned char *pcBuf = new unsigned char[nSize];
-      fread(pcBuf, nSize, 1, in);
-      fclose(in);
-
-      /* Got it. */
-      unsigned char c = FileList[i].length();
-      fputc(c, fp);
-      fwrite(FileList[i].c_str(), c, 1, fp);
-
-      std::string md5sum = md5file((DataDir + "/" + FileList[i]));
-      c = md5sum.length();
-      fputc(c, fp);
-      fwrite(md5sum.c_str(), c, 1, fp);
-
-      int LnSize = SwapEndian::LittleLong(nSize);
-      fwrite(&LnSize, 4, 1, fp);
-      fwrite(pcBuf, nSize, 1, fp);
-
-      /* NEXT! */
-      delete[] pcBuf;
-    } else
-      printf("!!! FAILED TO ADD '%s'\n", FileList[i].c_str());
+    FILE *in = fopen((DataDir + "/" + v_packFile.Name).c_str(), "rb");
+    if (in == NULL) {
+      fclose(fp);
+      throw Exception("Cannot read " + v_packFile.Name);
+    }
+    fseek(in, 0, SEEK_END);
+    int nSize = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    std::vector<unsigned char> v_data(nSize + 1);
+    fread(&v_data[0], nSize, 1, in);
+    fclose(in);
+
+    v_packFile.nOffset = v_offset;
+    v_packFile.nSize = nSize;
+    v_packFile.nCRC = crc32(0L, &v_data[0], nSize);
+
+    /* pictures and sounds are already compressed : keep the files which
+       don't shrink enough as they are, they are read without a copy */
+    uLongf v_packedSize = compressBound(nSize);
+    std::vector<unsigned char> v_packed(v_packedSize);
+    if (compress2(&v_packed[0],
+                  &v_packedSize,
+                  &v_data[0],
+                  nSize,
+                  Z_BEST_COMPRESSION) == Z_OK &&
+        v_packedSize < (uLongf)(nSize - nSize / 10)) {
+      v_packFile.Compression = PACK_ZLIB;
+      v_packFile.nPackedSize = v_packedSize;
+      fwrite(&v_packed[0], v_packedSize, 1, fp);
+    } else {
+      v_packFile.Compression = PACK_STORED;
+      v_packFile.nPackedSize = nSize;
+      fwrite(&v_data[0], nSize, 1, fp);
+    }
+
+    v_offset += v_packFile.nPackedSize;
+    v_totalSize += nSize;
   }
+
+  fseek(fp, v_directoryOffset, SEEK_SET);
+  writeDirectory(fp, v_packFiles);
   fclose(fp);
+
+  printf("%lu files packaged: %lld bytes, %lld bytes uncompressed\n",
+         v_packFiles.size(),
+         v_offset,
+         v_totalSize);
 }
@@ -23,6 +23,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /*===========================================================================
 Packager class
+
+the package (XBI4, little endian) :
+  "XBI4", md5 of package.lst
+  number of files (int)
+  directory, sorted by name ; for each file :
+    name, md5, offset from the start of the package (int64), size (int),
+    size in the package (int), crc32 of the file (int), compression (byte)
+  the files, compressed with zlib when it is worth it
+strings are one byte for the length, then the characters
 ===========================================================================*/
 class Packager {
 public:
@@ -36,6 +45,7 @@ private:
   /* Helpers */
   static FILE *createFile(const std::string &TargetDir,
                           const std::string &Path);
+  static void unpackXBI4(FILE *fp, const std::string &OutPath, FILE *fp_lst);
 };
 
 #endif
@@ -26,12 +26,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
   #include <winbase.h>
 #else
   #include <dirent.h>
+  #include <fcntl.h>
+  #include <sys/mman.h>
   #include <sys/types.h>
   #include <unistd.h>
 #endif
 
 #include <stdarg.h>
+#include <string.h>
 #include <sys/stat.h>
+#include <time.h>
+#include <utility>
 
 #if BUILD_MACOS_BUNDLE
 #include <CoreFoundation/CoreFoundation.h>
@@ -39,11 +44,19 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #endif
 
 #include "VFileIO.h"
+#include "BinaryReader.h"
 #include "helpers/Log.h"
 #include "helpers/SwapEndian.h"
 #include "helpers/Text.h"
 #include "helpers/VExcept.h"
+#include "include/xm_SDL.h"
 #include "md5sum/md5file.h"
+#include "thread/WorkersPool.h"
+#if defined(WIN32)
+#include "zlib.h"
+#else
+#include <zlib.h>
+#endif
 
 #include "XMSession_default.h"
 #include "xmoto/UserConfig.h"
@@ -238,6 +251,13 @@ std::string XMFS::getUserDir(FileDataType i_fdt) {
   return "";
 }
 
+void XMFS::setUserCacheDir(const std::string &i_dir) {
+  m_UserCacheDir = i_dir;
+  if (isDir(m_UserCacheDir + std::string("/LCache")) == false) {
+    mkArborescenceDir(m_UserCacheDir + std::string("/LCache"));
+  }
+}
+
 std::string XMFS::getUserDirUTF8(FileDataType i_fdt) {
   if (i_fdt != FDT_DATA) {
     throw Exception("Allow only utf8 from user data directory");
@@ -251,76 +271,218 @@ std::string XMFS::getUserDirUTF8(FileDataType i_fdt) {
 
   FutureRasmus: well, this is probably the crappiest code in the world. Period.
   ===========================================================================*/
-void XMFS::_FindFilesRecursive(const std::string &DirX,
-                               const std::string &Wildcard,
-                               std::vector<std::string> &List) {
+/* directories of one depth of the tree, searched at the same time */
+struct FilesSearch {
+  std::string wildcard;
+  bool recurse;
+  std::vector<std::string> dirs;
+  std::vector<unsigned int> roots; // directory searched first, for each dir
+  std::vector<std::vector<std::string> > files; // for each dir
+  std::vector<std::vector<std::string> > subDirs; // for each dir
+};
+
+static void matchDirListing(FilesSearch *io_search,
+                            unsigned int i_dir,
+                            const DirListing &i_listing) {
+  const std::string &v_dir = io_search->dirs[i_dir];
+  std::vector<std::string> &v_files = io_search->files[i_dir];
+#ifdef WIN32
+  bool v_caseSensitive = false; /* as _findfirst */
+#else
+  bool v_caseSensitive = true;
+#endif
+
+  for (unsigned int i = 0; i < i_listing.files.size(); i++) {
+    if (str_match_wildcard((char *)io_search->wildcard.c_str(),
+                           (char *)i_listing.files[i].c_str(),
+                           v_caseSensitive)) {
+      v_files.push_back(v_dir + i_listing.files[i]);
+    }
+  }
+
+  for (unsigned int i = 0; i < i_listing.dirs.size(); i++) {
+    if (io_search->recurse) {
+      io_search->subDirs[i_dir].push_back(v_dir + i_listing.dirs[i] + "/");
+    } else if (str_match_wildcard((char *)io_search->wildcard.c_str(),
+                                  (char *)i_listing.dirs[i].c_str(),
+                                  v_caseSensitive)) {
+      v_files.push_back(v_dir + i_listing.dirs[i]);
+    }
+  }
+}
+
+bool XMFS::listDir(const std::string &i_dir,
+                   std::vector<std::string> &o_files,
+                   std::vector<std::string> &o_dirs) {
 /* Windows? */
 #ifdef WIN32
   intptr_t fh;
   struct _finddata_t fd;
 
-  std::string Dir = DirX;
-  if (!DirX.empty() && DirX[DirX.length() - 1] == '/') {
-    Dir = DirX.substr(0, DirX.length() - 1);
+  if ((fh = _findfirst((i_dir + std::string("*")).c_str(), &fd)) == -1L) {
+    return false;
   }
-
-  if ((fh = _findfirst((Dir + std::string("/") + Wildcard).c_str(), &fd)) !=
-      -1L) {
-    do {
-      if (strcmp(fd.name, ".") && strcmp(fd.name, "..")) {
-        List.push_back(Dir + std::string("/") + std::string(fd.name));
-      }
-    } while (_findnext(fh, &fd) == 0);
-    _findclose(fh);
-  }
-
-  /* Now, recurse into sub-dirs */
-  if ((fh = _findfirst((Dir + std::string("/*")).c_str(), &fd)) != -1L) {
-    do {
-      if (strcmp(fd.name, ".") && strcmp(fd.name, "..")) {
-        std::string F = Dir + std::string("/") + std::string(fd.name);
-        if (isDir(F)) {
-          /* Recurse! */
-          _FindFilesRecursive(F, Wildcard, List);
-        }
+  do {
+    if (strcmp(fd.name, ".") && strcmp(fd.name, "..")) {
+      if (fd.attrib & _A_SUBDIR) {
+        o_dirs.push_back(fd.name);
+      } else {
+        o_files.push_back(fd.name);
       }
-    } while (_findnext(fh, &fd) == 0);
-    _findclose(fh);
-  }
+    }
+  } while (_findnext(fh, &fd) == 0);
+  _findclose(fh);
 #else
-  std::string Dir = DirX;
-
   struct dirent *dp;
-  DIR *dirp = opendir(Dir.c_str());
-  while (dirp) {
-    if ((dp = readdir(dirp)) != NULL) {
-      std::string F = Dir + std::string(dp->d_name);
-      if (isDir(F)) {
-        /* Recurse... */
-        if (strcmp(dp->d_name, ".") && strcmp(dp->d_name, "..")) {
-          _FindFilesRecursive(F + std::string("/"), Wildcard, List);
-        }
-      } else {
-        if (str_match_wildcard(
-              (char *)Wildcard.c_str(), (char *)dp->d_name, true)) {
-          /* Match! */
-          if (strcmp(dp->d_name, ".") && strcmp(dp->d_name, "..")) {
-            List.push_back(F);
-          }
-        }
-      }
+  DIR *dirp = opendir(i_dir.c_str());
+  bool v_isDir, v_typeKnown;
+
+  if (dirp == NULL) {
+    return false;
+  }
+  while ((dp = readdir(dirp)) != NULL) {
+    if (strcmp(dp->d_name, ".") == 0 || strcmp(dp->d_name, "..") == 0) {
+      continue;
+    }
+
+    /* the type is given by most file systems, no need to stat the file */
+    v_isDir = v_typeKnown = false;
+#ifdef DT_DIR
+    if (dp->d_type != DT_UNKNOWN && dp->d_type != DT_LNK) {
+      v_isDir = dp->d_type == DT_DIR;
+      v_typeKnown = true;
+    }
+#endif
+    if (v_typeKnown == false) {
+      v_isDir = isDir(i_dir + std::string(dp->d_name));
+    }
+
+    if (v_isDir) {
+      o_dirs.push_back(dp->d_name);
     } else {
-      closedir(dirp);
-      break;
+      o_files.push_back(dp->d_name);
     }
   }
+  closedir(dirp);
 #endif
+  return true;
+}
+
+void XMFS::findFilesInDir(void *i_search, unsigned int i_dir) {
+  FilesSearch *v_search = (FilesSearch *)i_search;
+  const std::string &v_dir = v_search->dirs[i_dir];
+  std::unordered_map<std::string, DirListing>::const_iterator v_it;
+  DirListing v_listing;
+  struct stat S;
+
+  /* windows stat doesn't like the final / */
+  if (stat(v_dir.length() > 1 ? v_dir.substr(0, v_dir.length() - 1).c_str()
+                              : v_dir.c_str(),
+           &S)) {
+    if (m_DirsListingsMutex != NULL) {
+      SDL_LockMutex(m_DirsListingsMutex);
+      if (m_DirsListings.erase(v_dir) > 0) {
+        m_DirsListingsChanged = true;
+      }
+      SDL_UnlockMutex(m_DirsListingsMutex);
+    }
+    return;
+  }
+  v_listing.mtime = (long long)S.st_mtime;
+  v_listing.inode = (long long)S.st_ino;
+
+  /* the mtime of a directory changes when a file is added, removed or
+     renamed in it ; the listing is copied so that the other workers don't
+     wait for the matching */
+  if (m_DirsListingsMutex != NULL) {
+    bool v_cached = false;
+
+    SDL_LockMutex(m_DirsListingsMutex);
+    v_it = m_DirsListings.find(v_dir);
+    if (v_it != m_DirsListings.end() &&
+        v_it->second.mtime == v_listing.mtime &&
+        v_it->second.inode == v_listing.inode) {
+      v_listing = v_it->second;
+      v_cached = true;
+    }
+    SDL_UnlockMutex(m_DirsListingsMutex);
+
+    if (v_cached) {
+      matchDirListing(v_search, i_dir, v_listing);
+      return;
+    }
+  }
+
+  if (listDir(v_dir, v_listing.files, v_listing.dirs) == false) {
+    return;
+  }
+  matchDirListing(v_search, i_dir, v_listing);
+
+  /* a directory modified during the last seconds can still be modified
+     without its mtime changing */
+  if (m_DirsListingsMutex != NULL &&
+      v_listing.mtime < (long long)time(NULL) - 1) {
+    SDL_LockMutex(m_DirsListingsMutex);
+    m_DirsListings[v_dir] = std::move(v_listing);
+    m_DirsListingsChanged = true;
+    SDL_UnlockMutex(m_DirsListingsMutex);
+  }
+}
+
+void XMFS::findFiles(const std::vector<std::string> &i_dirs,
+                     const std::string &i_wildcard,
+                     bool i_recurse,
+                     std::vector<std::string> &io_files) {
+  FilesSearch v_search;
+  std::vector<std::vector<std::string> > v_rootsFiles(i_dirs.size());
+  std::vector<std::string> v_nextDirs;
+  std::vector<unsigned int> v_nextRoots;
+
+  v_search.wildcard = i_wildcard;
+  v_search.recurse = i_recurse;
+  for (unsigned int i = 0; i < i_dirs.size(); i++) {
+    v_search.dirs.push_back(i_dirs[i]);
+    if (v_search.dirs[i] != "" &&
+        v_search.dirs[i][v_search.dirs[i].length() - 1] != '/') {
+      v_search.dirs[i] += "/";
+    }
+    v_search.roots.push_back(i);
+  }
+
+  /* one depth of the trees at a time, one task per directory ; the files
+     are then kept in the order of the directories to search */
+  while (v_search.dirs.size() > 0) {
+    v_search.files.assign(v_search.dirs.size(), std::vector<std::string>());
+    v_search.subDirs.assign(v_search.dirs.size(), std::vector<std::string>());
+    WorkersPool::run(findFilesInDir, &v_search, v_search.dirs.size());
+
+    v_nextDirs.clear();
+    v_nextRoots.clear();
+    for (unsigned int i = 0; i < v_search.dirs.size(); i++) {
+      std::vector<std::string> &v_files = v_rootsFiles[v_search.roots[i]];
+
+      v_files.insert(
+        v_files.end(), v_search.files[i].begin(), v_search.files[i].end());
+      for (unsigned int j = 0; j < v_search.subDirs[i].size(); j++) {
+        v_nextDirs.push_back(v_search.subDirs[i][j]);
+        v_nextRoots.push_back(v_search.roots[i]);
+      }
+    }
+    v_search.dirs.swap(v_nextDirs);
+    v_search.roots.swap(v_nextRoots);
+  }
+
+  for (unsigned int i = 0; i < v_rootsFiles.size(); i++) {
+    io_files.insert(
+      io_files.end(), v_rootsFiles[i].begin(), v_rootsFiles[i].end());
+  }
 }
 
 std::vector<std::string> XMFS::findPhysFiles(FileDataType i_fdt,
                                              std::string Files,
                                              bool bRecurse) {
   std::vector<std::string> Result;
+  std::vector<std::string> v_dirs;
   std::string Wildcard;
   std::string DataDirToSearch, AltDirToSearch, UDirToSearch = "";
 
@@ -344,135 +506,46 @@ std::vector<std::string> XMFS::findPhysFiles(FileDataType i_fdt,
 /* 1. find in user dir */
 /* 2. find in data dir */
 /* 3. find in package  */
-
-/* Windows? */
-#ifdef WIN32
   if (UDirToSearch != "") {
-    if (bRecurse) {
-      _FindFilesRecursive(UDirToSearch, Wildcard, Result);
-    } else {
-      intptr_t fh;
-      struct _finddata_t fd;
-
-      if ((fh = _findfirst((UDirToSearch + Wildcard).c_str(), &fd)) != -1L) {
-        do {
-          if (strcmp(fd.name, ".") && strcmp(fd.name, "..")) {
-            Result.push_back(UDirToSearch + std::string(fd.name));
-          }
-        } while (_findnext(fh, &fd) == 0);
-        _findclose(fh);
-      }
-    }
+    v_dirs.push_back(UDirToSearch);
   }
 
+/* Windows? */
+#ifdef WIN32
   if (i_fdt == FDT_DATA) {
-    if (bRecurse) {
-      _FindFilesRecursive(DataDirToSearch, Wildcard, Result);
-    } else {
-      intptr_t fh;
-      struct _finddata_t fd;
-
-      if ((fh = _findfirst((DataDirToSearch + Wildcard).c_str(), &fd)) != -1L) {
-        do {
-          if (strcmp(fd.name, ".") && strcmp(fd.name, "..")) {
-            Result.push_back(DataDirToSearch + std::string(fd.name));
-          }
-        } while (_findnext(fh, &fd) == 0);
-        _findclose(fh);
-      }
-    }
+    v_dirs.push_back(DataDirToSearch);
   }
-
 #else /* Assume linux, unix... yalla yalla... */
-  if (UDirToSearch != "") {
-    if (bRecurse) {
-      _FindFilesRecursive(UDirToSearch, Wildcard, Result);
-    } else {
-      struct dirent *dp;
-      DIR *dirp = opendir(UDirToSearch.c_str());
-      while (dirp) {
-        if ((dp = readdir(dirp)) != NULL) {
-          if (str_match_wildcard(
-                (char *)Wildcard.c_str(), (char *)dp->d_name, true)) {
-            /* Match! */
-            if (strcmp(dp->d_name, ".") && strcmp(dp->d_name, "..")) {
-              Result.push_back(UDirToSearch + std::string(dp->d_name));
-            }
-          }
-        } else {
-          closedir(dirp);
-          break;
-        }
-      }
-    }
-  }
-
   if (AltDirToSearch != UDirToSearch) {
-    if (bRecurse) {
-      _FindFilesRecursive(AltDirToSearch, Wildcard, Result);
-    } else {
-      struct dirent *dp;
-      DIR *dirp = opendir(AltDirToSearch.c_str());
-      while (dirp) {
-        if ((dp = readdir(dirp)) != NULL) {
-          if (str_match_wildcard(
-                (char *)Wildcard.c_str(), (char *)dp->d_name, true)) {
-            /* Match! */
-            if (strcmp(dp->d_name, ".") && strcmp(dp->d_name, "..")) {
-              Result.push_back(AltDirToSearch + std::string(dp->d_name));
-            }
-          }
-        } else {
-          closedir(dirp);
-          break;
-        }
-      }
-    }
+    v_dirs.push_back(AltDirToSearch);
   }
 
   if (i_fdt == FDT_DATA) {
     if (DataDirToSearch != AltDirToSearch && DataDirToSearch != UDirToSearch) {
-      if (bRecurse) {
-        _FindFilesRecursive(DataDirToSearch, Wildcard, Result);
-      } else {
-        /* Search directories */
-        struct dirent *dp;
-        DIR *dirp = opendir(DataDirToSearch.c_str());
-        while (dirp) {
-          if ((dp = readdir(dirp)) != NULL) {
-            if (str_match_wildcard(
-                  (char *)Wildcard.c_str(), (char *)dp->d_name, true)) {
-              /* Match! */
-              if (strcmp(dp->d_name, ".") && strcmp(dp->d_name, "..")) {
-                Result.push_back(DataDirToSearch + std::string(dp->d_name));
-              }
-            }
-          } else {
-            closedir(dirp);
-            break;
-          }
-        }
-      }
+      v_dirs.push_back(DataDirToSearch);
     }
   }
 #endif
 
+  findFiles(v_dirs, Wildcard, bRecurse, Result);
+
   if (i_fdt == FDT_DATA) {
     /* Look in package */
+    int k = Files.find_last_of('/');
+    std::string Ds1 = Files.substr(0, k + 1);
+    if (Ds1.substr(0, 2) == "./")
+      Ds1.erase(Ds1.begin(), Ds1.begin() + 2);
+
     for (unsigned int i = 0; i < m_PackFiles.size(); i++) {
       /* Make sure about the directory... */
-      int k = Files.find_last_of('/');
-      std::string Ds1 = Files.substr(0, k + 1);
-      k = m_PackFiles[i].Name.find_last_of('/');
-      std::string Ds2 = m_PackFiles[i].Name.substr(0, k + 1);
-      if (Ds1.substr(0, 2) == "./")
-        Ds1.erase(Ds1.begin(), Ds1.begin() + 2);
-
-      if (Ds1 == Ds2 && str_match_wildcard((char *)Files.c_str(),
-                                           (char *)m_PackFiles[i].Name.c_str(),
-                                           true)) {
+      const std::string &Name = m_PackFiles[i].Name;
+      k = Name.find_last_of('/');
+
+      if (k + 1 == (int)Ds1.length() && Name.compare(0, k + 1, Ds1) == 0 &&
+          str_match_wildcard(
+            (char *)Files.c_str(), (char *)Name.c_str(), true)) {
         /* Match. */
-        Result.push_back(m_PackFiles[i].Name);
+        Result.push_back(Name);
       }
     }
   }
@@ -546,33 +619,24 @@ FileHandle *XMFS::openIFile(FileDataType i_fdt,
 
   if (i_fdt == FDT_DATA) {
     if (pfh->fp == NULL) {
-      int v_packsize = m_PackFiles.size();
-
-      // remove all ./ of the Path
-      std::string v_path = Path;
-      while (v_path.substr(0, 2) == "./") {
-        v_path = v_path.substr(2, v_path.length() - 2);
-      }
-
       /* No luck so far, look in the data package */
-      for (unsigned int i = 0; i < v_packsize; i++) {
-        if (m_PackFiles[i].Name == v_path) {
-          /* Found it, yeah. */
-          pfh->fp = fopen(m_BinDataFile.c_str(), "rb");
-          if (pfh->fp != NULL) {
-            fseek(pfh->fp, m_PackFiles[i].nOffset, SEEK_SET);
-            pfh->Type = FHT_PACKAGE;
-            pfh->nSize = m_PackFiles[i].nSize;
-            pfh->nOffset = ftell(pfh->fp);
-            //            printf("OPENED '%s' IN PACKAGE!\n",Path.c_str());
-          } else
-            break;
+      const PackFile *v_packFile = findPackFile(Path);
+      const char *v_data;
+
+      if (v_packFile != NULL) {
+        v_data = loadPackFile(v_packFile);
+        if (v_data != NULL) {
+          pfh->Type = FHT_PACKAGE;
+          pfh->pData = v_data;
+          pfh->nPackFile = v_packFile - &m_PackFiles[0];
+          pfh->nSize = v_packFile->nSize;
+          pfh->nPos = 0;
         }
       }
     }
   }
 
-  if (pfh->fp == NULL) {
+  if (pfh->Type != FHT_PACKAGE && pfh->fp == NULL) {
     delete pfh;
     return NULL;
   }
@@ -593,7 +657,7 @@ void XMFS::closeFile(FileHandle *pfh) {
   if (pfh->Type == FHT_STDIO) {
     fclose(pfh->fp);
   } else if (pfh->Type == FHT_PACKAGE) {
-    fclose(pfh->fp);
+    releasePackFile(pfh->nPackFile);
   } else
     _ThrowFileError(pfh, "closeFile -> invalid type");
   delete pfh;
@@ -606,16 +670,12 @@ bool XMFS::readBuf(FileHandle *pfh, char *pcBuf, unsigned int nBufSize) {
     if (fread(pcBuf, 1, nBufSize, pfh->fp) != nBufSize)
       return false;
   } else if (pfh->Type == FHT_PACKAGE) {
-    int nRem = pfh->nSize - (ftell(pfh->fp) - pfh->nOffset);
-    //      printf("reading %d bytes. %d left  (%d %d
-    //      %d).\n",nBufSize,nRem,pfh->nSize,ftell(pfh->fp),pfh->nOffset);
     if (nBufSize == 0)
       return true;
-    if (nRem > 0) {
-      if (fread(pcBuf, 1, nBufSize, pfh->fp) != nBufSize)
-        return false;
-    } else
+    if (pfh->nPos < 0 || nBufSize > (unsigned int)(pfh->nSize - pfh->nPos))
       return false;
+    memcpy(pcBuf, pfh->pData + pfh->nPos, nBufSize);
+    pfh->nPos += nBufSize;
   } else
     _ThrowFileError(pfh, "readBuf -> invalid type");
   return true;
@@ -636,7 +696,7 @@ bool XMFS::setOffset(FileHandle *pfh, int nOffset) {
   if (pfh->Type == FHT_STDIO) {
     fseek(pfh->fp, nOffset, SEEK_SET);
   } else if (pfh->Type == FHT_PACKAGE) {
-    fseek(pfh->fp, nOffset + pfh->nOffset, SEEK_SET);
+    pfh->nPos = nOffset;
   } else
     _ThrowFileError(pfh, "setOffset -> invalid type");
   return true; /* blahh, this is not right, but... */
@@ -646,7 +706,7 @@ bool XMFS::setEnd(FileHandle *pfh) {
   if (pfh->Type == FHT_STDIO) {
     fseek(pfh->fp, 0, SEEK_END);
   } else if (pfh->Type == FHT_PACKAGE) {
-    fseek(pfh->fp, pfh->nSize + pfh->nOffset, SEEK_SET);
+    pfh->nPos = pfh->nSize;
   } else
     _ThrowFileError(pfh, "setEnd -> invalid type");
   return true; /* ... */
@@ -657,7 +717,7 @@ int XMFS::getOffset(FileHandle *pfh) {
   if (pfh->Type == FHT_STDIO) {
     nOffset = ftell(pfh->fp);
   } else if (pfh->Type == FHT_PACKAGE) {
-    nOffset = ftell(pfh->fp) - pfh->nOffset;
+    nOffset = pfh->nPos;
   } else
     _ThrowFileError(pfh, "getOffset -> invalid type");
   return nOffset;
@@ -673,8 +733,7 @@ bool XMFS::isEnd(FileHandle *pfh) {
     if (!feof(pfh->fp))
       bEnd = false;
   } else if (pfh->Type == FHT_PACKAGE) {
-    int nRem = pfh->nSize - (ftell(pfh->fp) - pfh->nOffset);
-    if (nRem > 0)
+    if (pfh->nPos < pfh->nSize)
       bEnd = false;
   } else
     _ThrowFileError(pfh, "isEnd -> invalid type");
@@ -686,6 +745,15 @@ std::string XMFS::readFileToEnd(FileHandle *pfh) {
   char v_buffer[16384 + 1];
   int v_remaining = getLength(pfh);
   int v_toread;
+  const char *v_view;
+
+  /* packaged file : one copy from the package */
+  v_view = getFileView(pfh, v_toread);
+  if (v_view != NULL) {
+    v_res.assign(v_view, v_toread);
+    pfh->nPos = pfh->nSize;
+    return v_res;
+  }
 
   v_res = "";
 
@@ -702,6 +770,16 @@ std::string XMFS::readFileToEnd(FileHandle *pfh) {
   return v_res;
 }
 
+const char *XMFS::getFileView(FileHandle *pfh, int &o_size) {
+  if (pfh->Type != FHT_PACKAGE || pfh->nPos < 0 || pfh->nPos > pfh->nSize) {
+    o_size = 0;
+    return NULL;
+  }
+
+  o_size = pfh->nSize - pfh->nPos;
+  return pfh->pData + pfh->nPos;
+}
+
 bool XMFS::readNextLine(FileHandle *pfh, std::string &Line) {
   int c;
   char b[2];
@@ -976,6 +1054,21 @@ int XMFS::getFileTimeStamp(const std::string &Path) {
   return (int)S.st_mtime; /* no we don't care about exact value */
 }
 
+bool XMFS::getFileStatSignature(FileDataType i_fdt,
+                                const std::string &i_filePath,
+                                FileStatSignature &o_signature) {
+  struct stat S;
+
+  if (stat(FullPath(i_fdt, i_filePath).c_str(), &S)) {
+    return false;
+  }
+
+  o_signature.size = (long long)S.st_size;
+  o_signature.mtime = (long long)S.st_mtime;
+  o_signature.inode = (long long)S.st_ino; /* always 0 on windows */
+  return true;
+}
+
 /*===========================================================================
   Is that a dir or what? - and similar stuffin'
   ===========================================================================*/
@@ -1162,6 +1255,28 @@ bool XMFS::moveFile(const std::string &From, const std::string &To) {
   return rename(From.c_str(), To.c_str()) == 0;
 }
 
+bool XMFS::replaceFile(FileDataType i_fdt,
+                       const std::string &From,
+                       const std::string &To) {
+  std::string v_from = From;
+  std::string v_to = To;
+
+  if (isPathAbsolute(From) == false) {
+    v_from = getUserDir(i_fdt) + std::string("/") + From;
+  }
+  if (isPathAbsolute(To) == false) {
+    v_to = getUserDir(i_fdt) + std::string("/") + To;
+  }
+
+#ifdef WIN32
+  // rename() doesn't replace an existing file
+  return MoveFileExA(v_from.c_str(), v_to.c_str(), MOVEFILE_REPLACE_EXISTING) !=
+         0;
+#else
+  return rename(v_from.c_str(), v_to.c_str()) == 0;
+#endif
+}
+
 /*===========================================================================
   Initialize file system fun
   ===========================================================================*/
@@ -1175,6 +1290,15 @@ bool XMFS::m_bGotSystemDataDir;
 std::string XMFS::m_BinDataFile = "";
 std::string XMFS::m_binCheckSum = "";
 std::vector<PackFile> XMFS::m_PackFiles;
+std::unordered_map<std::string, unsigned int> XMFS::m_PackFilesIndex;
+const char *XMFS::m_BinData = NULL;
+long XMFS::m_BinDataSize = 0;
+std::vector<const char *> XMFS::m_PackFilesData;
+std::vector<unsigned int> XMFS::m_PackFilesNbHandles;
+SDL_mutex *XMFS::m_PackFilesDataMutex = NULL;
+std::unordered_map<std::string, DirListing> XMFS::m_DirsListings;
+bool XMFS::m_DirsListingsChanged = false;
+SDL_mutex *XMFS::m_DirsListingsMutex = NULL;
 
 void XMFS::init(const std::string &AppDir,
                 const std::string &i_binFile,
@@ -1382,75 +1506,14 @@ void XMFS::init(const std::string &AppDir,
   }
 
   /* Initialize binary data package if any */
-  FILE *fp = fopen(m_BinDataFile.c_str(), "rb");
-  if (fp == NULL) {
+  if (doesRealFileOrDirectoryExists(m_BinDataFile) == false) {
     throw Exception("Package " + i_binFile + " not found !");
   }
 
-  char cBuf[256];
-  char md5sum[256];
-  fread(cBuf, 4, 1, fp);
-  if (!strncmp(cBuf, "XBI3", 4)) {
-    int nNameLen;
-    int md5sumLen;
-    PackFile v_packFile;
-    size_t v_extension_place;
-    std::string v_extension;
-
-    /* get bin checksum of the package.list */
-    md5sumLen = fgetc(fp);
-    fread(md5sum, md5sumLen, 1, fp);
-    md5sum[md5sumLen] = '\0';
-    m_binCheckSum = md5sum;
-
-    while ((nNameLen = fgetc(fp)) >= 0) {
-      //          printf("%d  \n",nNameLen);
-      /* Read file name */
-      fread(cBuf, nNameLen, 1, fp);
-      cBuf[nNameLen] = '\0';
-
-      md5sumLen = fgetc(fp);
-      fread(md5sum, md5sumLen, 1, fp);
-      md5sum[md5sumLen] = '\0';
-      //          printf("      %s\n",cBuf);
-
-      /* Read file size */
-      int nSize;
-
-      /* Patch by Michel Daenzer (applied 2005-10-25) */
-      unsigned char nSizeBuf[4];
-      fread(nSizeBuf, 4, 1, fp);
-      nSize =
-        nSizeBuf[0] | nSizeBuf[1] << 8 | nSizeBuf[2] << 16 | nSizeBuf[3] << 24;
-
-      v_packFile.Name = cBuf;
-
-      v_extension = "";
-      v_extension_place = v_packFile.Name.rfind(".");
-      if (v_extension_place != std::string::npos) {
-        v_extension = v_packFile.Name.substr(v_extension_place + 1);
-      }
-
-      // don't add unuseful graphics files
-      if (i_graphics || (v_extension != "png" && // picture
-                         v_extension != "jpg" && // picture
-                         v_extension != "frag" && // graphical card files
-                         v_extension != "vert" && // graphical card files
-                         v_extension != "ogg" && // music
-                         v_extension != "wav" // sound
-                         )) {
-        v_packFile.md5sum = md5sum;
-        v_packFile.nOffset = ftell(fp);
-        v_packFile.nSize = nSize;
-        m_PackFiles.push_back(v_packFile);
-      }
-
-      fseek(fp, nSize, SEEK_CUR);
-    }
-  } else {
-    throw Exception("Invalid binary data package format");
-  }
-  fclose(fp);
+  /* only the directory at the front is read, the files are checked when
+     they are opened */
+  mapPackage();
+  readPackageDirectory(i_graphics);
 
   m_isInitialized = true;
 
@@ -1473,9 +1536,23 @@ void XMFS::init(const std::string &AppDir,
   if (isDir(getUserLevelsDir()) == false) {
     mkArborescenceDir(getUserLevelsDir());
   }
+
+  loadDirsListings();
+  if (m_DirsListingsMutex == NULL) {
+    m_DirsListingsMutex = SDL_CreateMutex();
+  }
 }
 
 void XMFS::uninit() {
+  saveDirsListings();
+  m_DirsListings.clear();
+  if (m_DirsListingsMutex != NULL) {
+    SDL_DestroyMutex(m_DirsListingsMutex);
+    m_DirsListingsMutex = NULL;
+  }
+
+  clearPackFilesData();
+  unmapPackage();
 #ifndef WIN32
   if (m_xdgHd != NULL) {
     xdgWipeHandle(m_xdgHd);
@@ -1519,6 +1596,11 @@ void XMFS::writeFloat_LE(FileHandle *pfh, float v) {
   writeFloat(pfh, SwapEndian::LittleFloat(v));
 }
 
+void XMFS::writeInt64_LE(FileHandle *pfh, long long v) {
+  writeInt_LE(pfh, (int)(v & 0xFFFFFFFF));
+  writeInt_LE(pfh, (int)(v >> 32));
+}
+
 int XMFS::readShort_LE(FileHandle *pfh) {
   short v = readShort(pfh);
   return SwapEndian::LittleShort(v);
@@ -1610,20 +1692,331 @@ std::string XMFS::md5sum(FileDataType i_fdt, std::string i_filePath) {
 
   if (i_fdt == FDT_DATA) {
     /* package */
-    for (unsigned int i = 0; i < m_PackFiles.size(); i++) {
-      if (m_PackFiles[i].Name == i_filePath ||
-          (std::string("./") + m_PackFiles[i].Name) == i_filePath) {
-        /* Found it, yeah. */
-        // printf("md5sum(%s) = %s\n", m_PackFiles[i].Name.c_str(),
-        // m_PackFiles[i].md5sum.c_str());
-        return m_PackFiles[i].md5sum;
-      }
+    const PackFile *v_packFile = findPackFile(i_filePath);
+
+    if (v_packFile != NULL) {
+      return v_packFile->md5sum;
     }
   }
 
   return "";
 }
 
+void XMFS::readPackageDirectory(bool i_graphics) {
+  BinaryReader v_reader;
+  PackFile v_packFile;
+  char v_magic[4];
+  int v_nbFiles;
+  size_t v_extension_place;
+  std::string v_extension;
+
+  v_reader.openView(m_BinDataFile, m_BinData, m_BinDataSize);
+
+  try {
+    v_reader.readBuf(v_magic, 4);
+    if (strncmp(v_magic, "XBI4", 4) != 0) {
+      throw Exception("Invalid binary data package format");
+    }
+
+    /* get bin checksum of the package.list */
+    m_binCheckSum = v_reader.readString();
+
+    v_nbFiles = v_reader.readInt_LE();
+    for (int i = 0; i < v_nbFiles; i++) {
+      v_packFile.Name = v_reader.readString();
+      v_packFile.md5sum = v_reader.readString();
+      v_packFile.nOffset = v_reader.readInt64_LE();
+      v_packFile.nSize = v_reader.readInt_LE();
+      v_packFile.nPackedSize = v_reader.readInt_LE();
+      v_packFile.nCRC = (unsigned int)v_reader.readInt_LE();
+      v_packFile.Compression = (PackCompression)v_reader.readByte();
+
+      if (v_packFile.nOffset < 0 || v_packFile.nSize < 0 ||
+          v_packFile.nPackedSize < 0 ||
+          v_packFile.nOffset + v_packFile.nPackedSize > m_BinDataSize ||
+          (v_packFile.Compression != PACK_STORED &&
+           v_packFile.Compression != PACK_ZLIB) ||
+          (v_packFile.Compression == PACK_STORED &&
+           v_packFile.nPackedSize != v_packFile.nSize)) {
+        throw Exception("Invalid binary data package format");
+      }
+
+      v_extension = "";
+      v_extension_place = v_packFile.Name.rfind(".");
+      if (v_extension_place != std::string::npos) {
+        v_extension = v_packFile.Name.substr(v_extension_place + 1);
+      }
+
+      // don't add unuseful graphics files
+      if (i_graphics || (v_extension != "png" && // picture
+                         v_extension != "jpg" && // picture
+                         v_extension != "frag" && // graphical card files
+                         v_extension != "vert" && // graphical card files
+                         v_extension != "ogg" && // music
+                         v_extension != "wav" // sound
+                         )) {
+        // the first file of a name is used
+        m_PackFilesIndex.insert(
+          std::make_pair(v_packFile.Name, (unsigned int)m_PackFiles.size()));
+        m_PackFiles.push_back(v_packFile);
+      }
+    }
+  } catch (Exception &e) {
+    throw Exception("Invalid binary data package format");
+  }
+
+  m_PackFilesData.assign(m_PackFiles.size(), NULL);
+  m_PackFilesNbHandles.assign(m_PackFiles.size(), 0);
+  if (m_PackFilesDataMutex == NULL) {
+    m_PackFilesDataMutex = SDL_CreateMutex();
+  }
+}
+
+const char *XMFS::loadPackFile(const PackFile *i_packFile) {
+  unsigned int v_index = i_packFile - &m_PackFiles[0];
+  const char *v_data;
+  char *v_buffer = NULL;
+
+  SDL_LockMutex(m_PackFilesDataMutex);
+  v_data = m_PackFilesData[v_index];
+  if (v_data != NULL) {
+    m_PackFilesNbHandles[v_index]++;
+  }
+  SDL_UnlockMutex(m_PackFilesDataMutex);
+  if (v_data != NULL) {
+    return v_data;
+  }
+
+  // outside of the lock : other files can be loaded at the same time
+  v_data = m_BinData + i_packFile->nOffset;
+  if (i_packFile->Compression == PACK_ZLIB) {
+    uLongf v_size = i_packFile->nSize;
+
+    v_buffer = new char[i_packFile->nSize + 1];
+    if (uncompress((Bytef *)v_buffer,
+                   &v_size,
+                   (const Bytef *)v_data,
+                   i_packFile->nPackedSize) != Z_OK ||
+        v_size != (uLongf)i_packFile->nSize) {
+      delete[] v_buffer;
+      LogError("Packaged file %s can't be uncompressed",
+               i_packFile->Name.c_str());
+      return NULL;
+    }
+    v_data = v_buffer;
+  }
+
+  if (crc32(0L, (const Bytef *)v_data, i_packFile->nSize) !=
+      i_packFile->nCRC) {
+    delete[] v_buffer;
+    LogError("Packaged file %s is corrupted", i_packFile->Name.c_str());
+    return NULL;
+  }
+
+  SDL_LockMutex(m_PackFilesDataMutex);
+  if (m_PackFilesData[v_index] == NULL) {
+    m_PackFilesData[v_index] = v_data;
+  } else {
+    // loaded by another thread meanwhile
+    delete[] v_buffer;
+    v_data = m_PackFilesData[v_index];
+  }
+  m_PackFilesNbHandles[v_index]++;
+  SDL_UnlockMutex(m_PackFilesDataMutex);
+
+  return v_data;
+}
+
+void XMFS::releasePackFile(unsigned int i_index) {
+  SDL_LockMutex(m_PackFilesDataMutex);
+  if (m_PackFilesNbHandles[i_index] > 0) {
+    m_PackFilesNbHandles[i_index]--;
+  }
+  if (m_PackFilesNbHandles[i_index] == 0 &&
+      m_PackFiles[i_index].Compression != PACK_STORED) {
+    delete[] m_PackFilesData[i_index];
+    m_PackFilesData[i_index] = NULL;
+  }
+  SDL_UnlockMutex(m_PackFilesDataMutex);
+}
+
+void XMFS::clearPackFilesData() {
+  for (unsigned int i = 0; i < m_PackFilesData.size(); i++) {
+    if (m_PackFiles[i].Compression != PACK_STORED) {
+      delete[] m_PackFilesData[i];
+    }
+  }
+  m_PackFilesData.clear();
+  m_PackFilesNbHandles.clear();
+
+  if (m_PackFilesDataMutex != NULL) {
+    SDL_DestroyMutex(m_PackFilesDataMutex);
+    m_PackFilesDataMutex = NULL;
+  }
+}
+
+#define XMFS_DIRS_CACHE_FILE "dirs.cache"
+#define XMFS_DIRS_CACHE_VERSION 1
+
+void XMFS::loadDirsListings() {
+  BinaryReader v_reader;
+  int v_nbDirs, v_nb;
+
+  m_DirsListings.clear();
+  m_DirsListingsChanged = false;
+
+  try {
+    if (v_reader.open(FDT_CACHE, XMFS_DIRS_CACHE_FILE) == false ||
+        v_reader.readInt_LE() != XMFS_DIRS_CACHE_VERSION) {
+      return;
+    }
+
+    v_nbDirs = v_reader.readInt_LE();
+    for (int i = 0; i < v_nbDirs; i++) {
+      DirListing &v_listing = m_DirsListings[v_reader.readLongString()];
+
+      v_listing.mtime = v_reader.readInt64_LE();
+      v_listing.inode = v_reader.readInt64_LE();
+      v_nb = v_reader.readInt_LE();
+      for (int j = 0; j < v_nb; j++) {
+        v_listing.files.push_back(v_reader.readLongString());
+      }
+      v_nb = v_reader.readInt_LE();
+      for (int j = 0; j < v_nb; j++) {
+        v_listing.dirs.push_back(v_reader.readLongString());
+      }
+    }
+  } catch (Exception &e) {
+    LogWarning("Invalid directories cache (%s)", e.getMsg().c_str());
+    m_DirsListings.clear();
+  }
+}
+
+void XMFS::saveDirsListings() {
+  std::unordered_map<std::string, DirListing>::const_iterator v_it;
+  FileHandle *pfh;
+
+  if (m_DirsListingsChanged == false) {
+    return;
+  }
+
+  pfh = openOFile(FDT_CACHE, XMFS_DIRS_CACHE_FILE);
+  if (pfh == NULL) {
+    LogWarning("Unable to save the directories cache");
+    return;
+  }
+
+  try {
+    writeInt_LE(pfh, XMFS_DIRS_CACHE_VERSION);
+    writeInt_LE(pfh, m_DirsListings.size());
+    for (v_it = m_DirsListings.begin(); v_it != m_DirsListings.end(); v_it++) {
+      writeLongString(pfh, v_it->first);
+      writeInt64_LE(pfh, v_it->second.mtime);
+      writeInt64_LE(pfh, v_it->second.inode);
+      writeInt_LE(pfh, v_it->second.files.size());
+      for (unsigned int i = 0; i < v_it->second.files.size(); i++) {
+        writeLongString(pfh, v_it->second.files[i]);
+      }
+      writeInt_LE(pfh, v_it->second.dirs.size());
+      for (unsigned int i = 0; i < v_it->second.dirs.size(); i++) {
+        writeLongString(pfh, v_it->second.dirs[i]);
+      }
+    }
+    m_DirsListingsChanged = false;
+  } catch (Exception &e) {
+    LogWarning("Unable to save the directories cache (%s)",
+               e.getMsg().c_str());
+  }
+  closeFile(pfh);
+}
+
+const PackFile *XMFS::findPackFile(const std::string &i_path) {
+  std::unordered_map<std::string, unsigned int>::const_iterator v_it;
+  unsigned int v_start = 0;
+
+  // remove all ./ of the path
+  while (i_path.compare(v_start, 2, "./") == 0) {
+    v_start += 2;
+  }
+
+  v_it = m_PackFilesIndex.find(i_path.substr(v_start));
+  if (v_it == m_PackFilesIndex.end()) {
+    return NULL;
+  }
+  return &m_PackFiles[v_it->second];
+}
+
+void XMFS::mapPackage() {
+#ifdef WIN32
+  HANDLE v_file, v_mapping;
+  LARGE_INTEGER v_size;
+
+  v_file = CreateFileA(m_BinDataFile.c_str(),
+                       GENERIC_READ,
+                       FILE_SHARE_READ,
+                       NULL,
+                       OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL,
+                       NULL);
+  if (v_file == INVALID_HANDLE_VALUE) {
+    throw Exception("Unable to map the package " + m_BinDataFile);
+  }
+  if (GetFileSizeEx(v_file, &v_size) == 0) {
+    CloseHandle(v_file);
+    throw Exception("Unable to map the package " + m_BinDataFile);
+  }
+
+  // the view keeps the mapping and the file opened
+  v_mapping = CreateFileMapping(v_file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(v_file);
+  if (v_mapping == NULL) {
+    throw Exception("Unable to map the package " + m_BinDataFile);
+  }
+  m_BinData = (const char *)MapViewOfFile(v_mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(v_mapping);
+  if (m_BinData == NULL) {
+    throw Exception("Unable to map the package " + m_BinDataFile);
+  }
+  m_BinDataSize = (long)v_size.QuadPart;
+#else
+  struct stat v_stat;
+  void *v_data;
+  int v_fd;
+
+  v_fd = open(m_BinDataFile.c_str(), O_RDONLY);
+  if (v_fd < 0) {
+    throw Exception("Unable to map the package " + m_BinDataFile);
+  }
+  if (fstat(v_fd, &v_stat) != 0) {
+    close(v_fd);
+    throw Exception("Unable to map the package " + m_BinDataFile);
+  }
+
+  // the mapping stays valid once the file is closed
+  v_data = mmap(NULL, v_stat.st_size, PROT_READ, MAP_PRIVATE, v_fd, 0);
+  close(v_fd);
+  if (v_data == MAP_FAILED) {
+    throw Exception("Unable to map the package " + m_BinDataFile);
+  }
+  m_BinData = (const char *)v_data;
+  m_BinDataSize = (long)v_stat.st_size;
+#endif
+}
+
+void XMFS::unmapPackage() {
+  if (m_BinData == NULL) {
+    return;
+  }
+
+#ifdef WIN32
+  UnmapViewOfFile(m_BinData);
+#else
+  munmap((void *)m_BinData, m_BinDataSize);
+#endif
+  m_BinData = NULL;
+  m_BinDataSize = 0;
+}
+
 bool XMFS::isFileReal(const std::string &i_filePath) {
   FILE *fp;
 
@@ -22,12 +22,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define __VFILEIO_H__
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #ifndef WIN32
 #include <basedir.h>
 #endif
 #include "VFileIO_types.h"
 
+struct SDL_mutex;
+
 /*===========================================================================
   File handle types
   ===========================================================================*/
@@ -36,12 +39,45 @@ enum FileHandleType { FHT_UNASSIGNED, FHT_STDIO, FHT_PACKAGE };
 /*===========================================================================
   Packaged files
   ===========================================================================*/
+enum PackCompression { PACK_STORED = 0, PACK_ZLIB = 1 };
+
 struct PackFile {
-  PackFile() { nSize = nOffset = 0; }
+  PackFile() {
+    nOffset = 0;
+    nSize = nPackedSize = 0;
+    nCRC = 0;
+    Compression = PACK_STORED;
+  }
 
   std::string Name;
   std::string md5sum;
-  int nSize, nOffset;
+  long long nOffset; /* from the start of the package */
+  int nSize, nPackedSize; /* uncompressed and in the package */
+  unsigned int nCRC; /* crc32 of the uncompressed data */
+  PackCompression Compression;
+};
+
+/*===========================================================================
+  Signature of a real file, to know whether it changed without reading it
+  ===========================================================================*/
+struct FileStatSignature {
+  FileStatSignature() { size = mtime = inode = 0; }
+
+  long long size;
+  long long mtime;
+  long long inode;
+};
+
+/*===========================================================================
+  Content of a real directory, kept while its mtime doesn't change
+  ===========================================================================*/
+struct DirListing {
+  DirListing() { mtime = inode = 0; }
+
+  long long mtime;
+  long long inode;
+  std::vector<std::string> files;
+  std::vector<std::string> dirs;
 };
 
 /*===========================================================================
@@ -52,6 +88,9 @@ struct FileHandle {
     Type = FHT_UNASSIGNED;
     nRead = nWrite = nSize = 0;
     fp = NULL;
+    pData = NULL;
+    nPackFile = -1;
+    nPos = 0;
     bRead = bWrite = false;
   }
 
@@ -65,7 +104,11 @@ struct FileHandle {
 
   FILE *fp; /* File pointer for I/O */
 
-  int nOffset; /* in package */
+  /* packaged file : view in the mapped package, or in its uncompressed
+     data, valid while the handle is open */
+  const char *pData;
+  int nPackFile;
+  int nPos;
 
   /* I/O mode */
   bool bRead, bWrite;
@@ -97,6 +140,11 @@ public:
     bool mkdirs = false);
 
   static bool moveFile(const std::string &From, const std::string &To);
+  /* rename From over To, in the user dir if relative ; the readers of To
+     get either the old file or the new one */
+  static bool replaceFile(FileDataType i_fdt,
+                          const std::string &From,
+                          const std::string &To);
 
   static void deleteFile(FileDataType i_fdt, const std::string &File);
 
@@ -117,6 +165,9 @@ public:
   static int getLength(FileHandle *pfh);
   static bool isEnd(FileHandle *pfh);
   static std::string readFileToEnd(FileHandle *pfh);
+  /* remaining data of a packaged file, read without copy ; NULL for the
+     other files */
+  static const char *getFileView(FileHandle *pfh, int &o_size);
   static bool readNextLine(FileHandle *pfh,
                            std::string &Line); /* uses buffered reading */
   static int readByte(FileHandle *pfh);
@@ -144,6 +195,7 @@ public:
   static void writeShort_LE(FileHandle *pfh, short v);
   static void writeInt_LE(FileHandle *pfh, int v);
   static void writeFloat_LE(FileHandle *pfh, float v);
+  static void writeInt64_LE(FileHandle *pfh, long long v);
   static int readShort_LE(FileHandle *pfh);
   static int readInt_LE(FileHandle *pfh);
   static float readFloat_LE(FileHandle *pfh);
@@ -168,6 +220,10 @@ public:
   static bool isDir(const std::string &AppDir);
 
   static int getFileTimeStamp(const std::string &Path);
+  /* return false if the file is not a real file (ie in the package) */
+  static bool getFileStatSignature(FileDataType i_fdt,
+                                   const std::string &i_filePath,
+                                   FileStatSignature &o_signature);
   static bool isPathAbsolute(const std::string &Path);
 
   static int mkDir(const char *pcPath);
@@ -175,6 +231,8 @@ public:
   /* Data interfaces */
   static std::string getUserDir(FileDataType i_fdt);
   static std::string getUserDirUTF8(FileDataType i_fdt);
+  /* benchmarks only : no other thread must use the cache meanwhile */
+  static void setUserCacheDir(const std::string &i_dir);
   static std::string getSystemDataDir();
   static std::string getSystemLocaleDir();
   static bool isSystemDataDirAvailable() { return m_bGotSystemDataDir; }
@@ -218,9 +276,14 @@ private:
 
   /* Helper functions */
   static void _ThrowFileError(FileHandle *pfh, const std::string &Description);
-  static void _FindFilesRecursive(const std::string &Dir,
-                                  const std::string &Wildcard,
-                                  std::vector<std::string> &List);
+  static bool listDir(const std::string &i_dir,
+                      std::vector<std::string> &o_files,
+                      std::vector<std::string> &o_dirs);
+  static void findFilesInDir(void *i_search, unsigned int i_dir);
+  static void findFiles(const std::vector<std::string> &i_dirs,
+                        const std::string &i_wildcard,
+                        bool i_recurse,
+                        std::vector<std::string> &io_files);
 
   /* Data */
   static std::string m_UserDataDir, m_UserDataDirUTF8, m_UserConfigDir,
@@ -229,8 +292,36 @@ private:
 
   static std::string m_BinDataFile;
   static std::vector<PackFile> m_PackFiles;
+  static std::unordered_map<std::string, unsigned int> m_PackFilesIndex;
   static std::string m_binCheckSum;
 
+  /* the package is mapped in memory once, the packaged files are views */
+  static const char *m_BinData;
+  static long m_BinDataSize;
+  static void mapPackage();
+  static void unmapPackage();
+  static const PackFile *findPackFile(const std::string &i_path);
+  static void readPackageDirectory(bool i_graphics);
+
+  /* data of the packaged files, checked (and uncompressed) when they are
+     opened ; the uncompressed data is freed when their last handle is
+     closed, the stored data stays in the mapped package */
+  static std::vector<const char *> m_PackFilesData;
+  static std::vector<unsigned int> m_PackFilesNbHandles;
+  static SDL_mutex *m_PackFilesDataMutex;
+  static const char *loadPackFile(const PackFile *i_packFile);
+  static void releasePackFile(unsigned int i_index);
+  static void clearPackFilesData();
+
+  /* listings of the directories searched by findPhysFiles, saved in the
+     cache directory ; a directory is still stat'ed each time, its mtime
+     doesn't tell whether its subdirectories changed */
+  static std::unordered_map<std::string, DirListing> m_DirsListings;
+  static bool m_DirsListingsChanged;
+  static SDL_mutex *m_DirsListingsMutex;
+  static void loadDirsListings();
+  static void saveDirsListings();
+
   // migrate from .xmoto to xdg base directories
   static void migrateFSToXdgBaseDirIfRequired(const std::string &AppDir);
   static void migrateFSToXdgBaseDirFile(const std::string &i_src,
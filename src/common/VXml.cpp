@@ -64,15 +64,23 @@ void XMLDocument::readFromFile(FileDataType i_fdt,
   } else {
     FileHandle *pfh;
     std::string v_xmlstr;
+    const char *v_view;
+    int v_size;
 
     pfh = XMFS::openIFile(i_fdt, File, i_includeCurrentDir);
     if (pfh == NULL) {
       throw Exception("failed to load XML " + File);
     }
-    v_xmlstr = XMFS::readFileToEnd(pfh);
-    XMFS::closeFile(pfh);
 
-    m_doc = xmlParseMemory(v_xmlstr.c_str(), v_xmlstr.length());
+    // parse packaged files in place
+    v_view = XMFS::getFileView(pfh, v_size);
+    if (v_view != NULL) {
+      m_doc = xmlParseMemory(v_view, v_size);
+    } else {
+      v_xmlstr = XMFS::readFileToEnd(pfh);
+      m_doc = xmlParseMemory(v_xmlstr.c_str(), v_xmlstr.length());
+    }
+    XMFS::closeFile(pfh);
   }
 
   if (m_doc == NULL) {
@@ -80,6 +88,20 @@ void XMLDocument::readFromFile(FileDataType i_fdt,
   }
 }
 
+void XMLDocument::readFromMemory(const char *i_data,
+                                 int i_size,
+                                 const std::string &i_name) {
+  if (m_doc != NULL) {
+    xmlFreeDoc(m_doc);
+    m_doc = NULL;
+  }
+
+  m_doc = xmlParseMemory(i_data, i_size);
+  if (m_doc == NULL) {
+    throw Exception("failed to load XML " + i_name);
+  }
+}
+
 xmlNodePtr XMLDocument::getRootNode(const char *rootNameToCheck) {
   char *vc = (char *)rootNameToCheck;
   xmlChar *xvc = (xmlChar *)vc;
@@ -200,3 +222,126 @@ std::string XMLDocument::str2xmlstr(std::string str) {
   }
   return v_res;
 }
+
+XMLStreamReader::XMLStreamReader() {
+  m_reader = NULL;
+  m_file = NULL;
+}
+
+XMLStreamReader::~XMLStreamReader() {
+  close();
+}
+
+void XMLStreamReader::close() {
+  if (m_reader != NULL) {
+    xmlFreeTextReader(m_reader);
+    m_reader = NULL;
+  }
+
+  // in case libxml didn't close it
+  if (m_file != NULL) {
+    XMFS::closeFile(m_file);
+    m_file = NULL;
+  }
+}
+
+int XMLStreamReader::readCallback(void *context, char *buffer, int len) {
+  XMLStreamReader *v_stream = (XMLStreamReader *)context;
+  int v_remaining;
+
+  v_remaining =
+    XMFS::getLength(v_stream->m_file) - XMFS::getOffset(v_stream->m_file);
+  if (len > v_remaining) {
+    len = v_remaining;
+  }
+  if (len <= 0) {
+    return 0;
+  }
+
+  if (XMFS::readBuf(v_stream->m_file, buffer, len) == false) {
+    return -1;
+  }
+  return len;
+}
+
+int XMLStreamReader::closeCallback(void *context) {
+  XMLStreamReader *v_stream = (XMLStreamReader *)context;
+
+  if (v_stream->m_file != NULL) {
+    XMFS::closeFile(v_stream->m_file);
+    v_stream->m_file = NULL;
+  }
+  return 0;
+}
+
+void XMLStreamReader::openFile(FileDataType i_fdt,
+                               std::string File,
+                               bool i_includeCurrentDir) {
+  close();
+  m_fileName = File;
+
+  // directly open the file
+  if (XMFS::doesRealFileOrDirectoryExists(File)) {
+    m_reader = xmlReaderForFile(File.c_str(), NULL, 0);
+  } else {
+    m_file = XMFS::openIFile(i_fdt, File, i_includeCurrentDir);
+    if (m_file == NULL) {
+      throw Exception("failed to load XML " + File);
+    }
+
+    m_reader = xmlReaderForIO(XMLStreamReader::readCallback,
+                              XMLStreamReader::closeCallback,
+                              this,
+                              File.c_str(),
+                              NULL,
+                              0);
+  }
+
+  if (m_reader == NULL) {
+    close();
+    throw Exception("failed to load XML " + File);
+  }
+}
+
+bool XMLStreamReader::nextElement(int i_depth) {
+  int v_res;
+
+  if (m_reader == NULL) {
+    return false;
+  }
+
+  while ((v_res = xmlTextReaderRead(m_reader)) == 1) {
+    if (xmlTextReaderNodeType(m_reader) == XML_READER_TYPE_ELEMENT &&
+        xmlTextReaderDepth(m_reader) == i_depth) {
+      return true;
+    }
+  }
+
+  if (v_res < 0) {
+    throw Exception("failed to read XML " + m_fileName);
+  }
+  return false;
+}
+
+std::string XMLStreamReader::elementName() {
+  const xmlChar *v_name = xmlTextReaderConstName(m_reader);
+
+  if (v_name == NULL) {
+    return "";
+  }
+  return std::string((const char *)v_name);
+}
+
+std::string XMLStreamReader::getOption(const char *name, std::string Default) {
+  xmlChar *v_value;
+  std::string v_res;
+
+  v_value = xmlTextReaderGetAttribute(m_reader, (const xmlChar *)name);
+  if (v_value == NULL) {
+    return Default;
+  }
+
+  v_res = (const char *)v_value;
+  xmlFree(v_value);
+  return v_res;
+}
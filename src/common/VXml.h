@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "VFileIO_types.h"
 #include <libxml/parser.h>
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 #include <string>
 
 class XMLDocument {
@@ -38,6 +39,10 @@ public:
   void readFromFile(FileDataType i_fdt,
                     std::string File,
                     bool i_includeCurrentDir = false);
+  // i_name is only used for the errors
+  void readFromMemory(const char *i_data,
+                      int i_size,
+                      const std::string &i_name);
 
   xmlNodePtr getRootNode(const char *rootNameToCheck = NULL);
 
@@ -60,4 +65,35 @@ private:
   xmlDocPtr m_doc;
 };
 
+struct FileHandle;
+
+/*
+  forward only reader for big documents : the elements are read one by one,
+  the document is never loaded completely in memory
+*/
+class XMLStreamReader {
+public:
+  XMLStreamReader();
+  ~XMLStreamReader();
+
+  void openFile(FileDataType i_fdt,
+                std::string File,
+                bool i_includeCurrentDir = false);
+
+  // go to the next element at the depth i_depth (0 for the root node) ;
+  // return false at the end of the document
+  bool nextElement(int i_depth);
+  std::string elementName();
+  std::string getOption(const char *name, std::string Default = "");
+
+private:
+  void close();
+  static int readCallback(void *context, char *buffer, int len);
+  static int closeCallback(void *context);
+
+  xmlTextReaderPtr m_reader;
+  FileHandle *m_file;
+  std::string m_fileName;
+};
+
 #endif
@@ -0,0 +1,824 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "VXmlLight.h"
+#include "VFileIO.h"
+#include "VXml.h"
+#include "helpers/VExcept.h"
+#include <string.h>
+
+static bool isXMLSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isXMLNameEnd(char c) {
+  return isXMLSpace(c) || c == '>' || c == '/' || c == '=' || c == '\0';
+}
+
+static bool isXMLChar(unsigned int c) {
+  return c == 0x9 || c == 0xA || c == 0xD || (c >= 0x20 && c <= 0xD7FF) ||
+         (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF);
+}
+
+static bool isXMLNameStartChar(unsigned int c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+         c == ':' || (c >= 0xC0 && c <= 0xD6) || (c >= 0xD8 && c <= 0xF6) ||
+         (c >= 0xF8 && c <= 0x2FF) || (c >= 0x370 && c <= 0x37D) ||
+         (c >= 0x37F && c <= 0x1FFF) || (c >= 0x200C && c <= 0x200D) ||
+         (c >= 0x2070 && c <= 0x218F) || (c >= 0x2C00 && c <= 0x2FEF) ||
+         (c >= 0x3001 && c <= 0xD7FF) || (c >= 0xF900 && c <= 0xFDCF) ||
+         (c >= 0xFDF0 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0xEFFFF);
+}
+
+static bool isXMLNameChar(unsigned int c) {
+  return isXMLNameStartChar(c) || (c >= '0' && c <= '9') || c == '-' ||
+         c == '.' || c == 0xB7 || (c >= 0x300 && c <= 0x36F) ||
+         (c >= 0x203F && c <= 0x2040);
+}
+
+/* the names libxml2 accepts ; i_name is valid utf-8 */
+static bool isXMLName(const char *i_name, int i_length) {
+  const unsigned char *s = (const unsigned char *)i_name;
+  unsigned int v_char;
+  int n, i = 0;
+
+  if (i_length == 0) {
+    return false;
+  }
+
+  while (i < i_length) {
+    if (s[i] >= 0xF0) {
+      n = 3;
+      v_char = s[i] & 0x07;
+    } else if (s[i] >= 0xE0) {
+      n = 2;
+      v_char = s[i] & 0x0F;
+    } else if (s[i] >= 0xC0) {
+      n = 1;
+      v_char = s[i] & 0x1F;
+    } else {
+      n = 0;
+      v_char = s[i];
+    }
+    for (int k = 1; k <= n; k++) {
+      v_char = (v_char << 6) | (s[i + k] & 0x3F);
+    }
+
+    if (i == 0 ? isXMLNameStartChar(v_char) == false
+               : isXMLNameChar(v_char) == false) {
+      return false;
+    }
+    i += n + 1;
+  }
+
+  return true;
+}
+
+/* libxml2 refuses the invalid utf-8 sequences and the control characters */
+static bool isValidUTF8(const char *i_data, int i_size) {
+  const unsigned char *s = (const unsigned char *)i_data;
+  unsigned int v_char;
+  int n, i = 0;
+
+  while (i < i_size) {
+    if (s[i] < 0x80) {
+      if (isXMLChar(s[i]) == false) {
+        return false;
+      }
+      i++;
+      continue;
+    }
+
+    if ((s[i] & 0xE0) == 0xC0) {
+      n = 1;
+      v_char = s[i] & 0x1F;
+    } else if ((s[i] & 0xF0) == 0xE0) {
+      n = 2;
+      v_char = s[i] & 0x0F;
+    } else if ((s[i] & 0xF8) == 0xF0) {
+      n = 3;
+      v_char = s[i] & 0x07;
+    } else {
+      return false;
+    }
+    if (i + n >= i_size) {
+      return false;
+    }
+    for (int k = 1; k <= n; k++) {
+      if ((s[i + k] & 0xC0) != 0x80) {
+        return false;
+      }
+      v_char = (v_char << 6) | (s[i + k] & 0x3F);
+    }
+
+    // overlong sequences
+    if ((n == 1 && v_char < 0x80) || (n == 2 && v_char < 0x800) ||
+        (n == 3 && v_char < 0x10000) || isXMLChar(v_char) == false) {
+      return false;
+    }
+    i += n + 1;
+  }
+
+  return true;
+}
+
+static int encodeUTF8(unsigned int i_char, char *o_buf) {
+  if (i_char < 0x80) {
+    o_buf[0] = i_char;
+    return 1;
+  }
+  if (i_char < 0x800) {
+    o_buf[0] = 0xC0 | (i_char >> 6);
+    o_buf[1] = 0x80 | (i_char & 0x3F);
+    return 2;
+  }
+  if (i_char < 0x10000) {
+    o_buf[0] = 0xE0 | (i_char >> 12);
+    o_buf[1] = 0x80 | ((i_char >> 6) & 0x3F);
+    o_buf[2] = 0x80 | (i_char & 0x3F);
+    return 3;
+  }
+  o_buf[0] = 0xF0 | (i_char >> 18);
+  o_buf[1] = 0x80 | ((i_char >> 12) & 0x3F);
+  o_buf[2] = 0x80 | ((i_char >> 6) & 0x3F);
+  o_buf[3] = 0x80 | (i_char & 0x3F);
+  return 4;
+}
+
+/* decode the references and the new lines of io_buf[i_begin, i_end[ in place
+   (the decoded string is never longer) ; return the end of the decoded
+   string, -1 if libxml2 is required */
+static int decodeXMLString(char *io_buf,
+                           int i_begin,
+                           int i_end,
+                           bool i_attribute) {
+  int w = i_begin;
+  int r = i_begin;
+
+  while (r < i_end) {
+    char c = io_buf[r];
+
+    if (c == '&') {
+      const char *v_ref = io_buf + r + 1;
+      int v_len = 0;
+
+      while (r + 1 + v_len < i_end && v_ref[v_len] != ';') {
+        v_len++;
+      }
+      if (r + 1 + v_len >= i_end) {
+        return -1;
+      }
+
+      if (v_len == 2 && strncmp(v_ref, "lt", 2) == 0) {
+        io_buf[w++] = '<';
+      } else if (v_len == 2 && strncmp(v_ref, "gt", 2) == 0) {
+        io_buf[w++] = '>';
+      } else if (v_len == 3 && strncmp(v_ref, "amp", 3) == 0) {
+        io_buf[w++] = '&';
+      } else if (v_len == 4 && strncmp(v_ref, "quot", 4) == 0) {
+        io_buf[w++] = '"';
+      } else if (v_len == 4 && strncmp(v_ref, "apos", 4) == 0) {
+        io_buf[w++] = '\'';
+      } else if (v_len >= 2 && v_ref[0] == '#') {
+        unsigned int v_char = 0;
+        int k = 1;
+        bool v_hexa = v_ref[1] == 'x';
+
+        if (v_hexa) {
+          k++;
+        }
+        if (k >= v_len) {
+          return -1;
+        }
+        for (; k < v_len; k++) {
+          c = v_ref[k];
+          if (c >= '0' && c <= '9') {
+            v_char = v_char * (v_hexa ? 16 : 10) + (c - '0');
+          } else if (v_hexa && c >= 'a' && c <= 'f') {
+            v_char = v_char * 16 + (c - 'a' + 10);
+          } else if (v_hexa && c >= 'A' && c <= 'F') {
+            v_char = v_char * 16 + (c - 'A' + 10);
+          } else {
+            return -1;
+          }
+          if (v_char > 0x10FFFF) {
+            return -1;
+          }
+        }
+        if (isXMLChar(v_char) == false) {
+          return -1;
+        }
+        w += encodeUTF8(v_char, io_buf + w);
+      } else {
+        // entities of a dtd
+        return -1;
+      }
+      r += v_len + 2;
+
+    } else if (c == '\r') {
+      io_buf[w++] = i_attribute ? ' ' : '\n';
+      r++;
+      if (r < i_end && io_buf[r] == '\n') {
+        r++;
+      }
+
+    } else if (c == '<') {
+      return -1;
+
+    } else if (i_attribute == false && c == ']' && r + 2 < i_end &&
+               io_buf[r + 1] == ']' && io_buf[r + 2] == '>') {
+      return -1;
+
+    } else {
+      if (i_attribute && (c == '\n' || c == '\t')) {
+        c = ' ';
+      }
+      io_buf[w++] = c;
+      r++;
+    }
+  }
+
+  return w;
+}
+
+/* only utf-8 is parsed here */
+static bool isUTF8Declaration(const char *i_decl, int i_length) {
+  std::string v_decl(i_decl, i_length);
+  std::string v_encoding;
+  size_t v_pos;
+  char v_quote;
+
+  v_pos = v_decl.find("encoding");
+  if (v_pos == std::string::npos) {
+    return true;
+  }
+
+  v_pos = v_decl.find_first_of("\"'", v_pos);
+  if (v_pos == std::string::npos) {
+    return false;
+  }
+  v_quote = v_decl[v_pos];
+  for (v_pos++; v_pos < v_decl.length() && v_decl[v_pos] != v_quote;
+       v_pos++) {
+    v_encoding += tolower(v_decl[v_pos]);
+  }
+
+  return v_encoding == "utf-8" || v_encoding == "utf8";
+}
+
+XMLLightDocument::XMLLightDocument() {
+  m_root = -1;
+}
+
+void XMLLightDocument::clear() {
+  m_buffer.clear();
+  m_nodes.clear();
+  m_attributes.clear();
+  m_root = -1;
+}
+
+void XMLLightDocument::readFromFile(FileDataType i_fdt,
+                                    std::string File,
+                                    bool i_includeCurrentDir) {
+  FileHandle *pfh;
+  std::string v_xmlstr;
+  const char *v_data;
+  int v_size;
+
+  pfh = XMFS::openIFile(i_fdt, File, i_includeCurrentDir);
+  if (pfh == NULL) {
+    throw Exception("failed to load XML " + File);
+  }
+
+  v_data = XMFS::getFileView(pfh, v_size);
+  if (v_data == NULL) {
+    v_xmlstr = XMFS::readFileToEnd(pfh);
+    v_data = v_xmlstr.c_str();
+    v_size = v_xmlstr.length();
+  }
+
+  try {
+    if (parse(v_data, v_size) == false) {
+      XMLDocument v_xml;
+
+      v_xml.readFromMemory(v_data, v_size, File);
+      readFromDOM(v_xml.getRootNode());
+    }
+  } catch (Exception &e) {
+    XMFS::closeFile(pfh);
+    throw e;
+  }
+
+  XMFS::closeFile(pfh);
+}
+
+int XMLLightDocument::addNode(int i_parent, int i_name) {
+  XMLLightNode v_node;
+  int v_index = m_nodes.size();
+
+  v_node.doc = this;
+  v_node.name = i_name;
+  v_node.text = -1;
+  v_node.textLength = 0;
+  v_node.firstAttribute = m_attributes.size() / 2;
+  v_node.nbAttributes = 0;
+  v_node.firstChild = -1;
+  v_node.lastChild = -1;
+  v_node.next = -1;
+  m_nodes.push_back(v_node);
+
+  if (i_parent != -1) {
+    XMLLightNode &v_parent = m_nodes[i_parent];
+
+    if (v_parent.lastChild == -1) {
+      v_parent.firstChild = v_index;
+    } else {
+      m_nodes[v_parent.lastChild].next = v_index;
+    }
+    v_parent.lastChild = v_index;
+  }
+
+  return v_index;
+}
+
+int XMLLightDocument::addString(const char *i_str, int i_length) {
+  int v_offset = m_buffer.size();
+
+  m_buffer.insert(m_buffer.end(), i_str, i_str + i_length);
+  m_buffer.push_back('\0');
+  return v_offset;
+}
+
+void XMLLightDocument::addText(int i_parent, int i_text, int i_length) {
+  int v_node = addNode(i_parent, -1);
+
+  m_nodes[v_node].text = i_text;
+  m_nodes[v_node].textLength = i_length;
+}
+
+bool XMLLightDocument::parse(const char *i_data, int i_size) {
+  std::vector<int> v_openElements;
+  const char *v_end;
+  char *s;
+  int p = 0;
+
+  clear();
+
+  // byte order mark
+  if (i_size >= 3 && strncmp(i_data, "\xEF\xBB\xBF", 3) == 0) {
+    i_data += 3;
+    i_size -= 3;
+  }
+  if (isValidUTF8(i_data, i_size) == false) {
+    return false;
+  }
+
+  // the strings are decoded and ended in place
+  m_buffer.assign(i_data, i_data + i_size);
+  m_buffer.push_back('\0');
+  m_nodes.reserve(i_size / 32);
+  m_attributes.reserve(i_size / 8);
+  s = &m_buffer[0];
+
+  if (strncmp(s, "<?xml", 5) == 0 && isXMLSpace(s[5])) {
+    v_end = strstr(s, "?>");
+    if (v_end == NULL || isUTF8Declaration(s, v_end - s) == false) {
+      return false;
+    }
+    p = v_end - s + 2;
+  }
+
+  while (s[p] != '\0') {
+    /* text */
+    if (s[p] != '<') {
+      int v_begin = p;
+      int v_decodedEnd;
+
+      while (s[p] != '<' && s[p] != '\0') {
+        p++;
+      }
+
+      if (v_openElements.empty()) {
+        for (int i = v_begin; i < p; i++) {
+          if (isXMLSpace(s[i]) == false) {
+            return false;
+          }
+        }
+        continue;
+      }
+
+      v_decodedEnd = decodeXMLString(s, v_begin, p, false);
+      if (v_decodedEnd == -1) {
+        return false;
+      }
+      addText(v_openElements.back(), v_begin, v_decodedEnd - v_begin);
+      continue;
+    }
+
+    /* comment */
+    if (strncmp(s + p, "<!--", 4) == 0) {
+      v_end = strstr(s + p + 4, "--");
+      if (v_end == NULL || v_end[2] != '>') {
+        return false;
+      }
+      p = v_end - s + 3;
+      continue;
+    }
+
+    /* cdata : only the new lines are changed */
+    if (strncmp(s + p, "<![CDATA[", 9) == 0) {
+      int v_begin = p + 9;
+      int w = v_begin;
+
+      v_end = strstr(s + v_begin, "]]>");
+      if (v_end == NULL || v_openElements.empty()) {
+        return false;
+      }
+      for (int r = v_begin; r < v_end - s; r++) {
+        if (s[r] == '\r') {
+          s[w++] = '\n';
+          if (s[r + 1] == '\n') {
+            r++;
+          }
+        } else {
+          s[w++] = s[r];
+        }
+      }
+      addText(v_openElements.back(), v_begin, w - v_begin);
+      p = v_end - s + 3;
+      continue;
+    }
+
+    /* processing instruction ; the declaration must be the first one */
+    if (s[p + 1] == '?') {
+      v_end = strstr(s + p + 2, "?>");
+      if (v_end == NULL ||
+          (strncmp(s + p + 2, "xml", 3) == 0 && isXMLSpace(s[p + 5]))) {
+        return false;
+      }
+      p = v_end - s + 2;
+      continue;
+    }
+
+    /* dtd */
+    if (s[p + 1] == '!') {
+      return false;
+    }
+
+    /* end tag */
+    if (s[p + 1] == '/') {
+      int v_begin = p + 2;
+
+      if (v_openElements.empty()) {
+        return false;
+      }
+      for (p = v_begin; isXMLNameEnd(s[p]) == false; p++) {
+      }
+      const char *v_name = str(m_nodes[v_openElements.back()].name);
+      if ((int)strlen(v_name) != p - v_begin ||
+          strncmp(v_name, s + v_begin, p - v_begin) != 0) {
+        return false;
+      }
+      while (isXMLSpace(s[p])) {
+        p++;
+      }
+      if (s[p] != '>') {
+        return false;
+      }
+      p++;
+      v_openElements.pop_back();
+      continue;
+    }
+
+    /* start tag ; a document has only one root */
+    if (v_openElements.empty() && m_root != -1) {
+      return false;
+    }
+
+    int v_name = ++p;
+    for (; isXMLNameEnd(s[p]) == false; p++) {
+      if (s[p] == ':') { // namespaces
+        return false;
+      }
+    }
+    if (isXMLName(s + v_name, p - v_name) == false) {
+      return false;
+    }
+
+    int v_node =
+      addNode(v_openElements.empty() ? -1 : v_openElements.back(), v_name);
+    if (m_root == -1) {
+      m_root = v_node;
+    }
+
+    // c is the current character, s[p] can be the end of the previous string
+    char c = s[p];
+    s[p] = '\0';
+    bool v_emptyElement = false;
+
+    while (true) {
+      bool v_spaced = isXMLSpace(c);
+
+      while (isXMLSpace(c)) {
+        c = s[++p];
+      }
+      if (c == '>') {
+        p++;
+        break;
+      }
+      if (c == '/') {
+        if (s[p + 1] != '>') {
+          return false;
+        }
+        p += 2;
+        v_emptyElement = true;
+        break;
+      }
+      if (c == '\0' || v_spaced == false) {
+        return false;
+      }
+
+      /* attribute */
+      int v_attrName = p;
+      for (; isXMLNameEnd(s[p]) == false; p++) {
+        if (s[p] == ':') {
+          return false;
+        }
+      }
+      if (isXMLName(s + v_attrName, p - v_attrName) == false ||
+          strncmp(s + v_attrName, "xmlns", 5) == 0) {
+        return false;
+      }
+      c = s[p];
+      s[p] = '\0';
+
+      while (isXMLSpace(c)) {
+        c = s[++p];
+      }
+      if (c != '=') {
+        return false;
+      }
+      p++;
+      while (isXMLSpace(s[p])) {
+        p++;
+      }
+
+      char v_quote = s[p];
+      if (v_quote != '"' && v_quote != '\'') {
+        return false;
+      }
+      int v_value = ++p;
+      while (s[p] != v_quote && s[p] != '\0') {
+        p++;
+      }
+      if (s[p] == '\0') {
+        return false;
+      }
+      int v_valueEnd = decodeXMLString(s, v_value, p, true);
+      if (v_valueEnd == -1) {
+        return false;
+      }
+      s[v_valueEnd] = '\0';
+      c = s[++p];
+
+      // duplicated attributes are errors
+      XMLLightNode &v_element = m_nodes[v_node];
+      for (int i = 0; i < v_element.nbAttributes; i++) {
+        if (strcmp(str(m_attributes[2 * (v_element.firstAttribute + i)]),
+                   s + v_attrName) == 0) {
+          return false;
+        }
+      }
+      m_attributes.push_back(v_attrName);
+      m_attributes.push_back(v_value);
+      v_element.nbAttributes++;
+    }
+
+    if (v_emptyElement == false) {
+      v_openElements.push_back(v_node);
+    }
+  }
+
+  return m_root != -1 && v_openElements.empty();
+}
+
+void XMLLightDocument::readFromDOM(xmlNodePtr i_root) {
+  clear();
+
+  if (i_root != NULL) {
+    copyDOMNode(-1, i_root);
+    m_root = 0;
+  }
+}
+
+void XMLLightDocument::copyDOMNode(int i_parent, xmlNodePtr i_node) {
+  const char *v_name = (const char *)i_node->name;
+  int v_node = addNode(i_parent, addString(v_name, strlen(v_name)));
+
+  for (xmlAttrPtr v_attr = i_node->properties; v_attr != NULL;
+       v_attr = v_attr->next) {
+    const char *v_attrName = (const char *)v_attr->name;
+    xmlChar *v_value = xmlGetProp(i_node, v_attr->name);
+    const char *v_str = v_value == NULL ? "" : (const char *)v_value;
+
+    m_attributes.push_back(addString(v_attrName, strlen(v_attrName)));
+    m_attributes.push_back(addString(v_str, strlen(v_str)));
+    m_nodes[v_node].nbAttributes++;
+    if (v_value != NULL) {
+      xmlFree(v_value);
+    }
+  }
+
+  for (xmlNodePtr v_child = i_node->children; v_child != NULL;
+       v_child = v_child->next) {
+    switch (v_child->type) {
+      case XML_ELEMENT_NODE:
+        copyDOMNode(v_node, v_child);
+        break;
+
+      case XML_TEXT_NODE:
+      case XML_CDATA_SECTION_NODE:
+      case XML_ENTITY_REF_NODE: {
+        xmlChar *v_content = xmlNodeGetContent(v_child);
+
+        if (v_content != NULL) {
+          int v_length = strlen((const char *)v_content);
+          addText(
+            v_node, addString((const char *)v_content, v_length), v_length);
+          xmlFree(v_content);
+        }
+      } break;
+
+      default:
+        break;
+    }
+  }
+}
+
+const XMLLightNode *XMLLightDocument::getRootNode(
+  const char *rootNameToCheck) const {
+  if (rootNameToCheck != NULL) {
+    if (m_root == -1 ||
+        strcmp(str(m_nodes[m_root].name), rootNameToCheck) != 0) {
+      throw Exception("Invalid root name");
+    }
+  }
+  return node(m_root);
+}
+
+const char *XMLLightDocument::nodeName(const XMLLightNode *node) {
+  return node->name == -1 ? "" : node->doc->str(node->name);
+}
+
+const XMLLightNode *XMLLightDocument::subElement(const XMLLightNode *node,
+                                                 const char *name) {
+  const XMLLightNode *v_child = node->doc->node(node->firstChild);
+
+  while (v_child != NULL) {
+    if (v_child->name != -1 && strcmp(nodeName(v_child), name) == 0) {
+      return v_child;
+    }
+    v_child = node->doc->node(v_child->next);
+  }
+
+  return NULL;
+}
+
+const XMLLightNode *XMLLightDocument::nextElement(const XMLLightNode *node,
+                                                  const char *name) {
+  const XMLLightNode *v_next = node->doc->node(node->next);
+
+  if (name == NULL) {
+    name = nodeName(node);
+  }
+
+  while (v_next != NULL) {
+    if (v_next->name != -1 && strcmp(nodeName(v_next), name) == 0) {
+      return v_next;
+    }
+    v_next = node->doc->node(v_next->next);
+  }
+
+  return NULL;
+}
+
+std::string XMLLightDocument::getOption(const XMLLightNode *node,
+                                        const char *name,
+                                        std::string Default) {
+  const std::vector<int> &v_attributes = node->doc->m_attributes;
+  int v_end = node->firstAttribute + node->nbAttributes;
+
+  for (int i = node->firstAttribute; i < v_end; i++) {
+    if (strcmp(node->doc->str(v_attributes[2 * i]), name) == 0) {
+      return node->doc->str(v_attributes[2 * i + 1]);
+    }
+  }
+
+  return Default;
+}
+
+void XMLLightDocument::appendText(const XMLLightNode *node,
+                                  std::string &o_text) {
+  if (node->name == -1) {
+    o_text.append(node->doc->str(node->text), node->textLength);
+    return;
+  }
+
+  for (const XMLLightNode *v_child = node->doc->node(node->firstChild);
+       v_child != NULL;
+       v_child = node->doc->node(v_child->next)) {
+    appendText(v_child, o_text);
+  }
+}
+
+std::string XMLLightDocument::getElementText(const XMLLightNode *node) {
+  std::string v_text;
+
+  appendText(node, v_text);
+  return v_text;
+}
+
+std::string XMLLightDocument::compare(const XMLLightDocument &i_doc) const {
+  if (m_root == -1 || i_doc.m_root == -1) {
+    return m_root == i_doc.m_root ? "" : "no root element";
+  }
+  return compareNodes(node(m_root), i_doc.node(i_doc.m_root));
+}
+
+std::string XMLLightDocument::compareNodes(const XMLLightNode *i_node1,
+                                           const XMLLightNode *i_node2) {
+  std::string v_name = nodeName(i_node1);
+  const XMLLightNode *v_child1, *v_child2;
+
+  if (v_name != nodeName(i_node2)) {
+    return "<" + v_name + "> instead of <" + nodeName(i_node2) + ">";
+  }
+
+  if (i_node1->nbAttributes != i_node2->nbAttributes) {
+    return "<" + v_name + "> attributes differ";
+  }
+  for (int i = 0; i < i_node1->nbAttributes; i++) {
+    int v_attr1 = 2 * (i_node1->firstAttribute + i);
+    int v_attr2 = 2 * (i_node2->firstAttribute + i);
+    const std::vector<int> &v_attributes1 = i_node1->doc->m_attributes;
+    const std::vector<int> &v_attributes2 = i_node2->doc->m_attributes;
+
+    if (strcmp(i_node1->doc->str(v_attributes1[v_attr1]),
+               i_node2->doc->str(v_attributes2[v_attr2])) != 0 ||
+        strcmp(i_node1->doc->str(v_attributes1[v_attr1 + 1]),
+               i_node2->doc->str(v_attributes2[v_attr2 + 1])) != 0) {
+      return "<" + v_name + "> attribute " +
+             i_node1->doc->str(v_attributes1[v_attr1]) + " differs";
+    }
+  }
+
+  // consecutive texts are compared together, whatever their cutting
+  v_child1 = i_node1->doc->node(i_node1->firstChild);
+  v_child2 = i_node2->doc->node(i_node2->firstChild);
+  while (true) {
+    std::string v_text1, v_text2, v_res;
+
+    while (v_child1 != NULL && v_child1->name == -1) {
+      appendText(v_child1, v_text1);
+      v_child1 = i_node1->doc->node(v_child1->next);
+    }
+    while (v_child2 != NULL && v_child2->name == -1) {
+      appendText(v_child2, v_text2);
+      v_child2 = i_node2->doc->node(v_child2->next);
+    }
+    if (v_text1 != v_text2) {
+      return "<" + v_name + "> text differs";
+    }
+
+    if (v_child1 == NULL || v_child2 == NULL) {
+      if (v_child1 != v_child2) {
+        return "<" + v_name + "> children differ";
+      }
+      return "";
+    }
+
+    v_res = compareNodes(v_child1, v_child2);
+    if (v_res != "") {
+      return "<" + v_name + "> " + v_res;
+    }
+    v_child1 = i_node1->doc->node(v_child1->next);
+    v_child2 = i_node2->doc->node(v_child2->next);
+  }
+}
@@ -0,0 +1,103 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __VXMLLIGHT_H__
+#define __VXMLLIGHT_H__
+
+#include "VFileIO_types.h"
+#include <libxml/tree.h>
+#include <string>
+#include <vector>
+
+class XMLLightDocument;
+
+/* element or text of a XMLLightDocument */
+struct XMLLightNode {
+  const XMLLightDocument *doc;
+  int name; // -1 for a text
+  int text;
+  int textLength;
+  int firstAttribute;
+  int nbAttributes;
+  int firstChild;
+  int lastChild;
+  int next;
+};
+
+/*
+  read only element tree, parsed without libxml2 for the files read often (the
+  levels) ; the api is the one of XMLDocument. Only the utf-8 documents without
+  dtd and namespace are parsed, libxml2 is used for the others
+*/
+class XMLLightDocument {
+public:
+  XMLLightDocument();
+
+  void readFromFile(FileDataType i_fdt,
+                    std::string File,
+                    bool i_includeCurrentDir = false);
+  // return false if libxml2 is required to parse the document
+  bool parse(const char *i_data, int i_size);
+  // copy of a document parsed by libxml2
+  void readFromDOM(xmlNodePtr i_root);
+
+  const XMLLightNode *getRootNode(const char *rootNameToCheck = NULL) const;
+
+  static const XMLLightNode *subElement(const XMLLightNode *node,
+                                        const char *name);
+  static const XMLLightNode *nextElement(const XMLLightNode *node,
+                                         const char *name = NULL);
+
+  static std::string getOption(const XMLLightNode *node,
+                               const char *name,
+                               std::string Default = "");
+  static std::string getElementText(const XMLLightNode *node);
+
+  // first difference with i_doc, empty if the documents are the same
+  std::string compare(const XMLLightDocument &i_doc) const;
+
+private:
+  // nodes point to their document
+  XMLLightDocument(const XMLLightDocument &);
+  XMLLightDocument &operator=(const XMLLightDocument &);
+
+  void clear();
+  int addNode(int i_parent, int i_name);
+  int addString(const char *i_str, int i_length);
+  void addText(int i_parent, int i_text, int i_length);
+  void copyDOMNode(int i_parent, xmlNodePtr i_node);
+
+  const char *str(int i_offset) const { return &m_buffer[i_offset]; }
+  const XMLLightNode *node(int i_index) const {
+    return i_index == -1 ? NULL : &m_nodes[i_index];
+  }
+  static const char *nodeName(const XMLLightNode *node);
+  static void appendText(const XMLLightNode *node, std::string &o_text);
+  static std::string compareNodes(const XMLLightNode *i_node1,
+                                  const XMLLightNode *i_node2);
+
+  // strings are offsets in the buffer, nodes and attributes indexes
+  std::vector<char> m_buffer;
+  std::vector<XMLLightNode> m_nodes;
+  std::vector<int> m_attributes; // name and value
+  int m_root;
+};
+
+#endif
@@ -72,9 +72,17 @@ XMArguments::XMArguments() {
   m_opt_forceChildrenCompliant = false;
   m_opt_default_theme = false;
   m_opt_noDBDirsCheck = false;
+  m_opt_dbSafeMode = false;
+  m_opt_dbBenchmark = false;
+  m_opt_bspBenchmark = false;
+  m_opt_checkLevelParser = false;
+  m_opt_rebuildCache = false;
   m_opt_serverOnly = false;
   m_opt_serverPort = false;
   m_opt_serverAdminPassword = false;
+  m_opt_serverLoadTest = false;
+  m_opt_serverLoadTestDuration = false;
+  m_opt_serverLoadTestReplay = false;
   m_opt_updateLevelsOnly = false;
   m_opt_clientConnectAtStartup = false;
   m_opt_adminMode = false;
@@ -265,6 +273,16 @@ void XMArguments::parse(int i_argc, char **i_argv) {
       m_opt_hidePlayingInformation = true;
     } else if (v_opt == "--noDBDirsCheck") {
       m_opt_noDBDirsCheck = true;
+    } else if (v_opt == "--dbSafeMode") {
+      m_opt_dbSafeMode = true;
+    } else if (v_opt == "--dbBenchmark") {
+      m_opt_dbBenchmark = true;
+    } else if (v_opt == "--bspBenchmark") {
+      m_opt_bspBenchmark = true;
+    } else if (v_opt == "--checkLevelParser") {
+      m_opt_checkLevelParser = true;
+    } else if (v_opt == "--rebuildCache") {
+      m_opt_rebuildCache = true;
     } else if (v_opt == "--server") {
       m_opt_serverOnly = true;
     } else if (v_opt == "--serverPort") {
@@ -281,6 +299,27 @@ void XMArguments::parse(int i_argc, char **i_argv) {
       }
       m_opt_serverAdminPassword_value = i_argv[i + 1];
       i++;
+    } else if (v_opt == "--serverLoadTest") {
+      m_opt_serverLoadTest = true;
+      if (i + 1 >= i_argc) {
+        throw SyntaxError("missing value");
+      }
+      m_opt_serverLoadTest_value = atoi(i_argv[i + 1]);
+      i++;
+    } else if (v_opt == "--serverLoadTestDuration") {
+      m_opt_serverLoadTestDuration = true;
+      if (i + 1 >= i_argc) {
+        throw SyntaxError("missing value");
+      }
+      m_opt_serverLoadTestDuration_value = atoi(i_argv[i + 1]);
+      i++;
+    } else if (v_opt == "--serverLoadTestReplay") {
+      m_opt_serverLoadTestReplay = true;
+      if (i + 1 >= i_argc) {
+        throw SyntaxError("missing value");
+      }
+      m_opt_serverLoadTestReplay_value = i_argv[i + 1];
+      i++;
     } else if (v_opt == "--updateLevelsOnly") {
       m_opt_updateLevelsOnly = true;
     } else if (v_opt == "--connectAtStartup") {
@@ -601,6 +640,26 @@ bool XMArguments::isOptNoDBDirsCheck() const {
   return m_opt_noDBDirsCheck;
 }
 
+bool XMArguments::isOptDbSafeMode() const {
+  return m_opt_dbSafeMode;
+}
+
+bool XMArguments::isOptDbBenchmark() const {
+  return m_opt_dbBenchmark;
+}
+
+bool XMArguments::isOptBspBenchmark() const {
+  return m_opt_bspBenchmark;
+}
+
+bool XMArguments::isOptCheckLevelParser() const {
+  return m_opt_checkLevelParser;
+}
+
+bool XMArguments::isOptRebuildCache() const {
+  return m_opt_rebuildCache;
+}
+
 bool XMArguments::isOptServerOnly() const {
   return m_opt_serverOnly;
 }
@@ -621,6 +680,30 @@ std::string XMArguments::getOptServerAdminPassword_value() const {
   return m_opt_serverAdminPassword_value;
 }
 
+bool XMArguments::isOptServerLoadTest() const {
+  return m_opt_serverLoadTest;
+}
+
+int XMArguments::getOptServerLoadTest_value() const {
+  return m_opt_serverLoadTest_value;
+}
+
+bool XMArguments::isOptServerLoadTestDuration() const {
+  return m_opt_serverLoadTestDuration;
+}
+
+int XMArguments::getOptServerLoadTestDuration_value() const {
+  return m_opt_serverLoadTestDuration_value;
+}
+
+bool XMArguments::isOptServerLoadTestReplay() const {
+  return m_opt_serverLoadTestReplay;
+}
+
+std::string XMArguments::getOptServerLoadTestReplay_value() const {
+  return m_opt_serverLoadTestReplay_value;
+}
+
 bool XMArguments::isOptClientConnectAtStartup() const {
   return m_opt_clientConnectAtStartup;
 }
@@ -697,11 +780,30 @@ void XMArguments::help(const std::string &i_cmd) {
     "\t--defaultTheme THEME\n\t\tDefault theme for new profiles created.\n");
   printf("\t--noDBDirsCheck\n\t\tDon't check that system and user dirs changed "
          "at startup.\n");
+  printf("\t--dbSafeMode\n\t\tUse the sqlite default journal and sync the "
+         "database at each transaction (slower). Without it, the database "
+         "upgrades, made after a backup, run with synchronous=OFF.\n");
+  printf("\t--dbBenchmark\n\t\tMeasure the build of a new database, with "
+         "and without the safe mode ; the levels cache is built in the "
+         "Benchmark directory of the cache (no gui).\n");
+  printf("\t--bspBenchmark\n\t\tMeasure the convex decomposition of all the "
+         "levels, trying all the splitters or some of them (no gui).\n");
+  printf("\t--checkLevelParser\n\t\tCompare the levels parser with libxml2 "
+         "on all the levels (no gui).\n");
+  printf("\t--rebuildCache\n\t\tCheck and write again the cache of all the "
+         "levels, and remove the old cache files (no gui).\n");
   printf("\t--server\n\t\tRun X-Moto as a server only (no gui).\n");
   printf(
     "\t--serverPort PORT\n\t\tSpecify the server port (with --server only).\n");
   printf("\t--serverAdminPassword PASSWORD\n\t\tSpecify a server admin "
          "password which is always valid (with --server only).\n");
+  printf("\t--serverLoadTest NBBOTS\n\t\tRun the server and NBBOTS simulated "
+         "clients against it, then report the server load (with --server "
+         "only).\n");
+  printf("\t--serverLoadTestDuration SECONDS\n\t\tDuration of the load test "
+         "(60 by default).\n");
+  printf("\t--serverLoadTestReplay FILE\n\t\tThe bots play the ghost mode, "
+         "sending the frames of this replay, instead of the slave mode.\n");
   printf("\t--updateLevelsOnly\n\t\tOnly update levels (no gui).\n");
   printf(
     "\t--connectAtStartup\n\t\tConnect the client to the server at startup.\n");
@@ -92,11 +92,22 @@ public:
   bool isOptHidePlayingInformation() const;
   bool isOptForceChildrenCompliant() const;
   bool isOptNoDBDirsCheck() const;
+  bool isOptDbSafeMode() const;
+  bool isOptDbBenchmark() const;
+  bool isOptBspBenchmark() const;
+  bool isOptCheckLevelParser() const;
+  bool isOptRebuildCache() const;
   bool isOptServerOnly() const;
   bool isOptServerPort() const;
   int getOptServerPort_value() const;
   bool isOptServerAdminPassword() const;
   std::string getOptServerAdminPassword_value() const;
+  bool isOptServerLoadTest() const;
+  int getOptServerLoadTest_value() const;
+  bool isOptServerLoadTestDuration() const;
+  int getOptServerLoadTestDuration_value() const;
+  bool isOptServerLoadTestReplay() const;
+  std::string getOptServerLoadTestReplay_value() const;
   bool isOptUpdateLevelsOnly() const;
   bool isOptClientConnectAtStartup() const;
   bool isOptAdminMode() const;
@@ -196,12 +207,23 @@ private:
   int m_opt_serverPort_value;
   bool m_opt_serverAdminPassword;
   std::string m_opt_serverAdminPassword_value;
+  bool m_opt_serverLoadTest;
+  int m_opt_serverLoadTest_value;
+  bool m_opt_serverLoadTestDuration;
+  int m_opt_serverLoadTestDuration_value;
+  bool m_opt_serverLoadTestReplay;
+  std::string m_opt_serverLoadTestReplay_value;
 
   /* net */
   bool m_opt_clientConnectAtStartup;
 
   /* specific */
   bool m_opt_noDBDirsCheck;
+  bool m_opt_dbSafeMode;
+  bool m_opt_dbBenchmark;
+  bool m_opt_bspBenchmark;
+  bool m_opt_checkLevelParser;
+  bool m_opt_rebuildCache;
 
   /* default config replacement for new profiles */
   bool m_opt_default_theme;
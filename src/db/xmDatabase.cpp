@@ -31,15 +31,21 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "xmoto/input/InputLegacy.h"
 #include <sstream>
 
-#define XMDB_VERSION 37
+#define XMDB_VERSION 39
 #define DB_MAX_SQL_RUNTIME 0.25
 #define DB_BUSY_TIMEOUT 60000 // 60 seconds
+#define DB_CACHE_SIZE_KB 8192
+#define DB_BULKLOAD_CACHE_SIZE_KB 65536
+#define DB_MMAP_SIZE 67108864 // 64 MB
 
 bool xmDatabase::Trace = false;
+bool xmDatabase::SafeMode = false;
 
 xmDatabase::xmDatabase() {
   m_db = NULL;
   m_openingVersion = -1;
+  m_bulkLoadDepth = 0;
+  m_readOnly = false;
 }
 
 void xmDatabase::setUpdateAfterInitDone() {
@@ -53,14 +59,24 @@ void xmDatabase::openIfNot(const std::string &i_dbFileUTF8) {
   std::string dbFile = XMFS::getUserDirUTF8(FDT_DATA) + "/" + i_dbFileUTF8;
 
   // LogDebug("openDB(%X)", this);
-  if (sqlite3_open(dbFile.c_str(), &m_db) != 0) {
+  if (sqlite3_open_v2(dbFile.c_str(),
+                      &m_db,
+                      m_readOnly ? SQLITE_OPEN_READONLY
+                                 : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                      NULL) != SQLITE_OK) {
+    std::string v_errMsg = sqlite3_errmsg(m_db);
+
+    // close even if it fails as requested in the documentation
+    sqlite3_close(m_db);
+    m_db = NULL;
     throw Exception("Unable to open the database (" + i_dbFileUTF8 +
-                    ") : " + sqlite3_errmsg(m_db));
+                    ") : " + v_errMsg);
   }
 
   sqlite3_busy_timeout(m_db, DB_BUSY_TIMEOUT);
   sqlite3_trace(m_db, sqlTrace, NULL);
   createUserFunctions();
+  setPerformanceProfile(false, false);
 
   //  if(sqlite3_threadsafe() == 0) {
   //    LogWarning("Sqlite is not threadSafe !!!");
@@ -160,10 +176,7 @@ bool xmDatabase::init(const std::string &i_dbFileUTF8,
         LogError(e.getMsg().c_str());
         LogError("Bailing out..");
 
-        if (m_db != NULL) {
-          sqlite3_close(m_db);
-          m_db = NULL;
-        }
+        closeDb();
 
         return false;
       }
@@ -181,7 +194,15 @@ bool xmDatabase::init(const std::string &i_dbFileUTF8,
       setXmParameterKey("requireUpdateAfterInit", "1");
     }
 
-    upgradeXmDbToVersion(m_openingVersion, i_profile, i_interface);
+    // the base has been backed up just before
+    setBulkLoad(true, true);
+    try {
+      upgradeXmDbToVersion(m_openingVersion, i_profile, i_interface);
+    } catch (Exception &e) {
+      setBulkLoad(false);
+      throw e;
+    }
+    setBulkLoad(false);
   }
 
   /* check if gameDir and userDataDir are the same - otherwise, the computer
@@ -284,36 +305,131 @@ void xmDatabase::updateXMDirectories(const std::string &i_oldGameDataDir,
 }
 
 void xmDatabase::init(const std::string &i_dbFile, bool i_readOnly) {
-  /* my sqlite version doesn't allow readonly ; wait to allow this */
-  //  if(i_readOnly) {
-  //    LogDebug("Database opened in read-only mode");
-  //    if(sqlite3_open_v2(i_dbFile.c_str(), &m_db, SQLITE_OPEN_READONLY, NULL)
-  //    != 0){
-  //      if(m_db != NULL) {
-  //	sqlite3_close(m_db); // close even if it fails as requested in the
-  // documentation
-  //	m_db = NULL;
-  //      }
-  //      throw Exception("Unable to open the database (" + i_dbFile + ") : " +
-  //      sqlite3_errmsg(m_db));
-  //    }
-  //  } else {
-  //
-
+  if (i_readOnly) {
+    LogDebug("Database opened in read-only mode");
+  }
+  m_readOnly = i_readOnly;
   openIfNot(i_dbFile);
 }
 
 xmDatabase::~xmDatabase() {
+  closeDb();
+}
+
+void xmDatabase::closeDb() {
+  // statements must be finalized before closing
+  for (std::map<std::string, xmDatabaseStatement *>::iterator it =
+         m_statements.begin();
+       it != m_statements.end();
+       ++it) {
+    delete it->second;
+  }
+  m_statements.clear();
+
   if (m_db != NULL) {
     sqlite3_close(m_db);
     m_db = NULL;
   }
 }
 
+xmDatabaseStatement *xmDatabase::prepare(const std::string &i_sql) {
+  std::map<std::string, xmDatabaseStatement *>::iterator it =
+    m_statements.find(i_sql);
+  xmDatabaseStatement *v_stmt;
+
+  if (it != m_statements.end()) {
+    v_stmt = it->second;
+    v_stmt->reset();
+    v_stmt->clearBindings();
+    return v_stmt;
+  }
+
+  v_stmt = new xmDatabaseStatement(m_db, i_sql);
+  m_statements[i_sql] = v_stmt;
+  return v_stmt;
+}
+
+void xmDatabase::resetStatements() {
+  for (std::map<std::string, xmDatabaseStatement *>::iterator it =
+         m_statements.begin();
+       it != m_statements.end();
+       ++it) {
+    it->second->reset();
+  }
+}
+
 void xmDatabase::setTrace(bool i_value) {
   xmDatabase::Trace = i_value;
 }
 
+void xmDatabase::setSafeMode(bool i_value) {
+  xmDatabase::SafeMode = i_value;
+}
+
+bool xmDatabase::isSafeMode() {
+  return xmDatabase::SafeMode;
+}
+
+/*
+  the wal journal lets the threads read while the main one writes, and a
+  normal sync is enough to never corrupt the base (only the last transactions
+  can be lost on a power failure) ; no sync at all only while upgrading a
+  base backed up just before. The pragmas are only a tuning : a failure is
+  not fatal
+*/
+void xmDatabase::setPerformanceProfile(bool i_bulkLoad, bool i_noSync) {
+  std::ostringstream v_sql;
+  char *v_errMsg;
+
+  // the journal belongs to the writers
+  if (m_readOnly == false) {
+    if (SafeMode) {
+      v_sql << "PRAGMA journal_mode=DELETE;"
+            << "PRAGMA synchronous=FULL;";
+    } else {
+      v_sql << "PRAGMA journal_mode=WAL;"
+            << "PRAGMA synchronous=" << (i_noSync ? "OFF" : "NORMAL") << ";";
+    }
+  }
+
+  if (SafeMode == false) {
+    v_sql << "PRAGMA temp_store=MEMORY;"
+          << "PRAGMA cache_size=-"
+          << (i_bulkLoad ? DB_BULKLOAD_CACHE_SIZE_KB : DB_CACHE_SIZE_KB)
+          << ";"
+          << "PRAGMA mmap_size=" << DB_MMAP_SIZE << ";";
+  }
+
+  if (sqlite3_exec(m_db, v_sql.str().c_str(), NULL, NULL, &v_errMsg) !=
+      SQLITE_OK) {
+    LogWarning("Unable to tune the database: %s", v_errMsg);
+    sqlite3_free(v_errMsg);
+  }
+}
+
+void xmDatabase::setBulkLoad(bool i_value, bool i_backedUp) {
+  if (i_value) {
+    m_bulkLoadDepth++;
+    if (m_bulkLoadDepth != 1) {
+      return;
+    }
+  } else {
+    if (m_bulkLoadDepth == 0) {
+      return;
+    }
+    m_bulkLoadDepth--;
+    if (m_bulkLoadDepth != 0) {
+      return;
+    }
+  }
+
+  if (SafeMode || m_db == NULL) {
+    return;
+  }
+  // the nested calls keep the sync of the first one
+  setPerformanceProfile(i_value, i_value && i_backedUp);
+}
+
 void xmDatabase::sqlTrace(void *arg1, const char *sql) {
   if (Trace) {
     printf("%s\n", sql);
@@ -1024,6 +1140,90 @@ void xmDatabase::upgradeXmDbToVersion(int i_fromVersion,
         throw Exception("Unable to update xmDb from 36: " + e.getMsg());
       }
 
+    case 37:
+      try {
+        // stat signature of the files, to find the changed levels without
+        // computing their checksum
+        simpleSql("ALTER TABLE levels ADD COLUMN fileSize;");
+        simpleSql("ALTER TABLE levels ADD COLUMN fileMtime;");
+        simpleSql("ALTER TABLE levels ADD COLUMN fileInode;");
+        updateXmDbVersion(38, i_interface);
+      } catch (Exception &e) {
+        throw Exception("Unable to update xmDb from 37: " + e.getMsg());
+      }
+
+    case 38:
+      try {
+        // tables used by the levels packs : their version changes at each
+        // write, so that the packs counts are computed again only when needed
+        const char *v_tables[] = { "levels",
+                                   "levels_blacklist",
+                                   "levels_favorite",
+                                   "levels_mywebhighscores",
+                                   "levels_new",
+                                   "profile_completedLevels",
+                                   "stats_profiles_levels",
+                                   "webhighscores",
+                                   "weblevels" };
+        std::string v_table, v_update;
+
+        simpleSql(
+          "CREATE TABLE xm_tablesVersions(tableName PRIMARY KEY, version);");
+        simpleSql("CREATE TABLE levels_packsCounts(packSql, id_profile, "
+                  "tablesVersions, nbLevels, nbFinishedLevels, "
+                  "PRIMARY KEY(packSql, id_profile));");
+
+        for (unsigned int i = 0; i < sizeof(v_tables) / sizeof(char *); i++) {
+          v_table = v_tables[i];
+          v_update = "BEGIN UPDATE xm_tablesVersions SET version=version+1 "
+                     "WHERE tableName=\"" +
+                     v_table + "\"; END;";
+
+          simpleSql("INSERT INTO xm_tablesVersions(tableName, version) "
+                    "VALUES(\"" +
+                    v_table + "\", 0);");
+          simpleSql("CREATE TRIGGER " + v_table + "_version_insert " +
+                    "AFTER INSERT ON " + v_table + " " + v_update);
+          simpleSql("CREATE TRIGGER " + v_table + "_version_delete " +
+                    "AFTER DELETE ON " + v_table + " " + v_update);
+
+          // loaded and the file signature change at each start
+          if (v_table == "levels") {
+            simpleSql("CREATE TRIGGER levels_version_update "
+                      "AFTER UPDATE OF id_level, filepath, name, checkSum, "
+                      "author, description, date_str, packName, packNum, "
+                      "music, isScripted, isToReload, isPhysics ON levels " +
+                      v_update);
+          } else {
+            simpleSql("CREATE TRIGGER " + v_table + "_version_update " +
+                      "AFTER UPDATE ON " + v_table + " " + v_update);
+          }
+        }
+
+        // the finished levels change only when a level is completed the
+        // first time, not each time it is played
+        v_update = "BEGIN UPDATE xm_tablesVersions SET version=version+1 "
+                   "WHERE tableName=\"stats_profiles_levels_completed\"; END;";
+        simpleSql("INSERT INTO xm_tablesVersions(tableName, version) "
+                  "VALUES(\"stats_profiles_levels_completed\", 0);");
+        simpleSql("CREATE TRIGGER stats_profiles_levels_completed_insert "
+                  "AFTER INSERT ON stats_profiles_levels "
+                  "WHEN new.nbCompleted+0 > 0 " +
+                  v_update);
+        simpleSql("CREATE TRIGGER stats_profiles_levels_completed_delete "
+                  "AFTER DELETE ON stats_profiles_levels "
+                  "WHEN old.nbCompleted+0 > 0 " +
+                  v_update);
+        simpleSql("CREATE TRIGGER stats_profiles_levels_completed_update "
+                  "AFTER UPDATE OF nbCompleted ON stats_profiles_levels "
+                  "WHEN (old.nbCompleted+0 > 0) <> (new.nbCompleted+0 > 0) " +
+                  v_update);
+
+        updateXmDbVersion(39, i_interface);
+      } catch (Exception &e) {
+        throw Exception("Unable to update xmDb from 38: " + e.getMsg());
+      }
+
       // next
   }
 }
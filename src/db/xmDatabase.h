@@ -23,13 +23,39 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "common/VFileIO_types.h"
 #include "helpers/MultiSingleton.h"
+#include "xmDatabaseStatement.h"
 #include "xmDatabaseUpdateInterface.h"
+#include <map>
 #include <sqlite3.h>
 #include <string>
 #include <vector>
 
 class Level;
 
+/* plays of a level by a profile, added together to the stats */
+struct xmDatabaseLevelPlays {
+  int nbPlayed;
+  int nbDied;
+  int nbCompleted;
+  int nbRestarted;
+  int playedTime;
+};
+// (profile, level) => plays
+typedef std::map<std::pair<std::string, std::string>, xmDatabaseLevelPlays>
+  xmDatabaseLevelsPlays;
+
+/* rows of the levels table having the same file path */
+struct xmDatabaseLevelFileRows {
+  std::vector<std::string> names;
+  std::vector<std::string> checkSums;
+  int signatureRow; // row with the same stat signature as the file, or -1
+
+  // the file changed, its checksum is required to find its row
+  bool needChecksum() const {
+    return names.empty() == false && signatureRow == -1;
+  }
+};
+
 class xmDatabase : public MultiSingleton<xmDatabase> {
   friend class MultiSingleton<xmDatabase>;
 
@@ -53,6 +79,7 @@ public:
   void setUpdateAfterInitDone(); // call once, update after init are done
   int getXmDbVersion();
   bool isOpen() const { return m_db != NULL; }
+  bool isReadOnly() const { return m_readOnly; }
   static int getMemoryUsed();
 
   /* RULE:
@@ -68,6 +95,22 @@ public:
   void debugResult(char **i_result, int ncolumn, unsigned int nrow);
   static std::string protectString(const std::string &i_str);
   static void setTrace(bool i_value);
+  /* safe mode : sqlite default journal, synced at each transaction ; to set
+     before opening the connections */
+  static void setSafeMode(bool i_value);
+  static bool isSafeMode();
+
+  /* bulk load : bigger cache while filling lots of rows (first build,
+     upgrades, levels reloads) ; calls can be nested. i_backedUp : the base
+     has been backed up just before, the disk is not waited for */
+  void setBulkLoad(bool i_value, bool i_backedUp = false);
+
+  /* prepared statements are kept for the life of the connection, one per sql
+     text ; the statement is returned reset, without parameters, so don't
+     prepare the same sql while reading its rows */
+  xmDatabaseStatement *prepare(const std::string &i_sql);
+  // stop the reads in progress of the prepared statements
+  void resetStatements();
 
   /* stats */
   void stats_createProfile(const std::string &i_sitekey,
@@ -93,6 +136,9 @@ public:
                             int i_playTime);
   void stats_xmotoStarted(const std::string &i_sitekey,
                           const std::string &PlayerName);
+  // all the plays in one transaction
+  void stats_levelsPlayed(const std::string &i_sitekey,
+                          const xmDatabaseLevelsPlays &i_plays);
 
   /* levels */
   void levels_updateDB(
@@ -115,9 +161,17 @@ public:
   void levels_addToNew_end();
 
   void levels_add_begin(bool i_isToReload);
+  // rows of the file ; they are given to levels_add_fast
+  void levels_getFileRows(const std::string &i_filepath,
+                          bool i_isToReload,
+                          xmDatabaseLevelFileRows &o_rows);
+  // the checksum of the file is computed only if its size, date or inode
+  // changed ; give i_checkSum if it is already known
   bool levels_add_fast(const std::string &i_filepath,
+                       const xmDatabaseLevelFileRows &i_rows,
                        std::string &o_levelName,
-                       bool i_isToReload);
+                       bool i_isToReload,
+                       const std::string &i_checkSum = "");
   void levels_add(const std::string &i_id_level,
                   const std::string &i_filepath,
                   const std::string &i_name,
@@ -143,6 +197,21 @@ public:
   void levels_add_end();
   void levels_cleanNoWWWLevels();
 
+  /* levels packs counts are kept with the versions of the tables used by
+     the pack when they were computed, and the session options read by its
+     sql functions ; they are valid while none of them changes */
+  std::string levels_packTablesVersions(const std::string &i_sql);
+  bool levels_getPackCount(const std::string &i_sql,
+                           const std::string &i_profile,
+                           const std::string &i_tablesVersions,
+                           int &o_nbLevels,
+                           int &o_nbFinishedLevels);
+  void levels_setPackCount(const std::string &i_sql,
+                           const std::string &i_profile,
+                           const std::string &i_tablesVersions,
+                           int i_nbLevels,
+                           int i_nbFinishedLevels);
+
   /* replays */
   bool replays_isIndexUptodate() const;
   void replays_add_begin();
@@ -233,6 +302,7 @@ public:
 
   // sync
   std::string getXmDbSiteKey();
+  // i_outFile is written compressed with bzip2
   void sync_buildServerFile(const std::string &i_outFile,
                             const std::string &i_sitekey,
                             const std::string &i_profile);
@@ -264,20 +334,30 @@ public:
   void srv_cleanBans();
   void srv_changePassword(const std::string &i_profile,
                           const std::string &i_password);
+  // the server database thread writes its jobs by batches
+  void srv_beginTransaction();
+  void srv_commitTransaction();
+  void srv_rollbackTransaction();
 
   /* data fixes */
   void fixStatsProfilesLevelsNbCompleted();
 
 private:
   sqlite3 *m_db;
+  std::map<std::string, xmDatabaseStatement *> m_statements;
+  void closeDb();
   bool m_requiredLevelsUpdateAfterInit;
   bool m_requiredReplaysUpdateAfterInit;
   bool m_requiredThemesUpdateAfterInit;
   static bool Trace;
+  static bool SafeMode;
 
   // internal opening
   void openIfNot(const std::string &i_dbFileUTF8);
+  void setPerformanceProfile(bool i_bulkLoad, bool i_noSync);
   int m_openingVersion;
+  int m_bulkLoadDepth;
+  bool m_readOnly;
 
   /* add user function for db */
   void createUserFunctions();
@@ -363,6 +443,21 @@ private:
   bool stats_checkKeyExists_stats_profiles_levels(const std::string &i_sitekey,
                                                   const std::string &i_profile,
                                                   const std::string &i_level);
+  /* levels */
+  // bind the size, date and inode of the file from i_param
+  void levels_bindFileStat(xmDatabaseStatement *i_stmt,
+                           int i_param,
+                           const std::string &i_filepath);
+
+  // plays of the level, adding the given counters
+  void stats_levelPlayed(const std::string &i_sitekey,
+                         const std::string &PlayerName,
+                         const std::string &LevelID,
+                         int i_playTime,
+                         int i_nbPlayed,
+                         int i_nbDied,
+                         int i_nbCompleted,
+                         int i_nbRestarted);
   void updateDB_profiles(
     XmDatabaseUpdateInterface *i_interface = NULL); /* profiles */
 
@@ -0,0 +1,147 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "xmDatabasePool.h"
+#include "common/XMSession.h"
+#include "helpers/Log.h"
+#include "helpers/VExcept.h"
+#include "include/xm_SDL.h"
+#include "xmDatabase.h"
+#include <sstream>
+
+#define XMDB_POOL_MAX_IDLE_READERS 4
+
+xmDatabasePool::xmDatabasePool() {
+  m_readersMutex = SDL_CreateMutex();
+  m_writerMutex = SDL_CreateMutex();
+  m_nbCreatedReaders = 0;
+  m_writer = NULL;
+}
+
+xmDatabasePool::~xmDatabasePool() {
+  for (unsigned int i = 0; i < m_idleReaders.size(); i++) {
+    xmDatabase::destroy(m_idleReaders[i]);
+  }
+
+  // the threads should be finished
+  for (std::map<xmDatabase *, std::string>::iterator it =
+         m_usedReaders.begin();
+       it != m_usedReaders.end();
+       ++it) {
+    xmDatabase::destroy(it->second);
+  }
+
+  if (m_writer != NULL) {
+    xmDatabase::destroy("pool_writer");
+  }
+
+  SDL_DestroyMutex(m_readersMutex);
+  SDL_DestroyMutex(m_writerMutex);
+}
+
+xmDatabase *xmDatabasePool::acquireReader() {
+  std::string v_key;
+  bool v_isNew = false;
+  xmDatabase *v_db;
+
+  SDL_LockMutex(m_readersMutex);
+  if (m_idleReaders.empty() == false) {
+    v_key = m_idleReaders.back();
+    m_idleReaders.pop_back();
+  } else {
+    std::ostringstream v_nKey;
+
+    v_nKey << "pool_reader_" << m_nbCreatedReaders++;
+    v_key = v_nKey.str();
+    v_isNew = true;
+  }
+  SDL_UnlockMutex(m_readersMutex);
+
+  // open it out of the lock, it can be long
+  v_db = xmDatabase::instance(v_key);
+  if (v_isNew) {
+    LogDebug("Open db reader '%s'", v_key.c_str());
+    try {
+      v_db->init(DATABASE_FILE, true);
+    } catch (Exception &e) {
+      xmDatabase::destroy(v_key);
+      throw e;
+    }
+  }
+
+  SDL_LockMutex(m_readersMutex);
+  m_usedReaders[v_db] = v_key;
+  SDL_UnlockMutex(m_readersMutex);
+
+  return v_db;
+}
+
+void xmDatabasePool::releaseReader(xmDatabase *i_db) {
+  std::map<xmDatabase *, std::string>::iterator v_it;
+  std::string v_key;
+  bool v_keep;
+
+  // no read must stay in progress while the connection sleeps
+  i_db->resetStatements();
+
+  SDL_LockMutex(m_readersMutex);
+  v_it = m_usedReaders.find(i_db);
+  if (v_it == m_usedReaders.end()) {
+    SDL_UnlockMutex(m_readersMutex);
+    LogWarning("Releasing an unknown db reader");
+    return;
+  }
+  v_key = v_it->second;
+  m_usedReaders.erase(v_it);
+
+  v_keep = m_idleReaders.size() < XMDB_POOL_MAX_IDLE_READERS;
+  if (v_keep) {
+    m_idleReaders.push_back(v_key);
+  }
+  SDL_UnlockMutex(m_readersMutex);
+
+  if (v_keep == false) {
+    xmDatabase::destroy(v_key);
+  }
+}
+
+xmDatabase *xmDatabasePool::lockWriter() {
+  SDL_LockMutex(m_writerMutex);
+
+  if (m_writer == NULL) {
+    xmDatabase *v_db = xmDatabase::instance("pool_writer");
+
+    LogDebug("Open db writer");
+    try {
+      v_db->init(DATABASE_FILE);
+    } catch (Exception &e) {
+      xmDatabase::destroy("pool_writer");
+      SDL_UnlockMutex(m_writerMutex);
+      throw e;
+    }
+    m_writer = v_db;
+  }
+
+  return m_writer;
+}
+
+void xmDatabasePool::unlockWriter() {
+  SDL_UnlockMutex(m_writerMutex);
+}
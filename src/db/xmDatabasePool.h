@@ -0,0 +1,62 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __XMDATABASEPOOL_H__
+#define __XMDATABASEPOOL_H__
+
+#include "helpers/Singleton.h"
+#include <map>
+#include <string>
+#include <vector>
+
+struct SDL_mutex;
+class xmDatabase;
+
+/*
+  connections shared by the threads : read-only connections, kept open
+  between two threads runs (the wal journal lets them read while somebody
+  writes), and one writer for the small writes of the reading threads
+  (create the pool from the main thread)
+*/
+class xmDatabasePool : public Singleton<xmDatabasePool> {
+  friend class Singleton<xmDatabasePool>;
+
+private:
+  xmDatabasePool();
+  ~xmDatabasePool();
+
+public:
+  xmDatabase *acquireReader();
+  void releaseReader(xmDatabase *i_db);
+
+  // the writer is used by one thread at a time
+  xmDatabase *lockWriter();
+  void unlockWriter();
+
+private:
+  SDL_mutex *m_readersMutex;
+  SDL_mutex *m_writerMutex;
+  std::vector<std::string> m_idleReaders;
+  std::map<xmDatabase *, std::string> m_usedReaders;
+  unsigned int m_nbCreatedReaders;
+  xmDatabase *m_writer;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "xmDatabaseStatement.h"
+#include "helpers/Log.h"
+#include "helpers/VExcept.h"
+
+xmDatabaseStatement::xmDatabaseStatement(sqlite3 *i_db,
+                                         const std::string &i_sql) {
+  m_db = i_db;
+  m_sql = i_sql;
+  m_stmt = NULL;
+
+  if (sqlite3_prepare_v2(m_db, m_sql.c_str(), -1, &m_stmt, NULL) !=
+      SQLITE_OK) {
+    std::string v_errMsg = sqlite3_errmsg(m_db);
+
+    if (m_stmt != NULL) {
+      sqlite3_finalize(m_stmt);
+    }
+    LogError("xmDb failed while preparing :");
+    LogInfo("%s", m_sql.c_str());
+    LogError("%s", v_errMsg.c_str());
+    throw Exception("xmDb: " + v_errMsg);
+  }
+}
+
+xmDatabaseStatement::~xmDatabaseStatement() {
+  sqlite3_finalize(m_stmt);
+}
+
+std::string xmDatabaseStatement::sql() const {
+  return m_sql;
+}
+
+void xmDatabaseStatement::throwError(const std::string &i_action) {
+  std::string v_errMsg = sqlite3_errmsg(m_db);
+
+  // don't let the statement in a running state
+  sqlite3_reset(m_stmt);
+
+  LogError("xmDb failed while %s :", i_action.c_str());
+  LogInfo("%s", m_sql.c_str());
+  LogError("%s", v_errMsg.c_str());
+  throw Exception("xmDb: " + v_errMsg);
+}
+
+void xmDatabaseStatement::bind(int i_param, const std::string &i_value) {
+  if (sqlite3_bind_text(m_stmt,
+                        i_param,
+                        i_value.c_str(),
+                        i_value.length(),
+                        SQLITE_TRANSIENT) != SQLITE_OK) {
+    throwError("binding");
+  }
+}
+
+void xmDatabaseStatement::bind(int i_param, const char *i_value) {
+  bind(i_param, std::string(i_value));
+}
+
+void xmDatabaseStatement::bind(int i_param, int i_value) {
+  if (sqlite3_bind_int(m_stmt, i_param, i_value) != SQLITE_OK) {
+    throwError("binding");
+  }
+}
+
+void xmDatabaseStatement::bind(int i_param, long long i_value) {
+  if (sqlite3_bind_int64(m_stmt, i_param, (sqlite3_int64)i_value) !=
+      SQLITE_OK) {
+    throwError("binding");
+  }
+}
+
+void xmDatabaseStatement::bind(int i_param, double i_value) {
+  if (sqlite3_bind_double(m_stmt, i_param, i_value) != SQLITE_OK) {
+    throwError("binding");
+  }
+}
+
+void xmDatabaseStatement::bindNull(int i_param) {
+  if (sqlite3_bind_null(m_stmt, i_param) != SQLITE_OK) {
+    throwError("binding");
+  }
+}
+
+void xmDatabaseStatement::clearBindings() {
+  sqlite3_clear_bindings(m_stmt);
+}
+
+bool xmDatabaseStatement::next() {
+  switch (sqlite3_step(m_stmt)) {
+    case SQLITE_ROW:
+      return true;
+
+    case SQLITE_DONE:
+      sqlite3_reset(m_stmt);
+      return false;
+
+    default:
+      throwError("running");
+  }
+  return false;
+}
+
+void xmDatabaseStatement::execute() {
+  while (next()) {
+    /* rows are ignored */
+  }
+}
+
+void xmDatabaseStatement::reset() {
+  sqlite3_reset(m_stmt);
+}
+
+bool xmDatabaseStatement::isNull(int i_column) {
+  return sqlite3_column_type(m_stmt, i_column) == SQLITE_NULL;
+}
+
+std::string xmDatabaseStatement::getString(int i_column) {
+  const unsigned char *v_text = sqlite3_column_text(m_stmt, i_column);
+
+  if (v_text == NULL) {
+    return "";
+  }
+  return std::string((const char *)v_text,
+                     sqlite3_column_bytes(m_stmt, i_column));
+}
+
+int xmDatabaseStatement::getInt(int i_column) {
+  return sqlite3_column_int(m_stmt, i_column);
+}
+
+long long xmDatabaseStatement::getInt64(int i_column) {
+  return (long long)sqlite3_column_int64(m_stmt, i_column);
+}
+
+double xmDatabaseStatement::getDouble(int i_column) {
+  return sqlite3_column_double(m_stmt, i_column);
+}
@@ -0,0 +1,71 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __XMDATABASESTATEMENT_H__
+#define __XMDATABASESTATEMENT_H__
+
+#include <sqlite3.h>
+#include <string>
+
+/*
+  sql statement parsed once, then run as many times as required with new
+  parameters ; the rows are read one by one, without copying the whole result
+  (use xmDatabase::prepare to get one)
+*/
+class xmDatabaseStatement {
+public:
+  xmDatabaseStatement(sqlite3 *i_db, const std::string &i_sql);
+  ~xmDatabaseStatement();
+
+  std::string sql() const;
+
+  /* parameters are numbered from 1 (?1, ?2, ...) */
+  void bind(int i_param, const std::string &i_value);
+  void bind(int i_param, const char *i_value);
+  void bind(int i_param, int i_value);
+  void bind(int i_param, long long i_value);
+  void bind(int i_param, double i_value);
+  void bindNull(int i_param);
+  void clearBindings();
+
+  /* go to the next row ; return false when there is no more row, the
+     statement is then reset, ready to be run again */
+  bool next();
+  /* run a statement which returns no row */
+  void execute();
+  /* stop reading the rows before the end */
+  void reset();
+
+  /* columns of the current row are numbered from 0 */
+  bool isNull(int i_column);
+  std::string getString(int i_column);
+  int getInt(int i_column);
+  long long getInt64(int i_column);
+  double getDouble(int i_column);
+
+private:
+  void throwError(const std::string &i_action);
+
+  sqlite3 *m_db;
+  sqlite3_stmt *m_stmt;
+  std::string m_sql;
+};
+
+#endif
@@ -20,9 +20,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "common/VFileIO.h"
 #include "common/VXml.h"
+#include "common/XMSession.h"
 #include "helpers/Log.h"
 #include "xmDatabase.h"
 #include "xmscene/Level.h"
+#include <ctype.h>
 #include <sstream>
 
 void xmDatabase::levels_add_begin(bool i_isToReload) {
@@ -186,24 +188,28 @@ void xmDatabase::levels_add(const std::string &i_id_level,
                             bool i_isScripted,
                             bool i_isPhysics,
                             bool i_isToReload) {
-  std::ostringstream v_cacheFV;
-  v_cacheFV << CACHE_LEVEL_FORMAT_VERSION;
-
-  simpleSql("INSERT INTO levels(id_level,"
+  xmDatabaseStatement *v_stmt =
+    prepare("INSERT INTO levels(id_level,"
             "filepath, name, checkSum, author, description, "
             "date_str, music, isScripted, isPhysics, isToReload, loaded, "
-            "loadingCacheFormatVersion) "
-            "VALUES(\"" +
-            protectString(i_id_level) + "\", " + "\"" +
-            protectString(i_filepath) + "\", " + "\"" + protectString(i_name) +
-            "\", " + "\"" + protectString(i_checkSum) + "\", " + "\"" +
-            protectString(i_author) + "\", " + "\"" +
-            protectString(i_description) + "\", " + "\"" +
-            protectString(i_date) + "\", " + "\"" + protectString(i_music) +
-            "\", " + std::string(i_isScripted ? "1" : "0") + ", " +
-            std::string(i_isPhysics ? "1" : "0") + ", " +
-            std::string(i_isToReload ? "1" : "0") +
-            std::string(", 1, " + v_cacheFV.str() + ");"));
+            "loadingCacheFormatVersion, fileSize, fileMtime, fileInode) "
+            "VALUES(?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, 1, ?12, "
+            "?13, ?14, ?15);");
+
+  v_stmt->bind(1, i_id_level);
+  v_stmt->bind(2, i_filepath);
+  v_stmt->bind(3, i_name);
+  v_stmt->bind(4, i_checkSum);
+  v_stmt->bind(5, i_author);
+  v_stmt->bind(6, i_description);
+  v_stmt->bind(7, i_date);
+  v_stmt->bind(8, i_music);
+  v_stmt->bind(9, i_isScripted ? 1 : 0);
+  v_stmt->bind(10, i_isPhysics ? 1 : 0);
+  v_stmt->bind(11, i_isToReload ? 1 : 0);
+  v_stmt->bind(12, CACHE_LEVEL_FORMAT_VERSION);
+  levels_bindFileStat(v_stmt, 13, i_filepath);
+  v_stmt->execute();
 }
 
 void xmDatabase::levels_update(const std::string &i_id_level,
@@ -217,20 +223,45 @@ void xmDatabase::levels_update(const std::string &i_id_level,
                                bool i_isScripted,
                                bool i_isPhysics,
                                bool i_isToReload) {
-  std::ostringstream v_cacheFV;
-  v_cacheFV << CACHE_LEVEL_FORMAT_VERSION;
+  xmDatabaseStatement *v_stmt =
+    prepare("UPDATE levels SET filepath=?2, name=?3, checkSum=?4, "
+            "author=?5, description=?6, date_str=?7, music=?8, "
+            "isScripted=?9, isPhysics=?10, isToReload=?11, loaded=1, "
+            "loadingCacheFormatVersion=?12, "
+            "fileSize=?13, fileMtime=?14, fileInode=?15 "
+            "WHERE id_level=?1;");
+
+  v_stmt->bind(1, i_id_level);
+  v_stmt->bind(2, i_filepath);
+  v_stmt->bind(3, i_name);
+  v_stmt->bind(4, i_checkSum);
+  v_stmt->bind(5, i_author);
+  v_stmt->bind(6, i_description);
+  v_stmt->bind(7, i_date);
+  v_stmt->bind(8, i_music);
+  v_stmt->bind(9, i_isScripted ? 1 : 0);
+  v_stmt->bind(10, i_isPhysics ? 1 : 0);
+  v_stmt->bind(11, i_isToReload ? 1 : 0);
+  v_stmt->bind(12, CACHE_LEVEL_FORMAT_VERSION);
+  levels_bindFileStat(v_stmt, 13, i_filepath);
+  v_stmt->execute();
+}
 
-  simpleSql("UPDATE levels SET name=\"" + protectString(i_name) +
-            "\", filepath=\"" + protectString(i_filepath) + "\", checkSum=\"" +
-            protectString(i_checkSum) + "\", author=\"" +
-            protectString(i_author) + "\", description=\"" +
-            protectString(i_description) + "\", date_str=\"" +
-            protectString(i_date) + "\", music=\"" + protectString(i_music) +
-            "\", isScripted=" + std::string(i_isScripted ? "1" : "0") +
-            ", isPhysics=" + std::string(i_isPhysics ? "1" : "0") +
-            ", isToReload=" + std::string(i_isToReload ? "1" : "0") +
-            ", loaded=1, loadingCacheFormatVersion = " + v_cacheFV.str() +
-            " WHERE id_level=\"" + protectString(i_id_level) + "\";");
+void xmDatabase::levels_bindFileStat(xmDatabaseStatement *i_stmt,
+                                     int i_param,
+                                     const std::string &i_filepath) {
+  FileStatSignature v_signature;
+
+  // files of the package have no signature, their checksum is known
+  if (XMFS::getFileStatSignature(FDT_DATA, i_filepath, v_signature)) {
+    i_stmt->bind(i_param, v_signature.size);
+    i_stmt->bind(i_param + 1, v_signature.mtime);
+    i_stmt->bind(i_param + 2, v_signature.inode);
+  } else {
+    i_stmt->bindNull(i_param);
+    i_stmt->bindNull(i_param + 1);
+    i_stmt->bindNull(i_param + 2);
+  }
 }
 
 void xmDatabase::levels_cleanNoWWWLevels() {
@@ -280,47 +311,80 @@ void xmDatabase::levels_cleanNoWWWLevels() {
   read_DB_free(v_result);
 }
 
+void xmDatabase::levels_getFileRows(const std::string &i_filepath,
+                                    bool i_isToReload,
+                                    xmDatabaseLevelFileRows &o_rows) {
+  xmDatabaseStatement *v_stmt;
+  FileStatSignature v_signature;
+  bool v_hasSignature;
+
+  v_hasSignature =
+    XMFS::getFileStatSignature(FDT_DATA, i_filepath, v_signature);
+  o_rows.names.clear();
+  o_rows.checkSums.clear();
+  o_rows.signatureRow = -1;
+
+  v_stmt = prepare(std::string("SELECT name, checkSum, "
+                               "fileSize, fileMtime, fileInode "
+                               "FROM levels WHERE ") +
+                   (i_isToReload ? "isToReload=1 AND " : "") +
+                   "filepath=?1;");
+  v_stmt->bind(1, i_filepath);
+  while (v_stmt->next()) {
+    if (v_hasSignature && o_rows.signatureRow == -1 &&
+        v_stmt->isNull(2) == false &&
+        v_stmt->getInt64(2) == v_signature.size &&
+        v_stmt->getInt64(3) == v_signature.mtime &&
+        v_stmt->getInt64(4) == v_signature.inode) {
+      o_rows.signatureRow = o_rows.names.size();
+    }
+    o_rows.names.push_back(v_stmt->getString(0));
+    o_rows.checkSums.push_back(v_stmt->getString(1));
+  }
+}
+
 // if a level has the same checksum and has been loaded in the save cache format
 // version, don't reanalyse the level,
 // just resussite it from the trash (loaded=0)
+// the checksum is not computed if the stat signature of the file didn't change
 bool xmDatabase::levels_add_fast(const std::string &i_filepath,
+                                 const xmDatabaseLevelFileRows &i_rows,
                                  std::string &o_levelName,
-                                 bool i_isToReload) {
-  char **v_result;
-  unsigned int nrow;
+                                 bool i_isToReload,
+                                 const std::string &i_checkSum) {
+  xmDatabaseStatement *v_stmt;
   unsigned int i;
   bool v_found;
-  std::string v_checksum, v_dbchecksum;
+  std::string v_checksum;
   std::string v_cond;
   if (i_isToReload) {
     v_cond = "isToReload=1 AND ";
   }
 
-  v_result =
-    readDB("SELECT name, checkSum FROM levels "
-           "WHERE " +
-             v_cond + "filepath=\"" + protectString(i_filepath) + "\";",
-           nrow);
-
   // no result, no need to compute checksum
-  if (nrow == 0) {
-    read_DB_free(v_result);
+  if (i_rows.names.empty()) {
     return false;
   }
 
-  // checksum
-  v_checksum = XMFS::md5sum(FDT_DATA, i_filepath);
-  i = 0;
-  v_found = false;
-  while (i < nrow && v_found == false) {
-    v_dbchecksum = getResult(v_result, 2, i, 1);
-    if (v_dbchecksum == v_checksum) {
-      v_found = true;
-      o_levelName = getResult(v_result, 2, i, 0);
+  if (i_rows.signatureRow != -1) {
+    // the file didn't change
+    v_found = true;
+    v_checksum = i_rows.checkSums[i_rows.signatureRow];
+    o_levelName = i_rows.names[i_rows.signatureRow];
+  } else {
+    // checksum
+    v_checksum =
+      i_checkSum != "" ? i_checkSum : XMFS::md5sum(FDT_DATA, i_filepath);
+    i = 0;
+    v_found = false;
+    while (i < i_rows.names.size() && v_found == false) {
+      if (i_rows.checkSums[i] == v_checksum) {
+        v_found = true;
+        o_levelName = i_rows.names[i];
+      }
+      i++;
     }
-    i++;
   }
-  read_DB_free(v_result);
 
   // no level with the same checksum found
   if (v_found == false) {
@@ -328,9 +392,114 @@ bool xmDatabase::levels_add_fast(const std::string &i_filepath,
   }
 
   // found it in the database
-  simpleSql("UPDATE levels SET loaded=1 WHERE " + v_cond + "filepath=\"" +
-            protectString(i_filepath) + "\" "
-                                        "AND checkSum=\"" +
-            protectString(v_checksum) + "\";");
+  v_stmt = prepare("UPDATE levels SET loaded=1, "
+                   "fileSize=?3, fileMtime=?4, fileInode=?5 WHERE " +
+                   v_cond + "filepath=?1 AND checkSum=?2;");
+  v_stmt->bind(1, i_filepath);
+  v_stmt->bind(2, v_checksum);
+  levels_bindFileStat(v_stmt, 3, i_filepath);
+  v_stmt->execute();
   return true;
 }
+
+static bool sqlUsesTable(const std::string &i_sql,
+                         const std::string &i_table) {
+  size_t v_pos = i_sql.find(i_table);
+  size_t v_end;
+
+  while (v_pos != std::string::npos) {
+    v_end = v_pos + i_table.length();
+
+    // the whole word only (levels is not weblevels)
+    if ((v_pos == 0 || (isalnum(i_sql[v_pos - 1]) == 0 &&
+                        i_sql[v_pos - 1] != '_')) &&
+        (v_end == i_sql.length() ||
+         (isalnum(i_sql[v_end]) == 0 && i_sql[v_end] != '_'))) {
+      return true;
+    }
+    v_pos = i_sql.find(i_table, v_pos + 1);
+  }
+
+  return false;
+}
+
+std::string xmDatabase::levels_packTablesVersions(const std::string &i_sql) {
+  xmDatabaseStatement *v_stmt;
+  std::string v_table;
+  std::string v_res;
+
+  v_stmt = prepare("SELECT tableName, version FROM xm_tablesVersions "
+                   "ORDER BY tableName;");
+  while (v_stmt->next()) {
+    v_table = v_stmt->getString(0);
+
+    // the finished levels of the pack are always counted
+    if (v_table == "stats_profiles_levels_completed" ||
+        sqlUsesTable(i_sql, v_table)) {
+      v_res += v_table + "=" + v_stmt->getString(1) + ";";
+    }
+  }
+
+  // the options read by the sql functions change the counts too
+  if (i_sql.find("xm_userCrappy(") != std::string::npos) {
+    v_res += std::string("crappy=") +
+             (XMSession::instance()->useCrappyPack() ? "1" : "0") + ";";
+  }
+  if (i_sql.find("xm_userChildrenCompliant(") != std::string::npos) {
+    v_res += std::string("childrenCompliant=") +
+             (XMSession::instance()->useChildrenCompliant() ? "1" : "0") +
+             ";";
+  }
+  if (i_sql.find("xm_profile(") != std::string::npos) {
+    v_res += "profile=" + XMSession::instance()->profile() + ";";
+  }
+  if (i_sql.find("xm_idRoom(") != std::string::npos) {
+    for (unsigned int i = 0; i < ROOMS_NB_MAX; i++) {
+      v_res += "room=" + XMSession::instance()->idRoom(i) + ";";
+    }
+  }
+
+  return v_res;
+}
+
+bool xmDatabase::levels_getPackCount(const std::string &i_sql,
+                                     const std::string &i_profile,
+                                     const std::string &i_tablesVersions,
+                                     int &o_nbLevels,
+                                     int &o_nbFinishedLevels) {
+  xmDatabaseStatement *v_stmt;
+
+  v_stmt = prepare("SELECT nbLevels, nbFinishedLevels "
+                   "FROM levels_packsCounts "
+                   "WHERE packSql=?1 AND id_profile=?2 AND tablesVersions=?3;");
+  v_stmt->bind(1, i_sql);
+  v_stmt->bind(2, i_profile);
+  v_stmt->bind(3, i_tablesVersions);
+
+  if (v_stmt->next() == false) {
+    return false;
+  }
+  o_nbLevels = v_stmt->getInt(0);
+  o_nbFinishedLevels = v_stmt->getInt(1);
+  v_stmt->reset();
+
+  return true;
+}
+
+void xmDatabase::levels_setPackCount(const std::string &i_sql,
+                                     const std::string &i_profile,
+                                     const std::string &i_tablesVersions,
+                                     int i_nbLevels,
+                                     int i_nbFinishedLevels) {
+  xmDatabaseStatement *v_stmt;
+
+  v_stmt = prepare("INSERT OR REPLACE INTO levels_packsCounts(packSql, "
+                   "id_profile, tablesVersions, nbLevels, nbFinishedLevels) "
+                   "VALUES(?1, ?2, ?3, ?4, ?5);");
+  v_stmt->bind(1, i_sql);
+  v_stmt->bind(2, i_profile);
+  v_stmt->bind(3, i_tablesVersions);
+  v_stmt->bind(4, i_nbLevels);
+  v_stmt->bind(5, i_nbFinishedLevels);
+  v_stmt->execute();
+}
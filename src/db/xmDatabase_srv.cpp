@@ -118,3 +118,15 @@ void xmDatabase::srv_changePassword(const std::string &i_profile,
             "WHERE id_profile=\"" +
             protectString(i_profile) + "\";");
 }
+
+void xmDatabase::srv_beginTransaction() {
+  simpleSql("BEGIN TRANSACTION;");
+}
+
+void xmDatabase::srv_commitTransaction() {
+  simpleSql("COMMIT;");
+}
+
+void xmDatabase::srv_rollbackTransaction() {
+  simpleSql("ROLLBACK;");
+}
@@ -147,24 +147,33 @@ void xmDatabase::updateDB_stats(XmDatabaseUpdateInterface *i_interface) {
 
 void xmDatabase::stats_createProfile(const std::string &i_sitekey,
                                      const std::string &i_profile) {
-  simpleSql("INSERT INTO stats_profiles(sitekey, id_profile, nbStarts, since) "
-            "VALUES(\"" +
-            protectString(i_sitekey) + "\", \"" + protectString(i_profile) +
-            "\", 0, \"" + GameApp::getTimeStamp() + "\");");
+  xmDatabaseStatement *v_stmt =
+    prepare("INSERT INTO stats_profiles(sitekey, id_profile, nbStarts, since) "
+            "VALUES(?1, ?2, 0, ?3);");
+
+  v_stmt->bind(1, i_sitekey);
+  v_stmt->bind(2, i_profile);
+  v_stmt->bind(3, GameApp::getTimeStamp());
+  v_stmt->execute();
 }
 
 void xmDatabase::stats_destroyProfile(const std::string &i_profile) {
+  const char *v_tables[] = { "stats_profiles",
+                             "levels_favorite",
+                             "profile_completedLevels",
+                             "stats_profiles_levels" };
+  xmDatabaseStatement *v_stmt;
+
   /* delete with all sitekeys */
   try {
     simpleSql("BEGIN TRANSACTION;");
-    simpleSql("DELETE FROM stats_profiles          WHERE id_profile=\"" +
-              protectString(i_profile) + "\";");
-    simpleSql("DELETE FROM levels_favorite         WHERE id_profile=\"" +
-              protectString(i_profile) + "\";");
-    simpleSql("DELETE FROM profile_completedLevels WHERE id_profile=\"" +
-              protectString(i_profile) + "\";");
-    simpleSql("DELETE FROM stats_profiles_levels   WHERE id_profile=\"" +
-              protectString(i_profile) + "\";");
+    for (unsigned int i = 0; i < sizeof(v_tables) / sizeof(v_tables[0]);
+         i++) {
+      v_stmt = prepare("DELETE FROM " + std::string(v_tables[i]) +
+                       " WHERE id_profile=?1;");
+      v_stmt->bind(1, i_profile);
+      v_stmt->execute();
+    }
     simpleSql("COMMIT;");
   } catch (Exception &e) {
     simpleSql("ROLLBACK;");
@@ -175,59 +184,83 @@ void xmDatabase::stats_destroyProfile(const std::string &i_profile) {
 bool xmDatabase::stats_checkKeyExists_stats_profiles(
   const std::string &i_sitekey,
   const std::string &i_profile) {
-  return checkKey("SELECT count(1) FROM stats_profiles "
-                  "WHERE sitekey=\"" +
-                  protectString(i_sitekey) + "\" "
-                                             "AND   id_profile=\"" +
-                  protectString(i_profile) + "\";");
+  xmDatabaseStatement *v_stmt = prepare("SELECT count(1) FROM stats_profiles "
+                                        "WHERE sitekey=?1 AND id_profile=?2;");
+  bool v_res;
+
+  v_stmt->bind(1, i_sitekey);
+  v_stmt->bind(2, i_profile);
+  v_res = v_stmt->next() && v_stmt->getInt(0) > 0;
+  v_stmt->reset();
+
+  return v_res;
 }
 
 bool xmDatabase::stats_checkKeyExists_stats_profiles_levels(
   const std::string &i_sitekey,
   const std::string &i_profile,
   const std::string &i_level) {
-  return checkKey("SELECT count(1) FROM stats_profiles_levels "
-                  "WHERE sitekey=\"" +
-                  protectString(i_sitekey) + "\" "
-                                             "AND   id_profile=\"" +
-                  protectString(i_profile) + "\" "
-                                             "AND   id_level=\"" +
-                  protectString(i_level) + "\";");
+  xmDatabaseStatement *v_stmt =
+    prepare("SELECT count(1) FROM stats_profiles_levels "
+            "WHERE sitekey=?1 AND id_profile=?2 AND id_level=?3;");
+  bool v_res;
+
+  v_stmt->bind(1, i_sitekey);
+  v_stmt->bind(2, i_profile);
+  v_stmt->bind(3, i_level);
+  v_res = v_stmt->next() && v_stmt->getInt(0) > 0;
+  v_stmt->reset();
+
+  return v_res;
 }
 
-void xmDatabase::stats_levelCompleted(const std::string &i_sitekey,
-                                      const std::string &PlayerName,
-                                      const std::string &LevelID,
-                                      int i_playTime) {
-  // printf("stats: level completed\n");
-  std::ostringstream v_playTime;
-  v_playTime << i_playTime;
+void xmDatabase::stats_levelPlayed(const std::string &i_sitekey,
+                                   const std::string &PlayerName,
+                                   const std::string &LevelID,
+                                   int i_playTime,
+                                   int i_nbPlayed,
+                                   int i_nbDied,
+                                   int i_nbCompleted,
+                                   int i_nbRestarted) {
+  xmDatabaseStatement *v_stmt;
 
   if (stats_checkKeyExists_stats_profiles_levels(
         i_sitekey, PlayerName, LevelID)) {
-    simpleSql("UPDATE stats_profiles_levels SET "
-              "nbCompleted=nbCompleted+1,"
-              "nbPlayed=nbPlayed+1,"
-              "playedTime=playedTime+" +
-              v_playTime.str() + "," +
-              "last_play_date=datetime('now', 'localtime'), "
-              "synchronized = 0 "
-              "WHERE sitekey=\"" +
-              protectString(i_sitekey) + "\" "
-                                         "AND id_profile=\"" +
-              protectString(PlayerName) + "\" "
-                                          "AND id_level=\"" +
-              protectString(LevelID) + "\";");
+    v_stmt = prepare("UPDATE stats_profiles_levels SET "
+                     "nbDied=nbDied+?4,"
+                     "nbCompleted=nbCompleted+?5,"
+                     "nbRestarted=nbRestarted+?6,"
+                     "nbPlayed=nbPlayed+?8,"
+                     "playedTime=playedTime+?7,"
+                     "last_play_date=datetime('now', 'localtime'), "
+                     "synchronized = 0 "
+                     "WHERE sitekey=?1 AND id_profile=?2 AND id_level=?3;");
   } else {
-    simpleSql("INSERT INTO stats_profiles_levels("
-              "sitekey, id_profile, id_level,"
-              "nbPlayed, nbDied, nbCompleted, nbRestarted, playedTime, "
-              "last_play_date, synchronized) "
-              "VALUES (\"" +
-              protectString(i_sitekey) + "\",\"" + protectString(PlayerName) +
-              "\", \"" + protectString(LevelID) + "\", 1, 0, 1, 0, \"" +
-              v_playTime.str() + "\", datetime('now', 'localtime'), 0);");
+    v_stmt = prepare("INSERT INTO stats_profiles_levels("
+                     "sitekey, id_profile, id_level,"
+                     "nbPlayed, nbDied, nbCompleted, nbRestarted, playedTime, "
+                     "last_play_date, synchronized) "
+                     "VALUES (?1, ?2, ?3, ?8, ?4, ?5, ?6, ?7, "
+                     "datetime('now', 'localtime'), 0);");
   }
+
+  v_stmt->bind(1, i_sitekey);
+  v_stmt->bind(2, PlayerName);
+  v_stmt->bind(3, LevelID);
+  v_stmt->bind(4, i_nbDied);
+  v_stmt->bind(5, i_nbCompleted);
+  v_stmt->bind(6, i_nbRestarted);
+  v_stmt->bind(7, i_playTime);
+  v_stmt->bind(8, i_nbPlayed);
+  v_stmt->execute();
+}
+
+void xmDatabase::stats_levelCompleted(const std::string &i_sitekey,
+                                      const std::string &PlayerName,
+                                      const std::string &LevelID,
+                                      int i_playTime) {
+  // printf("stats: level completed\n");
+  stats_levelPlayed(i_sitekey, PlayerName, LevelID, i_playTime, 1, 0, 1, 0);
 }
 
 void xmDatabase::stats_died(const std::string &i_sitekey,
@@ -235,34 +268,7 @@ void xmDatabase::stats_died(const std::string &i_sitekey,
                             const std::string &LevelID,
                             int i_playTime) {
   // printf("stats: level dead\n");
-  std::ostringstream v_playTime;
-  v_playTime << i_playTime;
-
-  if (stats_checkKeyExists_stats_profiles_levels(
-        i_sitekey, PlayerName, LevelID)) {
-    simpleSql("UPDATE stats_profiles_levels SET "
-              "nbDied=nbDied+1,"
-              "nbPlayed=nbPlayed+1,"
-              "playedTime=playedTime+" +
-              v_playTime.str() + "," +
-              "last_play_date=datetime('now', 'localtime'), "
-              "synchronized = 0 "
-              "WHERE sitekey=\"" +
-              protectString(i_sitekey) + "\" "
-                                         "AND id_profile=\"" +
-              protectString(PlayerName) + "\" "
-                                          "AND id_level=\"" +
-              protectString(LevelID) + "\";");
-  } else {
-    simpleSql("INSERT INTO stats_profiles_levels("
-              "sitekey, id_profile, id_level,"
-              "nbPlayed, nbDied, nbCompleted, nbRestarted, playedTime, "
-              "last_play_date, synchronized) "
-              "VALUES (\"" +
-              protectString(i_sitekey) + "\",\"" + protectString(PlayerName) +
-              "\", \"" + protectString(LevelID) + "\", 1, 1, 0, 0, \"" +
-              v_playTime.str() + "\", datetime('now', 'localtime'), 0);");
-  }
+  stats_levelPlayed(i_sitekey, PlayerName, LevelID, i_playTime, 1, 1, 0, 0);
 }
 
 void xmDatabase::stats_abortedLevel(const std::string &i_sitekey,
@@ -270,33 +276,7 @@ void xmDatabase::stats_abortedLevel(const std::string &i_sitekey,
                                     const std::string &LevelID,
                                     int i_playTime) {
   // printf("stats: level aborted\n");
-  std::ostringstream v_playTime;
-  v_playTime << i_playTime;
-
-  if (stats_checkKeyExists_stats_profiles_levels(
-        i_sitekey, PlayerName, LevelID)) {
-    simpleSql("UPDATE stats_profiles_levels SET "
-              "nbPlayed=nbPlayed+1,"
-              "playedTime=playedTime+" +
-              v_playTime.str() + "," +
-              "last_play_date=datetime('now', 'localtime'), "
-              "synchronized = 0 "
-              "WHERE sitekey=\"" +
-              protectString(i_sitekey) + "\" "
-                                         "AND id_profile=\"" +
-              protectString(PlayerName) + "\" "
-                                          "AND id_level=\"" +
-              protectString(LevelID) + "\";");
-  } else {
-    simpleSql("INSERT INTO stats_profiles_levels("
-              "sitekey, id_profile, id_level,"
-              "nbPlayed, nbDied, nbCompleted, nbRestarted, playedTime, "
-              "last_play_date, synchronized) "
-              "VALUES (\"" +
-              protectString(i_sitekey) + "\",\"" + protectString(PlayerName) +
-              "\", \"" + protectString(LevelID) + "\", 1, 0, 0, 0, \"" +
-              v_playTime.str() + "\", datetime('now', 'localtime'), 0);");
-  }
+  stats_levelPlayed(i_sitekey, PlayerName, LevelID, i_playTime, 1, 0, 0, 0);
 }
 
 void xmDatabase::stats_levelRestarted(const std::string &i_sitekey,
@@ -304,41 +284,40 @@ void xmDatabase::stats_levelRestarted(const std::string &i_sitekey,
                                       const std::string &LevelID,
                                       int i_playTime) {
   // printf("stats: level restarted\n");
-  std::ostringstream v_playTime;
-  v_playTime << i_playTime;
-
-  if (stats_checkKeyExists_stats_profiles_levels(
-        i_sitekey, PlayerName, LevelID)) {
-    simpleSql("UPDATE stats_profiles_levels SET "
-              "nbRestarted=nbRestarted+1,"
-              "nbPlayed=nbPlayed+1,"
-              "playedTime=playedTime+" +
-              v_playTime.str() + "," +
-              "last_play_date=datetime('now', 'localtime'), "
-              "synchronized = 0 "
-              "WHERE sitekey=\"" +
-              protectString(i_sitekey) + "\" "
-                                         "AND id_profile=\"" +
-              protectString(PlayerName) + "\" "
-                                          "AND id_level=\"" +
-              protectString(LevelID) + "\";");
-  } else {
-    simpleSql("INSERT INTO stats_profiles_levels("
-              "sitekey, id_profile, id_level,"
-              "nbPlayed, nbDied, nbCompleted, nbRestarted, playedTime, "
-              "last_play_date, synchronized) "
-              "VALUES (\"" +
-              protectString(i_sitekey) + "\",\"" + protectString(PlayerName) +
-              "\", \"" + protectString(LevelID) + "\", 1, 0, 0, 1, \"" +
-              v_playTime.str() + "\", datetime('now', 'localtime'), 0);");
-  }
+  stats_levelPlayed(i_sitekey, PlayerName, LevelID, i_playTime, 1, 0, 0, 1);
 }
 
 void xmDatabase::stats_xmotoStarted(const std::string &i_sitekey,
                                     const std::string &PlayerName) {
-  simpleSql("UPDATE stats_profiles SET "
+  xmDatabaseStatement *v_stmt =
+    prepare("UPDATE stats_profiles SET "
             "nbStarts=nbStarts+1 "
-            "WHERE sitekey=\"" +
-            i_sitekey + "\" AND id_profile=\"" + protectString(PlayerName) +
-            "\";");
+            "WHERE sitekey=?1 AND id_profile=?2;");
+
+  v_stmt->bind(1, i_sitekey);
+  v_stmt->bind(2, PlayerName);
+  v_stmt->execute();
+}
+
+void xmDatabase::stats_levelsPlayed(const std::string &i_sitekey,
+                                    const xmDatabaseLevelsPlays &i_plays) {
+  try {
+    simpleSql("BEGIN TRANSACTION;");
+    for (xmDatabaseLevelsPlays::const_iterator it = i_plays.begin();
+         it != i_plays.end();
+         ++it) {
+      stats_levelPlayed(i_sitekey,
+                        it->first.first,
+                        it->first.second,
+                        it->second.playedTime,
+                        it->second.nbPlayed,
+                        it->second.nbDied,
+                        it->second.nbCompleted,
+                        it->second.nbRestarted);
+    }
+    simpleSql("COMMIT;");
+  } catch (Exception &e) {
+    simpleSql("ROLLBACK;");
+    throw e;
+  }
 }
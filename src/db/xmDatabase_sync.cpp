@@ -21,21 +21,19 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "common/VFileIO.h"
 #include "common/VXml.h"
 #include "common/XMSession.h"
+#include "helpers/FileCompression.h"
 #include "helpers/VExcept.h"
 #include "xmDatabase.h"
 #include <sstream>
 
+/* the rows not synchronized yet are compressed as they are read */
 void xmDatabase::sync_buildServerFile(const std::string &i_outFile,
                                       const std::string &i_sitekey,
                                       const std::string &i_profile) {
-  char **v_result;
-  unsigned int nrow;
-  std::string v_res;
-  char v_line[2048];
+  xmDatabaseStatement *v_stmt;
+  std::ostringstream v_line;
   std::ostringstream v_lastDbSync;
 
-  FileHandle *pfh = XMFS::openOFile(FDT_CACHE, i_outFile);
-
   /*
     update dbSync:
     preparing all waiting lines with the new dbSync (incremented of 1)
@@ -50,92 +48,70 @@ void xmDatabase::sync_buildServerFile(const std::string &i_outFile,
             v_lastDbSync.str() + "\" WHERE synchronized=0;");
   /* ***** */
 
-  if (pfh == NULL) {
-    throw Exception("Unable to open " + i_outFile);
-  }
+  BZip2Writer v_out(i_outFile);
 
-  XMFS::writeLine(pfh, "<?xml version=\"1.0\" encoding=\"utf-8\"?>");
+  v_out.writeLine("<?xml version=\"1.0\" encoding=\"utf-8\"?>");
 
   /* header */
-  v_result = readDB("SELECT nbStarts, since "
-                    "FROM stats_profiles "
-                    "WHERE sitekey=\"" +
-                      protectString(i_sitekey) + "\" AND id_profile=\"" +
-                      protectString(i_profile) + "\";",
-                    nrow);
-  if (nrow != 1) {
-    read_DB_free(v_result);
+  v_stmt = prepare("SELECT nbStarts, since "
+                   "FROM stats_profiles "
+                   "WHERE sitekey=?1 AND id_profile=?2;");
+  v_stmt->bind(1, i_sitekey);
+  v_stmt->bind(2, i_profile);
+  if (v_stmt->next() == false) {
     throw Exception("Unable to retrieve information");
   }
 
-  snprintf(v_line,
-           2048,
-           "<xmoto_sync fileformat=\"1\" sitekey=\"%s\" profile=\"%s\" "
-           "nbStarts=\"%i\" since=\"%s\">",
-           XMLDocument::str2xmlstr(i_sitekey).c_str(),
-           XMLDocument::str2xmlstr(i_profile).c_str(),
-           atoi(getResult(v_result, 2, 0, 0)),
-           getResult(v_result, 2, 0, 1));
-  XMFS::writeLine(pfh, v_line);
-  read_DB_free(v_result);
+  v_line << "<xmoto_sync fileformat=\"1\" sitekey=\""
+         << XMLDocument::str2xmlstr(i_sitekey) << "\" profile=\""
+         << XMLDocument::str2xmlstr(i_profile) << "\" nbStarts=\""
+         << v_stmt->getInt(0) << "\" since=\"" << v_stmt->getString(1)
+         << "\">";
+  v_stmt->reset();
+  v_out.writeLine(v_line.str());
 
   /* stats_levels */
-  XMFS::writeLine(pfh, "<stats_levels>");
-  v_result = readDB("SELECT dbSync, id_level, nbPlayed, nbDied, nbCompleted, "
-                    "nbRestarted, playedTime, last_play_date "
-                    "FROM stats_profiles_levels "
-                    "WHERE sitekey=\"" +
-                      protectString(i_sitekey) + "\" AND id_profile=\"" +
-                      protectString(i_profile) + "\" "
-                                                 "AND synchronized=0;",
-                    nrow);
-  for (unsigned int i = 0; i < nrow; i++) {
-    snprintf(
-      v_line,
-      2048,
-      "<stats_level dbSync=\"%i\" id_level=\"%s\" nbPlayed=\"%i\" "
-      "nbDied=\"%i\" nbCompleted=\"%i\" nbRestarted=\"%i\" playedTime=\"%i\" "
-      "last_play_date=\"%s\" />",
-      atoi(getResult(v_result, 8, i, 0)),
-      XMLDocument::str2xmlstr(getResult(v_result, 8, i, 1)).c_str(),
-      atoi(getResult(v_result, 8, i, 2)),
-      atoi(getResult(v_result, 8, i, 3)),
-      atoi(getResult(v_result, 8, i, 4)),
-      atoi(getResult(v_result, 8, i, 5)),
-      getResult(v_result, 8, i, 6) == NULL ? 0
-                                           : atoi(getResult(v_result, 8, i, 6)),
-      getResult(v_result, 8, i, 7) == NULL ? "" : getResult(v_result, 8, i, 7));
-    XMFS::writeLine(pfh, v_line);
+  v_out.writeLine("<stats_levels>");
+  v_stmt = prepare("SELECT dbSync, id_level, nbPlayed, nbDied, nbCompleted, "
+                   "nbRestarted, playedTime, last_play_date "
+                   "FROM stats_profiles_levels "
+                   "WHERE sitekey=?1 AND id_profile=?2 "
+                   "AND synchronized=0;");
+  v_stmt->bind(1, i_sitekey);
+  v_stmt->bind(2, i_profile);
+  while (v_stmt->next()) {
+    v_line.str("");
+    v_line << "<stats_level dbSync=\"" << v_stmt->getInt(0)
+           << "\" id_level=\"" << XMLDocument::str2xmlstr(v_stmt->getString(1))
+           << "\" nbPlayed=\"" << v_stmt->getInt(2) << "\" nbDied=\""
+           << v_stmt->getInt(3) << "\" nbCompleted=\"" << v_stmt->getInt(4)
+           << "\" nbRestarted=\"" << v_stmt->getInt(5) << "\" playedTime=\""
+           << v_stmt->getInt(6) << "\" last_play_date=\""
+           << v_stmt->getString(7) << "\" />";
+    v_out.writeLine(v_line.str());
   }
-  XMFS::writeLine(pfh, "</stats_levels>");
+  v_out.writeLine("</stats_levels>");
 
   /* stats_completedLevels */
-  XMFS::writeLine(pfh, "<stats_completedLevels>");
-  read_DB_free(v_result);
-  v_result = readDB("SELECT dbSync, id_level, timeStamp, finishTime "
-                    "FROM profile_completedLevels "
-                    "WHERE sitekey=\"" +
-                      protectString(i_sitekey) + "\" AND id_profile=\"" +
-                      protectString(i_profile) + "\" "
-                                                 "AND synchronized=0;",
-                    nrow);
-  for (unsigned int i = 0; i < nrow; i++) {
-    snprintf(v_line,
-             2048,
-             "<stats_completedLevel dbSync=\"%i\" id_level=\"%s\" "
-             "timeStamp=\"%s\" finishTime=\"%i\" />",
-             atoi(getResult(v_result, 4, i, 0)),
-             XMLDocument::str2xmlstr(getResult(v_result, 4, i, 1)).c_str(),
-             getResult(v_result, 4, i, 2),
-             atoi(getResult(v_result, 4, i, 3)));
-    XMFS::writeLine(pfh, v_line);
+  v_out.writeLine("<stats_completedLevels>");
+  v_stmt = prepare("SELECT dbSync, id_level, timeStamp, finishTime "
+                   "FROM profile_completedLevels "
+                   "WHERE sitekey=?1 AND id_profile=?2 "
+                   "AND synchronized=0;");
+  v_stmt->bind(1, i_sitekey);
+  v_stmt->bind(2, i_profile);
+  while (v_stmt->next()) {
+    v_line.str("");
+    v_line << "<stats_completedLevel dbSync=\"" << v_stmt->getInt(0)
+           << "\" id_level=\"" << XMLDocument::str2xmlstr(v_stmt->getString(1))
+           << "\" timeStamp=\"" << v_stmt->getString(2) << "\" finishTime=\""
+           << v_stmt->getInt(3) << "\" />";
+    v_out.writeLine(v_line.str());
   }
-  read_DB_free(v_result);
-  XMFS::writeLine(pfh, "</stats_completedLevels>");
-
-  XMFS::writeLine(pfh, "</xmoto_sync>");
+  v_out.writeLine("</stats_completedLevels>");
 
-  XMFS::closeFile(pfh);
+  v_out.writeLine("</xmoto_sync>");
+  v_out.close();
 }
 
 void xmDatabase::setSynchronized() {
@@ -24,7 +24,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "helpers/VExcept.h"
 #include "xmDatabase.h"
 #include "xmoto/GameText.h"
+#include <set>
 #include <sstream>
+#include <vector>
 
 #define XM_NB_THIEFS_MAX 3
 
@@ -48,8 +50,7 @@ std::string xmDatabase::webhighscores_updateDB(
   FileDataType i_fdt,
   const std::string &i_webhighscoresFile,
   const std::string &i_websource) {
-  XMLDocument v_xml;
-  xmlNodePtr v_xmlElt;
+  XMLStreamReader v_xml;
   std::string v_roomName;
   std::string v_roomId;
   std::string v_levelId;
@@ -59,20 +60,24 @@ std::string xmDatabase::webhighscores_updateDB(
   std::string v_date;
   int v_time;
   size_t pos_1, pos_2;
+  xmDatabaseStatement *v_stmts[2];
+  xmDatabaseStatement *v_stmt;
+  std::set<std::string> v_levels;
+  std::vector<std::string> v_removedLevels;
 
   try {
     simpleSql("BEGIN TRANSACTION;");
 
-    v_xml.readFromFile(i_fdt, i_webhighscoresFile);
+    v_xml.openFile(i_fdt, i_webhighscoresFile);
 
-    v_xmlElt = v_xml.getRootNode("xmoto_worldrecords");
-    if (v_xmlElt == NULL) {
+    if (v_xml.nextElement(0) == false ||
+        v_xml.elementName() != "xmoto_worldrecords") {
       throw Exception("unable to analyze xml highscore file");
     }
 
     /* get Room information */
-    v_roomName = XMLDocument::getOption(v_xmlElt, "roomname");
-    v_roomId = XMLDocument::getOption(v_xmlElt, "roomid");
+    v_roomName = v_xml.getOption("roomname");
+    v_roomId = v_xml.getOption("roomid");
 
     if (v_roomId == "") {
       throw Exception("error : unable to analyze xml highscore file");
@@ -83,23 +88,35 @@ std::string xmDatabase::webhighscores_updateDB(
       webrooms_addRoom(v_roomId, v_roomName, i_websource);
     }
 
-    simpleSql("DELETE FROM webhighscores WHERE id_room=" + v_roomId + ";");
+    /* only the changed highscores are written : update them if they exist,
+       else insert them */
+    v_stmts[0] = prepare("UPDATE webhighscores "
+                         "SET id_profile=?3, finishTime=?4, date=?5, "
+                         "fileUrl=?6 "
+                         "WHERE id_room=?1 AND id_level=?2 "
+                         "AND NOT (id_profile IS ?3 AND finishTime IS ?4 "
+                         "AND date IS ?5 AND fileUrl IS ?6);");
+    v_stmts[1] = prepare("INSERT OR IGNORE INTO webhighscores(id_room, "
+                         "id_level, id_profile, finishTime, date, fileUrl) "
+                         "VALUES(?1, ?2, ?3, ?4, ?5, ?6);");
+
+    while (v_xml.nextElement(1)) {
+      if (v_xml.elementName() != "worldrecord") {
+        continue;
+      }
 
-    for (xmlNodePtr pSubElem = XMLDocument::subElement(v_xmlElt, "worldrecord");
-         pSubElem != NULL;
-         pSubElem = XMLDocument::nextElement(pSubElem)) {
-      v_levelId = XMLDocument::getOption(pSubElem, "level_id");
+      v_levelId = v_xml.getOption("level_id");
       if (v_levelId == "") {
         continue;
       }
 
-      v_player = XMLDocument::getOption(pSubElem, "player");
+      v_player = v_xml.getOption("player");
       if (v_player == "") {
         continue;
       }
 
       /* time */
-      v_strtime = XMLDocument::getOption(pSubElem, "time");
+      v_strtime = v_xml.getOption("time");
       if (v_strtime == "") {
         continue;
       }
@@ -118,27 +135,46 @@ std::string xmDatabase::webhighscores_updateDB(
           v_strtime.substr(pos_2 + 1, v_strtime.length() - pos_2 - 1).c_str());
 
       /* replay */
-      v_rplUrl = XMLDocument::getOption(pSubElem, "replay");
+      v_rplUrl = v_xml.getOption("replay");
       if (v_rplUrl == "") {
         continue;
       }
 
       /* date */
-      v_date = XMLDocument::getOption(pSubElem, "date");
+      v_date = v_xml.getOption("date");
       if (v_date == "") {
         continue;
       }
 
-      std::ostringstream v_secondTime;
-      v_secondTime << v_time;
+      for (unsigned int i = 0; i < 2; i++) {
+        v_stmts[i]->bind(1, atoi(v_roomId.c_str()));
+        v_stmts[i]->bind(2, v_levelId);
+        v_stmts[i]->bind(3, v_player);
+        v_stmts[i]->bind(4, v_time);
+        v_stmts[i]->bind(5, v_date);
+        v_stmts[i]->bind(6, v_rplUrl);
+        v_stmts[i]->execute();
+      }
+      v_levels.insert(v_levelId);
+    }
+
+    /* remove the highscores which are no more in the file */
+    v_stmt = prepare("SELECT id_level FROM webhighscores WHERE id_room=?1;");
+    v_stmt->bind(1, atoi(v_roomId.c_str()));
+    while (v_stmt->next()) {
+      if (v_levels.find(v_stmt->getString(0)) == v_levels.end()) {
+        v_removedLevels.push_back(v_stmt->getString(0));
+      }
+    }
 
-      simpleSql("INSERT INTO webhighscores(id_room, id_level, id_profile, "
-                "finishTime, date, fileUrl)"
-                "VALUES(" +
-                v_roomId + ", \"" + protectString(v_levelId) + "\", \"" +
-                protectString(v_player) + "\", " + v_secondTime.str() + ", \"" +
-                v_date + "\", \"" + protectString(v_rplUrl) + "\");");
+    v_stmt = prepare("DELETE FROM webhighscores "
+                     "WHERE id_room=?1 AND id_level=?2;");
+    for (unsigned int i = 0; i < v_removedLevels.size(); i++) {
+      v_stmt->bind(1, atoi(v_roomId.c_str()));
+      v_stmt->bind(2, v_removedLevels[i]);
+      v_stmt->execute();
     }
+
     simpleSql("COMMIT;");
   } catch (Exception &e) {
     simpleSql("ROLLBACK;");
@@ -197,51 +233,76 @@ bool xmDatabase::isWebVoteLocked(const std::string &i_id_level) {
 
 void xmDatabase::weblevels_updateDB(FileDataType i_fdt,
                                     const std::string &i_weblevelsFile) {
-  XMLDocument v_xml;
-  xmlNodePtr v_xmlElt;
+  XMLStreamReader v_xml;
+  xmDatabaseStatement *v_stmts[2];
+  xmDatabaseStatement *v_stmt;
+  std::set<std::string> v_levels;
+  std::vector<std::string> v_removedLevels;
 
   try {
     simpleSql("BEGIN TRANSACTION;");
-    simpleSql("DELETE FROM weblevels;");
 
-    v_xml.readFromFile(i_fdt, i_weblevelsFile);
+    v_xml.openFile(i_fdt, i_weblevelsFile);
 
-    v_xmlElt = v_xml.getRootNode("xmoto_levels");
-    if (v_xmlElt == NULL) {
+    if (v_xml.nextElement(0) == false ||
+        v_xml.elementName() != "xmoto_levels") {
       throw Exception("unable to analyze xml file");
     }
 
-    for (xmlNodePtr pSubElem = XMLDocument::subElement(v_xmlElt, "level");
-         pSubElem != NULL;
-         pSubElem = XMLDocument::nextElement(pSubElem)) {
+    /* only the changed levels are written : update them if they exist, else
+       insert them ; difficulty and quality are converted by sqlite to not
+       depend on the locale */
+    v_stmts[0] = prepare(
+      "UPDATE weblevels "
+      "SET name=?2, packname=?3, packnum=?4, fileUrl=?5, checkSum=?6, "
+      "difficulty=CAST(?7 AS REAL), quality=CAST(?8 AS REAL), "
+      "creationDate=?9, crappy=?10, children_compliant=?11, vote_locked=?12 "
+      "WHERE id_level=?1 "
+      "AND NOT (name IS ?2 AND packname IS ?3 AND packnum IS ?4 "
+      "AND fileUrl IS ?5 AND checkSum IS ?6 "
+      "AND difficulty IS CAST(?7 AS REAL) AND quality IS CAST(?8 AS REAL) "
+      "AND creationDate IS ?9 AND crappy IS ?10 "
+      "AND children_compliant IS ?11 AND vote_locked IS ?12);");
+    v_stmts[1] = prepare(
+      "INSERT OR IGNORE INTO weblevels(id_level, name, packname, packnum, "
+      "fileUrl, checkSum, difficulty, quality, creationDate, crappy, "
+      "children_compliant, vote_locked) "
+      "VALUES(?1, ?2, ?3, ?4, ?5, ?6, CAST(?7 AS REAL), CAST(?8 AS REAL), "
+      "?9, ?10, ?11, ?12);");
+
+    while (v_xml.nextElement(1)) {
       std::string v_levelId, v_levelName, v_url, v_MD5sum_web;
       std::string v_difficulty, v_quality, v_creationDate;
       std::string v_crappy, v_children_compliant, v_vote_locked;
       std::string v_packname, v_packnum;
 
-      v_levelId = XMLDocument::getOption(pSubElem, "level_id");
+      if (v_xml.elementName() != "level") {
+        continue;
+      }
+
+      v_levelId = v_xml.getOption("level_id");
       if (v_levelId == "")
         continue;
 
-      v_levelName = XMLDocument::getOption(pSubElem, "name");
+      v_levelName = v_xml.getOption("name");
       if (v_levelName == "")
         continue;
 
-      v_packname = XMLDocument::getOption(pSubElem, "packname");
+      v_packname = v_xml.getOption("packname");
       if (v_packname != "") {
-        v_packnum = XMLDocument::getOption(pSubElem, "packnum");
+        v_packnum = v_xml.getOption("packnum");
       }
 
-      v_url = XMLDocument::getOption(pSubElem, "url");
+      v_url = v_xml.getOption("url");
       if (v_url == "")
         continue;
 
-      v_MD5sum_web = XMLDocument::getOption(pSubElem, "sum");
+      v_MD5sum_web = v_xml.getOption("sum");
       if (v_MD5sum_web == "")
         continue;
 
       /* web information */
-      v_difficulty = XMLDocument::getOption(pSubElem, "web_difficulty");
+      v_difficulty = v_xml.getOption("web_difficulty");
       if (v_difficulty == "")
         continue;
       for (unsigned int i = 0; i < v_difficulty.length(); i++) {
@@ -249,7 +310,7 @@ void xmDatabase::weblevels_updateDB(FileDataType i_fdt,
           v_difficulty[i] = '.';
       }
 
-      v_quality = XMLDocument::getOption(pSubElem, "web_quality");
+      v_quality = v_xml.getOption("web_quality");
       if (v_quality == "")
         continue;
       for (unsigned int i = 0; i < v_quality.length(); i++) {
@@ -257,44 +318,64 @@ void xmDatabase::weblevels_updateDB(FileDataType i_fdt,
           v_quality[i] = '.';
       }
 
-      v_creationDate = XMLDocument::getOption(pSubElem, "creation_date");
+      v_creationDate = v_xml.getOption("creation_date");
       if (v_creationDate == "")
         continue;
 
-      v_crappy = XMLDocument::getOption(pSubElem, "crappy");
+      v_crappy = v_xml.getOption("crappy");
       if (v_crappy == "") {
         v_crappy = "0";
       } else {
         v_crappy = v_crappy == "true" ? "1" : "0";
       }
 
-      v_children_compliant =
-        XMLDocument::getOption(pSubElem, "children_compliant");
+      v_children_compliant = v_xml.getOption("children_compliant");
       if (v_children_compliant == "") {
         v_children_compliant = "1";
       } else {
         v_children_compliant = v_children_compliant == "true" ? "1" : "0";
       }
 
-      v_vote_locked = XMLDocument::getOption(pSubElem, "vote_locked");
+      v_vote_locked = v_xml.getOption("vote_locked");
       if (v_vote_locked == "") {
         v_vote_locked = "0";
       } else {
         v_vote_locked = v_vote_locked == "true" ? "1" : "0";
       }
 
-      // add the level
-      simpleSql(
-        "INSERT INTO weblevels(id_level, name, packname, packnum, fileUrl, "
-        "checkSum, difficulty, quality, creationDate, crappy, "
-        "children_compliant, vote_locked) VALUES (\"" +
-        protectString(v_levelId) + "\", \"" + protectString(v_levelName) +
-        "\", \"" + protectString(v_packname) + "\", \"" +
-        protectString(v_packnum) + "\", \"" + protectString(v_url) + "\", \"" +
-        protectString(v_MD5sum_web) + "\", " + v_difficulty + ", " + v_quality +
-        ", \"" + v_creationDate + "\", " + v_crappy + ", " +
-        v_children_compliant + ", " + v_vote_locked + ");");
+      // add or update the level
+      for (unsigned int i = 0; i < 2; i++) {
+        v_stmts[i]->bind(1, v_levelId);
+        v_stmts[i]->bind(2, v_levelName);
+        v_stmts[i]->bind(3, v_packname);
+        v_stmts[i]->bind(4, v_packnum);
+        v_stmts[i]->bind(5, v_url);
+        v_stmts[i]->bind(6, v_MD5sum_web);
+        v_stmts[i]->bind(7, v_difficulty);
+        v_stmts[i]->bind(8, v_quality);
+        v_stmts[i]->bind(9, v_creationDate);
+        v_stmts[i]->bind(10, atoi(v_crappy.c_str()));
+        v_stmts[i]->bind(11, atoi(v_children_compliant.c_str()));
+        v_stmts[i]->bind(12, atoi(v_vote_locked.c_str()));
+        v_stmts[i]->execute();
+      }
+      v_levels.insert(v_levelId);
+    }
+
+    /* remove the levels which are no more in the file */
+    v_stmt = prepare("SELECT id_level FROM weblevels;");
+    while (v_stmt->next()) {
+      if (v_levels.find(v_stmt->getString(0)) == v_levels.end()) {
+        v_removedLevels.push_back(v_stmt->getString(0));
+      }
+    }
+
+    v_stmt = prepare("DELETE FROM weblevels WHERE id_level=?1;");
+    for (unsigned int i = 0; i < v_removedLevels.size(); i++) {
+      v_stmt->bind(1, v_removedLevels[i]);
+      v_stmt->execute();
     }
+
     simpleSql("COMMIT;");
   } catch (Exception &e) {
     simpleSql("ROLLBACK;");
@@ -400,6 +481,9 @@ void xmDatabase::webLoadDataFirstTime() {
   unsigned int nrow;
   bool v_update = false;
 
+  // errors are caught below, the bulk load is always left
+  setBulkLoad(true);
+
   /* updating weblevels table with defaults */
   try {
     /* if the is any row already in the table, no update is done */
@@ -442,6 +526,8 @@ void xmDatabase::webLoadDataFirstTime() {
     /* ok, no pb */
     LogWarning("Loading delivered webhighscores.xml failed");
   }
+
+  setBulkLoad(false);
 }
 
 void xmDatabase::updateMyHighscoresFromHighscores(
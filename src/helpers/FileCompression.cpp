@@ -149,6 +149,86 @@ void FileCompression::bzip2(std::string p_fileIN, std::string p_fileOUT) {
   fclose(f_out);
 }
 
+BZip2Writer::BZip2Writer(const std::string &i_fileOUT) {
+  int bzerror_out;
+
+  m_fileOUT = i_fileOUT;
+  m_bzFile = NULL;
+
+  m_file = fopen(m_fileOUT.c_str(), "wb");
+  if (!m_file) {
+    throw Exception("Unable to write file " + m_fileOUT);
+  }
+
+  m_bzFile = BZ2_bzWriteOpen(&bzerror_out, m_file, 9, 0, 0);
+  if (bzerror_out != BZ_OK) {
+    m_bzFile = NULL;
+    abort();
+    throw Exception("Unable to write file " + m_fileOUT);
+  }
+}
+
+BZip2Writer::~BZip2Writer() {
+  if (m_file != NULL) {
+    abort();
+  }
+}
+
+void BZip2Writer::abort() {
+  int bzerror_out;
+
+  if (m_bzFile != NULL) {
+    BZ2_bzWriteClose(&bzerror_out, (BZFILE *)m_bzFile, 1, NULL, NULL);
+    m_bzFile = NULL;
+  }
+  fclose(m_file);
+  m_file = NULL;
+  remove(m_fileOUT.c_str());
+}
+
+void BZip2Writer::write(const std::string &i_data) {
+  int bzerror_out;
+
+  if (m_file == NULL) {
+    throw Exception("Unable to write file " + m_fileOUT);
+  }
+
+  BZ2_bzWrite(&bzerror_out,
+              (BZFILE *)m_bzFile,
+              (void *)i_data.c_str(),
+              i_data.length());
+  if (bzerror_out != BZ_OK) {
+    abort();
+    throw Exception("Unable to write file " + m_fileOUT);
+  }
+}
+
+void BZip2Writer::writeLine(const std::string &i_line) {
+  write(i_line + "\n");
+}
+
+void BZip2Writer::close() {
+  int bzerror_out;
+
+  if (m_file == NULL) {
+    throw Exception("Unable to write file " + m_fileOUT);
+  }
+
+  BZ2_bzWriteClose(&bzerror_out, (BZFILE *)m_bzFile, 0, NULL, NULL);
+  m_bzFile = NULL;
+  if (bzerror_out != BZ_OK) {
+    abort();
+    throw Exception("Unable to write file " + m_fileOUT);
+  }
+
+  if (fclose(m_file) != 0) {
+    m_file = NULL;
+    remove(m_fileOUT.c_str());
+    throw Exception("Unable to write file " + m_fileOUT);
+  }
+  m_file = NULL;
+}
+
 char *FileCompression::zcompress(const char *i_data,
                                  int i_len,
                                  int &o_outputLen) {
@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #ifndef __FILECOMPRESSION_H__
 #define __FILECOMPRESSION_H__
 
+#include <stdio.h>
 #include <string>
 
 class FileCompression {
@@ -35,4 +36,25 @@ public:
                           int i_outputDataLen);
 };
 
+/*
+  text compressed as it is written, without temporary file ; the file is
+  removed if it is not closed
+*/
+class BZip2Writer {
+public:
+  BZip2Writer(const std::string &i_fileOUT);
+  ~BZip2Writer();
+
+  void write(const std::string &i_data);
+  void writeLine(const std::string &i_line);
+  void close();
+
+private:
+  void abort();
+
+  std::string m_fileOUT;
+  FILE *m_file;
+  void *m_bzFile;
+};
+
 #endif /* __FILECOMPRESSION_H__ */
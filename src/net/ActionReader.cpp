@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <string.h>
 
 #define XM_MAX_PACKET_SIZE_DIGITS 6 // limit the size of a command : n digits
+#define XM_MAX_PACKET_SIZE_VARINT 3 // idem for binary headers : n bytes
 
 unsigned int ActionReader::m_biggestTCPPacketReceived = 0;
 unsigned int ActionReader::m_biggestUDPPacketReceived = 0;
@@ -41,10 +42,15 @@ ActionReader::ActionReader() {
   m_tcpPacketOffset = 0;
   m_tcpNotEnoughData = false;
   m_tcpPossiblyInBuffer = false;
+  m_tcpBytesReceived = 0;
 }
 
 ActionReader::~ActionReader() {}
 
+unsigned int ActionReader::tcpBytesReceived() const {
+  return m_tcpBytesReceived;
+}
+
 /* log version */
 void ActionReader::logStats() {
   LogInfo("%-36s : %u",
@@ -73,6 +79,7 @@ bool ActionReader::TCPReadAction(TCPsocket *i_tcpsd, NetActionU *o_netAction) {
   int nread;
   unsigned int v_cmdStart;
   unsigned int v_packetSize;
+  bool v_binaryHeader;
 
   if (m_tcpPossiblyInBuffer == false) { // don't read from the socket if there
     // is possibly still packets in the
@@ -84,6 +91,7 @@ bool ActionReader::TCPReadAction(TCPsocket *i_tcpsd, NetActionU *o_netAction) {
       throw DisconnectedException();
     }
     m_tcpPacketOffset += nread;
+    m_tcpBytesReceived += nread;
     LogDebug("Data received (%u bytes available)", m_tcpPacketOffset);
     m_tcpNotEnoughData = false; // you don't know if the buffer is full enough
 
@@ -96,15 +104,18 @@ bool ActionReader::TCPReadAction(TCPsocket *i_tcpsd, NetActionU *o_netAction) {
 
   m_tcpPossiblyInBuffer = false;
 
-  while ((v_packetSize =
-            getSubPacketSize(m_tcpBuffer, m_tcpPacketOffset, v_cmdStart)) > 0 &&
+  while ((v_packetSize = getSubPacketSize(
+              m_tcpBuffer, m_tcpPacketOffset, v_cmdStart, v_binaryHeader)) >
+           0 &&
          m_tcpNotEnoughData == false) {
     LogDebug("Packet size is %u", v_packetSize);
     try {
       if (m_tcpPacketOffset - v_cmdStart >= v_packetSize) {
         LogDebug("One packet to manage");
-        NetAction::getNetAction(
-          o_netAction, ((char *)m_tcpBuffer) + v_cmdStart, v_packetSize);
+        NetAction::getNetAction(o_netAction,
+                                ((char *)m_tcpBuffer) + v_cmdStart,
+                                v_packetSize,
+                                v_binaryHeader);
 
         // remove the managed packet
         // main case : the buffer contains exactly one command
@@ -138,9 +149,38 @@ bool ActionReader::TCPReadAction(TCPsocket *i_tcpsd, NetActionU *o_netAction) {
 // return the size of the packet or 0 if no packet is available
 unsigned int ActionReader::getSubPacketSize(void *data,
                                             unsigned int len,
-                                            unsigned int &o_cmdStart) {
+                                            unsigned int &o_cmdStart,
+                                            bool &o_binaryHeader) {
   unsigned int i = 0;
   unsigned int res;
+  unsigned int v_sizeLength;
+
+  /* binary header : the size is a varint, read without any copy */
+  if (len > 0 && ((unsigned char *)data)[0] == XM_NET_BINARY_HEADER_MARKER) {
+    o_binaryHeader = true;
+
+    try {
+      if (NetAction::readVarint(((unsigned char *)data) + 1,
+                                len - 1,
+                                XM_MAX_PACKET_SIZE_VARINT,
+                                &res,
+                                &v_sizeLength) == false) {
+        return 0; // wait for more data
+      }
+    } catch (Exception &e) {
+      res = 0;
+    }
+
+    if (res == 0 || res > XM_MAX_PACKET_SIZE) {
+      Logger::LogData(data, len);
+      LogWarning("net: nasty client detected (4)");
+      throw Exception("net: nasty client detected");
+    }
+
+    o_cmdStart = 1 + v_sizeLength;
+    return res;
+  }
+  o_binaryHeader = false;
 
   while (i < len && i < XM_MAX_PACKET_SIZE_DIGITS + 1) {
     if (((char *)data)[i] == '\n') {
@@ -174,6 +214,7 @@ void ActionReader::UDPReadAction(Uint8 *data,
                                  NetActionU *o_netAction) {
   unsigned int v_size;
   unsigned int v_cmdStart;
+  bool v_binaryHeader;
 
   if (len > ActionReader::m_biggestUDPPacketReceived) {
     ActionReader::m_biggestUDPPacketReceived = len;
@@ -181,8 +222,14 @@ void ActionReader::UDPReadAction(Uint8 *data,
   ActionReader::m_nbUDPPacketsReceived++;
   ActionReader::m_UDPPacketsSizeReceived += len;
 
-  if ((v_size = ActionReader::getSubPacketSize(data, len, v_cmdStart)) > 0) {
-    NetAction::getNetAction(o_netAction, ((char *)data) + v_cmdStart, v_size);
+  if ((v_size = ActionReader::getSubPacketSize(
+         data, len, v_cmdStart, v_binaryHeader)) > 0) {
+    /* the size must match the datagram */
+    if (v_cmdStart + v_size > (unsigned int)len) {
+      throw Exception("net: nasty client detected (3)");
+    }
+    NetAction::getNetAction(
+      o_netAction, ((char *)data) + v_cmdStart, v_size, v_binaryHeader);
   } else {
     throw Exception("net: nasty client detected (3)");
   }
@@ -41,6 +41,9 @@ public:
 
   static void logStats();
 
+  // bytes read by this reader
+  unsigned int tcpBytesReceived() const;
+
   /* stats */
   static unsigned int m_biggestTCPPacketReceived;
   static unsigned int m_biggestUDPPacketReceived;
@@ -55,10 +58,12 @@ private:
   bool m_tcpNotEnoughData;
   char m_tcpBuffer[XM_MAX_PACKET_SIZE];
   bool m_tcpPossiblyInBuffer; // an action is possibly in the buffer
+  unsigned int m_tcpBytesReceived;
 
   static unsigned int getSubPacketSize(void *data,
                                        unsigned int len,
-                                       unsigned int &o_cmdStart);
+                                       unsigned int &o_cmdStart,
+                                       bool &o_binaryHeader);
 };
 
 #endif
@@ -44,6 +44,8 @@ std::string NA_chatMessage::ActionKey = "message";
 std::string NA_chatMessagePP::ActionKey = "messagePP";
 // frame : while it's sent a lot, reduce it at maximum
 std::string NA_frame::ActionKey = "f";
+std::string NA_frameDelta::ActionKey = "fd";
+std::string NA_frameAck::ActionKey = "fa";
 std::string NA_clientInfos::ActionKey = "clientInfos";
 std::string NA_udpBind::ActionKey = "udpbind";
 std::string NA_udpBindQuery::ActionKey = "udpbindingQuery";
@@ -70,6 +72,8 @@ std::string NA_ping::ActionKey = "ping";
 NetActionType NA_chatMessage::NAType = TNA_chatMessage;
 NetActionType NA_chatMessagePP::NAType = TNA_chatMessagePP;
 NetActionType NA_frame::NAType = TNA_frame;
+NetActionType NA_frameDelta::NAType = TNA_frameDelta;
+NetActionType NA_frameAck::NAType = TNA_frameAck;
 NetActionType NA_clientInfos::NAType = TNA_clientInfos;
 NetActionType NA_udpBind::NAType = TNA_udpBind;
 NetActionType NA_udpBindQuery::NAType = TNA_udpBindQuery;
@@ -95,6 +99,7 @@ NetAction::NetAction(bool i_forceTcp) {
   m_source = -2; // < -1 => undefined
   m_subsource = -2;
   m_forceTCP = i_forceTcp;
+  m_binaryHeader = false;
 }
 
 NetAction::~NetAction() {}
@@ -135,28 +140,55 @@ void NetAction::send(TCPsocket *i_tcpsd,
   }
 
   unsigned int v_subPacketSize = subPacketLen + 1;
-  std::ostringstream v_nb, v_src, v_subsrc;
-  v_src << m_source;
-  v_subsrc << m_subsource;
-  unsigned int v_subHeaderSize = v_src.str().length() + 1 +
-                                 v_subsrc.str().length() + 1 +
-                                 actionKey().length() + 1;
-  v_nb << (v_subHeaderSize + v_subPacketSize);
-  unsigned int v_headerSize = v_nb.str().length() + 1 + v_subHeaderSize;
-
-  unsigned int v_totalPacketSize = v_headerSize + v_subPacketSize;
-
-  if (v_totalPacketSize > NETACTION_MAX_PACKET_SIZE) {
-    throw Exception("net: too big packet to send");
-  }
-
-  snprintf(m_buffer,
-           NETACTION_MAX_PACKET_SIZE,
-           "%s\n%s\n%s\n%s\n",
-           v_nb.str().c_str(),
-           v_src.str().c_str(),
-           v_subsrc.str().c_str(),
-           actionKey().c_str());
+  unsigned int v_headerSize;
+  unsigned int v_totalPacketSize;
+
+  if (m_binaryHeader) {
+    /* marker, varint size, type, varint (source+1)*NETACTION_MAX_SUBSRC +
+     * subsource */
+    unsigned char v_size[XM_NET_VARINT_MAX_SIZE];
+    unsigned char v_source[XM_NET_VARINT_MAX_SIZE];
+    unsigned int v_sizeLength, v_sourceLength;
+
+    v_sourceLength = writeVarint(
+      (m_source + 1) * NETACTION_MAX_SUBSRC + m_subsource, v_source);
+    v_sizeLength = writeVarint(1 + v_sourceLength + v_subPacketSize, v_size);
+    v_headerSize = 1 + v_sizeLength + 1 + v_sourceLength;
+    v_totalPacketSize = v_headerSize + v_subPacketSize;
+
+    if (v_totalPacketSize > NETACTION_MAX_PACKET_SIZE) {
+      throw Exception("net: too big packet to send");
+    }
+
+    m_buffer[0] = XM_NET_BINARY_HEADER_MARKER;
+    memcpy(m_buffer + 1, v_size, v_sizeLength);
+    m_buffer[1 + v_sizeLength] = (unsigned char)actionType();
+    memcpy(m_buffer + 1 + v_sizeLength + 1, v_source, v_sourceLength);
+
+  } else {
+    std::ostringstream v_nb, v_src, v_subsrc;
+    v_src << m_source;
+    v_subsrc << m_subsource;
+    unsigned int v_subHeaderSize = v_src.str().length() + 1 +
+                                   v_subsrc.str().length() + 1 +
+                                   actionKey().length() + 1;
+    v_nb << (v_subHeaderSize + v_subPacketSize);
+    v_headerSize = v_nb.str().length() + 1 + v_subHeaderSize;
+    v_totalPacketSize = v_headerSize + v_subPacketSize;
+
+    if (v_totalPacketSize > NETACTION_MAX_PACKET_SIZE) {
+      throw Exception("net: too big packet to send");
+    }
+
+    snprintf(m_buffer,
+             NETACTION_MAX_PACKET_SIZE,
+             "%s\n%s\n%s\n%s\n",
+             v_nb.str().c_str(),
+             v_src.str().c_str(),
+             v_subsrc.str().c_str(),
+             actionKey().c_str());
+  }
+
   if (subPacketLen != 0) {
     memcpy(m_buffer + v_headerSize, subPacketData, subPacketLen);
   }
@@ -212,175 +244,319 @@ int NetAction::getSubSource() const {
   return m_subsource;
 }
 
+void NetAction::setBinaryHeader(bool i_value) {
+  m_binaryHeader = i_value;
+}
+
+bool NetAction::hasBinaryHeader() const {
+  return m_binaryHeader;
+}
+
+unsigned int NetAction::writeVarint(unsigned int i_value,
+                                    unsigned char *o_data) {
+  unsigned int v_size = 0;
+
+  while (i_value >= 0x80) {
+    o_data[v_size++] = (i_value & 0x7F) | 0x80;
+    i_value >>= 7;
+  }
+  o_data[v_size++] = i_value;
+
+  return v_size;
+}
+
+bool NetAction::readVarint(const unsigned char *i_data,
+                           unsigned int i_len,
+                           unsigned int i_maxSize,
+                           unsigned int *o_value,
+                           unsigned int *o_size) {
+  unsigned int v_value = 0;
+
+  for (unsigned int i = 0; i < i_maxSize; i++) {
+    if (i >= i_len) {
+      return false;
+    }
+    v_value |= ((unsigned int)(i_data[i] & 0x7F)) << (7 * i);
+    if ((i_data[i] & 0x80) == 0) {
+      *o_value = v_value;
+      *o_size = i + 1;
+      return true;
+    }
+  }
+
+  throw Exception("net: invalid varint");
+}
+
 void NetAction::getNetAction(NetActionU *o_netAction,
                              void *data,
-                             unsigned int len) {
-  std::string v_cmd;
+                             unsigned int len,
+                             bool i_binaryHeader) {
+  NetActionType v_type;
   int v_src, v_subsrc;
   unsigned int v_totalOffset = 0;
 
-  v_src = atoi(
-    getLine(((char *)data) + v_totalOffset, len - v_totalOffset, &v_totalOffset)
-      .c_str());
-  v_subsrc = atoi(
-    getLine(((char *)data + v_totalOffset), len - v_totalOffset, &v_totalOffset)
-      .c_str());
+  if (i_binaryHeader) {
+    /* read in place : the type on one byte, then the source and the subsource
+     * packed in a varint */
+    unsigned int v_source, v_sourceSize;
+
+    if (len < 1 || ((unsigned char *)data)[0] > TNA_frameAck) {
+      throw Exception("net: invalid command");
+    }
+    v_type = (NetActionType)((unsigned char *)data)[0];
+
+    if (readVarint(((unsigned char *)data) + 1,
+                   len - 1,
+                   XM_NET_VARINT_MAX_SIZE,
+                   &v_source,
+                   &v_sourceSize) == false) {
+      throw Exception("Invalid source");
+    }
+    v_src = ((int)(v_source / NETACTION_MAX_SUBSRC)) - 1;
+    v_subsrc = v_source % NETACTION_MAX_SUBSRC;
+    v_totalOffset = 1 + v_sourceSize;
+
+  } else {
+    v_src = atoi(getLine(((char *)data) + v_totalOffset,
+                         len - v_totalOffset,
+                         &v_totalOffset)
+                   .c_str());
+    v_subsrc = atoi(getLine(((char *)data + v_totalOffset),
+                            len - v_totalOffset,
+                            &v_totalOffset)
+                      .c_str());
+
+    v_type = getActionType(
+      getLine(((char *)data + v_totalOffset), len, &v_totalOffset));
+  }
 
   if (v_src < -1 || v_subsrc < 0 ||
       v_subsrc >= NETACTION_MAX_SUBSRC) { // subsrc must be 0, 1 or 2 or 3
     throw Exception("Invalid source");
   }
 
-  v_cmd = getLine(((char *)data + v_totalOffset), len, &v_totalOffset);
+  buildNetAction(
+    o_netAction, v_type, ((char *)data) + v_totalOffset, len - v_totalOffset);
 
-  // printf("cmd = %s (%i/%i)\n", v_cmd.c_str(), v_totalOffset,
-  // len-v_totalOffset);
+  o_netAction->master->setSource(v_src, v_subsrc);
+  o_netAction->master->setBinaryHeader(i_binaryHeader);
+}
 
-  if (v_cmd == NA_frame::ActionKey) {
-    o_netAction->frame =
-      NA_frame(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->frame);
+NetActionType NetAction::getActionType(const std::string &i_key) {
+  if (i_key == NA_frame::ActionKey) {
+    return NA_frame::NAType;
   }
-
-  else if (v_cmd == NA_playerControl::ActionKey) {
-    o_netAction->playerControl =
-      NA_playerControl(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->playerControl);
+  if (i_key == NA_frameDelta::ActionKey) {
+    return NA_frameDelta::NAType;
   }
-
-  else if (v_cmd == NA_chatMessage::ActionKey) {
-    o_netAction->chatMessage =
-      NA_chatMessage(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->chatMessage);
+  if (i_key == NA_frameAck::ActionKey) {
+    return NA_frameAck::NAType;
   }
-
-  else if (v_cmd == NA_chatMessagePP::ActionKey) {
-    o_netAction->chatMessagePP =
-      NA_chatMessagePP(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->chatMessagePP);
+  if (i_key == NA_playerControl::ActionKey) {
+    return NA_playerControl::NAType;
   }
-
-  else if (v_cmd == NA_clientInfos::ActionKey) {
-    o_netAction->clientInfos =
-      NA_clientInfos(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->clientInfos);
+  if (i_key == NA_chatMessage::ActionKey) {
+    return NA_chatMessage::NAType;
   }
-
-  else if (v_cmd == NA_udpBindQuery::ActionKey) {
-    o_netAction->udpBindQuery =
-      NA_udpBindQuery(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->udpBindQuery);
+  if (i_key == NA_chatMessagePP::ActionKey) {
+    return NA_chatMessagePP::NAType;
   }
-
-  else if (v_cmd == NA_udpBindValidation::ActionKey) {
-    o_netAction->udpBindValidation =
-      NA_udpBindValidation(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->udpBindValidation);
+  if (i_key == NA_clientInfos::ActionKey) {
+    return NA_clientInfos::NAType;
   }
-
-  else if (v_cmd == NA_udpBind::ActionKey) {
-    o_netAction->udpBind =
-      NA_udpBind(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->udpBind);
+  if (i_key == NA_udpBindQuery::ActionKey) {
+    return NA_udpBindQuery::NAType;
   }
-
-  else if (v_cmd == NA_changeName::ActionKey) {
-    o_netAction->changeName =
-      NA_changeName(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->changeName);
+  if (i_key == NA_udpBindValidation::ActionKey) {
+    return NA_udpBindValidation::NAType;
   }
-
-  else if (v_cmd == NA_playingLevel::ActionKey) {
-    o_netAction->playingLevel =
-      NA_playingLevel(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->playingLevel);
+  if (i_key == NA_udpBind::ActionKey) {
+    return NA_udpBind::NAType;
   }
-
-  else if (v_cmd == NA_serverError::ActionKey) {
-    o_netAction->serverError =
-      NA_serverError(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->serverError);
+  if (i_key == NA_changeName::ActionKey) {
+    return NA_changeName::NAType;
   }
-
-  else if (v_cmd == NA_changeClients::ActionKey) {
-    o_netAction->changeClients =
-      NA_changeClients(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->changeClients);
+  if (i_key == NA_playingLevel::ActionKey) {
+    return NA_playingLevel::NAType;
   }
-
-  else if (v_cmd == NA_slaveClientsPoints::ActionKey) {
-    o_netAction->slaveClientsPoints = NA_slaveClientsPoints(
-      ((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->slaveClientsPoints);
+  if (i_key == NA_serverError::ActionKey) {
+    return NA_serverError::NAType;
   }
-
-  else if (v_cmd == NA_clientsNumber::ActionKey) {
-    o_netAction->clientsNumber =
-      NA_clientsNumber(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->clientsNumber);
+  if (i_key == NA_changeClients::ActionKey) {
+    return NA_changeClients::NAType;
   }
-
-  else if (v_cmd == NA_clientsNumberQuery::ActionKey) {
-    o_netAction->clientsNumberQuery = NA_clientsNumberQuery(
-      ((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->clientsNumberQuery);
+  if (i_key == NA_slaveClientsPoints::ActionKey) {
+    return NA_slaveClientsPoints::NAType;
   }
-
-  else if (v_cmd == NA_clientMode::ActionKey) {
-    o_netAction->clientMode =
-      NA_clientMode(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->clientMode);
+  if (i_key == NA_clientsNumber::ActionKey) {
+    return NA_clientsNumber::NAType;
   }
-
-  else if (v_cmd == NA_prepareToPlay::ActionKey) {
-    o_netAction->prepareToPlay =
-      NA_prepareToPlay(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->prepareToPlay);
+  if (i_key == NA_clientsNumberQuery::ActionKey) {
+    return NA_clientsNumberQuery::NAType;
   }
-
-  else if (v_cmd == NA_killAlert::ActionKey) {
-    o_netAction->killAlert =
-      NA_killAlert(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->killAlert);
+  if (i_key == NA_clientMode::ActionKey) {
+    return NA_clientMode::NAType;
   }
-
-  else if (v_cmd == NA_prepareToGo::ActionKey) {
-    o_netAction->prepareToGo =
-      NA_prepareToGo(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->prepareToGo);
+  if (i_key == NA_prepareToPlay::ActionKey) {
+    return NA_prepareToPlay::NAType;
   }
-
-  else if (v_cmd == NA_gameEvents::ActionKey) {
-    o_netAction->gameEvents =
-      NA_gameEvents(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->gameEvents);
+  if (i_key == NA_killAlert::ActionKey) {
+    return NA_killAlert::NAType;
   }
-
-  else if (v_cmd == NA_srvCmd::ActionKey) {
-    o_netAction->srvCmd =
-      NA_srvCmd(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->srvCmd);
+  if (i_key == NA_prepareToGo::ActionKey) {
+    return NA_prepareToGo::NAType;
   }
-
-  else if (v_cmd == NA_srvCmdAsw::ActionKey) {
-    o_netAction->srvCmdAsw =
-      NA_srvCmdAsw(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->srvCmdAsw);
+  if (i_key == NA_gameEvents::ActionKey) {
+    return NA_gameEvents::NAType;
   }
-
-  else if (v_cmd == NA_ping::ActionKey) {
-    o_netAction->ping =
-      NA_ping(((char *)data) + v_totalOffset, len - v_totalOffset);
-    o_netAction->master = &(o_netAction->ping);
+  if (i_key == NA_srvCmd::ActionKey) {
+    return NA_srvCmd::NAType;
   }
-
-  else {
-    //((char*)data)[len-1] = '\0';
-    // LogInfo("Invalid command : %s", (char*)data);
-    throw Exception("net: invalid command");
+  if (i_key == NA_srvCmdAsw::ActionKey) {
+    return NA_srvCmdAsw::NAType;
+  }
+  if (i_key == NA_ping::ActionKey) {
+    return NA_ping::NAType;
   }
 
-  o_netAction->master->setSource(v_src, v_subsrc);
+  //((char*)data)[len-1] = '\0';
+  // LogInfo("Invalid command : %s", (char*)data);
+  throw Exception("net: invalid command");
+}
+
+void NetAction::buildNetAction(NetActionU *o_netAction,
+                               NetActionType i_type,
+                               void *data,
+                               unsigned int len) {
+  switch (i_type) {
+    case TNA_frame:
+      o_netAction->frame = NA_frame(data, len);
+      o_netAction->master = &(o_netAction->frame);
+      break;
+
+    case TNA_frameDelta:
+      o_netAction->frameDelta = NA_frameDelta(data, len);
+      o_netAction->master = &(o_netAction->frameDelta);
+      break;
+
+    case TNA_frameAck:
+      o_netAction->frameAck = NA_frameAck(data, len);
+      o_netAction->master = &(o_netAction->frameAck);
+      break;
+
+    case TNA_playerControl:
+      o_netAction->playerControl = NA_playerControl(data, len);
+      o_netAction->master = &(o_netAction->playerControl);
+      break;
+
+    case TNA_chatMessage:
+      o_netAction->chatMessage = NA_chatMessage(data, len);
+      o_netAction->master = &(o_netAction->chatMessage);
+      break;
+
+    case TNA_chatMessagePP:
+      o_netAction->chatMessagePP = NA_chatMessagePP(data, len);
+      o_netAction->master = &(o_netAction->chatMessagePP);
+      break;
+
+    case TNA_clientInfos:
+      o_netAction->clientInfos = NA_clientInfos(data, len);
+      o_netAction->master = &(o_netAction->clientInfos);
+      break;
+
+    case TNA_udpBindQuery:
+      o_netAction->udpBindQuery = NA_udpBindQuery(data, len);
+      o_netAction->master = &(o_netAction->udpBindQuery);
+      break;
+
+    case TNA_udpBindValidation:
+      o_netAction->udpBindValidation = NA_udpBindValidation(data, len);
+      o_netAction->master = &(o_netAction->udpBindValidation);
+      break;
+
+    case TNA_udpBind:
+      o_netAction->udpBind = NA_udpBind(data, len);
+      o_netAction->master = &(o_netAction->udpBind);
+      break;
+
+    case TNA_changeName:
+      o_netAction->changeName = NA_changeName(data, len);
+      o_netAction->master = &(o_netAction->changeName);
+      break;
+
+    case TNA_playingLevel:
+      o_netAction->playingLevel = NA_playingLevel(data, len);
+      o_netAction->master = &(o_netAction->playingLevel);
+      break;
+
+    case TNA_serverError:
+      o_netAction->serverError = NA_serverError(data, len);
+      o_netAction->master = &(o_netAction->serverError);
+      break;
+
+    case TNA_changeClients:
+      o_netAction->changeClients = NA_changeClients(data, len);
+      o_netAction->master = &(o_netAction->changeClients);
+      break;
+
+    case TNA_slaveClientsPoints:
+      o_netAction->slaveClientsPoints = NA_slaveClientsPoints(data, len);
+      o_netAction->master = &(o_netAction->slaveClientsPoints);
+      break;
+
+    case TNA_clientsNumber:
+      o_netAction->clientsNumber = NA_clientsNumber(data, len);
+      o_netAction->master = &(o_netAction->clientsNumber);
+      break;
+
+    case TNA_clientsNumberQuery:
+      o_netAction->clientsNumberQuery = NA_clientsNumberQuery(data, len);
+      o_netAction->master = &(o_netAction->clientsNumberQuery);
+      break;
+
+    case TNA_clientMode:
+      o_netAction->clientMode = NA_clientMode(data, len);
+      o_netAction->master = &(o_netAction->clientMode);
+      break;
+
+    case TNA_prepareToPlay:
+      o_netAction->prepareToPlay = NA_prepareToPlay(data, len);
+      o_netAction->master = &(o_netAction->prepareToPlay);
+      break;
+
+    case TNA_killAlert:
+      o_netAction->killAlert = NA_killAlert(data, len);
+      o_netAction->master = &(o_netAction->killAlert);
+      break;
+
+    case TNA_prepareToGo:
+      o_netAction->prepareToGo = NA_prepareToGo(data, len);
+      o_netAction->master = &(o_netAction->prepareToGo);
+      break;
+
+    case TNA_gameEvents:
+      o_netAction->gameEvents = NA_gameEvents(data, len);
+      o_netAction->master = &(o_netAction->gameEvents);
+      break;
+
+    case TNA_srvCmd:
+      o_netAction->srvCmd = NA_srvCmd(data, len);
+      o_netAction->master = &(o_netAction->srvCmd);
+      break;
+
+    case TNA_srvCmdAsw:
+      o_netAction->srvCmdAsw = NA_srvCmdAsw(data, len);
+      o_netAction->master = &(o_netAction->srvCmdAsw);
+      break;
+
+    case TNA_ping:
+      o_netAction->ping = NA_ping(data, len);
+      o_netAction->master = &(o_netAction->ping);
+      break;
+
+    default:
+      throw Exception("net: invalid command");
+  }
 }
 
 std::string NetAction::getLine(void *data,
@@ -629,6 +805,344 @@ SerializedBikeState *NA_frame::getState() {
   return &m_state;
 }
 
+//
+// frame deltas
+//
+
+/* bits are written from the lowest to the highest, so that the stream doesn't
+ * depend on the endianness */
+class FrameBitWriter {
+public:
+  FrameBitWriter(unsigned char *o_buffer, unsigned int i_size) {
+    m_buffer = o_buffer;
+    m_size = i_size;
+    m_nbBits = 0;
+  }
+
+  void write(unsigned int i_value, unsigned int i_nbBits) {
+    for (unsigned int i = 0; i < i_nbBits; i++) {
+      if (m_nbBits / 8 >= m_size) {
+        throw Exception("net: too big frame delta");
+      }
+      if (m_nbBits % 8 == 0) {
+        m_buffer[m_nbBits / 8] = 0;
+      }
+      if ((i_value >> i) & 1) {
+        m_buffer[m_nbBits / 8] |= 1 << (m_nbBits % 8);
+      }
+      m_nbBits++;
+    }
+  }
+
+  unsigned int length() const { return (m_nbBits + 7) / 8; }
+
+private:
+  unsigned char *m_buffer;
+  unsigned int m_size;
+  unsigned int m_nbBits;
+};
+
+class FrameBitReader {
+public:
+  FrameBitReader(const unsigned char *i_buffer, unsigned int i_size) {
+    m_buffer = i_buffer;
+    m_size = i_size;
+    m_nbBits = 0;
+  }
+
+  unsigned int read(unsigned int i_nbBits) {
+    unsigned int v_value = 0;
+
+    for (unsigned int i = 0; i < i_nbBits; i++) {
+      if (m_nbBits / 8 >= m_size) {
+        throw Exception("Invalid NA_frameDelta");
+      }
+      if ((m_buffer[m_nbBits / 8] >> (m_nbBits % 8)) & 1) {
+        v_value |= 1u << i;
+      }
+      m_nbBits++;
+    }
+    return v_value;
+  }
+
+private:
+  const unsigned char *m_buffer;
+  unsigned int m_size;
+  unsigned int m_nbBits;
+};
+
+/* each field is a bit "changed", followed by the new value when changed */
+static void writeDelta8(FrameBitWriter &w, unsigned char v, unsigned char b) {
+  w.write(v != b ? 1 : 0, 1);
+  if (v != b) {
+    w.write(v, 8);
+  }
+}
+
+static void writeDelta16(FrameBitWriter &w,
+                         unsigned short v,
+                         unsigned short b) {
+  w.write(v != b ? 1 : 0, 1);
+  if (v != b) {
+    w.write(v, 16);
+  }
+}
+
+/* floats are xored with the base : close values share their sign, exponent
+ * and first bits of mantissa, so that the leading null bytes are skipped */
+static void writeDeltaFloat(FrameBitWriter &w, float v, float b) {
+  Uint32 v_v, v_b, v_x;
+  unsigned int v_nullBytes = 0;
+
+  memcpy(&v_v, &v, sizeof(Uint32));
+  memcpy(&v_b, &b, sizeof(Uint32));
+  v_x = v_v ^ v_b;
+
+  w.write(v_x != 0 ? 1 : 0, 1);
+  if (v_x != 0) {
+    while (v_nullBytes < 3 && (v_x >> (8 * (3 - v_nullBytes))) == 0) {
+      v_nullBytes++;
+    }
+    w.write(v_nullBytes, 2);
+    w.write(v_x, 8 * (4 - v_nullBytes));
+  }
+}
+
+static unsigned char readDelta8(FrameBitReader &r, unsigned char b) {
+  return r.read(1) == 1 ? r.read(8) : b;
+}
+
+static unsigned short readDelta16(FrameBitReader &r, unsigned short b) {
+  return r.read(1) == 1 ? r.read(16) : b;
+}
+
+static float readDeltaFloat(FrameBitReader &r, float b) {
+  Uint32 v_v;
+  float v_res;
+
+  memcpy(&v_v, &b, sizeof(Uint32));
+  if (r.read(1) == 1) {
+    v_v ^= r.read(8 * (4 - r.read(2)));
+  }
+  memcpy(&v_res, &v_v, sizeof(float));
+  return v_res;
+}
+
+static void encodeFrameDelta(FrameBitWriter &w,
+                             const SerializedBikeState *s,
+                             const SerializedBikeState *b) {
+  writeDelta8(w, s->cFlags, b->cFlags);
+  writeDeltaFloat(w, s->fGameTime, b->fGameTime);
+  writeDeltaFloat(w, s->fFrameX, b->fFrameX);
+  writeDeltaFloat(w, s->fFrameY, b->fFrameY);
+  writeDeltaFloat(w, s->fMaxXDiff, b->fMaxXDiff);
+  writeDeltaFloat(w, s->fMaxYDiff, b->fMaxYDiff);
+  writeDelta16(w, s->nRearWheelRot, b->nRearWheelRot);
+  writeDelta16(w, s->nFrontWheelRot, b->nFrontWheelRot);
+  writeDelta16(w, s->nFrameRot, b->nFrameRot);
+  writeDelta8(w, s->cBikeEngineRPM, b->cBikeEngineRPM);
+  writeDelta8(w, s->cRearWheelX, b->cRearWheelX);
+  writeDelta8(w, s->cRearWheelY, b->cRearWheelY);
+  writeDelta8(w, s->cFrontWheelX, b->cFrontWheelX);
+  writeDelta8(w, s->cFrontWheelY, b->cFrontWheelY);
+  writeDelta8(w, s->cElbowX, b->cElbowX);
+  writeDelta8(w, s->cElbowY, b->cElbowY);
+  writeDelta8(w, s->cShoulderX, b->cShoulderX);
+  writeDelta8(w, s->cShoulderY, b->cShoulderY);
+  writeDelta8(w, s->cLowerBodyX, b->cLowerBodyX);
+  writeDelta8(w, s->cLowerBodyY, b->cLowerBodyY);
+  writeDelta8(w, s->cKneeX, b->cKneeX);
+  writeDelta8(w, s->cKneeY, b->cKneeY);
+}
+
+static void decodeFrameDelta(FrameBitReader &r,
+                             const SerializedBikeState *b,
+                             SerializedBikeState *s) {
+  s->cFlags = readDelta8(r, b->cFlags);
+  s->fGameTime = readDeltaFloat(r, b->fGameTime);
+  s->fFrameX = readDeltaFloat(r, b->fFrameX);
+  s->fFrameY = readDeltaFloat(r, b->fFrameY);
+  s->fMaxXDiff = readDeltaFloat(r, b->fMaxXDiff);
+  s->fMaxYDiff = readDeltaFloat(r, b->fMaxYDiff);
+  s->nRearWheelRot = readDelta16(r, b->nRearWheelRot);
+  s->nFrontWheelRot = readDelta16(r, b->nFrontWheelRot);
+  s->nFrameRot = readDelta16(r, b->nFrameRot);
+  s->cBikeEngineRPM = readDelta8(r, b->cBikeEngineRPM);
+  s->cRearWheelX = readDelta8(r, b->cRearWheelX);
+  s->cRearWheelY = readDelta8(r, b->cRearWheelY);
+  s->cFrontWheelX = readDelta8(r, b->cFrontWheelX);
+  s->cFrontWheelY = readDelta8(r, b->cFrontWheelY);
+  s->cElbowX = readDelta8(r, b->cElbowX);
+  s->cElbowY = readDelta8(r, b->cElbowY);
+  s->cShoulderX = readDelta8(r, b->cShoulderX);
+  s->cShoulderY = readDelta8(r, b->cShoulderY);
+  s->cLowerBodyX = readDelta8(r, b->cLowerBodyX);
+  s->cLowerBodyY = readDelta8(r, b->cLowerBodyY);
+  s->cKneeX = readDelta8(r, b->cKneeX);
+  s->cKneeY = readDelta8(r, b->cKneeY);
+}
+
+/* header : flags (1 = full frame), seq, base seq if not full */
+#define XM_NET_FRAMEDELTA_FULL 1
+#define XM_NET_FRAMEDELTA_HEADER_SIZE(full) ((full) ? 3 : 5)
+
+NA_frameDelta::NA_frameDelta(unsigned short i_seq,
+                             SerializedBikeState *i_state,
+                             unsigned short i_baseSeq,
+                             SerializedBikeState *i_base)
+  : NetAction(false) {
+  m_seq = i_seq;
+  m_isFull = i_base == NULL;
+  m_baseSeq = m_isFull ? 0 : i_baseSeq;
+  m_bufferLength = 0;
+
+  if (i_state != NULL) {
+    SerializedBikeState v_empty;
+    unsigned int v_headerSize = XM_NET_FRAMEDELTA_HEADER_SIZE(m_isFull);
+
+    m_buffer[0] = m_isFull ? XM_NET_FRAMEDELTA_FULL : 0;
+    m_buffer[1] = m_seq & 0xFF;
+    m_buffer[2] = m_seq >> 8;
+    if (m_isFull) {
+      memset(&v_empty, 0, sizeof(SerializedBikeState));
+    } else {
+      m_buffer[3] = m_baseSeq & 0xFF;
+      m_buffer[4] = m_baseSeq >> 8;
+    }
+
+    FrameBitWriter v_writer(m_buffer + v_headerSize,
+                            XM_NET_MAX_FRAMEDELTA_SIZE - v_headerSize);
+    encodeFrameDelta(v_writer, i_state, m_isFull ? &v_empty : i_base);
+    m_bufferLength = v_headerSize + v_writer.length();
+  }
+}
+
+NA_frameDelta::NA_frameDelta(void *data, unsigned int len)
+  : NetAction(false) {
+  // -1 because in the protocol, you always finish by a \n
+  if (len < 1 + XM_NET_FRAMEDELTA_HEADER_SIZE(true) ||
+      len - 1 > XM_NET_MAX_FRAMEDELTA_SIZE) {
+    throw Exception("Invalid NA_frameDelta");
+  }
+  m_bufferLength = len - 1;
+  memcpy(m_buffer, data, m_bufferLength);
+
+  m_isFull = (m_buffer[0] & XM_NET_FRAMEDELTA_FULL) != 0;
+  if (m_bufferLength < XM_NET_FRAMEDELTA_HEADER_SIZE(m_isFull)) {
+    throw Exception("Invalid NA_frameDelta");
+  }
+  m_seq = m_buffer[1] | (m_buffer[2] << 8);
+  m_baseSeq = m_isFull ? 0 : m_buffer[3] | (m_buffer[4] << 8);
+}
+
+NA_frameDelta::~NA_frameDelta() {}
+
+void NA_frameDelta::send(TCPsocket *i_tcpsd,
+                         UDPsocket *i_udpsd,
+                         UDPpacket *i_sendPacket,
+                         IPaddress *i_udpRemoteIP) {
+  if (i_udpsd != NULL) {
+    // if udp is available, prefer udp
+    NetAction::send(
+      NULL, i_udpsd, i_sendPacket, i_udpRemoteIP, m_buffer, m_bufferLength);
+  } else {
+    NetAction::send(i_tcpsd,
+                    i_udpsd,
+                    i_sendPacket,
+                    i_udpRemoteIP,
+                    m_buffer,
+                    m_bufferLength);
+  }
+}
+
+unsigned short NA_frameDelta::seq() const {
+  return m_seq;
+}
+
+bool NA_frameDelta::isFull() const {
+  return m_isFull;
+}
+
+unsigned short NA_frameDelta::baseSeq() const {
+  return m_baseSeq;
+}
+
+void NA_frameDelta::getState(const SerializedBikeState *i_base,
+                             SerializedBikeState *o_state) {
+  SerializedBikeState v_empty;
+  unsigned int v_headerSize = XM_NET_FRAMEDELTA_HEADER_SIZE(m_isFull);
+
+  if (m_isFull) {
+    memset(&v_empty, 0, sizeof(SerializedBikeState));
+    i_base = &v_empty;
+  }
+
+  FrameBitReader v_reader(m_buffer + v_headerSize,
+                          m_bufferLength - v_headerSize);
+  decodeFrameDelta(v_reader, i_base, o_state);
+}
+
+NA_frameAck::NA_frameAck()
+  : NetAction(false) {}
+
+NA_frameAck::NA_frameAck(void *data, unsigned int len)
+  : NetAction(false) {
+  unsigned int v_localOffset = 0;
+  NetFrameAck v_ack;
+
+  if (len == 1) { // no ack (only \n)
+    return;
+  }
+
+  while (v_localOffset < len) {
+    v_ack.Src = atoi(getLine(((char *)data) + v_localOffset,
+                             len - v_localOffset,
+                             &v_localOffset)
+                       .c_str());
+    v_ack.SubSrc = atoi(getLine(((char *)data) + v_localOffset,
+                                len - v_localOffset,
+                                &v_localOffset)
+                          .c_str());
+    v_ack.Seq = atoi(getLine(((char *)data) + v_localOffset,
+                             len - v_localOffset,
+                             &v_localOffset)
+                       .c_str());
+    m_acks.push_back(v_ack);
+  }
+}
+
+NA_frameAck::~NA_frameAck() {}
+
+void NA_frameAck::send(TCPsocket *i_tcpsd,
+                       UDPsocket *i_udpsd,
+                       UDPpacket *i_sendPacket,
+                       IPaddress *i_udpRemoteIP) {
+  std::ostringstream v_send;
+
+  for (unsigned int i = 0; i < m_acks.size(); i++) {
+    v_send << m_acks[i].Src << "\n";
+    v_send << m_acks[i].SubSrc << "\n";
+    v_send << m_acks[i].Seq << "\n";
+  }
+
+  NetAction::send(i_tcpsd,
+                  i_udpsd,
+                  i_sendPacket,
+                  i_udpRemoteIP,
+                  v_send.str().c_str(),
+                  m_acks.size() > 0
+                    ? v_send.str().size() - 1 // don't send the last \n
+                    : 0);
+}
+
+const std::vector<NetFrameAck> &NA_frameAck::acks() const {
+  return m_acks;
+}
+
+void NA_frameAck::add(const NetFrameAck &i_ack) {
+  m_acks.push_back(i_ack);
+}
+
 NA_udpBind::NA_udpBind(const std::string &i_key)
   : NetAction(false) {
   m_key = i_key;
@@ -27,7 +27,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <string>
 #include <vector>
 
-#define XM_NET_PROTOCOL_VERSION 6
+#define XM_NET_PROTOCOL_VERSION 8
 /*
 DELTA 1->2:
 clientInfos : add xmversion string
@@ -39,16 +39,27 @@ DELTA 4->5
 add slaveClientsPoints
 DELTA 5->6
 add pings
+DELTA 6->7
+add frameDelta and frameAck (frames encoded against the last acknowledged one)
+DELTA 7->8
+binary headers (see NetAction::send) ; used by the server for clients >= 8,
+used by the clients once the server sent them a binary header
 */
 
 #define NETACTION_MAX_PACKET_SIZE 1024 * 8 // bytes
 #define NETACTION_MAX_SUBSRC 4 // maximum 4 players by client
 #define XM_NET_MAX_EVENTS_SHOT_SIZE 1024 * 8
+#define XM_NET_FRAMES_HISTORY 32 // frames kept as possible delta bases
+#define XM_NET_MAX_FRAMEDELTA_SIZE 128 // bytes
+#define XM_NET_BINARY_HEADER_MIN_PROTOCOL 8
+#define XM_NET_BINARY_HEADER_MARKER 0x00 // text headers start with a digit
+#define XM_NET_VARINT_MAX_SIZE 5 // bytes
 
 class NetClient;
 class ServerThread;
 class DBuffer;
 
+/* the values are sent in the binary headers : add new types at the end */
 enum NetActionType {
   TNA_clientInfos,
   TNA_udpBindQuery,
@@ -72,7 +83,9 @@ enum NetActionType {
   TNA_gameEvents,
   TNA_srvCmd,
   TNA_srvCmdAsw,
-  TNA_ping
+  TNA_ping,
+  TNA_frameDelta,
+  TNA_frameAck
 };
 
 struct NetInfosClient {
@@ -85,6 +98,12 @@ struct NetPointsClient {
   int Points;
 };
 
+struct NetFrameAck {
+  int Src; // source of the frame, as received by the client
+  int SubSrc;
+  unsigned short Seq;
+};
+
 struct NetActionU;
 
 class NetAction {
@@ -99,13 +118,25 @@ public:
                     UDPpacket *i_sendPacket,
                     IPaddress *i_udpRemoteIP);
   void setSource(int i_src, int i_subsrc);
+  void setBinaryHeader(bool i_value);
 
   int getSource() const;
   int getSubSource() const;
+  bool hasBinaryHeader() const;
 
   static void getNetAction(NetActionU *o_netAction,
                            void *data,
-                           unsigned int len);
+                           unsigned int len,
+                           bool i_binaryHeader);
+
+  // 7 bits by byte, lowest first ; return the number of bytes written
+  static unsigned int writeVarint(unsigned int i_value, unsigned char *o_data);
+  // return false if len is too small to contain the whole varint
+  static bool readVarint(const unsigned char *i_data,
+                         unsigned int i_len,
+                         unsigned int i_maxSize,
+                         unsigned int *o_value,
+                         unsigned int *o_size);
 
   static void logStats();
 
@@ -151,6 +182,13 @@ private:
 
   bool m_forceTCP; // by default, xmoto try to use UDP when available ; for some
   // actions, TCP can be forced
+  bool m_binaryHeader; // the receiver supports the binary headers
+
+  static NetActionType getActionType(const std::string &i_key);
+  static void buildNetAction(NetActionU *o_netAction,
+                             NetActionType i_type,
+                             void *data,
+                             unsigned int len);
 };
 
 class NA_udpBind : public NetAction {
@@ -344,6 +382,65 @@ private:
   SerializedBikeState m_state;
 };
 
+/* frame encoded against a previous frame acknowledged by the receiver ; the
+ * first frames and the frames sent after a loss are encoded against an empty
+ * state */
+class NA_frameDelta : public NetAction {
+public:
+  NA_frameDelta(unsigned short i_seq = 0,
+                SerializedBikeState *i_state = NULL,
+                unsigned short i_baseSeq = 0,
+                SerializedBikeState *i_base = NULL /* NULL for a full frame */);
+  NA_frameDelta(void *data, unsigned int len);
+  virtual ~NA_frameDelta();
+  std::string actionKey() { return ActionKey; }
+  NetActionType actionType() { return NAType; }
+  static std::string ActionKey;
+  static NetActionType NAType;
+
+  void send(TCPsocket *i_tcpsd,
+            UDPsocket *i_udpsd,
+            UDPpacket *i_sendPacket,
+            IPaddress *i_udpRemoteIP);
+
+  unsigned short seq() const;
+  bool isFull() const;
+  unsigned short baseSeq() const;
+
+  // i_base is ignored for full frames
+  void getState(const SerializedBikeState *i_base,
+                SerializedBikeState *o_state);
+
+private:
+  unsigned short m_seq;
+  bool m_isFull;
+  unsigned short m_baseSeq;
+  unsigned char m_buffer[XM_NET_MAX_FRAMEDELTA_SIZE];
+  unsigned int m_bufferLength;
+};
+
+class NA_frameAck : public NetAction {
+public:
+  NA_frameAck();
+  NA_frameAck(void *data, unsigned int len);
+  virtual ~NA_frameAck();
+  std::string actionKey() { return ActionKey; }
+  NetActionType actionType() { return NAType; }
+  static std::string ActionKey;
+  static NetActionType NAType;
+
+  void send(TCPsocket *i_tcpsd,
+            UDPsocket *i_udpsd,
+            UDPpacket *i_sendPacket,
+            IPaddress *i_udpRemoteIP);
+
+  const std::vector<NetFrameAck> &acks() const;
+  void add(const NetFrameAck &i_ack);
+
+private:
+  std::vector<NetFrameAck> m_acks;
+};
+
 class NA_changeName : public NetAction {
 public:
   NA_changeName(const std::string &i_name = "");
@@ -698,6 +795,8 @@ public:
   NA_chatMessagePP chatMessagePP;
   NA_serverError serverError;
   NA_frame frame;
+  NA_frameDelta frameDelta;
+  NA_frameAck frameAck;
   NA_changeName changeName;
   NA_clientsNumber clientsNumber;
   NA_clientsNumberQuery clientsNumberQuery;
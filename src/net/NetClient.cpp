@@ -50,6 +50,7 @@ NetClient::NetClient() {
   m_isConnected = false;
   m_serverReceivesUdp = false;
   m_serverSendsUdp = false;
+  m_serverSendsBinaryHeaders = false;
   m_universe = NULL;
   m_mode = NETCLIENT_GHOST_MODE;
   m_points = 0;
@@ -78,6 +79,7 @@ NetClient::NetClient() {
 }
 
 NetClient::~NetClient() {
+  clearReceivedFrames();
   delete m_otherClientsLevelsList;
   delete m_tcpReader;
   SDLNet_FreePacket(m_udpSendPacket);
@@ -153,6 +155,9 @@ void NetClient::manageNetwork(int i_timeout, xmDatabase *pDb) {
       v_timeout_remaining =
         i_timeout - (GameApp::getXMTimeInt() - v_start /* = time spent */);
     } while (v_timeout_remaining > 0);
+
+    // acknowledge all the frames received at once
+    sendFrameAcks();
   } catch (Exception &e) {
     disconnect();
     StateManager::instance()->sendAsynchronousMessage("CLIENT_STATUS_CHANGED");
@@ -223,6 +228,7 @@ void NetClient::connect(const std::string &i_server, int i_port) {
   // reset udp server information
   m_serverReceivesUdp = false;
   m_serverSendsUdp = false;
+  m_serverSendsBinaryHeaders = false;
 
   if (SDLNet_ResolveHost(&serverIp, i_server.c_str(), i_port) < 0) {
     throw Exception(SDLNet_GetError());
@@ -249,6 +255,7 @@ void NetClient::connect(const std::string &i_server, int i_port) {
 
   m_isConnected = true;
   m_mode = NETCLIENT_GHOST_MODE; // reset the default mode
+  clearReceivedFrames();
   StateManager::instance()->sendAsynchronousMessage("CLIENT_STATUS_CHANGED");
 
   LogInfo("client: connected on %s:%d", i_server.c_str(), i_port);
@@ -292,6 +299,7 @@ void NetClient::disconnect() {
     delete m_otherClients[i];
     m_otherClients.clear();
   }
+  clearReceivedFrames();
 
   m_isConnected = false;
   StateManager::instance()->sendAsynchronousMessage("CLIENT_STATUS_CHANGED");
@@ -311,6 +319,7 @@ UDPsocket *NetClient::udpSocket() {
 
 void NetClient::send(NetAction *i_netAction, int i_subsrc, bool i_forceUdp) {
   i_netAction->setSource(0, i_subsrc);
+  i_netAction->setBinaryHeader(m_serverSendsBinaryHeaders);
 
   try {
     if (i_forceUdp) {
@@ -403,6 +412,11 @@ void NetClient::updateOtherClientsMode(std::vector<int> i_slavePlayers) {
 }
 
 void NetClient::manageAction(xmDatabase *pDb, NetAction *i_netAction) {
+  // the server sends binary headers only to the clients supporting them
+  if (i_netAction->hasBinaryHeader()) {
+    m_serverSendsBinaryHeaders = true;
+  }
+
   switch (i_netAction->actionType()) {
     case TNA_clientInfos:
     case TNA_clientMode:
@@ -410,6 +424,7 @@ void NetClient::manageAction(xmDatabase *pDb, NetAction *i_netAction) {
     case TNA_srvCmd:
     case TNA_clientsNumber:
     case TNA_clientsNumberQuery:
+    case TNA_frameAck:
       /* should not happend */
       break;
 
@@ -498,118 +513,45 @@ void NetClient::manageAction(xmDatabase *pDb, NetAction *i_netAction) {
     } break;
 
     case TNA_frame: {
-      NetGhost *v_ghost = NULL;
-      int v_clientId = -1;
-
-      if (m_universe == NULL) {
-        return;
-      }
-
-      /* the server sending us our own frame */
-      if (i_netAction->getSource() == -1) {
-        if (m_mode == NETCLIENT_SLAVE_MODE) { /* ONLY IN SLAVE MODE */
-          if (GameApp::getXMTimeInt() - m_currentOwnFramesTime > 1000) {
-            m_lastOwnFPS = (m_currentOwnFramesNb * 1000) /
-                           (GameApp::getXMTimeInt() - m_currentOwnFramesTime);
-            m_currentOwnFramesTime = GameApp::getXMTimeInt();
-            m_currentOwnFramesNb = 0;
-          }
-          m_currentOwnFramesNb++;
+      manageFrame(i_netAction->getSource(),
+                  i_netAction->getSubSource(),
+                  ((NA_frame *)i_netAction)->getState());
+    } break;
 
-          for (unsigned int i = 0; i < m_universe->getScenes().size(); i++) {
-            for (unsigned int j = 0;
-                 j < m_universe->getScenes()[i]->Players().size();
-                 j++) {
-              BikeState::convertStateFromReplay(
-                ((NA_frame *)i_netAction)->getState(),
-                m_universe->getScenes()[i]->Players()[j]->getStateForUpdate(),
-                m_universe->getScenes()[i]->getPhysicsSettings());
-
-              // adjust the time of the server frame to the time of the local
-              // scene
-              m_universe->getScenes()[i]->setTargetTime(
-                ((NA_frame *)i_netAction)->getState()->fGameTime * 100.0);
-            }
+    case TNA_frameDelta: {
+      NA_frameDelta *v_na = (NA_frameDelta *)i_netAction;
+      NetReceivedFrames *v_frames;
+      SerializedBikeState v_state;
+      unsigned int v_slot;
 
-            // if the game is in pause, at least update the player position
-            if (m_universe->getScenes()[i]->isPaused()) {
-              m_universe->getScenes()[i]->updatePlayers(0 /* 0 to not update */,
-                                                        true);
-            }
-          }
-        }
+      v_frames =
+        receivedFrames(i_netAction->getSource(), i_netAction->getSubSource());
 
+      if (v_na->isFull()) {
+        v_na->getState(NULL, &v_state);
       } else {
-        // search the client
-        for (unsigned int i = 0; i < m_otherClients.size(); i++) {
-          if (m_otherClients[i]->id() == i_netAction->getSource()) {
-            v_clientId = i;
-            break;
-          }
-        }
-        if (v_clientId < 0) {
-          return; // client not declared
+        // the base frame must have been received, else, forget this frame
+        v_slot = v_na->baseSeq() % XM_NET_FRAMES_HISTORY;
+        if (v_frames->valids[v_slot] == false ||
+            v_frames->seqs[v_slot] != v_na->baseSeq()) {
+          return;
         }
+        v_na->getState(&(v_frames->states[v_slot]), &v_state);
+      }
 
-        // check if the ghost already exists
-        if (m_otherClients[v_clientId]->netGhost(i_netAction->getSubSource()) !=
-            NULL) {
-          v_ghost =
-            m_otherClients[v_clientId]->netGhost(i_netAction->getSubSource());
-        }
-
-        if (v_ghost == NULL) {
-          /* add the net ghost */
-
-          // if this is a client of the current party, add it as normal player
-          bool v_isSlaveMode =
-            m_otherClients[v_clientId]->mode() == NETCLIENT_SLAVE_MODE;
-
-          for (unsigned int i = 0; i < m_universe->getScenes().size(); i++) {
-            if (v_isSlaveMode) {
-              v_ghost = m_universe->getScenes()[i]->addNetGhost(
-                m_otherClients[v_clientId]->name(),
-                Theme::instance(),
-                Theme::instance()->getNetPlayerTheme(),
-                TColor(0, 255, 255, 0),
-                TColor(GET_RED(Theme::instance()
-                                 ->getNetPlayerTheme()
-                                 ->getUglyRiderColor()),
-                       GET_GREEN(Theme::instance()
-                                   ->getNetPlayerTheme()
-                                   ->getUglyRiderColor()),
-                       GET_BLUE(Theme::instance()
-                                  ->getNetPlayerTheme()
-                                  ->getUglyRiderColor()),
-                       0));
-            } else {
-              v_ghost = m_universe->getScenes()[i]->addNetGhost(
-                m_otherClients[v_clientId]->name(),
-                Theme::instance(),
-                Theme::instance()->getGhostTheme(),
-                TColor(255, 255, 255, 0),
-                TColor(
-                  GET_RED(
-                    Theme::instance()->getGhostTheme()->getUglyRiderColor()),
-                  GET_GREEN(
-                    Theme::instance()->getGhostTheme()->getUglyRiderColor()),
-                  GET_BLUE(
-                    Theme::instance()->getGhostTheme()->getUglyRiderColor()),
-                  0));
-            }
-            m_otherClients[v_clientId]->setNetGhost(i_netAction->getSubSource(),
-                                                    v_ghost);
-          }
-        }
+      v_slot = v_na->seq() % XM_NET_FRAMES_HISTORY;
+      v_frames->states[v_slot] = v_state;
+      v_frames->seqs[v_slot] = v_na->seq();
+      v_frames->valids[v_slot] = true;
 
-        // take the physic of the first world
-        if (m_universe->getScenes().size() > 0) {
-          BikeState::convertStateFromReplay(
-            ((NA_frame *)i_netAction)->getState(),
-            v_ghost->getStateForUpdate(),
-            m_universe->getScenes()[0]->getPhysicsSettings());
-        }
+      if (v_frames->ackPending == false ||
+          (short)(v_na->seq() - v_frames->ackSeq) > 0) {
+        v_frames->ackSeq = v_na->seq();
+        v_frames->ackPending = true;
       }
+
+      manageFrame(
+        i_netAction->getSource(), i_netAction->getSubSource(), &v_state);
     } break;
 
     case TNA_changeName: {
@@ -686,6 +628,7 @@ void NetClient::manageAction(xmDatabase *pDb, NetAction *i_netAction) {
                      GAMETEXT_CLIENTDISCONNECTSERVER,
                      m_otherClients[j]->name().c_str());
             SysMessage::instance()->addConsoleLine(buf, CLT_GAMEINFORMATION);
+            removeReceivedFrames(m_otherClients[j]->id());
             delete m_otherClients[j];
             m_otherClients.erase(m_otherClients.begin() + j);
           } else {
@@ -887,6 +830,184 @@ void NetOtherClient::setPoints(int i_points) {
   m_points = i_points;
 }
 
+void NetClient::manageFrame(int i_src,
+                            int i_subsrc,
+                            SerializedBikeState *i_state) {
+  NetGhost *v_ghost = NULL;
+  int v_clientId = -1;
+
+  if (m_universe == NULL) {
+    return;
+  }
+
+  /* the server sending us our own frame */
+  if (i_src == -1) {
+    if (m_mode == NETCLIENT_SLAVE_MODE) { /* ONLY IN SLAVE MODE */
+      if (GameApp::getXMTimeInt() - m_currentOwnFramesTime > 1000) {
+        m_lastOwnFPS = (m_currentOwnFramesNb * 1000) /
+                       (GameApp::getXMTimeInt() - m_currentOwnFramesTime);
+        m_currentOwnFramesTime = GameApp::getXMTimeInt();
+        m_currentOwnFramesNb = 0;
+      }
+      m_currentOwnFramesNb++;
+
+      for (unsigned int i = 0; i < m_universe->getScenes().size(); i++) {
+        for (unsigned int j = 0;
+             j < m_universe->getScenes()[i]->Players().size();
+             j++) {
+          BikeState::convertStateFromReplay(
+            i_state,
+            m_universe->getScenes()[i]->Players()[j]->getStateForUpdate(),
+            m_universe->getScenes()[i]->getPhysicsSettings());
+          m_universe->getScenes()[i]->Players()[j]->stateAfterExternalUpdated();
+
+          // adjust the time of the server frame to the time of the local scene
+          m_universe->getScenes()[i]->setTargetTime(i_state->fGameTime * 100.0);
+        }
+
+        // if the game is in pause, at least update the player position
+        if (m_universe->getScenes()[i]->isPaused()) {
+          m_universe->getScenes()[i]->updatePlayers(0 /* 0 to not update */,
+                                                    true);
+        }
+      }
+    }
+
+  } else {
+    // search the client
+    for (unsigned int i = 0; i < m_otherClients.size(); i++) {
+      if (m_otherClients[i]->id() == i_src) {
+        v_clientId = i;
+        break;
+      }
+    }
+    if (v_clientId < 0) {
+      return; // client not declared
+    }
+
+    // check if the ghost already exists
+    if (m_otherClients[v_clientId]->netGhost(i_subsrc) != NULL) {
+      v_ghost = m_otherClients[v_clientId]->netGhost(i_subsrc);
+    }
+
+    if (v_ghost == NULL) {
+      /* add the net ghost */
+
+      // if this is a client of the current party, add it as normal player
+      bool v_isSlaveMode =
+        m_otherClients[v_clientId]->mode() == NETCLIENT_SLAVE_MODE;
+
+      for (unsigned int i = 0; i < m_universe->getScenes().size(); i++) {
+        if (v_isSlaveMode) {
+          v_ghost = m_universe->getScenes()[i]->addNetGhost(
+            m_otherClients[v_clientId]->name(),
+            Theme::instance(),
+            Theme::instance()->getNetPlayerTheme(),
+            TColor(0, 255, 255, 0),
+            TColor(
+              GET_RED(
+                Theme::instance()->getNetPlayerTheme()->getUglyRiderColor()),
+              GET_GREEN(
+                Theme::instance()->getNetPlayerTheme()->getUglyRiderColor()),
+              GET_BLUE(
+                Theme::instance()->getNetPlayerTheme()->getUglyRiderColor()),
+              0));
+        } else {
+          v_ghost = m_universe->getScenes()[i]->addNetGhost(
+            m_otherClients[v_clientId]->name(),
+            Theme::instance(),
+            Theme::instance()->getGhostTheme(),
+            TColor(255, 255, 255, 0),
+            TColor(
+              GET_RED(Theme::instance()->getGhostTheme()->getUglyRiderColor()),
+              GET_GREEN(
+                Theme::instance()->getGhostTheme()->getUglyRiderColor()),
+              GET_BLUE(Theme::instance()->getGhostTheme()->getUglyRiderColor()),
+              0));
+        }
+        m_otherClients[v_clientId]->setNetGhost(i_subsrc, v_ghost);
+      }
+    }
+
+    // take the physic of the first world
+    if (m_universe->getScenes().size() > 0) {
+      BikeState::convertStateFromReplay(
+        i_state,
+        v_ghost->getStateForUpdate(),
+        m_universe->getScenes()[0]->getPhysicsSettings());
+      v_ghost->stateAfterExternalUpdated();
+    }
+  }
+}
+
+NetReceivedFrames *NetClient::receivedFrames(int i_src, int i_subsrc) {
+  NetReceivedFrames *v_frames;
+
+  for (unsigned int i = 0; i < m_receivedFrames.size(); i++) {
+    if (m_receivedFrames[i]->src == i_src &&
+        m_receivedFrames[i]->subsrc == i_subsrc) {
+      return m_receivedFrames[i];
+    }
+  }
+
+  v_frames = new NetReceivedFrames();
+  v_frames->src = i_src;
+  v_frames->subsrc = i_subsrc;
+  for (unsigned int i = 0; i < XM_NET_FRAMES_HISTORY; i++) {
+    v_frames->valids[i] = false;
+  }
+  v_frames->ackPending = false;
+  v_frames->ackSeq = 0;
+  m_receivedFrames.push_back(v_frames);
+
+  return v_frames;
+}
+
+void NetClient::clearReceivedFrames() {
+  for (unsigned int i = 0; i < m_receivedFrames.size(); i++) {
+    delete m_receivedFrames[i];
+  }
+  m_receivedFrames.clear();
+}
+
+void NetClient::removeReceivedFrames(int i_src) {
+  unsigned int i = 0;
+
+  while (i < m_receivedFrames.size()) {
+    if (m_receivedFrames[i]->src == i_src) {
+      delete m_receivedFrames[i];
+      m_receivedFrames.erase(m_receivedFrames.begin() + i);
+    } else {
+      i++;
+    }
+  }
+}
+
+void NetClient::sendFrameAcks() {
+  NA_frameAck na;
+  NetFrameAck v_ack;
+  bool v_toSend = false;
+
+  if (m_isConnected == false) {
+    return;
+  }
+
+  for (unsigned int i = 0; i < m_receivedFrames.size(); i++) {
+    if (m_receivedFrames[i]->ackPending) {
+      v_ack.Src = m_receivedFrames[i]->src;
+      v_ack.SubSrc = m_receivedFrames[i]->subsrc;
+      v_ack.Seq = m_receivedFrames[i]->ackSeq;
+      na.add(v_ack);
+      m_receivedFrames[i]->ackPending = false;
+      v_toSend = true;
+    }
+  }
+
+  if (v_toSend) {
+    send(&na, 0);
+  }
+}
+
 void NetClient::getOtherClientsNameList(std::vector<std::string> &io_list,
                                         const std::string &i_suffix) {
   for (int i = 0, n = m_otherClients.size(); i < n; i++) {
@@ -70,6 +70,17 @@ private:
   int m_points;
 };
 
+/* last frames received for a bike, to decode the deltas sent by the server */
+struct NetReceivedFrames {
+  int src;
+  int subsrc;
+  SerializedBikeState states[XM_NET_FRAMES_HISTORY];
+  unsigned short seqs[XM_NET_FRAMES_HISTORY];
+  bool valids[XM_NET_FRAMES_HISTORY];
+  bool ackPending;
+  unsigned short ackSeq; // most recent frame received
+};
+
 class NetClient : public Singleton<NetClient> {
 public:
   NetClient();
@@ -121,6 +132,7 @@ private:
   IPaddress serverIp;
   bool m_serverReceivesUdp;
   bool m_serverSendsUdp;
+  bool m_serverSendsBinaryHeaders;
   TCPsocket m_tcpsd;
   UDPsocket m_udpsd;
   UDPpacket *m_udpSendPacket;
@@ -145,8 +157,17 @@ private:
   void updateOtherClientsMode(std::vector<int> i_slavePlayers);
 
   void manageAction(xmDatabase *pDb, NetAction *i_netAction);
+  void manageFrame(int i_src, int i_subsrc, SerializedBikeState *i_state);
   void cleanOtherClientsGhosts();
 
+  // frame deltas
+  NetReceivedFrames *receivedFrames(int i_src, int i_subsrc);
+  void clearReceivedFrames();
+  // frames of a client which left the server
+  void removeReceivedFrames(int i_src);
+  void sendFrameAcks();
+  std::vector<NetReceivedFrames *> m_receivedFrames;
+
   int m_lastOwnFPS;
   int m_currentOwnFramesNb;
   int m_currentOwnFramesTime;
@@ -99,3 +99,10 @@ bool NetServer::acceptConnections() {
 void NetServer::setStandAloneOptions() {
   XMSession::instance()->setEnableAudio(false);
 }
+
+void NetServer::getTicksStats(ServerTicksStats *o_stats, bool i_reset) {
+  if (m_serverThread == NULL) {
+    throw Exception("Server not started");
+  }
+  *o_stats = m_serverThread->getTicksStats(i_reset);
+}
@@ -25,6 +25,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <string>
 
 class ServerThread;
+struct ServerTicksStats;
 
 class NetServer : public Singleton<NetServer> {
 public:
@@ -39,6 +40,7 @@ public:
   void wait();
   bool acceptConnections();
   void setStandAloneOptions();
+  void getTicksStats(ServerTicksStats *o_stats, bool i_reset);
 
 private:
   ServerThread *m_serverThread;
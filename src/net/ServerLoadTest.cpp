@@ -0,0 +1,536 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "ServerLoadTest.h"
+#include "ActionReader.h"
+#include "NetServer.h"
+#include "helpers/Log.h"
+#include "helpers/Net.h"
+#include "helpers/VExcept.h"
+#include "thread/ServerThread.h"
+#include "xmoto/Game.h"
+#include "xmoto/Replay.h"
+#include "xmscene/Bike.h"
+#include "xmscene/PhysicsSettings.h"
+#include "xmscene/Scene.h"
+#include <algorithm>
+#include <sstream>
+
+#define XM_LOADTEST_MAX_UDP_PACKET_SIZE 1024 // bytes
+#define XM_LOADTEST_PING_PERIOD 500 // ms
+#define XM_LOADTEST_CONTROL_PERIOD 100 // ms
+#define XM_LOADTEST_PHYSICS_FILE "Physics/original.xml"
+
+LoadTestBot::LoadTestBot(unsigned int i_num, NetClientMode i_mode) {
+  std::ostringstream v_key;
+
+  m_num = i_num;
+  m_mode = i_mode;
+  m_isConnected = false;
+  m_set = NULL;
+  m_serverReceivesUdp = false;
+  m_serverSendsUdp = false;
+  m_serverSendsBinaryHeaders = false;
+
+  m_udpSendPacket = SDLNet_AllocPacket(XM_LOADTEST_MAX_UDP_PACKET_SIZE);
+  m_udpReceiptPacket = SDLNet_AllocPacket(XM_LOADTEST_MAX_UDP_PACKET_SIZE);
+  if (!m_udpSendPacket || !m_udpReceiptPacket) {
+    throw Exception("SDLNet_AllocPacket: " + std::string(SDLNet_GetError()));
+  }
+  m_tcpReader = new ActionReader();
+
+  // deterministic keys and timings, to get comparable runs
+  v_key << "loadtest" << i_num;
+  m_udpBindKey = v_key.str();
+
+  m_udpBytesReceived = 0;
+  m_statsStartBytes = 0;
+  m_pingId = -1;
+  m_pingTime = 0;
+  m_nextPingTime = 0;
+  m_nextControlTime = 0;
+  m_nbControls = 0;
+  m_nextFrameTime = 0;
+  m_currentFrame = 0;
+}
+
+LoadTestBot::~LoadTestBot() {
+  disconnect();
+  delete m_tcpReader;
+  SDLNet_FreePacket(m_udpSendPacket);
+  SDLNet_FreePacket(m_udpReceiptPacket);
+}
+
+void LoadTestBot::connect(IPaddress *i_serverIp,
+                          SDLNet_SocketSet i_set,
+                          const std::string &i_levelId) {
+  std::ostringstream v_name;
+
+  if (!(m_tcpsd = SDLNet_TCP_Open(i_serverIp))) {
+    throw Exception(SDLNet_GetError());
+  }
+
+  if ((m_udpsd = SDLNet_UDP_Open(0)) == 0) {
+    SDLNet_TCP_Close(m_tcpsd);
+    throw Exception(SDLNet_GetError());
+  }
+  m_udpSendPacket->address = *i_serverIp;
+
+  m_set = i_set;
+  SDLNet_TCP_AddSocket(m_set, m_tcpsd);
+  SDLNet_UDP_AddSocket(m_set, m_udpsd);
+  m_isConnected = true;
+
+  // same sequence as the real client
+  NA_clientInfos na(XM_NET_PROTOCOL_VERSION, m_udpBindKey);
+  send(&na);
+
+  v_name << "bot" << m_num;
+  NA_changeName nan(v_name.str());
+  send(&nan);
+
+  if (m_mode == NETCLIENT_SLAVE_MODE) {
+    NA_clientMode nam(NETCLIENT_SLAVE_MODE);
+    send(&nam);
+  } else {
+    NA_playingLevel nal(i_levelId);
+    send(&nal);
+  }
+}
+
+void LoadTestBot::disconnect() {
+  if (m_isConnected == false) {
+    return;
+  }
+
+  SDLNet_TCP_DelSocket(m_set, m_tcpsd);
+  SDLNet_UDP_DelSocket(m_set, m_udpsd);
+  SDLNet_TCP_Close(m_tcpsd);
+  SDLNet_UDP_Close(m_udpsd);
+  m_isConnected = false;
+}
+
+bool LoadTestBot::isConnected() const {
+  return m_isConnected;
+}
+
+void LoadTestBot::send(NetAction *i_netAction, bool i_forceUdp) {
+  i_netAction->setSource(0, 0);
+  i_netAction->setBinaryHeader(m_serverSendsBinaryHeaders);
+
+  try {
+    if (i_forceUdp) {
+      i_netAction->send(
+        NULL, &m_udpsd, m_udpSendPacket, &m_udpSendPacket->address);
+    } else if (m_serverReceivesUdp) {
+      i_netAction->send(
+        &m_tcpsd, &m_udpsd, m_udpSendPacket, &m_udpSendPacket->address);
+    } else {
+      i_netAction->send(&m_tcpsd, NULL, NULL, NULL);
+    }
+  } catch (Exception &e) {
+    LogWarning(
+      "loadtest: bot %u: send failed (%s)", m_num, e.getMsg().c_str());
+    disconnect();
+  }
+}
+
+void LoadTestBot::manageNetwork() {
+  while (m_isConnected && SDLNet_SocketReady(m_udpsd)) {
+    if (SDLNet_UDP_Recv(m_udpsd, m_udpReceiptPacket) == 1) {
+      m_udpBytesReceived += m_udpReceiptPacket->len;
+      try {
+        ActionReader::UDPReadAction(
+          m_udpReceiptPacket->data, m_udpReceiptPacket->len, &m_preAllocatedNA);
+        manageAction(m_preAllocatedNA.master);
+      } catch (Exception &e) {
+        LogWarning("loadtest: bot %u: bad UDP packet received (%s)",
+                   m_num,
+                   e.getMsg().c_str());
+      }
+    }
+  }
+
+  while (m_isConnected && SDLNet_SocketReady(m_tcpsd)) {
+    try {
+      // managing an action can disconnect the bot
+      while (m_isConnected &&
+             m_tcpReader->TCPReadAction(&m_tcpsd, &m_preAllocatedNA)) {
+        manageAction(m_preAllocatedNA.master);
+      }
+    } catch (Exception &e) {
+      LogWarning(
+        "loadtest: bot %u: disconnected (%s)", m_num, e.getMsg().c_str());
+      disconnect();
+    }
+  }
+}
+
+void LoadTestBot::manageAction(NetAction *i_netAction) {
+  if (i_netAction->hasBinaryHeader()) {
+    m_serverSendsBinaryHeaders = true;
+  }
+
+  switch (i_netAction->actionType()) {
+    case TNA_udpBindQuery: {
+      NA_udpBind na(m_udpBindKey);
+      for (unsigned int i = 0; i < 3; i++) {
+        send(&na, true);
+      }
+    } break;
+
+    case TNA_udpBind: {
+      if (m_serverSendsUdp == false) {
+        m_serverSendsUdp = true;
+        NA_udpBindValidation na;
+        send(&na);
+      }
+    } break;
+
+    case TNA_udpBindValidation: {
+      m_serverReceivesUdp = true;
+    } break;
+
+    case TNA_ping: {
+      if (((NA_ping *)i_netAction)->isPong()) {
+        if (((NA_ping *)i_netAction)->id() == m_pingId) {
+          m_latencies.push_back(GameApp::getXMTimeInt() - m_pingTime);
+          m_pingId = -1;
+        }
+      } else {
+        NA_ping na((NA_ping *)i_netAction);
+        send(&na);
+      }
+    } break;
+
+    case TNA_frameDelta: {
+      NetFrameAck v_ack;
+      bool v_found = false;
+
+      // only the last frame of each bike is acknowledged
+      for (unsigned int i = 0; i < m_pendingAcks.size(); i++) {
+        if (m_pendingAcks[i].Src == i_netAction->getSource() &&
+            m_pendingAcks[i].SubSrc == i_netAction->getSubSource()) {
+          m_pendingAcks[i].Seq = ((NA_frameDelta *)i_netAction)->seq();
+          v_found = true;
+        }
+      }
+      if (v_found == false) {
+        v_ack.Src = i_netAction->getSource();
+        v_ack.SubSrc = i_netAction->getSubSource();
+        v_ack.Seq = ((NA_frameDelta *)i_netAction)->seq();
+        m_pendingAcks.push_back(v_ack);
+      }
+    } break;
+
+    case TNA_serverError: {
+      LogWarning("loadtest: bot %u: server error (%s)",
+                 m_num,
+                 ((NA_serverError *)i_netAction)->getMessage().c_str());
+    } break;
+
+    default:
+      /* the content is not used by the bots */
+      break;
+  }
+}
+
+void LoadTestBot::update(int i_time,
+                         const std::vector<SerializedBikeState> &i_frames,
+                         int i_framePeriod) {
+  if (m_isConnected == false) {
+    return;
+  }
+
+  if (i_time >= m_nextPingTime) {
+    NA_ping na;
+    m_pingId = na.id();
+    m_pingTime = i_time;
+    m_nextPingTime = i_time + XM_LOADTEST_PING_PERIOD;
+    send(&na);
+  }
+
+  if (m_mode == NETCLIENT_SLAVE_MODE) {
+    if (i_time >= m_nextControlTime) {
+      // always throttle, pull and change the direction from time to time
+      NA_playerControl nat(PC_THROTTLE, 1.0f);
+      send(&nat);
+
+      NA_playerControl nap(PC_PULL,
+                           ((m_nbControls / 10 + m_num) % 2) == 0 ? 1.0f
+                                                                  : 0.0f);
+      send(&nap);
+
+      if (m_nbControls % (20 + m_num % 7) == 0) {
+        NA_playerControl nac(PC_CHANGEDIR, true);
+        send(&nac);
+      }
+
+      m_nbControls++;
+      m_nextControlTime = i_time + XM_LOADTEST_CONTROL_PERIOD;
+    }
+  } else if (i_frames.empty() == false) {
+    if (m_nextFrameTime == 0) {
+      // don't make all the bots ride at the same place
+      m_currentFrame = (m_num * 7) % i_frames.size();
+      m_nextFrameTime = i_time;
+    }
+
+    if (i_time >= m_nextFrameTime) {
+      SerializedBikeState v_state = i_frames[m_currentFrame];
+      NA_frame na(&v_state);
+      send(&na);
+
+      m_currentFrame = (m_currentFrame + 1) % i_frames.size();
+      m_nextFrameTime += i_framePeriod;
+      if (m_nextFrameTime < i_time) { // too late, don't burst
+        m_nextFrameTime = i_time + i_framePeriod;
+      }
+    }
+  }
+
+  if (m_pendingAcks.empty() == false) {
+    NA_frameAck na;
+    for (unsigned int i = 0; i < m_pendingAcks.size(); i++) {
+      na.add(m_pendingAcks[i]);
+    }
+    m_pendingAcks.clear();
+    send(&na);
+  }
+}
+
+void LoadTestBot::resetStats() {
+  m_statsStartBytes = m_tcpReader->tcpBytesReceived() + m_udpBytesReceived;
+  m_latencies.clear();
+}
+
+unsigned int LoadTestBot::bytesReceived() const {
+  return m_tcpReader->tcpBytesReceived() + m_udpBytesReceived -
+         m_statsStartBytes;
+}
+
+const std::vector<int> &LoadTestBot::latencies() const {
+  return m_latencies;
+}
+
+ServerLoadTest::ServerLoadTest(const std::string &i_server,
+                               int i_port,
+                               unsigned int i_nbBots,
+                               int i_duration,
+                               const std::string &i_replay) {
+  m_server = i_server;
+  m_port = i_port;
+  m_nbBots = i_nbBots;
+  m_duration = i_duration;
+  m_replay = i_replay;
+  m_frameRate = 25;
+  m_set = NULL;
+}
+
+ServerLoadTest::~ServerLoadTest() {
+  for (unsigned int i = 0; i < m_bots.size(); i++) {
+    delete m_bots[i];
+  }
+  if (m_set != NULL) {
+    SDLNet_FreeSocketSet(m_set);
+  }
+}
+
+void ServerLoadTest::loadReplayFrames() {
+  Replay v_replay;
+  std::string v_player;
+  PhysicsSettings v_physicsSettings(XM_LOADTEST_PHYSICS_FILE);
+  BikeState v_bikeState(&v_physicsSettings);
+  SerializedBikeState v_state;
+
+  m_levelId = v_replay.openReplay(m_replay, v_player);
+  if (v_replay.getFrameRate() > 0.0) {
+    m_frameRate = (int)v_replay.getFrameRate();
+  }
+
+  while (v_replay.endOfFile() == false) {
+    v_replay.loadState(&v_bikeState, &v_physicsSettings);
+    Scene::getSerializedBikeState(
+      &v_bikeState, v_bikeState.GameTime, &v_state, &v_physicsSettings);
+    m_frames.push_back(v_state);
+  }
+
+  if (m_frames.empty()) {
+    throw Exception("No frame in the replay " + m_replay);
+  }
+  LogInfo("loadtest: %u frames loaded from %s (level %s)",
+          (unsigned int)m_frames.size(),
+          m_replay.c_str(),
+          m_levelId.c_str());
+}
+
+void ServerLoadTest::run() {
+  IPaddress v_serverIp;
+  ServerTicksStats v_ticksStats;
+  int v_start, v_time;
+  int v_framePeriod;
+  int n_activ;
+
+  if (SDLNet_ResolveHost(&v_serverIp, m_server.c_str(), m_port) < 0) {
+    throw Exception(SDLNet_GetError());
+  }
+
+  // a local server is started in background : wait for it
+  if (NetServer::instance()->isStarted()) {
+    v_start = GameApp::getXMTimeInt();
+    while (NetServer::instance()->acceptConnections() == false &&
+           GameApp::getXMTimeInt() - v_start < 5000) {
+      SDL_Delay(10);
+    }
+  }
+
+  if (m_replay != "") {
+    loadReplayFrames();
+  }
+  v_framePeriod = 1000 / (m_frameRate > 0 ? m_frameRate : 25);
+
+  m_set = SDLNet_AllocSocketSet(m_nbBots * 2);
+  if (!m_set) {
+    throw Exception(SDLNet_GetError());
+  }
+
+  for (unsigned int i = 0; i < m_nbBots; i++) {
+    m_bots.push_back(new LoadTestBot(
+      i, m_replay == "" ? NETCLIENT_SLAVE_MODE : NETCLIENT_GHOST_MODE));
+    try {
+      m_bots[i]->connect(&v_serverIp, m_set, m_levelId);
+    } catch (Exception &e) {
+      LogWarning("loadtest: bot %u: unable to connect (%s)",
+                 i,
+                 e.getMsg().c_str());
+    }
+  }
+
+  // let the bindings and the first round settle, then measure
+  v_start = GameApp::getXMTimeInt();
+  do {
+    n_activ = SDLNet_CheckSockets(m_set, 10);
+    for (unsigned int i = 0; i < m_bots.size(); i++) {
+      m_bots[i]->manageNetwork();
+    }
+  } while (n_activ != -1 && GameApp::getXMTimeInt() - v_start < 1000);
+
+  for (unsigned int i = 0; i < m_bots.size(); i++) {
+    m_bots[i]->resetStats();
+  }
+  if (NetServer::instance()->isStarted()) {
+    NetServer::instance()->getTicksStats(&v_ticksStats, true);
+  }
+
+  LogInfo("loadtest: running %u bots during %i seconds", m_nbBots, m_duration);
+  v_start = GameApp::getXMTimeInt();
+  v_time = v_start;
+
+  while (v_time - v_start < m_duration * 1000) {
+    n_activ = SDLNet_CheckSockets(m_set, 1);
+    if (n_activ == -1) {
+      LogError("SDLNet_CheckSockets: %s", SDLNet_GetError());
+      throw Exception("CheckSockets failed");
+    }
+
+    if (n_activ > 0) {
+      for (unsigned int i = 0; i < m_bots.size(); i++) {
+        m_bots[i]->manageNetwork();
+      }
+    }
+
+    v_time = GameApp::getXMTimeInt();
+    for (unsigned int i = 0; i < m_bots.size(); i++) {
+      m_bots[i]->update(v_time, m_frames, v_framePeriod);
+    }
+  }
+
+  printReport((v_time - v_start) / 1000);
+}
+
+void ServerLoadTest::printReport(int i_duration) {
+  std::vector<int> v_latencies;
+  unsigned int v_nbConnected = 0;
+  unsigned int v_bytes, v_minBytes = 0, v_maxBytes = 0;
+  double v_totalBytes = 0.0;
+
+  if (i_duration <= 0) {
+    i_duration = 1;
+  }
+
+  for (unsigned int i = 0; i < m_bots.size(); i++) {
+    if (m_bots[i]->isConnected()) {
+      v_nbConnected++;
+    }
+
+    v_bytes = m_bots[i]->bytesReceived();
+    if (i == 0 || v_bytes < v_minBytes) {
+      v_minBytes = v_bytes;
+    }
+    if (i == 0 || v_bytes > v_maxBytes) {
+      v_maxBytes = v_bytes;
+    }
+    v_totalBytes += v_bytes;
+
+    v_latencies.insert(v_latencies.end(),
+                       m_bots[i]->latencies().begin(),
+                       m_bots[i]->latencies().end());
+  }
+  std::sort(v_latencies.begin(), v_latencies.end());
+
+  printf("Server load test: %u bots (%s), %i seconds\n",
+         m_nbBots,
+         m_replay == "" ? "slave mode" : "ghost mode",
+         i_duration);
+  printf("  %-24s %u\n", "connected at the end", v_nbConnected);
+
+  if (NetServer::instance()->isStarted()) {
+    ServerTicksStats v_ticksStats;
+    NetServer::instance()->getTicksStats(&v_ticksStats, false);
+    printf("  %-24s %u\n", "server ticks", v_ticksStats.nbTicks);
+    if (v_ticksStats.nbTicks > 0) {
+      printf("  %-24s %.3f ms (max %.3f ms)\n",
+             "server tick time",
+             v_ticksStats.totalTime / v_ticksStats.nbTicks,
+             v_ticksStats.maxTime);
+    }
+  }
+
+  if (m_bots.empty() == false) {
+    printf("  %-24s %s/s (min %s/s, max %s/s)\n",
+           "download by client",
+           XMNet::getFancyBytes(v_totalBytes / m_bots.size() / i_duration)
+             .c_str(),
+           XMNet::getFancyBytes(v_minBytes / i_duration).c_str(),
+           XMNet::getFancyBytes(v_maxBytes / i_duration).c_str());
+  }
+
+  if (v_latencies.empty()) {
+    printf("  %-24s -\n", "latency");
+  } else {
+    printf("  %-24s p50 %i ms, p90 %i ms, p99 %i ms, max %i ms (%u pings)\n",
+           "latency",
+           v_latencies[v_latencies.size() * 50 / 100],
+           v_latencies[v_latencies.size() * 90 / 100],
+           v_latencies[v_latencies.size() * 99 / 100],
+           v_latencies[v_latencies.size() - 1],
+           (unsigned int)v_latencies.size());
+  }
+}
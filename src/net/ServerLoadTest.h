@@ -0,0 +1,121 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __SERVERLOADTEST_H__
+#define __SERVERLOADTEST_H__
+
+#include "../include/xm_SDL_net.h"
+#include "BasicStructures.h"
+#include "NetActions.h"
+#include <string>
+#include <vector>
+
+class ActionReader;
+
+/*
+  Simulated client, speaking the protocol like NetClient does, but without
+  any scene : in slave mode, it sends controls to the server ; in ghost mode,
+  it sends the frames of a replay.
+*/
+class LoadTestBot {
+public:
+  LoadTestBot(unsigned int i_num, NetClientMode i_mode);
+  ~LoadTestBot();
+
+  void connect(IPaddress *i_serverIp,
+               SDLNet_SocketSet i_set,
+               const std::string &i_levelId);
+  void disconnect();
+  bool isConnected() const;
+
+  // read all the available actions
+  void manageNetwork();
+  // send what is planned at time i_time (ms)
+  void update(int i_time,
+              const std::vector<SerializedBikeState> &i_frames,
+              int i_framePeriod);
+
+  // statistics since the last reset
+  void resetStats();
+  unsigned int bytesReceived() const;
+  const std::vector<int> &latencies() const;
+
+private:
+  void send(NetAction *i_netAction, bool i_forceUdp = false);
+  void manageAction(NetAction *i_netAction);
+
+  unsigned int m_num;
+  NetClientMode m_mode;
+  bool m_isConnected;
+  SDLNet_SocketSet m_set;
+  TCPsocket m_tcpsd;
+  UDPsocket m_udpsd;
+  UDPpacket *m_udpSendPacket;
+  UDPpacket *m_udpReceiptPacket;
+  ActionReader *m_tcpReader;
+  NetActionU m_preAllocatedNA;
+  std::string m_udpBindKey;
+  bool m_serverReceivesUdp;
+  bool m_serverSendsUdp;
+  bool m_serverSendsBinaryHeaders;
+
+  unsigned int m_udpBytesReceived;
+  unsigned int m_statsStartBytes;
+  std::vector<int> m_latencies; // ms
+  int m_pingId;
+  int m_pingTime;
+  int m_nextPingTime;
+  int m_nextControlTime;
+  unsigned int m_nbControls;
+  int m_nextFrameTime;
+  unsigned int m_currentFrame;
+  std::vector<NetFrameAck> m_pendingAcks;
+};
+
+class ServerLoadTest {
+public:
+  // i_replay : empty for bots in slave mode, else bots sending the frames
+  ServerLoadTest(const std::string &i_server,
+                 int i_port,
+                 unsigned int i_nbBots,
+                 int i_duration /* seconds */,
+                 const std::string &i_replay = "");
+  ~ServerLoadTest();
+
+  void run();
+
+private:
+  void loadReplayFrames();
+  void printReport(int i_duration);
+
+  std::string m_server;
+  int m_port;
+  unsigned int m_nbBots;
+  int m_duration;
+  std::string m_replay;
+  std::string m_levelId;
+  int m_frameRate;
+
+  std::vector<LoadTestBot *> m_bots;
+  std::vector<SerializedBikeState> m_frames;
+  SDLNet_SocketSet m_set;
+};
+
+#endif
@@ -0,0 +1,422 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "ServerDbThread.h"
+#include "ServerThread.h"
+#include "db/xmDatabase.h"
+#include "helpers/Log.h"
+#include "helpers/VExcept.h"
+#include "include/xm_SDL.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+ServerDbJob::ServerDbJob() {}
+
+ServerDbJob::~ServerDbJob() {}
+
+void ServerDbJob::done(ServerThread *i_server) {
+  if (m_error != "") {
+    LogWarning("server: database job failed (%s)", m_error.c_str());
+  }
+}
+
+std::string ServerDbJob::error() const {
+  return m_error;
+}
+
+void ServerDbJob::setError(const std::string &i_error) {
+  m_error = i_error;
+}
+
+ServerDbThread::ServerDbThread(const std::string &i_dbKey)
+  : XMThread(i_dbKey) {
+  m_jobsMutex = SDL_CreateMutex();
+  m_jobsCond = SDL_CreateCond();
+  m_nbExecutingJobs = 0;
+}
+
+ServerDbThread::~ServerDbThread() {
+  if (isThreadRunning()) {
+    askThreadToEnd();
+    waitForThreadEnd();
+  }
+
+  for (unsigned int i = 0; i < m_jobs.size(); i++) {
+    delete m_jobs[i];
+  }
+  for (unsigned int i = 0; i < m_doneJobs.size(); i++) {
+    delete m_doneJobs[i];
+  }
+
+  SDL_DestroyMutex(m_jobsMutex);
+  SDL_DestroyCond(m_jobsCond);
+}
+
+void ServerDbThread::askThreadToEnd() {
+  SDL_LockMutex(m_jobsMutex);
+  XMThread::askThreadToEnd();
+  SDL_CondSignal(m_jobsCond);
+  SDL_UnlockMutex(m_jobsMutex);
+}
+
+int ServerDbThread::realThreadFunction() {
+  std::vector<ServerDbJob *> v_jobs;
+
+  SDL_LockMutex(m_jobsMutex);
+
+  // the jobs pushed before the end are still written
+  while (m_askThreadToEnd == false || m_jobs.empty() == false) {
+    if (m_jobs.empty()) {
+      SDL_CondWait(m_jobsCond, m_jobsMutex);
+      continue;
+    }
+
+    // take all the pending jobs in one batch
+    v_jobs.swap(m_jobs);
+    m_nbExecutingJobs = v_jobs.size();
+    SDL_UnlockMutex(m_jobsMutex);
+
+    executeJobs(v_jobs);
+
+    SDL_LockMutex(m_jobsMutex);
+    m_doneJobs.insert(m_doneJobs.end(), v_jobs.begin(), v_jobs.end());
+    m_nbExecutingJobs = 0;
+    v_jobs.clear();
+  }
+
+  SDL_UnlockMutex(m_jobsMutex);
+
+  return 0;
+}
+
+void ServerDbThread::executeJobs(std::vector<ServerDbJob *> &i_jobs) {
+  try {
+    m_pDb->srv_beginTransaction();
+  } catch (Exception &e) {
+    for (unsigned int i = 0; i < i_jobs.size(); i++) {
+      i_jobs[i]->setError(e.getMsg());
+    }
+    return;
+  }
+
+  for (unsigned int i = 0; i < i_jobs.size(); i++) {
+    try {
+      i_jobs[i]->execute(m_pDb);
+    } catch (Exception &e) {
+      i_jobs[i]->setError(e.getMsg());
+    }
+  }
+
+  try {
+    m_pDb->srv_commitTransaction();
+  } catch (Exception &e) {
+    LogWarning("server: unable to commit the database jobs (%s)",
+               e.getMsg().c_str());
+    try {
+      m_pDb->srv_rollbackTransaction();
+    } catch (Exception &e2) {
+      /* ok, no pb */
+    }
+    for (unsigned int i = 0; i < i_jobs.size(); i++) {
+      i_jobs[i]->setError(e.getMsg());
+    }
+  }
+}
+
+void ServerDbThread::pushJob(ServerDbJob *i_job) {
+  SDL_LockMutex(m_jobsMutex);
+  m_jobs.push_back(i_job);
+  SDL_CondSignal(m_jobsCond);
+  SDL_UnlockMutex(m_jobsMutex);
+}
+
+void ServerDbThread::manageDoneJobs(ServerThread *i_server) {
+  std::vector<ServerDbJob *> v_jobs;
+
+  SDL_LockMutex(m_jobsMutex);
+  v_jobs.swap(m_doneJobs);
+  SDL_UnlockMutex(m_jobsMutex);
+
+  for (unsigned int i = 0; i < v_jobs.size(); i++) {
+    try {
+      v_jobs[i]->done(i_server);
+    } catch (Exception &e) {
+      LogWarning("server: database job not managed (%s)", e.getMsg().c_str());
+    }
+    delete v_jobs[i];
+  }
+}
+
+bool ServerDbThread::hasJobs() {
+  bool v_res;
+
+  SDL_LockMutex(m_jobsMutex);
+  v_res = m_jobs.empty() == false || m_nbExecutingJobs > 0 ||
+          m_doneJobs.empty() == false;
+  SDL_UnlockMutex(m_jobsMutex);
+
+  return v_res;
+}
+
+void ServerLevelsJob::execute(xmDatabase *i_db) {
+  char **v_result;
+  unsigned int nrow;
+
+  // don't allow own levels (isToReload=1)
+  v_result = i_db->readDB("SELECT id_level "
+                          "FROM levels "
+                          // warning, addforcetoplayer event cannot be over
+                          // network game cause player id is serialized
+                          "WHERE isToReload=0 AND isScripted=0 "
+                          "AND isPhysics=0;",
+                          nrow);
+  for (unsigned int i = 0; i < nrow; i++) {
+    m_levels.push_back(i_db->getResult(v_result, 1, i, 0));
+  }
+  i_db->read_DB_free(v_result);
+}
+
+void ServerLevelsJob::done(ServerThread *i_server) {
+  i_server->dbSnapshotsJobDone();
+  if (error() != "") {
+    ServerDbJob::done(i_server);
+    return;
+  }
+  i_server->setLevelsSnapshot(m_levels);
+}
+
+ServerBansJob::ServerBansJob(bool i_isSnapshotsRefresh) {
+  m_isSnapshotsRefresh = i_isSnapshotsRefresh;
+}
+
+void ServerBansJob::execute(xmDatabase *i_db) {
+  char **v_result;
+  unsigned int nrow;
+  ServerBan v_ban;
+  time_t v_now = time(NULL);
+
+  v_result = i_db->readDB(
+    "SELECT id_profile, ip, "
+    "(nb_days - (julianday('now')-julianday(from_date))) * 86400 "
+    "FROM srv_bans "
+    "WHERE nb_days - (julianday('now')-julianday(from_date)) > 0;",
+    nrow);
+  for (unsigned int i = 0; i < nrow; i++) {
+    v_ban.profile = i_db->getResult(v_result, 3, i, 0);
+    v_ban.ip = i_db->getResult(v_result, 3, i, 1);
+    v_ban.endTime = v_now + (time_t)atof(i_db->getResult(v_result, 3, i, 2));
+    m_bans.push_back(v_ban);
+  }
+  i_db->read_DB_free(v_result);
+}
+
+void ServerBansJob::done(ServerThread *i_server) {
+  if (m_isSnapshotsRefresh) {
+    i_server->dbSnapshotsJobDone();
+  }
+  if (error() != "") {
+    ServerDbJob::done(i_server);
+    return;
+  }
+  i_server->setBansSnapshot(m_bans);
+}
+
+ServerCmdJob::ServerCmdJob(ServerCmdJobType i_type, unsigned int i_clientId) {
+  m_type = i_type;
+  m_clientId = i_clientId;
+  m_id = 0;
+  m_nbDays = 0;
+  m_adminConnected = false;
+}
+
+void ServerCmdJob::setProfile(const std::string &i_profile) {
+  m_profile = i_profile;
+}
+
+void ServerCmdJob::setPassword(const std::string &i_password) {
+  m_password = i_password;
+}
+
+void ServerCmdJob::setIp(const std::string &i_ip) {
+  m_ip = i_ip;
+}
+
+void ServerCmdJob::setId(int i_id) {
+  m_id = i_id;
+}
+
+void ServerCmdJob::setNbDays(unsigned int i_nbDays) {
+  m_nbDays = i_nbDays;
+}
+
+void ServerCmdJob::setAdminBanner(const std::string &i_adminBanner) {
+  m_adminBanner = i_adminBanner;
+}
+
+void ServerCmdJob::execute(xmDatabase *i_db) {
+  char **v_result;
+  unsigned int nrow;
+
+  switch (m_type) {
+    case SRVCMD_LOCAL_LOGIN:
+      // local admins are allowed only when there is no other admin
+      v_result = i_db->readDB("SELECT id, id_profile "
+                              "FROM srv_admins;",
+                              nrow);
+      i_db->read_DB_free(v_result);
+      if (nrow == 0) {
+        m_adminConnected = true;
+        m_answer += "Local admin\n";
+        m_answer += "Connected\n";
+      } else {
+        m_answer +=
+          "Local admins are allowed only when no other admin exists\n";
+      }
+      break;
+
+    case SRVCMD_LOGIN:
+      if (i_db->srv_isAdmin(m_profile, m_password)) {
+        m_adminConnected = true;
+        m_answer += "Connected\n";
+      } else {
+        m_answer += "Invalid password\n";
+      }
+      break;
+
+    case SRVCMD_CHANGEPASSWORD:
+      i_db->srv_changePassword(m_profile, m_password);
+      m_answer += "Password changed";
+      break;
+
+    case SRVCMD_LSADMINS: {
+      char v_adminstr[20];
+
+      v_result = i_db->readDB("SELECT id, id_profile "
+                              "FROM srv_admins "
+                              "ORDER BY id_profile;",
+                              nrow);
+      for (unsigned int i = 0; i < nrow; i++) {
+        snprintf(v_adminstr,
+                 20,
+                 "%5s: %-12s",
+                 i_db->getResult(v_result, 2, i, 0),
+                 i_db->getResult(v_result, 2, i, 1));
+        m_answer += v_adminstr;
+        m_answer += "\n";
+      }
+      i_db->read_DB_free(v_result);
+    } break;
+
+    case SRVCMD_ADDADMIN:
+      try {
+        i_db->srv_addAdmin(m_profile, m_password);
+        m_answer += "admin added\n";
+      } catch (Exception &e) {
+        m_answer += "unable to add the admin\n";
+        m_answer += e.getMsg() + "\n";
+      }
+      break;
+
+    case SRVCMD_RMADMIN:
+      i_db->srv_removeAdmin(m_id);
+      m_answer += "admin removed\n";
+      break;
+
+    case SRVCMD_LSBANS: {
+      char v_banstr[100];
+
+      // clean old bans before reading them
+      i_db->srv_cleanBans();
+
+      v_result =
+        i_db->readDB("SELECT id, id_profile, ip, from_date, ROUND(nb_days - "
+                     "(julianday('now')-julianday(from_date)), 1) remaining, "
+                     "id_admin_banner "
+                     "FROM srv_bans "
+                     "ORDER BY id;",
+                     nrow);
+
+      m_answer += "+----+-----------------+----------------+-------------------"
+                  "+----------------+-----------------+\n";
+      m_answer += "|  id|login            |ip              | ban date          "
+                  "| remaining days | banner          |\n";
+      m_answer += "+----+-----------------+----------------+-------------------"
+                  "+----------------+-----------------+\n";
+
+      for (unsigned int i = 0; i < nrow; i++) {
+        snprintf(v_banstr,
+                 100,
+                 "%5s %-17s %-16s %19s %16s %17s",
+                 std::string(i_db->getResult(v_result, 6, i, 0)).c_str(),
+                 std::string(i_db->getResult(v_result, 6, i, 1)).c_str(),
+                 std::string(i_db->getResult(v_result, 6, i, 2)).c_str(),
+                 std::string(i_db->getResult(v_result, 6, i, 3)).c_str(),
+                 std::string(i_db->getResult(v_result, 6, i, 4)).c_str(),
+                 (i_db->getResult(v_result, 6, i, 5) == NULL)
+                   ? "Unknown"
+                   : std::string(i_db->getResult(v_result, 6, i, 5)).c_str());
+        m_answer += v_banstr;
+        m_answer += "\n"; // cause 100 could not include the \n
+      }
+      i_db->read_DB_free(v_result);
+    } break;
+
+    case SRVCMD_BAN:
+      try {
+        i_db->srv_addBan(m_profile, m_ip, m_nbDays, m_adminBanner);
+        m_answer += "ban added\n";
+      } catch (Exception &e) {
+        m_answer += "unable to add the ban\n";
+        m_answer += e.getMsg() + "\n";
+      }
+      break;
+
+    case SRVCMD_UNBAN:
+      i_db->srv_removeBan(m_id);
+      m_answer += "ban removed\n";
+      break;
+  }
+}
+
+void ServerCmdJob::done(ServerThread *i_server) {
+  if (error() != "") {
+    ServerDbJob::done(i_server);
+    i_server->sendSrvCmdAnswer(m_clientId, "An error occurred: " + error());
+    return;
+  }
+
+  if (m_adminConnected) {
+    try {
+      NetSClient *v_client = i_server->getNetSClientById(m_clientId);
+
+      // the client could have changed its name while the job was executed
+      if (v_client->name() == m_profile) {
+        v_client->setAdminConnected(true);
+      } else {
+        m_answer = "Invalid password\n";
+      }
+    } catch (Exception &e) {
+      /* the client left */
+      return;
+    }
+  }
+
+  i_server->sendSrvCmdAnswer(m_clientId, m_answer);
+}
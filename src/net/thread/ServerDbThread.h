@@ -0,0 +1,155 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __SERVERDBTHREAD_H__
+#define __SERVERDBTHREAD_H__
+
+#include "../../thread/XMThread.h"
+#include <string>
+#include <time.h>
+#include <vector>
+
+struct SDL_mutex;
+struct SDL_cond;
+class ServerThread;
+
+/*
+  database access of the server : execute() is called from the database
+  thread, then done() is called from the server thread
+*/
+class ServerDbJob {
+public:
+  ServerDbJob();
+  virtual ~ServerDbJob();
+
+  virtual void execute(xmDatabase *i_db) = 0;
+  virtual void done(ServerThread *i_server);
+
+  // empty if execute() succeeded
+  std::string error() const;
+  void setError(const std::string &i_error);
+
+private:
+  std::string m_error;
+};
+
+/*
+  the server thread must not wait for the database : it pushes its jobs to
+  this thread which writes them in batches, one transaction per batch
+*/
+class ServerDbThread : public XMThread {
+public:
+  ServerDbThread(const std::string &i_dbKey);
+  virtual ~ServerDbThread();
+
+  int realThreadFunction();
+  void askThreadToEnd();
+
+  // the thread takes the ownership of the job
+  void pushJob(ServerDbJob *i_job);
+  // call done() on the executed jobs and delete them ; from the server thread
+  void manageDoneJobs(ServerThread *i_server);
+  // jobs are still to execute or to manage
+  bool hasJobs();
+
+private:
+  void executeJobs(std::vector<ServerDbJob *> &i_jobs);
+
+  std::vector<ServerDbJob *> m_jobs;
+  std::vector<ServerDbJob *> m_doneJobs;
+  unsigned int m_nbExecutingJobs; // neither in m_jobs nor in m_doneJobs
+  SDL_mutex *m_jobsMutex;
+  SDL_cond *m_jobsCond;
+};
+
+struct ServerBan {
+  std::string profile; // * for all profiles
+  std::string ip; // * for all ips
+  time_t endTime;
+};
+
+/* levels which can be played on the server */
+class ServerLevelsJob : public ServerDbJob {
+public:
+  void execute(xmDatabase *i_db);
+  void done(ServerThread *i_server);
+
+private:
+  std::vector<std::string> m_levels;
+};
+
+/* bans still active */
+class ServerBansJob : public ServerDbJob {
+public:
+  // i_isSnapshotsRefresh : false when the bans changed by a command
+  ServerBansJob(bool i_isSnapshotsRefresh = true);
+
+  void execute(xmDatabase *i_db);
+  void done(ServerThread *i_server);
+
+private:
+  bool m_isSnapshotsRefresh;
+  std::vector<ServerBan> m_bans;
+};
+
+enum ServerCmdJobType {
+  SRVCMD_LOCAL_LOGIN,
+  SRVCMD_LOGIN,
+  SRVCMD_CHANGEPASSWORD,
+  SRVCMD_LSADMINS,
+  SRVCMD_ADDADMIN,
+  SRVCMD_RMADMIN,
+  SRVCMD_LSBANS,
+  SRVCMD_BAN,
+  SRVCMD_UNBAN
+};
+
+/* server command accessing the database ; the answer is sent to the client
+   once executed */
+class ServerCmdJob : public ServerDbJob {
+public:
+  ServerCmdJob(ServerCmdJobType i_type, unsigned int i_clientId);
+
+  // arguments, depending on the command
+  void setProfile(const std::string &i_profile);
+  void setPassword(const std::string &i_password);
+  void setIp(const std::string &i_ip);
+  void setId(int i_id);
+  void setNbDays(unsigned int i_nbDays);
+  void setAdminBanner(const std::string &i_adminBanner);
+
+  void execute(xmDatabase *i_db);
+  void done(ServerThread *i_server);
+
+private:
+  ServerCmdJobType m_type;
+  unsigned int m_clientId;
+  std::string m_profile;
+  std::string m_password;
+  std::string m_ip;
+  int m_id;
+  unsigned int m_nbDays;
+  std::string m_adminBanner;
+
+  std::string m_answer;
+  bool m_adminConnected;
+};
+
+#endif
@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "helpers/Log.h"
 #include "helpers/System.h"
 #include "helpers/VExcept.h"
+#include "helpers/VMath.h"
 #include "helpers/utf8.h"
 #include "states/StateManager.h"
 #include "xmoto/Game.h"
@@ -36,6 +37,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "xmoto/Universe.h"
 #include "xmscene/BikeController.h"
 #include "xmscene/Level.h"
+#include <chrono>
 #include <sstream>
 #include <string>
 
@@ -53,6 +55,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define XM_SERVER_DEFAULT_BANNER "Welcome on this server"
 #define XM_SERVER_UNPLAYING_SLEEP 10
 #define XM_SERVER_NICK_LENGTH_MAX 16
+#define XM_SERVER_DB_JOBS_CHECK_TIME 10 // ms
+#define XM_SERVER_NO_LEVEL_RETRY_TIME 5000 // ms
 
 // limit multi private message to avoid people spamming everybody and making
 // think it's private
@@ -90,6 +94,10 @@ NetSClient::NetSClient(unsigned int i_id,
 
 NetSClient::~NetSClient() {
   delete tcpReader;
+
+  for (unsigned int i = 0; i < m_frameStreams.size(); i++) {
+    delete m_frameStreams[i];
+  }
 }
 
 bool NetSClient::isAdminConnected() const {
@@ -272,6 +280,46 @@ NetPing *NetSClient::lastPing() {
   return &m_lastPing;
 }
 
+NetFrameStream *NetSClient::getFrameStream(int i_src, int i_subsrc) {
+  for (unsigned int i = 0; i < m_frameStreams.size(); i++) {
+    if (m_frameStreams[i]->src == i_src &&
+        m_frameStreams[i]->subsrc == i_subsrc) {
+      return m_frameStreams[i];
+    }
+  }
+  return NULL;
+}
+
+NetFrameStream *NetSClient::frameStream(int i_src, int i_subsrc) {
+  NetFrameStream *v_stream = getFrameStream(i_src, i_subsrc);
+
+  if (v_stream == NULL) {
+    v_stream = new NetFrameStream();
+    v_stream->src = i_src;
+    v_stream->subsrc = i_subsrc;
+    v_stream->nextSeq = 0;
+    v_stream->ackedSeq = -1;
+    for (unsigned int i = 0; i < XM_NET_FRAMES_HISTORY; i++) {
+      v_stream->valids[i] = false;
+    }
+    m_frameStreams.push_back(v_stream);
+  }
+  return v_stream;
+}
+
+void NetSClient::removeFrameStreams(int i_src) {
+  unsigned int i = 0;
+
+  while (i < m_frameStreams.size()) {
+    if (m_frameStreams[i]->src == i_src) {
+      delete m_frameStreams[i];
+      m_frameStreams.erase(m_frameStreams.begin() + i);
+    } else {
+      i++;
+    }
+  }
+}
+
 ServerThread::ServerThread(const std::string &i_dbKey,
                            int i_port,
                            const std::string &i_adminPassword)
@@ -298,6 +346,14 @@ ServerThread::ServerThread(const std::string &i_dbKey,
   m_rules = NULL;
   m_needToReloadRules = false;
   m_sceneHook = new XMServerSceneHooks(this);
+  m_dbThread = new ServerDbThread(i_dbKey + "_DB");
+  m_nbDbSnapshotsJobs = 0;
+  m_lastDbSnapshotsRefresh = 0;
+
+  m_ticksStats.nbTicks = 0;
+  m_ticksStats.totalTime = 0.0;
+  m_ticksStats.maxTime = 0.0;
+  m_ticksStatsMutex = SDL_CreateMutex();
 
   if (!m_udpPacket) {
     throw Exception("SDLNet_AllocPacket: " + std::string(SDLNet_GetError()));
@@ -311,6 +367,23 @@ ServerThread::~ServerThread() {
     delete m_rules;
   }
   delete m_sceneHook;
+  delete m_dbThread;
+  SDL_DestroyMutex(m_ticksStatsMutex);
+}
+
+ServerTicksStats ServerThread::getTicksStats(bool i_reset) {
+  ServerTicksStats v_res;
+
+  SDL_LockMutex(m_ticksStatsMutex);
+  v_res = m_ticksStats;
+  if (i_reset) {
+    m_ticksStats.nbTicks = 0;
+    m_ticksStats.totalTime = 0.0;
+    m_ticksStats.maxTime = 0.0;
+  }
+  SDL_UnlockMutex(m_ticksStatsMutex);
+
+  return v_res;
 }
 
 int ServerThread::realThreadFunction() {
@@ -329,6 +402,20 @@ int ServerThread::realThreadFunction() {
     return 1;
   }
 
+  // first snapshots of the database, before accepting clients
+  try {
+    ServerLevelsJob v_levelsJob;
+    ServerBansJob v_bansJob;
+
+    v_levelsJob.execute(m_pDb);
+    v_levelsJob.done(this);
+    v_bansJob.execute(m_pDb);
+    v_bansJob.done(this);
+  } catch (Exception &e) {
+    LogError("server: unable to read the database (%s)", e.getMsg().c_str());
+    return 1;
+  }
+
   LogInfo("server: ports %i UDP & TCP", m_port);
 
   /* Resolving the host using NULL make network interface to listen */
@@ -375,6 +462,8 @@ int ServerThread::realThreadFunction() {
     return 1;
   }
 
+  m_dbThread->startThread();
+
   m_acceptConnections = true;
   if (StateManager::exists()) {
     StateManager::instance()->sendAsynchronousMessage("SERVER_STATUS_CHANGED");
@@ -431,6 +520,12 @@ void ServerThread::close() {
   SDLNet_FreeSocketSet(m_set);
   m_set = NULL;
 
+  // write the last jobs
+  if (m_dbThread->isThreadRunning()) {
+    m_dbThread->askThreadToEnd();
+    m_dbThread->waitForThreadEnd();
+  }
+
   if (StateManager::exists()) {
     StateManager::instance()->sendAsynchronousMessage("SERVER_STATUS_CHANGED");
   }
@@ -438,32 +533,72 @@ void ServerThread::close() {
 }
 
 std::string ServerThread::SP2_determineLevel() {
-  char **v_result;
-  unsigned int nrow;
-  std::string v_id_level;
-
-  // don't allow own levels (isToReload=1)
-  v_result = m_pDb->readDB(
-    "SELECT id_level "
-    "FROM levels "
-    "WHERE isToReload=0 AND isScripted=0 AND isPhysics=0 " // warning,
-    // addforcetoplayer
-    // event cannot be
-    // over network game
-    // cause player id is
-    // serialized
-    //"WHERE id_level='_iL00_' " // for tests
-    "ORDER BY RANDOM() LIMIT 1;",
-    nrow);
-  if (nrow == 0) {
-    m_pDb->read_DB_free(v_result);
+  if (m_levelsSnapshot.empty()) {
     throw Exception("Unable to get a level");
   }
-  v_id_level = m_pDb->getResult(v_result, 1, 0, 0);
-  m_pDb->read_DB_free(v_result);
-  /* */
 
-  return v_id_level;
+  // for tests : return "_iL00_";
+  return m_levelsSnapshot[randomIntNum(0, m_levelsSnapshot.size())];
+}
+
+void ServerThread::setLevelsSnapshot(const std::vector<std::string> &i_levels) {
+  m_levelsSnapshot = i_levels;
+  if (m_levelsSnapshot.empty()) {
+    LogWarning("server: no level can be played");
+  }
+}
+
+void ServerThread::setBansSnapshot(const std::vector<ServerBan> &i_bans) {
+  m_bansSnapshot = i_bans;
+}
+
+void ServerThread::refreshDbSnapshots() {
+  // don't queue the same jobs again while the database thread is busy
+  if (m_nbDbSnapshotsJobs > 0) {
+    return;
+  }
+
+  m_nbDbSnapshotsJobs = 2;
+  m_lastDbSnapshotsRefresh = GameApp::getXMTimeInt();
+  m_dbThread->pushJob(new ServerLevelsJob());
+  m_dbThread->pushJob(new ServerBansJob());
+}
+
+void ServerThread::dbSnapshotsJobDone() {
+  // the first snapshots are not done by the database thread
+  if (m_nbDbSnapshotsJobs > 0) {
+    m_nbDbSnapshotsJobs--;
+  }
+}
+
+bool ServerThread::isWaitingForLevels() {
+  return m_levelsSnapshot.empty() &&
+         nbClientsInMode(NETCLIENT_SLAVE_MODE) > 0;
+}
+
+bool ServerThread::isBanned(const std::string &i_profile,
+                            const std::string &i_ip) const {
+  time_t v_now = time(NULL);
+
+  for (unsigned int i = 0; i < m_bansSnapshot.size(); i++) {
+    if (m_bansSnapshot[i].endTime > v_now &&
+        (m_bansSnapshot[i].profile == "*" ||
+         m_bansSnapshot[i].profile == i_profile) &&
+        (m_bansSnapshot[i].ip == "*" || m_bansSnapshot[i].ip == i_ip)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int ServerThread::networkWaitTimeout() {
+  // answers of the database thread must not wait a network event
+  if (m_dbThread->hasJobs()) {
+    return XM_SERVER_DB_JOBS_CHECK_TIME;
+  }
+  return m_sp2phase == SP2_PHASE_WAIT_CLIENTS && isWaitingForLevels()
+           ? XM_SERVER_NO_LEVEL_RETRY_TIME
+           : -1;
 }
 
 void ServerThread::SP2_initPlaying() {
@@ -726,19 +861,26 @@ void ServerThread::SP2_updateScenePlaying() {
               v_scene->getTime(),
               &BikeState,
               v_scene->getPhysicsSettings());
-            NA_frame na(&BikeState);
-            try {
-              if (v_firstFrame ||
-                  m_currentFrame % (100 / XM_SERVER_UPLOADING_FPS_PLAYER) ==
-                    0) {
-                sendToClient(&na, i, -1, 0);
+            if (v_firstFrame ||
+                m_currentFrame % (100 / XM_SERVER_UPLOADING_FPS_PLAYER) == 0) {
+              try {
+                sendFrameToClient(&BikeState, i, -1, 0);
+              } catch (Exception &e) {
               }
-              if (v_firstFrame ||
-                  m_currentFrame % (100 / XM_SERVER_UPLOADING_FPS_OPLAYERS) ==
-                    0) {
-                sendToAllClientsMarkedToPlay(&na, m_clients[i]->id(), 0, i);
+            }
+            if (v_firstFrame ||
+                m_currentFrame % (100 / XM_SERVER_UPLOADING_FPS_OPLAYERS) ==
+                  0) {
+              for (unsigned int j = 0; j < m_clients.size(); j++) {
+                if (j != i && m_clients[j]->isMarkedToPlay()) {
+                  // one client failing must not prevent the others to get
+                  // the frame
+                  try {
+                    sendFrameToClient(&BikeState, j, m_clients[i]->id(), 0);
+                  } catch (Exception &e) {
+                  }
+                }
               }
-            } catch (Exception &e) {
             }
           }
         }
@@ -776,6 +918,8 @@ void ServerThread::SP2_setPhase(ServerP2Phase i_sp2phase) {
       break;
 
     case SP2_PHASE_WAIT_CLIENTS:
+      refreshDbSnapshots();
+
       // load rules if they changed
       try {
         if (m_needToReloadRules) {
@@ -831,13 +975,23 @@ unsigned int ServerThread::nbClientsInMode(NetClientMode i_mode) {
 }
 
 void ServerThread::run_loop() {
+  m_dbThread->manageDoneJobs(this);
+
   switch (m_sp2phase) {
     case SP2_PHASE_NONE:
-      manageNetwork(-1); // wait a network event
+      manageNetwork(networkWaitTimeout()); // wait a network event
       break;
 
     case SP2_PHASE_WAIT_CLIENTS:
-      if (nbClientsInMode(NETCLIENT_SLAVE_MODE) > 0) {
+      // without any level, the round would fail to start again and again ;
+      // the levels are read again from time to time instead
+      if (isWaitingForLevels()) {
+        if (GameApp::getXMTimeInt() - m_lastDbSnapshotsRefresh >=
+            XM_SERVER_NO_LEVEL_RETRY_TIME) {
+          refreshDbSnapshots();
+        }
+        manageNetwork(networkWaitTimeout()); // wait a network event
+      } else if (nbClientsInMode(NETCLIENT_SLAVE_MODE) > 0) {
         // mark clients as to play
         for (unsigned int i = 0; i < m_clients.size(); i++) {
           if (m_clients[i]->mode() == NETCLIENT_SLAVE_MODE) {
@@ -846,7 +1000,7 @@ void ServerThread::run_loop() {
         }
         SP2_setPhase(SP2_PHASE_PLAYING);
       } else {
-        manageNetwork(-1); // wait a network event
+        manageNetwork(networkWaitTimeout()); // wait a network event
       }
       break;
 
@@ -864,8 +1018,25 @@ void ServerThread::run_loop() {
       }
       m_sp2_lastLoopTime = GameApp::getXMTimeInt();
 
-      SP2_updateScenePlaying();
-      SP2_updateCheckScenePlaying();
+      {
+        // the ticks last a few ms : the ms of the game time is too coarse
+        std::chrono::steady_clock::time_point v_tickStart =
+          std::chrono::steady_clock::now();
+
+        SP2_updateScenePlaying();
+        SP2_updateCheckScenePlaying();
+
+        double v_tickTime = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - v_tickStart)
+                              .count();
+        SDL_LockMutex(m_ticksStatsMutex);
+        m_ticksStats.nbTicks++;
+        m_ticksStats.totalTime += v_tickTime;
+        if (v_tickTime > m_ticksStats.maxTime) {
+          m_ticksStats.maxTime = v_tickTime;
+        }
+        SDL_UnlockMutex(m_ticksStatsMutex);
+      }
 
       // mange the network according to time spent
       // what is the remaing time on the 0.01s allowed
@@ -1001,16 +1172,66 @@ void ServerThread::removeClient(unsigned int i) {
   } catch (Exception &e) {
   }
 
+  // forget the frames sent about him
+  for (unsigned int j = 0; j < m_clients.size(); j++) {
+    if (j != i) {
+      m_clients[j]->removeFrameStreams(m_clients[i]->id());
+    }
+  }
+
   delete m_clients[i];
   m_clients.erase(m_clients.begin() + i);
 }
 
+void ServerThread::sendFrameToClient(SerializedBikeState *i_state,
+                                     unsigned int i,
+                                     int i_src,
+                                     int i_subsrc) {
+  NetFrameStream *v_stream;
+  unsigned short v_seq;
+  unsigned int v_baseSlot;
+
+  if (m_clients[i]->protocolVersion() < 7) {
+    NA_frame na(i_state);
+    sendToClient(&na, i, i_src, i_subsrc);
+    return;
+  }
+
+  v_stream = m_clients[i]->frameStream(i_src, i_subsrc);
+  v_seq = v_stream->nextSeq++;
+
+  /* encode against the last acknowledged frame if it is still known, else
+   * send the full frame */
+  if (v_stream->ackedSeq >= 0 &&
+      (unsigned short)(v_seq - v_stream->ackedSeq) < XM_NET_FRAMES_HISTORY) {
+    v_baseSlot = v_stream->ackedSeq % XM_NET_FRAMES_HISTORY;
+  } else {
+    v_baseSlot = XM_NET_FRAMES_HISTORY;
+  }
+
+  if (v_baseSlot < XM_NET_FRAMES_HISTORY && v_stream->valids[v_baseSlot] &&
+      v_stream->seqs[v_baseSlot] == v_stream->ackedSeq) {
+    NA_frameDelta na(
+      v_seq, i_state, v_stream->ackedSeq, &(v_stream->states[v_baseSlot]));
+    sendToClient(&na, i, i_src, i_subsrc);
+  } else {
+    NA_frameDelta na(v_seq, i_state);
+    sendToClient(&na, i, i_src, i_subsrc);
+  }
+
+  v_stream->states[v_seq % XM_NET_FRAMES_HISTORY] = *i_state;
+  v_stream->seqs[v_seq % XM_NET_FRAMES_HISTORY] = v_seq;
+  v_stream->valids[v_seq % XM_NET_FRAMES_HISTORY] = true;
+}
+
 void ServerThread::sendToClient(NetAction *i_netAction,
                                 unsigned int i,
                                 int i_src,
                                 int i_subsrc,
                                 bool i_forceUdp) {
   i_netAction->setSource(i_src, i_subsrc);
+  i_netAction->setBinaryHeader(m_clients[i]->protocolVersion() >=
+                               XM_NET_BINARY_HEADER_MIN_PROTOCOL);
   if (i_forceUdp) {
     i_netAction->send(NULL, &m_udpsd, m_udpPacket, m_clients[i]->udpRemoteIP());
   } else if (m_clients[i]->isUdpBinded() &&
@@ -1169,7 +1390,7 @@ void ServerThread::acceptClient() {
 
   // check bans - don't go over this code, while this is the only way to become
   // a client (new NetSClient)
-  if (m_pDb->srv_isBanned("", XMNet::getIp(tcpRemoteIP))) {
+  if (isBanned("", XMNet::getIp(tcpRemoteIP))) {
     LogInfo("server: banned client rejected (%s)",
             (XMNet::getIp(tcpRemoteIP)).c_str());
     NA_serverError na("Connexion refused");
@@ -1328,6 +1549,7 @@ bool ServerThread::manageAction(NetAction *i_netAction, unsigned int i_client) {
     case TNA_prepareToGo:
     case TNA_killAlert:
     case TNA_gameEvents:
+    case TNA_frameDelta:
     case TNA_srvCmdAsw: {
       /* should not be received */
       throw Exception("");
@@ -1497,10 +1719,10 @@ bool ServerThread::manageAction(NetAction *i_netAction, unsigned int i_client) {
                 m_clients[i_client]->playingLevelId() ==
                   m_clients[i]->playingLevelId()) {
               try {
-                sendToClient(i_netAction,
-                             i,
-                             m_clients[i_client]->id(),
-                             i_netAction->getSubSource());
+                sendFrameToClient(((NA_frame *)i_netAction)->getState(),
+                                  i,
+                                  m_clients[i_client]->id(),
+                                  i_netAction->getSubSource());
               } catch (Exception &e) {
                 // don't remove the client, it will be done in the main loop
               }
@@ -1511,6 +1733,32 @@ bool ServerThread::manageAction(NetAction *i_netAction, unsigned int i_client) {
       }
     } break;
 
+    case TNA_frameAck: {
+      const std::vector<NetFrameAck> &v_acks =
+        ((NA_frameAck *)i_netAction)->acks();
+      NetFrameStream *v_stream;
+      unsigned int v_slot;
+
+      for (unsigned int i = 0; i < v_acks.size(); i++) {
+        v_stream = m_clients[i_client]->getFrameStream(v_acks[i].Src,
+                                                       v_acks[i].SubSrc);
+        if (v_stream == NULL) {
+          continue;
+        }
+
+        // only frames sent and more recent than the current base
+        v_slot = v_acks[i].Seq % XM_NET_FRAMES_HISTORY;
+        if (v_stream->valids[v_slot] == false ||
+            v_stream->seqs[v_slot] != v_acks[i].Seq) {
+          continue;
+        }
+        if (v_stream->ackedSeq < 0 ||
+            (short)(v_acks[i].Seq - v_stream->ackedSeq) > 0) {
+          v_stream->ackedSeq = v_acks[i].Seq;
+        }
+      }
+    } break;
+
     case TNA_changeName: {
       m_clients[i_client]->setName(((NA_changeName *)i_netAction)->getName());
       if (m_clients[i_client]->name() == "") {
@@ -1530,9 +1778,8 @@ bool ServerThread::manageAction(NetAction *i_netAction, unsigned int i_client) {
       }
 
       // check bans
-      if (m_pDb->srv_isBanned(
-            m_clients[i_client]->name(),
-            XMNet::getIp(m_clients[i_client]->tcpRemoteIP()))) {
+      if (isBanned(m_clients[i_client]->name(),
+                   XMNet::getIp(m_clients[i_client]->tcpRemoteIP()))) {
         LogInfo("server: banned client rejected (%s)",
                 m_clients[i_client]->name().c_str());
 
@@ -1669,8 +1916,7 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
                                 const std::string &i_cmd) {
   std::string v_answer;
   std::vector<std::string> v_args;
-  char **v_result;
-  unsigned int nrow;
+  ServerCmdJob *v_job = NULL; // commands accessing the database
 
   utf8::utf8_split(i_cmd, " ", v_args);
 
@@ -1717,19 +1963,8 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
   } else if (v_args[0] == "login") {
     if (v_args.size() == 1) { // no arguments (local admins)
       if (XMNet::getIp(m_clients[i_client]->tcpRemoteIP()) == "127.0.0.1") {
-        // local admins are allowed only when there is no other admin
-        v_result = m_pDb->readDB("SELECT id, id_profile "
-                                 "FROM srv_admins;",
-                                 nrow);
-        m_pDb->read_DB_free(v_result);
-        if (nrow == 0) {
-          m_clients[i_client]->setAdminConnected(true);
-          v_answer += "Local admin\n";
-          v_answer += "Connected\n";
-        } else {
-          v_answer +=
-            "Local admins are allowed only when no other admin exists\n";
-        }
+        v_job = new ServerCmdJob(SRVCMD_LOCAL_LOGIN, m_clients[i_client]->id());
+        v_job->setProfile(m_clients[i_client]->name());
       } else {
         v_answer +=
           "Only local admins are allowed to connect without password\n";
@@ -1739,16 +1974,14 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
     } else if (m_clients[i_client]->isAdminConnected()) {
       v_answer += "Already connected\n";
     } else {
-      if ((m_adminPassword != "" &&
-           m_adminPassword ==
-             std::string(v_args[1])) || // master admin password
-          (m_pDb->srv_isAdmin(m_clients[i_client]->name(),
-                              v_args[1])) // normal admin password
-          ) {
+      if (m_adminPassword != "" &&
+          m_adminPassword == std::string(v_args[1])) { // master admin password
         m_clients[i_client]->setAdminConnected(true);
         v_answer += "Connected\n";
-      } else {
-        v_answer += "Invalid password\n";
+      } else { // normal admin password
+        v_job = new ServerCmdJob(SRVCMD_LOGIN, m_clients[i_client]->id());
+        v_job->setProfile(m_clients[i_client]->name());
+        v_job->setPassword(v_args[1]);
       }
     }
   } else if (m_clients[i_client]->isAdminConnected() == false) {
@@ -1767,38 +2000,25 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
     if (v_args.size() != 2) {
       v_answer += "changepassword: invalid arguments\n";
     } else {
-      m_pDb->srv_changePassword(m_clients[i_client]->name(), v_args[1]);
-      v_answer += "Password changed";
+      v_job =
+        new ServerCmdJob(SRVCMD_CHANGEPASSWORD, m_clients[i_client]->id());
+      v_job->setProfile(m_clients[i_client]->name());
+      v_job->setPassword(v_args[1]);
     }
 
   } else if (v_args[0] == "lsadmins") {
     if (v_args.size() != 1) {
       v_answer += "lsadmins: invalid arguments\n";
     } else {
-      char v_adminstr[20];
-
-      v_result = m_pDb->readDB("SELECT id, id_profile "
-                               "FROM srv_admins "
-                               "ORDER BY id_profile;",
-                               nrow);
-      for (unsigned int i = 0; i < nrow; i++) {
-        snprintf(v_adminstr,
-                 20,
-                 "%5s: %-12s",
-                 m_pDb->getResult(v_result, 2, i, 0),
-                 m_pDb->getResult(v_result, 2, i, 1));
-        v_answer += v_adminstr;
-        v_answer += "\n";
-      }
-      m_pDb->read_DB_free(v_result);
+      v_job = new ServerCmdJob(SRVCMD_LSADMINS, m_clients[i_client]->id());
     }
 
   } else if (v_args[0] == "rmadmin") {
     if (v_args.size() != 2) {
       v_answer += "rmadmin: invalid arguments\n";
     } else {
-      m_pDb->srv_removeAdmin(atoi(v_args[1].c_str()));
-      v_answer += "admin removed\n";
+      v_job = new ServerCmdJob(SRVCMD_RMADMIN, m_clients[i_client]->id());
+      v_job->setId(atoi(v_args[1].c_str()));
     }
 
   } else if (v_args[0] == "addadmin") {
@@ -1807,8 +2027,9 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
     } else {
       try {
         unsigned int v_nclient = getClientById(atoi(v_args[1].c_str()));
-        m_pDb->srv_addAdmin(m_clients[v_nclient]->name(), v_args[2]);
-        v_answer += "admin added\n";
+        v_job = new ServerCmdJob(SRVCMD_ADDADMIN, m_clients[i_client]->id());
+        v_job->setProfile(m_clients[v_nclient]->name());
+        v_job->setPassword(v_args[2]);
       } catch (Exception &e) {
         v_answer += "unable to add the admin\n";
         v_answer += e.getMsg() + "\n";
@@ -1889,42 +2110,7 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
     if (v_args.size() != 1) {
       v_answer += "lsban: invalid arguments\n";
     } else {
-      char v_banstr[100];
-
-      // clean old bans before reading them
-      m_pDb->srv_cleanBans();
-
-      v_result =
-        m_pDb->readDB("SELECT id, id_profile, ip, from_date, ROUND(nb_days - "
-                      "(julianday('now')-julianday(from_date)), 1) remaining, "
-                      "id_admin_banner "
-                      "FROM srv_bans "
-                      "ORDER BY id;",
-                      nrow);
-
-      v_answer += "+----+-----------------+----------------+-------------------"
-                  "+----------------+-----------------+\n";
-      v_answer += "|  id|login            |ip              | ban date          "
-                  "| remaining days | banner          |\n";
-      v_answer += "+----+-----------------+----------------+-------------------"
-                  "+----------------+-----------------+\n";
-
-      for (unsigned int i = 0; i < nrow; i++) {
-        snprintf(v_banstr,
-                 100,
-                 "%5s %-17s %-16s %19s %16s %17s",
-                 std::string(m_pDb->getResult(v_result, 6, i, 0)).c_str(),
-                 std::string(m_pDb->getResult(v_result, 6, i, 1)).c_str(),
-                 std::string(m_pDb->getResult(v_result, 6, i, 2)).c_str(),
-                 std::string(m_pDb->getResult(v_result, 6, i, 3)).c_str(),
-                 std::string(m_pDb->getResult(v_result, 6, i, 4)).c_str(),
-                 (m_pDb->getResult(v_result, 6, i, 5) == NULL)
-                   ? "Unknown"
-                   : std::string(m_pDb->getResult(v_result, 6, i, 5)).c_str());
-        v_answer += v_banstr;
-        v_answer += "\n"; // cause 100 could not include the \n
-      }
-      m_pDb->read_DB_free(v_result);
+      v_job = new ServerCmdJob(SRVCMD_LSBANS, m_clients[i_client]->id());
     }
 
   } else if (v_args[0] == "ban") {
@@ -1935,15 +2121,16 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
     } else {
       try {
         unsigned int v_nclient = getClientById(atoi(v_args[1].c_str()));
-        m_pDb->srv_addBan(
-          v_args[2] == "profile" ? m_clients[v_nclient]->name() : "*",
-          v_args[2] == "ip" ? XMNet::getIp(m_clients[v_nclient]->tcpRemoteIP())
-                            : "*",
-          v_args.size() == 4 ? atoi(v_args[3].c_str())
-                             : XM_SERVER_DEFAULT_BAN_NBDAYS,
-          m_clients[i_client]->adminLoginName());
+        v_job = new ServerCmdJob(SRVCMD_BAN, m_clients[i_client]->id());
+        v_job->setProfile(
+          v_args[2] == "profile" ? m_clients[v_nclient]->name() : "*");
+        v_job->setIp(v_args[2] == "ip"
+                       ? XMNet::getIp(m_clients[v_nclient]->tcpRemoteIP())
+                       : "*");
+        v_job->setNbDays(v_args.size() == 4 ? atoi(v_args[3].c_str())
+                                            : XM_SERVER_DEFAULT_BAN_NBDAYS);
+        v_job->setAdminBanner(m_clients[i_client]->adminLoginName());
         m_clientMarkToBeRemoved.push_back(atoi(v_args[1].c_str()));
-        v_answer += "ban added\n";
       } catch (Exception &e) {
         v_answer += "unable to add the ban\n";
         v_answer += e.getMsg() + "\n";
@@ -1954,8 +2141,8 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
     if (v_args.size() != 2) {
       v_answer += "unban: invalid arguments\n";
     } else {
-      m_pDb->srv_removeBan(atoi(v_args[1].c_str()));
-      v_answer += "ban removed\n";
+      v_job = new ServerCmdJob(SRVCMD_UNBAN, m_clients[i_client]->id());
+      v_job->setId(atoi(v_args[1].c_str()));
     }
 
   } else if (v_args[0] == "reloadrules") {
@@ -2114,15 +2301,37 @@ void ServerThread::manageSrvCmd(unsigned int i_client,
                "\"\nType help to get more information\n";
   }
 
-  // send the answer
-  NA_srvCmdAsw na(v_answer);
+  // the answer is sent once the database thread executed the command
+  if (v_job != NULL) {
+    m_dbThread->pushJob(v_job);
+    if (v_args[0] == "lsbans" || v_args[0] == "ban" || v_args[0] == "unban") {
+      m_dbThread->pushJob(new ServerBansJob(false));
+    }
+    return;
+  }
+
+  sendSrvCmdAnswer(m_clients[i_client]->id(), v_answer);
+}
+
+void ServerThread::sendSrvCmdAnswer(unsigned int i_clientId,
+                                    const std::string &i_answer) {
+  unsigned int v_client;
+
+  try {
+    v_client = getClientById(i_clientId);
+  } catch (Exception &e) {
+    /* the client left */
+    return;
+  }
+
+  NA_srvCmdAsw na(i_answer);
   try {
-    sendToClient(&na, i_client, -1, 0);
+    sendToClient(&na, v_client, -1, 0);
   } catch (Exception &e) {
     /* ok, no pb retry with the error */
     try {
       NA_srvCmdAsw na("An error occurred: " + e.getMsg());
-      sendToClient(&na, i_client, -1, 0);
+      sendToClient(&na, v_client, -1, 0);
     } catch (Exception &e2) {
       /* ok, no pb */
     }
@@ -26,6 +26,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "../../xmscene/Scene.h"
 #include "../BasicStructures.h"
 #include "../NetActions.h"
+#include "ServerDbThread.h"
 #include <vector>
 
 class ActionReader;
@@ -41,6 +42,18 @@ enum ServerP2Phase {
   SP2_PHASE_PLAYING
 };
 
+/* frames of a bike sent to a client, kept to encode the next ones against the
+ * last one acknowledged by the client */
+struct NetFrameStream {
+  int src;
+  int subsrc;
+  unsigned short nextSeq;
+  int ackedSeq; // -1 if no frame has been acknowledged
+  SerializedBikeState states[XM_NET_FRAMES_HISTORY];
+  unsigned short seqs[XM_NET_FRAMES_HISTORY];
+  bool valids[XM_NET_FRAMES_HISTORY];
+};
+
 class NetSClient {
 public:
   NetSClient(unsigned int i_id,
@@ -102,6 +115,11 @@ public:
 
   NetPing *lastPing();
 
+  // frames sent to this client (created if not existing)
+  NetFrameStream *frameStream(int i_src, int i_subsrc);
+  NetFrameStream *getFrameStream(int i_src, int i_subsrc); // NULL if not found
+  void removeFrameStreams(int i_src);
+
 private:
   unsigned int m_id; // uniq id of the client
   NetClientMode m_mode; // playing mode (simple ghost or slave)
@@ -128,6 +146,14 @@ private:
   // this is your name at the moment you login
   int m_lastGhostFrameTime;
   NetPing m_lastPing;
+  std::vector<NetFrameStream *> m_frameStreams;
+};
+
+/* time spent by the server to update the scenes (ms) */
+struct ServerTicksStats {
+  unsigned int nbTicks;
+  double totalTime;
+  double maxTime;
 };
 
 class ServerThread : public XMThread {
@@ -150,6 +176,15 @@ public:
   ServerRules *getRules();
   void sendPointsToSlavePlayers();
 
+  // can be called from an other thread
+  ServerTicksStats getTicksStats(bool i_reset);
+
+  // called back by the database jobs
+  void setLevelsSnapshot(const std::vector<std::string> &i_levels);
+  void setBansSnapshot(const std::vector<ServerBan> &i_bans);
+  void dbSnapshotsJobDone();
+  void sendSrvCmdAnswer(unsigned int i_clientId, const std::string &i_answer);
+
 private:
   TCPsocket m_tcpsd;
   UDPsocket m_udpsd;
@@ -180,11 +215,26 @@ private:
 
   SDLNet_SocketSet m_set;
   std::vector<NetSClient *> m_clients;
+  ServerTicksStats m_ticksStats;
+  SDL_mutex *m_ticksStatsMutex;
   ServerRules *m_rules;
   bool m_needToReloadRules; // rules are reloaded only when out of a round, not
   // immediatly when requested
   XMServerSceneHooks *m_sceneHook;
 
+  // levels and bans are read from snapshots, refreshed by the database
+  // thread between the rounds
+  ServerDbThread *m_dbThread;
+  std::vector<std::string> m_levelsSnapshot;
+  std::vector<ServerBan> m_bansSnapshot;
+  unsigned int m_nbDbSnapshotsJobs; // queued and not done yet
+  int m_lastDbSnapshotsRefresh;
+  void refreshDbSnapshots();
+  // slave clients are waiting, but there is no level to play
+  bool isWaitingForLevels();
+  bool isBanned(const std::string &i_profile, const std::string &i_ip) const;
+  int networkWaitTimeout(); // -1 if no database job is waiting
+
   void acceptClient();
   bool manageClientTCP(unsigned int i);
   void manageClientUDP();
@@ -232,6 +282,11 @@ private:
                     int i_src,
                     int i_subsrc,
                     bool i_forceUdp = false);
+  // send the frame as a delta to the clients supporting it
+  void sendFrameToClient(SerializedBikeState *i_state,
+                         unsigned int i,
+                         int i_src,
+                         int i_subsrc);
   void sendMsgToClient(unsigned int i_client, const std::string &i_msg);
   void removeClient(unsigned int i);
   unsigned int nbClientsInMode(NetClientMode i_mode);
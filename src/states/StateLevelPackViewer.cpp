@@ -371,8 +371,8 @@ void StateLevelPackViewer::updateLevelsList() {
   UILevelList *pList =
     reinterpret_cast<UILevelList *>(m_GUI->getChild("FRAME:LEVEL_LIST"));
   int v_selected = pList->getSelected();
-  char **v_result;
-  unsigned int nrow;
+  std::vector<const LevelsCatalogEntry *> v_levels;
+  std::vector<std::string> v_names;
   int v_totalProfileTime = 0;
   int v_totalHighscoreTime = 0;
 
@@ -406,27 +406,26 @@ void StateLevelPackViewer::updateLevelsList() {
     pList->hideRoomBestTime();
   }
 
-  v_result = pDb->readDB(
-    m_pActiveLevelPack->getLevelsWithHighscoresQuery(
-      XMSession::instance()->profile(), XMSession::instance()->idRoom(0)),
-    nrow);
-  for (unsigned int i = 0; i < nrow; i++) {
-    if (pDb->getResult(v_result, 4, i, 2) == NULL) {
-      v_playerHighscore = -1;
-    } else {
-      v_playerHighscore = atoi(pDb->getResult(v_result, 4, i, 2));
+  LevelsManager::instance()->getLevelsOfPack(m_pActiveLevelPack,
+                                             XMSession::instance()->profile(),
+                                             XMSession::instance()->idRoom(0),
+                                             pDb,
+                                             v_levels,
+                                             v_names);
+  for (unsigned int i = 0; i < v_levels.size(); i++) {
+    v_playerHighscore = v_levels[i]->playerHighscore;
+    if (v_playerHighscore != -1) {
       v_totalProfileTime += v_playerHighscore;
     }
 
-    if (pDb->getResult(v_result, 4, i, 3) == NULL) {
-      v_roomHighscore = -1;
+    v_roomHighscore = v_levels[i]->roomHighscore;
+    if (v_roomHighscore == -1) {
       if (v_playerHighscore > 0) {
         v_totalHighscoreTime +=
           v_playerHighscore; // add player time in case he has a better score
         // than room, to not have to update www
       }
     } else {
-      v_roomHighscore = atoi(pDb->getResult(v_result, 4, i, 3));
       if (v_playerHighscore > 0 && v_playerHighscore < v_roomHighscore) {
         v_totalHighscoreTime +=
           v_playerHighscore; // add player time in case he has a better score
@@ -439,12 +438,9 @@ void StateLevelPackViewer::updateLevelsList() {
       }
     }
 
-    pList->addLevel(pDb->getResult(v_result, 4, i, 0),
-                    pDb->getResult(v_result, 4, i, 1),
-                    v_playerHighscore,
-                    v_roomHighscore);
+    pList->addLevel(
+      v_levels[i]->id, v_names[i], v_playerHighscore, v_roomHighscore);
   }
-  pDb->read_DB_free(v_result);
 
   /* reselect the previous level */
   if (v_selected_levelName != "") {
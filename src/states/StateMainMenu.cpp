@@ -1778,18 +1778,58 @@ UILevelList *StateMainMenu::buildQuickStartList() {
   v_list->showWindow(false);
   v_list->setCanGetFocus(false);
 
-  createLevelListsSql(
-    v_list,
-    LevelsManager::getQuickStartPackQuery(v_quickStart->getQualityMIN(),
-                                          v_quickStart->getDifficultyMIN(),
-                                          v_quickStart->getQualityMAX(),
-                                          v_quickStart->getDifficultyMAX(),
-                                          XMSession::instance()->profile(),
-                                          XMSession::instance()->idRoom(0),
-                                          xmDatabase::instance("main")));
+  if (LevelsManager::isQuickStartForTutorials(
+        XMSession::instance()->profile(), xmDatabase::instance("main"))) {
+    createLevelListsSql(v_list,
+                        LevelsManager::getQuickStartTutorialsQuery(
+                          XMSession::instance()->profile(),
+                          XMSession::instance()->idRoom(0)));
+  } else {
+    std::vector<const LevelsCatalogEntry *> v_levels;
+
+    LevelsManager::instance()->getQuickStartLevels(
+      v_quickStart->getQualityMIN(),
+      v_quickStart->getDifficultyMIN(),
+      v_quickStart->getQualityMAX(),
+      v_quickStart->getDifficultyMAX(),
+      XMSession::instance()->profile(),
+      XMSession::instance()->idRoom(0),
+      xmDatabase::instance("main"),
+      v_levels);
+    createLevelListsCatalog(v_list, v_levels);
+  }
   return v_list;
 }
 
+void StateMainMenu::createLevelListsCatalog(
+  UILevelList *io_levelsList,
+  const std::vector<const LevelsCatalogEntry *> &i_levels,
+  const std::vector<std::string> *i_names) {
+  std::string v_selected_levelName = "";
+  int v_selected;
+
+  /* get selected item */
+  if ((io_levelsList->getSelected() >= 0) &&
+      (io_levelsList->getSelected() < io_levelsList->getEntries().size())) {
+    UIListEntry *pEntry =
+      io_levelsList->getEntries()[io_levelsList->getSelected()];
+    v_selected_levelName = pEntry->Text[0];
+  }
+  v_selected = io_levelsList->getSelected();
+
+  io_levelsList->clear();
+
+  for (unsigned int i = 0; i < i_levels.size(); i++) {
+    io_levelsList->addLevel(i_levels[i]->id,
+                            i_names != NULL ? (*i_names)[i]
+                                            : i_levels[i]->name,
+                            i_levels[i]->playerHighscore,
+                            i_levels[i]->roomHighscore);
+  }
+
+  reselectLevel(io_levelsList, v_selected_levelName, v_selected);
+}
+
 void StateMainMenu::createLevelListsSql(UILevelList *io_levelsList,
                                         const std::string &i_sql) {
   char **v_result;
@@ -1833,19 +1873,25 @@ void StateMainMenu::createLevelListsSql(UILevelList *io_levelsList,
   }
   xmDatabase::instance("main")->read_DB_free(v_result);
 
+  reselectLevel(io_levelsList, v_selected_levelName, v_selected);
+}
+
+void StateMainMenu::reselectLevel(UILevelList *io_levelsList,
+                                  const std::string &i_levelName,
+                                  int i_selected) {
   /* reselect the previous level */
-  if (v_selected_levelName != "") {
+  if (i_levelName != "") {
     int nLevel = 0;
     bool v_found = false;
     for (unsigned int i = 0; i < io_levelsList->getEntries().size(); i++) {
-      if (io_levelsList->getEntries()[i]->Text[0] == v_selected_levelName) {
+      if (io_levelsList->getEntries()[i]->Text[0] == i_levelName) {
         nLevel = i;
         v_found = true;
         break;
       }
     }
     if (v_found == false) {
-      nLevel = v_selected;
+      nLevel = i_selected;
     }
     io_levelsList->setRealSelected(nLevel);
   }
@@ -2064,14 +2110,21 @@ void StateMainMenu::updateLevelsLists() {
 
 void StateMainMenu::createLevelLists(UILevelList *i_list,
                                      const std::string &i_packageName) {
+  std::vector<const LevelsCatalogEntry *> v_levels;
+  std::vector<std::string> v_names;
+
   LevelsManager::instance()->lockLevelsPacks();
   LevelsPack *v_levelsPack =
     &(LevelsManager::instance()->LevelsPackByName(i_packageName));
   try {
-    createLevelListsSql(
-      i_list,
-      v_levelsPack->getLevelsWithHighscoresQuery(
-        XMSession::instance()->profile(), XMSession::instance()->idRoom(0)));
+    LevelsManager::instance()->getLevelsOfPack(
+      v_levelsPack,
+      XMSession::instance()->profile(),
+      XMSession::instance()->idRoom(0),
+      xmDatabase::instance("main"),
+      v_levels,
+      v_names);
+    createLevelListsCatalog(i_list, v_levels, &v_names);
     LevelsManager::instance()->unlockLevelsPacks();
   } catch (Exception &e) {
     LevelsManager::instance()->unlockLevelsPacks();
@@ -23,10 +23,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "StateManager.h"
 #include "StateMenu.h"
+#include <vector>
 
 class Texture;
 class UILevelList;
 class LevelsPacksCountUpdateThread;
+struct LevelsCatalogEntry;
 class CheckWwwThread;
 
 class StateMainMenu : public StateMenu {
@@ -87,6 +89,14 @@ private:
   UILevelList *buildQuickStartList();
   void createLevelListsSql(UILevelList *io_levelsList,
                            const std::string &i_sql);
+  /* i_names are the names of the levels in their pack, if not NULL */
+  void createLevelListsCatalog(
+    UILevelList *io_levelsList,
+    const std::vector<const LevelsCatalogEntry *> &i_levels,
+    const std::vector<std::string> *i_names = NULL);
+  void reselectLevel(UILevelList *io_levelsList,
+                     const std::string &i_levelName,
+                     int i_selected);
   void createLevelLists(UILevelList *i_list, const std::string &i_packageName);
   void updateLevelsPackInPackList(const std::string &v_levelPack);
 
@@ -37,10 +37,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "StateVote.h"
 #include "net/NetClient.h"
 
+#include "common/Theme.h"
 #include "common/XMSession.h"
 #include "drawlib/DrawLib.h"
 #include "helpers/Log.h"
 #include "thread/DownloadReplaysThread.h"
+#include "thread/PreloadLevelThread.h"
 #include "thread/XMThreadStats.h"
 #include "xmoto/Game.h"
 #include "xmoto/GameText.h"
@@ -105,6 +107,8 @@ StateManager::StateManager() {
   // create the replay downloader thread
   m_drt = new DownloadReplaysThread(this);
 
+  m_plt = NULL;
+
   // mouse
   m_isCursorVisible = false;
   SDL_ShowCursor(SDL_DISABLE);
@@ -140,6 +144,9 @@ StateManager::~StateManager() {
     delete m_drt;
   }
 
+  /* preloaded level */
+  deletePreloadLevelThread();
+
   deleteToDeleteState();
 
   if (m_videoRecorder != NULL) {
@@ -1140,6 +1147,57 @@ DownloadReplaysThread *StateManager::getReplayDownloaderThread() {
   return m_drt;
 }
 
+void StateManager::preloadLevel(const std::string &i_id_level) {
+  if (m_plt != NULL) {
+    if (m_plt->idLevel() == i_id_level) {
+      return; // already done or in progress
+    }
+
+    // don't wait for a previous preloading
+    if (m_plt->isThreadRunning()) {
+      return;
+    }
+  }
+
+  deletePreloadLevelThread();
+  m_plt = new PreloadLevelThread(i_id_level);
+  m_plt->startThread();
+}
+
+Level *StateManager::takePreloadedLevel(const std::string &i_id_level) {
+  Level *v_level;
+
+  if (m_plt == NULL || m_plt->idLevel() != i_id_level) {
+    return NULL;
+  }
+
+  // the end is near, and loading the level again would take longer
+  if (m_plt->waitForThreadEnd() != 0) {
+    deletePreloadLevelThread();
+    return NULL;
+  }
+
+  v_level = m_plt->takeLevel();
+  deletePreloadLevelThread();
+
+  // not done by the thread, the theme could have been changed meanwhile
+  if (v_level != NULL) {
+    v_level->loadSprites();
+  }
+  return v_level;
+}
+
+void StateManager::deletePreloadLevelThread() {
+  if (m_plt == NULL) {
+    return;
+  }
+
+  // be sure the thread is finished
+  m_plt->waitForThreadEnd();
+  delete m_plt;
+  m_plt = NULL;
+}
+
 void StateManager::setCursorVisible(bool visible) {
   if (m_isCursorVisible == visible)
     return;
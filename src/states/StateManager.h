@@ -36,6 +36,8 @@ class Texture;
 class RenderSurface;
 class XMThreadStats;
 class DownloadReplaysThread;
+class Level;
+class PreloadLevelThread;
 
 class StateManager : public Singleton<StateManager> {
   friend class Singleton<StateManager>;
@@ -111,6 +113,12 @@ public:
 
   DownloadReplaysThread *getReplayDownloaderThread();
 
+  // load in the background the level which will probably be played next
+  void preloadLevel(const std::string &i_id_level);
+  // NULL if the level has not been preloaded ; else, the caller becomes the
+  // owner of the level
+  Level *takePreloadedLevel(const std::string &i_id_level);
+
   void setCursorVisible(bool visible);
 
   void connectOrDisconnect();
@@ -185,6 +193,10 @@ private:
   // replays downloader
   DownloadReplaysThread *m_drt;
 
+  // next level preloader
+  PreloadLevelThread *m_plt;
+  void deletePreloadLevelThread();
+
   int m_currentUniqueId;
 
   RenderSurface m_screen;
@@ -100,9 +100,18 @@ void StatePreplaying::enter() {
   }
 
   try {
+    // the level may have been loaded while the previous one was played
+    Level *v_preloadedLevel =
+      StateManager::instance()->takePreloadedLevel(m_idlevel);
+
     for (unsigned int i = 0; i < m_universe->getScenes().size(); i++) {
-      m_universe->getScenes()[i]->loadLevel(xmDatabase::instance("main"),
-                                            m_idlevel);
+      if (v_preloadedLevel != NULL) {
+        m_universe->getScenes()[i]->loadLevel(v_preloadedLevel);
+        v_preloadedLevel = NULL;
+      } else {
+        m_universe->getScenes()[i]->loadLevel(xmDatabase::instance("main"),
+                                              m_idlevel);
+      }
     }
   } catch (Exception &e) {
     LogWarning("level '%s' cannot be loaded", m_idlevel.c_str());
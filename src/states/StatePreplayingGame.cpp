@@ -104,6 +104,13 @@ void StatePreplayingGame::initPlayers() {
 }
 
 void StatePreplayingGame::runPlaying() {
+  std::string v_nextLevel = GameApp::instance()->determineNextLevel(m_idlevel);
+
+  // get the next level ready while this one is played
+  if (v_nextLevel != "" && v_nextLevel != m_idlevel) {
+    StateManager::instance()->preloadLevel(v_nextLevel);
+  }
+
   StateManager::instance()->replaceState(
     new StatePlayingLocal(m_universe, m_renderer), getStateId());
 }
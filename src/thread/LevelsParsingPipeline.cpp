@@ -0,0 +1,164 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "LevelsParsingPipeline.h"
+#include "WorkersPool.h"
+#include "helpers/Log.h"
+#include "helpers/VExcept.h"
+#include "include/xm_SDL.h"
+#include "xmscene/Level.h"
+
+// parsed levels waiting for the caller, per worker
+#define LEVELSPARSINGPIPELINE_WINDOW_PER_WORKER 4
+
+LevelsParsingPipeline::LevelsParsingPipeline(
+  const std::vector<std::string> &i_files,
+  bool i_loadMainLayerOnly,
+  unsigned int i_nbWorkers) {
+  SDL_Thread *v_thread;
+
+  m_files = i_files;
+  m_loadMainLayerOnly = i_loadMainLayerOnly;
+  m_levels.resize(m_files.size(), NULL);
+  m_errors.resize(m_files.size());
+  m_parsed.resize(m_files.size(), false);
+  m_nextFile = 0;
+  m_nextTaken = 0;
+  m_askToEnd = false;
+
+  if (i_nbWorkers == 0) {
+    i_nbWorkers = WorkersPool::defaultNbWorkers();
+  }
+  if (i_nbWorkers > m_files.size()) {
+    i_nbWorkers = m_files.size();
+  }
+  m_window = i_nbWorkers * LEVELSPARSINGPIPELINE_WINDOW_PER_WORKER;
+
+  m_mutex = SDL_CreateMutex();
+  m_cond = SDL_CreateCond();
+
+  for (unsigned int i = 0; i < i_nbWorkers; i++) {
+    v_thread =
+      SDL_CreateThread(&LevelsParsingPipeline::workerFunction, NULL, this);
+    if (v_thread == NULL) {
+      LogWarning("Unable to create a level parser (%s)", SDL_GetError());
+      break;
+    }
+    m_threads.push_back(v_thread);
+  }
+}
+
+LevelsParsingPipeline::~LevelsParsingPipeline() {
+  SDL_LockMutex(m_mutex);
+  m_askToEnd = true;
+  SDL_CondBroadcast(m_cond);
+  SDL_UnlockMutex(m_mutex);
+
+  for (unsigned int i = 0; i < m_threads.size(); i++) {
+    SDL_WaitThread(m_threads[i], NULL);
+  }
+
+  // levels not taken by the caller
+  for (unsigned int i = 0; i < m_levels.size(); i++) {
+    if (m_levels[i] != NULL) {
+      delete m_levels[i];
+    }
+  }
+
+  SDL_DestroyCond(m_cond);
+  SDL_DestroyMutex(m_mutex);
+}
+
+unsigned int LevelsParsingPipeline::size() const {
+  return m_files.size();
+}
+
+Level *LevelsParsingPipeline::parseFile(unsigned int i, std::string &o_error) {
+  Level *v_level = new Level();
+
+  o_error = "";
+  try {
+    v_level->setFileName(m_files[i]);
+    v_level->loadReducedFromFile(m_loadMainLayerOnly);
+  } catch (Exception &e) {
+    o_error = e.getMsg();
+  }
+
+  return v_level;
+}
+
+int LevelsParsingPipeline::workerFunction(void *i_pipeline) {
+  ((LevelsParsingPipeline *)i_pipeline)->work();
+  return 0;
+}
+
+void LevelsParsingPipeline::work() {
+  unsigned int v_file;
+  Level *v_level;
+  std::string v_error;
+
+  while (true) {
+    SDL_LockMutex(m_mutex);
+    while (m_askToEnd == false && m_nextFile < m_files.size() &&
+           m_nextFile >= m_nextTaken + m_window) {
+      SDL_CondWait(m_cond, m_mutex);
+    }
+    if (m_askToEnd || m_nextFile >= m_files.size()) {
+      SDL_UnlockMutex(m_mutex);
+      return;
+    }
+    v_file = m_nextFile++;
+    SDL_UnlockMutex(m_mutex);
+
+    v_level = parseFile(v_file, v_error);
+
+    SDL_LockMutex(m_mutex);
+    m_levels[v_file] = v_level;
+    m_errors[v_file] = v_error;
+    m_parsed[v_file] = true;
+    SDL_CondBroadcast(m_cond);
+    SDL_UnlockMutex(m_mutex);
+  }
+}
+
+Level *LevelsParsingPipeline::takeLevel(unsigned int i, std::string &o_error) {
+  Level *v_level;
+
+  // no worker could be created
+  if (m_threads.size() == 0) {
+    return parseFile(i, o_error);
+  }
+
+  SDL_LockMutex(m_mutex);
+  while (m_parsed[i] == false) {
+    SDL_CondWait(m_cond, m_mutex);
+  }
+  v_level = m_levels[i];
+  o_error = m_errors[i];
+  m_levels[i] = NULL;
+
+  if (i + 1 > m_nextTaken) {
+    m_nextTaken = i + 1;
+    SDL_CondBroadcast(m_cond);
+  }
+  SDL_UnlockMutex(m_mutex);
+
+  return v_level;
+}
@@ -0,0 +1,74 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __LEVELSPARSINGPIPELINE_H__
+#define __LEVELSPARSINGPIPELINE_H__
+
+#include <string>
+#include <vector>
+
+class Level;
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+/*
+  parse the level files in background threads while the caller takes the
+  levels one by one, in the order of the files, to add them into the
+  database ; the database stays accessed by the caller only
+*/
+class LevelsParsingPipeline {
+public:
+  // i_nbWorkers = 0 for one worker per cpu
+  LevelsParsingPipeline(const std::vector<std::string> &i_files,
+                        bool i_loadMainLayerOnly,
+                        unsigned int i_nbWorkers = 0);
+  ~LevelsParsingPipeline();
+
+  unsigned int size() const;
+
+  // wait for the level of the file i ; the caller owns it. o_error is empty
+  // if the level has been loaded correctly. each file can be taken once.
+  Level *takeLevel(unsigned int i, std::string &o_error);
+
+  // don't use it
+  static int workerFunction(void *i_pipeline);
+
+private:
+  void work();
+  Level *parseFile(unsigned int i, std::string &o_error);
+
+  std::vector<std::string> m_files;
+  bool m_loadMainLayerOnly;
+
+  std::vector<Level *> m_levels;
+  std::vector<std::string> m_errors;
+  std::vector<bool> m_parsed;
+  unsigned int m_nextFile; // next file to parse
+  unsigned int m_nextTaken; // files before are taken by the caller
+  unsigned int m_window; // how far the workers can be ahead of the caller
+  bool m_askToEnd;
+
+  SDL_mutex *m_mutex;
+  SDL_cond *m_cond;
+  std::vector<SDL_Thread *> m_threads;
+};
+
+#endif
@@ -0,0 +1,83 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "PreloadLevelThread.h"
+#include "common/XMSession.h"
+#include "db/xmDatabase.h"
+#include "helpers/Log.h"
+#include "xmscene/Level.h"
+
+PreloadLevelThread::PreloadLevelThread(const std::string &i_id_level)
+  : XMThread("PLT", true) {
+  m_id_level = i_id_level;
+  m_level = NULL;
+}
+
+PreloadLevelThread::~PreloadLevelThread() {
+  if (m_level != NULL) {
+    delete m_level;
+  }
+}
+
+std::string PreloadLevelThread::idLevel() const {
+  return m_id_level;
+}
+
+Level *PreloadLevelThread::takeLevel() {
+  Level *v_level = m_level;
+
+  m_level = NULL;
+  return v_level;
+}
+
+int PreloadLevelThread::realThreadFunction() {
+  xmDatabaseStatement *v_stmt;
+  Level *v_level = NULL;
+
+  // same steps as Scene::loadLevel() and Scene::prePlayLevel()
+  try {
+    v_stmt = m_pDb->prepare("SELECT filepath FROM levels WHERE id_level=?1;");
+    v_stmt->bind(1, m_id_level);
+    if (v_stmt->next() == false) {
+      throw Exception("Level " + m_id_level + " not found");
+    }
+
+    v_level = new Level();
+    v_level->setFileName(v_stmt->getString(0));
+    v_stmt->reset();
+
+    v_level->loadReducedFromFile(false);
+    // the theme may be changed meanwhile : the sprites are loaded by the
+    // main thread when the level is taken
+    v_level->loadFullyFromFile(false, true, false);
+  } catch (Exception &e) {
+    LogWarning("Unable to preload the level %s (%s)",
+               m_id_level.c_str(),
+               e.getMsg().c_str());
+    if (v_level != NULL) {
+      delete v_level;
+    }
+    return 1;
+  }
+
+  LogDebug("Level %s preloaded", m_id_level.c_str());
+  m_level = v_level;
+  return 0;
+}
@@ -0,0 +1,50 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __PRELOADLEVELTHREAD_H__
+#define __PRELOADLEVELTHREAD_H__
+
+#include "XMThread.h"
+
+class Level;
+
+/*
+  load the level which will probably be played next while the current one is
+  played : the cache, the bsp and the cache update are done in this thread
+*/
+class PreloadLevelThread : public XMThread {
+public:
+  PreloadLevelThread(const std::string &i_id_level);
+  virtual ~PreloadLevelThread();
+
+  virtual int realThreadFunction();
+
+  std::string idLevel() const;
+
+  // once the thread is finished ; NULL if the level cannot be loaded, else,
+  // the caller becomes the owner of the level
+  Level *takeLevel();
+
+private:
+  std::string m_id_level;
+  Level *m_level;
+};
+
+#endif
@@ -23,7 +23,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "common/WWW.h"
 #include "common/XMSession.h"
 #include "db/xmDatabase.h"
-#include "helpers/FileCompression.h"
 #include "helpers/Log.h"
 #include "helpers/VExcept.h"
 #include "states/StateManager.h"
@@ -53,16 +52,13 @@ int SyncThread::realThreadFunction() {
   v_syncDownFile =
     XMFS::getUserDir(FDT_CACHE) + "/" + DEFAULT_DBSYNCUPLOAD_MSGFILE;
 
-  /* create the .xml sync file */
+  /* create the compressed .xml sync file */
   try {
     /* first, remove in case of windows */
-    remove(std::string(SYNC_UP_TMPFILE).c_str());
     remove(std::string(SYNC_UP_TMPFILEBZ2).c_str());
-    m_pDb->sync_buildServerFile(SYNC_UP_TMPFILE,
+    m_pDb->sync_buildServerFile(SYNC_UP_TMPFILEBZ2,
                                 XMSession::instance()->sitekey(),
                                 XMSession::instance()->profile());
-    FileCompression::bzip2(SYNC_UP_TMPFILE, SYNC_UP_TMPFILEBZ2);
-    remove(std::string(SYNC_UP_TMPFILE).c_str());
   } catch (Exception &e) {
     LogWarning("%s", e.getMsg().c_str());
     remove(std::string(SYNC_UP_TMPFILEBZ2).c_str());
@@ -208,6 +208,20 @@ int UpgradeLevelsThread::realThreadFunction() {
       this,
       m_pDb);
 
+    /* build the cache now rather than at the first play of each level */
+    if (m_loadMainLayerOnly == false) {
+      std::vector<std::string> v_files = m_pWebLevels->getNewDownloadedLevels();
+      LevelsCacheSummary v_summary;
+
+      v_files.insert(v_files.end(),
+                     m_pWebLevels->getUpdatedDownloadedLevels().begin(),
+                     m_pWebLevels->getUpdatedDownloadedLevels().end());
+      LevelsManager::rebuildCache(m_pDb, v_files, v_summary);
+      LogInfo("Cache of the new levels: %u rebuilt, %u failed",
+              v_summary.nbRebuilt,
+              v_summary.nbFailed);
+    }
+
     /* Update level lists */
     if (StateManager::exists()) {
       StateManager::instance()->sendAsynchronousMessage(
@@ -0,0 +1,116 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "WorkersPool.h"
+#include "helpers/Log.h"
+#include "helpers/VExcept.h"
+#include "include/xm_SDL.h"
+#include <vector>
+
+#define WORKERSPOOL_MAX_WORKERS 16
+
+// set in the threads running the items, to not multiply the threads
+static thread_local bool s_isWorker = false;
+
+struct WorkersPoolRun {
+  WorkersPool::WorkFunction function;
+  void *data;
+  unsigned int nbItems;
+  unsigned int nextItem;
+  SDL_mutex *mutex;
+};
+
+unsigned int WorkersPool::defaultNbWorkers() {
+  int v_nb = SDL_GetCPUCount();
+
+  if (v_nb < 1) {
+    return 1;
+  }
+  if (v_nb > WORKERSPOOL_MAX_WORKERS) {
+    return WORKERSPOOL_MAX_WORKERS;
+  }
+  return (unsigned int)v_nb;
+}
+
+int WorkersPool::workerFunction(void *i_run) {
+  WorkersPoolRun *v_run = (WorkersPoolRun *)i_run;
+  unsigned int v_item;
+  bool v_wasWorker = s_isWorker;
+
+  s_isWorker = true;
+  while (true) {
+    SDL_LockMutex(v_run->mutex);
+    v_item = v_run->nextItem++;
+    SDL_UnlockMutex(v_run->mutex);
+
+    if (v_item >= v_run->nbItems) {
+      s_isWorker = v_wasWorker;
+      return 0;
+    }
+
+    // an exception must not leave the thread
+    try {
+      v_run->function(v_run->data, v_item);
+    } catch (Exception &e) {
+      LogWarning("Worker failed on item %u (%s)", v_item, e.getMsg().c_str());
+    }
+  }
+}
+
+void WorkersPool::run(WorkFunction i_function,
+                      void *i_data,
+                      unsigned int i_nbItems,
+                      unsigned int i_nbWorkers) {
+  WorkersPoolRun v_run;
+  std::vector<SDL_Thread *> v_threads;
+  SDL_Thread *v_thread;
+
+  if (i_nbWorkers == 0) {
+    i_nbWorkers = defaultNbWorkers();
+  }
+  if (s_isWorker) {
+    i_nbWorkers = 1;
+  }
+  if (i_nbWorkers > i_nbItems) {
+    i_nbWorkers = i_nbItems;
+  }
+
+  v_run.function = i_function;
+  v_run.data = i_data;
+  v_run.nbItems = i_nbItems;
+  v_run.nextItem = 0;
+  v_run.mutex = SDL_CreateMutex();
+
+  // the calling thread is a worker too
+  for (unsigned int i = 1; i < i_nbWorkers; i++) {
+    v_thread = SDL_CreateThread(&WorkersPool::workerFunction, NULL, &v_run);
+    if (v_thread == NULL) {
+      LogWarning("Unable to create a worker (%s)", SDL_GetError());
+      break;
+    }
+    v_threads.push_back(v_thread);
+  }
+  workerFunction(&v_run);
+
+  for (unsigned int i = 0; i < v_threads.size(); i++) {
+    SDL_WaitThread(v_threads[i], NULL);
+  }
+  SDL_DestroyMutex(v_run.mutex);
+}
@@ -0,0 +1,45 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __WORKERSPOOL_H__
+#define __WORKERSPOOL_H__
+
+/*
+  run a function on a list of items, using several threads ; the items are
+  taken one by one by the first available worker, so the function must not
+  rely on the order. run() returns once all the items are processed ; called
+  from a worker, it runs the items in this worker.
+*/
+class WorkersPool {
+public:
+  typedef void (*WorkFunction)(void *i_data, unsigned int i_item);
+
+  // i_nbWorkers = 0 for one worker per cpu
+  static void run(WorkFunction i_function,
+                  void *i_data,
+                  unsigned int i_nbItems,
+                  unsigned int i_nbWorkers = 0);
+  static unsigned int defaultNbWorkers();
+
+  // don't use it
+  static int workerFunction(void *i_run);
+};
+
+#endif
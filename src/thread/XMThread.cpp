@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "XMThread.h"
 #include "common/VCommon.h"
 #include "common/VFileIO.h"
+#include "db/xmDatabasePool.h"
 #include "helpers/Log.h"
 #include "xmoto/Game.h"
 
@@ -191,11 +192,19 @@ void XMThread::setThreadCurrentMicroOperation(std::string curMicOp) {
 
 int XMThread::threadFunctionEncapsulate() {
   // we can only have one thread at once.
-  LogDebug("Open db for thread with key '%s'", m_dbKey.c_str());
-  m_pDb = xmDatabase::instance(m_dbKey);
-  m_pDb->init(DATABASE_FILE, m_dbReadOnly);
+  if (m_dbReadOnly) {
+    m_pDb = xmDatabasePool::instance()->acquireReader();
+  } else {
+    LogDebug("Open db for thread with key '%s'", m_dbKey.c_str());
+    m_pDb = xmDatabase::instance(m_dbKey);
+    m_pDb->init(DATABASE_FILE);
+  }
 
   int returnValue = realThreadFunction();
+  if (m_dbReadOnly) {
+    xmDatabasePool::instance()->releaseReader(m_pDb);
+    m_pDb = NULL;
+  }
   m_isRunning = false;
 
   return returnValue;
@@ -89,7 +89,8 @@ protected:
 
   std::string m_wakeUpInfos;
 
-  // different thread, different database connection
+  // different thread, different database connection ; the read-only threads
+  // share the readers of the pool
   xmDatabase *m_pDb;
 
 private:
@@ -39,56 +39,72 @@ XMThreadStats::~XMThreadStats() {
 void XMThreadStats::delay_levelCompleted(const std::string &PlayerName,
                                          const std::string &LevelID,
                                          int i_playTime) {
-  xmstats_event xe;
-
-  xe.playerName = PlayerName;
-  xe.levelId = LevelID;
-  xe.playTime = i_playTime;
-
-  SDL_LockMutex(m_eventsMutex);
-  m_events_levelCompleted.push_back(xe);
-  SDL_UnlockMutex(m_eventsMutex);
+  xmDatabaseLevelPlays v_plays;
+
+  v_plays.nbPlayed = 1;
+  v_plays.nbDied = 0;
+  v_plays.nbCompleted = 1;
+  v_plays.nbRestarted = 0;
+  v_plays.playedTime = i_playTime;
+  addPlays(PlayerName, LevelID, v_plays);
 }
 
 void XMThreadStats::delay_died(const std::string &PlayerName,
                                const std::string &LevelID,
                                int i_playTime) {
-  xmstats_event xe;
-
-  xe.playerName = PlayerName;
-  xe.levelId = LevelID;
-  xe.playTime = i_playTime;
-
-  SDL_LockMutex(m_eventsMutex);
-  m_events_died.push_back(xe);
-  SDL_UnlockMutex(m_eventsMutex);
+  xmDatabaseLevelPlays v_plays;
+
+  v_plays.nbPlayed = 1;
+  v_plays.nbDied = 1;
+  v_plays.nbCompleted = 0;
+  v_plays.nbRestarted = 0;
+  v_plays.playedTime = i_playTime;
+  addPlays(PlayerName, LevelID, v_plays);
 }
 
 void XMThreadStats::delay_abortedLevel(const std::string &PlayerName,
                                        const std::string &LevelID,
                                        int i_playTime) {
-  xmstats_event xe;
-
-  xe.playerName = PlayerName;
-  xe.levelId = LevelID;
-  xe.playTime = i_playTime;
-
-  SDL_LockMutex(m_eventsMutex);
-  m_events_abortedLevel.push_back(xe);
-  SDL_UnlockMutex(m_eventsMutex);
+  xmDatabaseLevelPlays v_plays;
+
+  v_plays.nbPlayed = 1;
+  v_plays.nbDied = 0;
+  v_plays.nbCompleted = 0;
+  v_plays.nbRestarted = 0;
+  v_plays.playedTime = i_playTime;
+  addPlays(PlayerName, LevelID, v_plays);
 }
 
 void XMThreadStats::delay_levelRestarted(const std::string &PlayerName,
                                          const std::string &LevelID,
                                          int i_playTime) {
-  xmstats_event xe;
+  xmDatabaseLevelPlays v_plays;
+
+  v_plays.nbPlayed = 1;
+  v_plays.nbDied = 0;
+  v_plays.nbCompleted = 0;
+  v_plays.nbRestarted = 1;
+  v_plays.playedTime = i_playTime;
+  addPlays(PlayerName, LevelID, v_plays);
+}
 
-  xe.playerName = PlayerName;
-  xe.levelId = LevelID;
-  xe.playTime = i_playTime;
+void XMThreadStats::addPlays(const std::string &PlayerName,
+                             const std::string &LevelID,
+                             const xmDatabaseLevelPlays &i_plays) {
+  std::pair<std::string, std::string> v_key(PlayerName, LevelID);
+  xmDatabaseLevelsPlays::iterator v_it;
 
   SDL_LockMutex(m_eventsMutex);
-  m_events_levelRestarted.push_back(xe);
+  v_it = m_plays.find(v_key);
+  if (v_it == m_plays.end()) {
+    m_plays[v_key] = i_plays;
+  } else {
+    v_it->second.nbPlayed += i_plays.nbPlayed;
+    v_it->second.nbDied += i_plays.nbDied;
+    v_it->second.nbCompleted += i_plays.nbCompleted;
+    v_it->second.nbRestarted += i_plays.nbRestarted;
+    v_it->second.playedTime += i_plays.playedTime;
+  }
   SDL_UnlockMutex(m_eventsMutex);
 }
 
@@ -103,42 +119,30 @@ int XMThreadStats::realThreadFunction() {
 }
 
 void XMThreadStats::play() {
-  xmstats_event xe;
+  xmDatabaseLevelsPlays v_plays;
 
+  // the game can add new events while these ones are written
   SDL_LockMutex(m_eventsMutex);
+  v_plays.swap(m_plays);
+  SDL_UnlockMutex(m_eventsMutex);
 
-  try {
-    while (m_events_levelCompleted.size() > 0) {
-      xe = m_events_levelCompleted[0];
-      m_pDb->stats_levelCompleted(
-        m_sitekey, xe.playerName, xe.levelId, xe.playTime);
-      m_events_levelCompleted.erase(m_events_levelCompleted.begin());
-    }
-
-    while (m_events_died.size() > 0) {
-      xe = m_events_died[0];
-      m_pDb->stats_died(m_sitekey, xe.playerName, xe.levelId, xe.playTime);
-      m_events_died.erase(m_events_died.begin());
-    }
-
-    while (m_events_abortedLevel.size() > 0) {
-      xe = m_events_abortedLevel[0];
-      m_pDb->stats_abortedLevel(
-        m_sitekey, xe.playerName, xe.levelId, xe.playTime);
-      m_events_abortedLevel.erase(m_events_abortedLevel.begin());
-    }
+  if (v_plays.empty()) {
+    return;
+  }
 
-    while (m_events_levelRestarted.size() > 0) {
-      xe = m_events_levelRestarted[0];
-      m_pDb->stats_levelRestarted(
-        m_sitekey, xe.playerName, xe.levelId, xe.playTime);
-      m_events_levelRestarted.erase(m_events_levelRestarted.begin());
-    }
+  try {
+    m_pDb->stats_levelsPlayed(m_sitekey, v_plays);
   } catch (Exception &e) {
     LogError("Unable to update statistics");
-  }
 
-  SDL_UnlockMutex(m_eventsMutex);
+    // nothing has been written, try again next time
+    for (xmDatabaseLevelsPlays::const_iterator it = v_plays.begin();
+         it != v_plays.end();
+         ++it) {
+      addPlays(it->first.first, it->first.second, it->second);
+    }
+    return;
+  }
 
   m_manager->sendAsynchronousMessage(std::string("STATS_UPDATED"));
 }
@@ -25,18 +25,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define __XMTHREADSTATS_H__
 
 #include "XMThread.h"
-#include <vector>
+#include "db/xmDatabase.h"
 
 class StateManager;
 
 struct SDL_mutex;
 
-struct xmstats_event {
-  std::string playerName;
-  std::string levelId;
-  int playTime;
-};
-
+/*
+  the events are counted by level as they come ; the thread takes the
+  counters as a whole and writes them in one transaction, so that the game
+  never waits for the disk
+*/
 class XMThreadStats : public XMThread {
 public:
   XMThreadStats(const std::string &i_sitekey, StateManager *i_manager);
@@ -62,16 +61,16 @@ public:
 
 private:
   void play();
+  void addPlays(const std::string &PlayerName,
+                const std::string &LevelID,
+                const xmDatabaseLevelPlays &i_plays);
 
   SDL_mutex *m_eventsMutex;
 
   std::string m_sitekey;
   StateManager *m_manager; // for the communication
 
-  std::vector<xmstats_event> m_events_levelCompleted;
-  std::vector<xmstats_event> m_events_died;
-  std::vector<xmstats_event> m_events_abortedLevel;
-  std::vector<xmstats_event> m_events_levelRestarted;
+  xmDatabaseLevelsPlays m_plays; // not written yet
 };
 
 #endif
@@ -76,8 +76,9 @@ void BSPPoly::addVertice(const Vector2f &i_vertice) {
   m_vertices.push_back(i_vertice);
 }
 
-BSP::BSP() {
+BSP::BSP(unsigned int i_maxSplitters) {
   m_nNumErrors = 0;
+  m_maxSplitters = i_maxSplitters;
 }
 
 BSP::~BSP() {
@@ -214,30 +215,25 @@ void BSP::recurse(BSPPoly *pSubSpace, std::vector<BSPLine *> &Lines) {
   ===========================================================================*/
 BSPLine *BSP::findBestSplitter(std::vector<BSPLine *> &i_lines) {
   BSPLine *pBest = NULL;
-  std::vector<BSPLine *> Dummy1, Dummy2;
-  Dummy1.reserve(i_lines.size());
-  Dummy2.reserve(i_lines.size());
   int nBestScore = -1;
-  int nNumFront, nNumBack, nNumSplits, nScore;
+  unsigned int v_step = 1;
+
+  /* Trying all the lines is quadratic ; on big sets, try only some lines
+     evenly spread, the result stays the same from one run to the other */
+  if (m_maxSplitters != 0 && i_lines.size() > m_maxSplitters) {
+    v_step = i_lines.size() / m_maxSplitters;
+  }
 
-  /* Try splitting all lines with each of the lines */
-  for (unsigned int i = 0; i < i_lines.size(); i++) {
-    splitLines(i_lines,
-               Dummy1,
-               Dummy2,
-               i_lines[i],
-               true,
-               &nNumFront,
-               &nNumBack,
-               &nNumSplits);
-
-    /* Only qualify if both front and back is larger than 0 */
-    if (nNumFront > 0 && nNumBack > 0) {
-      /* Compute the score (smaller the better) */
-      nScore = abs(nNumBack - nNumFront) + nNumSplits * 2;
-      if (nScore < nBestScore || nBestScore == -1) {
-        pBest = i_lines[i];
-        nBestScore = nScore;
+  for (unsigned int i = 0; i < i_lines.size(); i += v_step) {
+    scoreSplitter(i_lines, i_lines[i], pBest, nBestScore);
+  }
+
+  /* None of them splits the set : try the others before deciding that the
+     subspace is convex */
+  if (pBest == NULL && v_step > 1) {
+    for (unsigned int i = 0; i < i_lines.size(); i++) {
+      if (i % v_step != 0) {
+        scoreSplitter(i_lines, i_lines[i], pBest, nBestScore);
       }
     }
   }
@@ -245,6 +241,33 @@ BSPLine *BSP::findBestSplitter(std::vector<BSPLine *> &i_lines) {
   return pBest;
 }
 
+void BSP::scoreSplitter(std::vector<BSPLine *> &i_lines,
+                        BSPLine *i_splitter,
+                        BSPLine *&io_best,
+                        int &io_bestScore) {
+  std::vector<BSPLine *> Dummy1, Dummy2;
+  int nNumFront, nNumBack, nNumSplits, nScore;
+
+  splitLines(i_lines,
+             Dummy1,
+             Dummy2,
+             i_splitter,
+             true,
+             &nNumFront,
+             &nNumBack,
+             &nNumSplits);
+
+  /* Only qualify if both front and back is larger than 0 */
+  if (nNumFront > 0 && nNumBack > 0) {
+    /* Compute the score (smaller the better) */
+    nScore = abs(nNumBack - nNumFront) + nNumSplits * 2;
+    if (nScore < io_bestScore || io_bestScore == -1) {
+      io_best = i_splitter;
+      io_bestScore = nScore;
+    }
+  }
+}
+
 /*===========================================================================
   Split polygon
   ===========================================================================*/
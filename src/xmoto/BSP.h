@@ -24,6 +24,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "common/VTexture.h"
 #include "helpers/VMath.h"
 
+/* number of lines tried as splitter at each step ; 0 to try them all */
+#define BSP_MAX_SPLITTERS 32
+
 class BSPLine {
 public:
   BSPLine(const Vector2f &i_p0, const Vector2f &i_p1);
@@ -54,7 +57,7 @@ private:
 
 class BSP {
 public:
-  BSP();
+  BSP(unsigned int i_maxSplitters = BSP_MAX_SPLITTERS);
   ~BSP();
 
   int getNumErrors();
@@ -66,12 +69,17 @@ public:
 
 private:
   int m_nNumErrors; /* Number of errors found */
+  unsigned int m_maxSplitters;
   std::vector<BSPLine *> m_lines; /* Input data set */
   std::vector<BSPPoly *> m_polys; /* Output data set */
 
   void recurse(BSPPoly *pSubSpace, std::vector<BSPLine *> &Lines);
 
   BSPLine *findBestSplitter(std::vector<BSPLine *> &i_lines);
+  void scoreSplitter(std::vector<BSPLine *> &i_lines,
+                     BSPLine *i_splitter,
+                     BSPLine *&io_best,
+                     int &io_bestScore);
   /* if bProbe is true, pnNumFront, pnNumBack and pnNumSplits must not be NULL
    * to be filled AND Front and Back will not be filled */
   void splitLines(std::vector<BSPLine *> &Lines,
@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "common/VFileIO.h"
 #include "common/XMSession.h"
 #include "db/xmDatabase.h"
+#include "db/xmDatabasePool.h"
 #include "drawlib/DrawLib.h"
 #include "gui/specific/GUIXMoto.h"
 #include "helpers/Log.h"
@@ -138,6 +139,7 @@ void GameApp::_InitWin(bool bInitGraphics) {
 }
 
 GameApp::~GameApp() {
+  xmDatabasePool::destroy();
   xmDatabase::destroy("main");
 
   if (drawLib != NULL) {
@@ -495,19 +497,35 @@ void GameApp::initReplaysFromDir(
   xmDatabase *threadDb,
   XMotoLoadReplaysInterface *pLoadReplaysInterface) {
   std::vector<std::string> ReplayFiles;
+  std::vector<std::string> v_files, v_names;
+  std::vector<ReplayInfo *> v_infos;
 
   ReplayFiles = XMFS::findPhysFiles(FDT_DATA, "Replays/*.rpl");
+  for (unsigned int i = 0; i < ReplayFiles.size(); i++) {
+    if (XMFS::getFileBaseName(ReplayFiles[i]) != "Latest") {
+      v_files.push_back(ReplayFiles[i]);
+      v_names.push_back(XMFS::getFileBaseName(ReplayFiles[i]));
+    }
+  }
+
+  /* only the replays changed since the last time are opened */
+  Replay::getReplaysInfos(v_names, v_infos);
+
   threadDb->replays_add_begin();
 
-  for (unsigned int i = 0; i < ReplayFiles.size(); i++) {
+  for (unsigned int i = 0; i < v_names.size(); i++) {
     try {
-      if (XMFS::getFileBaseName(ReplayFiles[i]) == "Latest") {
-        continue;
+      if (v_infos[i] == NULL) {
+        continue; // ok, forget this replay
       }
-      addReplay(ReplayFiles[i], threadDb, false);
+      threadDb->replays_add(v_infos[i]->Level,
+                            v_infos[i]->Name,
+                            v_infos[i]->Player,
+                            v_infos[i]->IsFinished,
+                            v_infos[i]->finishTime);
       if (pLoadReplaysInterface != NULL) {
         pLoadReplaysInterface->loadReplayHook(
-          ReplayFiles[i], (int)((i * 100) / ((float)ReplayFiles.size())));
+          v_files[i], (int)((i * 100) / ((float)v_files.size())));
       }
 
     } catch (Exception &e) {
@@ -515,6 +533,10 @@ void GameApp::initReplaysFromDir(
     }
   }
   threadDb->replays_add_end();
+
+  for (unsigned int i = 0; i < v_infos.size(); i++) {
+    delete v_infos[i];
+  }
 }
 
 void GameApp::addReplay(const std::string &i_file,
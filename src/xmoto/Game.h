@@ -191,6 +191,9 @@ private:
 
   void initNetwork(bool i_forceNoServerStarted, bool i_forceNoClientStarted);
   void uninitNetwork();
+  void benchmarkDbBuild();
+  void benchmarkBSP();
+  void checkLevelParser();
 
   ReplayBiker *m_replayBiker; /* link to the replay biker in REPLAYING state */
 
@@ -30,11 +30,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Sound.h"
 #include "common/VFileIO.h"
 #include "db/xmDatabase.h"
+#include "db/xmDatabasePool.h"
 #include "helpers/Environment.h"
 #include "helpers/Log.h"
 #include "helpers/Random.h"
 #include "helpers/Time.h"
 
+#include "BSP.h"
 #include "Credits.h"
 #include "GeomsManager.h"
 #include "LuaLibBase.h"
@@ -43,12 +45,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "XMDemo.h"
 #include "common/Packager.h"
 #include "common/VXml.h"
+#include "common/VXmlLight.h"
 #include "common/XMArgs.h"
 #include "common/XMSession.h"
 #include "drawlib/DrawLib.h"
 #include "gui/specific/GUIXMoto.h"
 #include "helpers/SwapEndian.h"
 #include "helpers/Text.h"
+#include "xmscene/Block.h"
+#include "xmscene/Level.h"
 #include <curl/curl.h>
 
 #include "states/StateEditProfile.h"
@@ -69,6 +74,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "net/NetActions.h"
 #include "net/NetClient.h"
 #include "net/NetServer.h"
+#include "net/ServerLoadTest.h"
 
 #if !defined(WIN32)
 #include <signal.h>
@@ -270,7 +276,9 @@ void GameApp::run_load(int nNumArgs, char **ppcArgs) {
 
   if (v_xmArgs.isOptListLevels() || v_xmArgs.isOptListReplays() ||
       v_xmArgs.isOptReplayInfos() || v_xmArgs.isOptServerOnly() ||
-      v_xmArgs.isOptUpdateLevelsOnly()) {
+      v_xmArgs.isOptUpdateLevelsOnly() || v_xmArgs.isOptDbBenchmark() ||
+      v_xmArgs.isOptBspBenchmark() || v_xmArgs.isOptRebuildCache() ||
+      v_xmArgs.isOptCheckLevelParser()) {
     v_useGraphics = false;
   }
 
@@ -303,6 +311,7 @@ void GameApp::run_load(int nNumArgs, char **ppcArgs) {
   /* database */
   /* thus, resolution/bpp/windowed parameters cannot be stored in the db (or
    * some minor modifications are required) */
+  xmDatabase::setSafeMode(v_xmArgs.isOptDbSafeMode());
   xmDatabase *pDb = xmDatabase::instance("main");
   pDb->preInitForProfileLoading(DATABASE_FILE);
 
@@ -400,6 +409,8 @@ void GameApp::run_load(int nNumArgs, char **ppcArgs) {
     quit();
     return;
   }
+  // the threads connections, created before the first thread
+  xmDatabasePool::instance();
 
   if (v_useGraphics) {
     // allocate the statemanager instance so that if it fails, it's not in a
@@ -536,6 +547,44 @@ void GameApp::run_load(int nNumArgs, char **ppcArgs) {
     return;
   }
 
+  /* -dbBenchmark */
+  if (v_xmArgs.isOptDbBenchmark()) {
+    benchmarkDbBuild();
+    quit();
+    return;
+  }
+
+  /* -rebuildCache */
+  if (v_xmArgs.isOptRebuildCache()) {
+    LevelsCacheSummary v_summary;
+
+    LevelsManager::rebuildCache(
+      xmDatabase::instance("main"), std::vector<std::string>(), v_summary);
+    printf("%u levels: %u up to date, %u rebuilt, %u failed ; "
+           "%u old cache files removed\n",
+           v_summary.nbLevels,
+           v_summary.nbUpToDate,
+           v_summary.nbRebuilt,
+           v_summary.nbFailed,
+           v_summary.nbRemoved);
+    quit();
+    return;
+  }
+
+  /* -bspBenchmark */
+  if (v_xmArgs.isOptBspBenchmark()) {
+    benchmarkBSP();
+    quit();
+    return;
+  }
+
+  /* -checkLevelParser */
+  if (v_xmArgs.isOptCheckLevelParser()) {
+    checkLevelParser();
+    quit();
+    return;
+  }
+
   /* -updateLevels */
   if (v_xmArgs.isOptUpdateLevelsOnly()) {
     UpgradeLevelsThread *m_upgradeLevelsThread;
@@ -634,7 +683,38 @@ void GameApp::run_load(int nNumArgs, char **ppcArgs) {
     _UpdateLoadingShell(); // no more loading screen
   }
 
-  if (v_xmArgs.isOptServerOnly()) {
+  if (v_xmArgs.isOptServerOnly() && v_xmArgs.isOptServerLoadTest()) {
+    int v_port = v_xmArgs.isOptServerPort()
+                   ? v_xmArgs.getOptServerPort_value()
+                   : XMSession::instance()->serverPort();
+
+    try {
+      // run the server in background and the bots in the main thread
+      NetServer::instance()->setStandAloneOptions();
+      NetServer::instance()->start(true, v_port);
+
+      ServerLoadTest v_loadTest(
+        "localhost",
+        v_port,
+        v_xmArgs.getOptServerLoadTest_value(),
+        v_xmArgs.isOptServerLoadTestDuration()
+          ? v_xmArgs.getOptServerLoadTestDuration_value()
+          : 60,
+        v_xmArgs.isOptServerLoadTestReplay()
+          ? v_xmArgs.getOptServerLoadTestReplay_value()
+          : "");
+      v_loadTest.run();
+    } catch (Exception &e) {
+      LogError((std::string("Exception: ") + e.getMsg()).c_str());
+    }
+
+    if (NetServer::instance()->isStarted()) {
+      NetServer::instance()->stop();
+    }
+    quit();
+    return;
+
+  } else if (v_xmArgs.isOptServerOnly()) {
     try {
       // start the server
       m_standAloneServer = NetServer::instance();
@@ -1232,6 +1312,180 @@ void GameApp::initNetwork(bool i_forceNoServerStarted,
   }
 }
 
+/* build a new database as on the first run, with and without the safe
+   mode ; the levels cache is cleared before each run to not give the cache
+   files of a run to the next one, and the modes are run in both orders. The
+   cache used is a scratch one, the real cache of the user is kept */
+void GameApp::benchmarkDbBuild() {
+  std::string v_dbFile = "xm_benchmark.db";
+  std::string v_cacheDir = XMFS::getUserDir(FDT_CACHE);
+  bool v_safeMode = xmDatabase::isSafeMode();
+  const char *v_journals[] = { "", "-journal", "-wal", "-shm" };
+  bool v_modes[] = { true, false, false, true }; // safe mode or not
+
+  XMFS::setUserCacheDir(v_cacheDir + "/Benchmark");
+  for (unsigned int v_run = 0; v_run < sizeof(v_modes) / sizeof(bool);
+       v_run++) {
+    double v_startTime, v_dbTime, v_levelsTime;
+
+    for (unsigned int i = 0; i < sizeof(v_journals) / sizeof(char *); i++) {
+      if (XMFS::fileExists(FDT_DATA, v_dbFile + v_journals[i])) {
+        XMFS::deleteFile(FDT_DATA, v_dbFile + v_journals[i]);
+      }
+    }
+    LevelsManager::cleanCache();
+    xmDatabase::setSafeMode(v_modes[v_run]);
+
+    try {
+      xmDatabase *v_db = xmDatabase::instance("benchmark");
+
+      v_startTime = getXMTime();
+      v_db->init(v_dbFile,
+                 "",
+                 XMFS::getSystemDataDir(),
+                 XMFS::getUserDir(FDT_DATA),
+                 XMFS::binCheckSum(),
+                 true,
+                 this);
+      v_dbTime = getXMTime();
+      LevelsManager::instance()->reloadLevelsFromLvl(v_db, false);
+      v_levelsTime = getXMTime();
+
+      printf("%s mode: database %.3fs, levels %.3fs, total %.3fs\n",
+             v_modes[v_run] ? "safe" : "fast",
+             v_dbTime - v_startTime,
+             v_levelsTime - v_dbTime,
+             v_levelsTime - v_startTime);
+    } catch (Exception &e) {
+      LogError("Database benchmark failed: %s", e.getMsg().c_str());
+    }
+    xmDatabase::destroy("benchmark");
+  }
+  LevelsManager::cleanCache();
+  XMFS::setUserCacheDir(v_cacheDir);
+
+  for (unsigned int i = 0; i < sizeof(v_journals) / sizeof(char *); i++) {
+    if (XMFS::fileExists(FDT_DATA, v_dbFile + v_journals[i])) {
+      XMFS::deleteFile(FDT_DATA, v_dbFile + v_journals[i]);
+    }
+  }
+  xmDatabase::setSafeMode(v_safeMode);
+}
+
+void GameApp::benchmarkBSP() {
+  std::vector<std::string> v_files;
+  xmDatabaseStatement *v_stmt =
+    xmDatabase::instance("main")->prepare("SELECT filepath FROM levels;");
+
+  while (v_stmt->next()) {
+    v_files.push_back(v_stmt->getString(0));
+  }
+
+  // the number of polygons tells the quality of the decomposition
+  for (unsigned int v_mode = 0; v_mode < 2; v_mode++) {
+    unsigned int v_maxSplitters = v_mode == 0 ? 0 : BSP_MAX_SPLITTERS;
+    unsigned int v_nbPolys = 0;
+    int v_nbErrors = 0;
+    double v_time = 0.0;
+    double v_startTime;
+
+    for (unsigned int i = 0; i < v_files.size(); i++) {
+      Level v_level;
+
+      try {
+        v_level.setFileName(v_files[i]);
+        v_level.loadXML(false);
+      } catch (Exception &e) {
+        continue;
+      }
+
+      v_startTime = getXMTime();
+      for (unsigned int j = 0; j < v_level.Blocks().size(); j++) {
+        v_nbErrors += v_level.Blocks()[j]->computeBSP(v_maxSplitters);
+        v_nbPolys += v_level.Blocks()[j]->nbBSPPolys();
+      }
+      v_time += getXMTime() - v_startTime;
+    }
+
+    printf("%s splitters: %u levels, %.3fs, %u polygons, %i errors\n",
+           v_mode == 0 ? "all" : "sampled",
+           (unsigned int)v_files.size(),
+           v_time,
+           v_nbPolys,
+           v_nbErrors);
+  }
+}
+
+void GameApp::checkLevelParser() {
+  std::vector<std::string> v_files;
+  xmDatabaseStatement *v_stmt =
+    xmDatabase::instance("main")->prepare("SELECT filepath FROM levels;");
+  unsigned int v_nbSame = 0, v_nbDifferent = 0, v_nbLibxml = 0;
+  double v_lightTime = 0.0, v_libxmlTime = 0.0;
+  double v_startTime;
+
+  while (v_stmt->next()) {
+    v_files.push_back(v_stmt->getString(0));
+  }
+
+  // the levels are read with the same code from both trees
+  for (unsigned int i = 0; i < v_files.size(); i++) {
+    XMLLightDocument v_light, v_copy;
+    XMLDocument v_xml;
+    FileHandle *pfh;
+    std::string v_data;
+    std::string v_diff;
+    bool v_parsed;
+
+    pfh = XMFS::openIFile(FDT_DATA, v_files[i], true);
+    if (pfh == NULL) {
+      continue;
+    }
+    v_data = XMFS::readFileToEnd(pfh);
+    XMFS::closeFile(pfh);
+
+    v_startTime = getXMTime();
+    v_parsed = v_light.parse(v_data.c_str(), v_data.length());
+    v_lightTime += getXMTime() - v_startTime;
+
+    // only the libxml2 parsing is timed, not the copy of its tree
+    v_startTime = getXMTime();
+    try {
+      v_xml.readFromMemory(v_data.c_str(), v_data.length(), v_files[i]);
+    } catch (Exception &e) {
+      v_diff = "refused by libxml2";
+    }
+    v_libxmlTime += getXMTime() - v_startTime;
+    if (v_diff == "") {
+      v_copy.readFromDOM(v_xml.getRootNode());
+    }
+
+    if (v_parsed == false) {
+      v_nbLibxml++;
+      continue;
+    }
+
+    if (v_diff == "") {
+      v_diff = v_light.compare(v_copy);
+    }
+    if (v_diff == "") {
+      v_nbSame++;
+    } else {
+      printf("%s: %s\n", v_files[i].c_str(), v_diff.c_str());
+      v_nbDifferent++;
+    }
+  }
+
+  printf("%u levels: %u same, %u different, %u left to libxml2 ; "
+         "parsed in %.3fs instead of %.3fs\n",
+         (unsigned int)v_files.size(),
+         v_nbSame,
+         v_nbDifferent,
+         v_nbLibxml,
+         v_lightTime,
+         v_libxmlTime);
+}
+
 void GameApp::uninitNetwork() {
   // stop the client
   if (NetClient::instance()->isConnected()) {
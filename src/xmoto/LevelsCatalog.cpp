@@ -0,0 +1,438 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "LevelsCatalog.h"
+#include "common/XMSession.h"
+#include "db/xmDatabase.h"
+#include "helpers/Log.h"
+#include "helpers/VExcept.h"
+#include <algorithm>
+#include <ctype.h>
+#include <set>
+#include <stdlib.h>
+
+#define LEVELSCATALOG_LEVELS_QUERY                                             \
+  "SELECT a.id_level, a.name, a.isScripted+0, a.isPhysics+0, "                \
+  "a.isToReload+0, b.id_level, b.packName, b.packNum, b.quality+0, "         \
+  "b.difficulty+0, b.crappy+0, b.children_compliant "                         \
+  "FROM levels AS a LEFT OUTER JOIN weblevels AS b "                          \
+  "ON a.id_level=b.id_level ORDER BY UPPER(a.name);"
+#define LEVELSCATALOG_BLACKLIST_QUERY                                          \
+  "SELECT id_level FROM levels_blacklist WHERE id_profile=?1;"
+#define LEVELSCATALOG_FAVORITE_QUERY                                           \
+  "SELECT id_level FROM levels_favorite WHERE id_profile=?1;"
+#define LEVELSCATALOG_FINISHED_QUERY                                           \
+  "SELECT id_level FROM stats_profiles_levels "                               \
+  "WHERE id_profile=?1 AND nbCompleted+0 > 0;"
+#define LEVELSCATALOG_PLAYERHIGHSCORES_QUERY                                   \
+  "SELECT id_level, MIN(finishTime+0) FROM profile_completedLevels "          \
+  "WHERE id_profile=?1 GROUP BY id_level;"
+#define LEVELSCATALOG_ROOMHIGHSCORES_QUERY                                     \
+  "SELECT id_level, MIN(finishTime+0) FROM webhighscores "                    \
+  "WHERE id_room=?1 GROUP BY id_level;"
+
+struct LevelsCatalogOrder {
+  const std::vector<LevelsCatalogEntry> *levels;
+  bool quality;
+
+  bool operator()(unsigned int i_a, unsigned int i_b) const {
+    if (quality) {
+      return (*levels)[i_a].quality < (*levels)[i_b].quality;
+    }
+    return (*levels)[i_a].difficulty < (*levels)[i_b].difficulty;
+  }
+};
+
+/* order of the standard packs : packNum || UPPER(name) */
+struct LevelsCatalogPackOrder {
+  const std::vector<std::string> *keys;
+
+  bool operator()(unsigned int i_a, unsigned int i_b) const {
+    return (*keys)[i_a] < (*keys)[i_b];
+  }
+};
+
+LevelsCatalogFilter::LevelsCatalogFilter(
+  levelPropertyRequiredValue i_isScripted,
+  levelPropertyRequiredValue i_isPhysics,
+  levelPropertyRequiredValue i_isCrappy,
+  levelPropertyRequiredValue i_isChildrenCompliant,
+  levelPropertyRequiredValue i_isBlacklisted,
+  levelPropertyRequiredValue i_isToReload,
+  levelPropertyRequiredValue i_isFavorite,
+  levelPropertyRequiredValue i_isFinished,
+  const std::string &i_webPack) {
+  isScripted = i_isScripted;
+  isPhysics = i_isPhysics;
+  isCrappy = i_isCrappy;
+  isChildrenCompliant = i_isChildrenCompliant;
+  isBlacklisted = i_isBlacklisted;
+  isToReload = i_isToReload;
+  isFavorite = i_isFavorite;
+  isFinished = i_isFinished;
+  webPack = i_webPack;
+}
+
+LevelsCatalog::LevelsCatalog() {}
+
+LevelsCatalog::~LevelsCatalog() {}
+
+void LevelsCatalog::update(xmDatabase *i_db,
+                           const std::string &i_profile,
+                           const std::string &i_id_room) {
+  std::string v_tablesVersions;
+
+  v_tablesVersions = i_db->levels_packTablesVersions(
+    LEVELSCATALOG_LEVELS_QUERY LEVELSCATALOG_BLACKLIST_QUERY
+      LEVELSCATALOG_FAVORITE_QUERY LEVELSCATALOG_FINISHED_QUERY
+        LEVELSCATALOG_PLAYERHIGHSCORES_QUERY
+          LEVELSCATALOG_ROOMHIGHSCORES_QUERY);
+
+  if (i_profile == m_profile && i_id_room == m_idRoom &&
+      v_tablesVersions == m_tablesVersions) {
+    return;
+  }
+
+  m_profile = i_profile;
+  m_idRoom = i_id_room;
+
+  try {
+    load(i_db);
+    m_tablesVersions = v_tablesVersions;
+  } catch (Exception &e) {
+    // load it again next time
+    m_tablesVersions = "";
+    throw e;
+  }
+}
+
+void LevelsCatalog::load(xmDatabase *i_db) {
+  xmDatabaseStatement *v_stmt;
+  std::map<std::string, unsigned int>::iterator v_level;
+  std::vector<unsigned int> v_blacklist;
+  LevelsCatalogEntry v_entry;
+
+  m_levels.clear();
+  m_levelsById.clear();
+  m_queries.clear();
+
+  v_stmt = i_db->prepare(LEVELSCATALOG_LEVELS_QUERY);
+  while (v_stmt->next()) {
+    v_entry.id = v_stmt->getString(0);
+    v_entry.name = v_stmt->getString(1);
+    v_entry.isScripted = v_stmt->getInt(2) != 0;
+    v_entry.isPhysics = v_stmt->getInt(3) != 0;
+    v_entry.isToReload = v_stmt->getInt(4) != 0;
+    v_entry.isOnTheWeb = v_stmt->isNull(5) == false;
+    v_entry.packName = v_stmt->getString(6);
+    v_entry.packNum = v_stmt->getString(7);
+    v_entry.quality = (float)v_stmt->getDouble(8);
+    v_entry.difficulty = (float)v_stmt->getDouble(9);
+    v_entry.isCrappy = v_stmt->getInt(10) != 0;
+    v_entry.isChildrenCompliant =
+      v_stmt->isNull(11) || v_stmt->getInt(11) != 0;
+    v_entry.isBlacklisted = false;
+    v_entry.isFavorite = false;
+    v_entry.isFinished = false;
+    v_entry.playerHighscore = -1;
+    v_entry.roomHighscore = -1;
+
+    m_levelsById[v_entry.id] = m_levels.size();
+    m_levels.push_back(v_entry);
+  }
+
+  loadLevelsOfProfile(i_db, LEVELSCATALOG_BLACKLIST_QUERY, v_blacklist);
+  for (unsigned int i = 0; i < v_blacklist.size(); i++) {
+    m_levels[v_blacklist[i]].isBlacklisted = true;
+  }
+  loadLevelsOfProfile(i_db, LEVELSCATALOG_FAVORITE_QUERY, m_favoriteLevels);
+  for (unsigned int i = 0; i < m_favoriteLevels.size(); i++) {
+    m_levels[m_favoriteLevels[i]].isFavorite = true;
+  }
+  loadLevelsOfProfile(i_db, LEVELSCATALOG_FINISHED_QUERY, m_finishedLevels);
+  for (unsigned int i = 0; i < m_finishedLevels.size(); i++) {
+    m_levels[m_finishedLevels[i]].isFinished = true;
+  }
+
+  v_stmt = i_db->prepare(LEVELSCATALOG_PLAYERHIGHSCORES_QUERY);
+  v_stmt->bind(1, m_profile);
+  while (v_stmt->next()) {
+    v_level = m_levelsById.find(v_stmt->getString(0));
+    if (v_level != m_levelsById.end()) {
+      m_levels[v_level->second].playerHighscore = v_stmt->getInt(1);
+    }
+  }
+
+  v_stmt = i_db->prepare(LEVELSCATALOG_ROOMHIGHSCORES_QUERY);
+  v_stmt->bind(1, atoi(m_idRoom.c_str()));
+  while (v_stmt->next()) {
+    v_level = m_levelsById.find(v_stmt->getString(0));
+    if (v_level != m_levelsById.end()) {
+      m_levels[v_level->second].roomHighscore = v_stmt->getInt(1);
+    }
+  }
+
+  makeIndexes();
+  LogDebug("Levels catalog loaded (%u levels)", (unsigned int)m_levels.size());
+}
+
+void LevelsCatalog::loadLevelsOfProfile(xmDatabase *i_db,
+                                        const char *i_sql,
+                                        std::vector<unsigned int> &o_levels) {
+  xmDatabaseStatement *v_stmt;
+  std::map<std::string, unsigned int>::iterator v_level;
+
+  o_levels.clear();
+
+  v_stmt = i_db->prepare(i_sql);
+  v_stmt->bind(1, m_profile);
+  while (v_stmt->next()) {
+    v_level = m_levelsById.find(v_stmt->getString(0));
+    if (v_level != m_levelsById.end()) {
+      o_levels.push_back(v_level->second);
+    }
+  }
+
+  // same order as the catalog, by name
+  std::sort(o_levels.begin(), o_levels.end());
+  o_levels.erase(std::unique(o_levels.begin(), o_levels.end()),
+                 o_levels.end());
+}
+
+void LevelsCatalog::makeIndexes() {
+  LevelsCatalogOrder v_order;
+  LevelsCatalogPackOrder v_packOrder;
+  std::vector<std::string> v_packKeys;
+  std::map<std::string, std::vector<unsigned int>>::iterator v_pack;
+
+  m_levelsByQuality.clear();
+  m_levelsByPack.clear();
+  v_packKeys.resize(m_levels.size());
+
+  for (unsigned int i = 0; i < m_levels.size(); i++) {
+    if (m_levels[i].isOnTheWeb) {
+      m_levelsByQuality.push_back(i);
+
+      if (m_levels[i].packName != "") {
+        m_levelsByPack[m_levels[i].packName].push_back(i);
+        v_packKeys[i] = m_levels[i].packNum + m_levels[i].name;
+        for (unsigned int j = m_levels[i].packNum.size();
+             j < v_packKeys[i].size();
+             j++) {
+          v_packKeys[i][j] = toupper(v_packKeys[i][j]);
+        }
+      }
+    }
+  }
+  m_levelsByDifficulty = m_levelsByQuality;
+
+  v_order.levels = &m_levels;
+  v_order.quality = true;
+  std::sort(m_levelsByQuality.begin(), m_levelsByQuality.end(), v_order);
+  v_order.quality = false;
+  std::sort(m_levelsByDifficulty.begin(), m_levelsByDifficulty.end(), v_order);
+
+  v_packOrder.keys = &v_packKeys;
+  for (v_pack = m_levelsByPack.begin(); v_pack != m_levelsByPack.end();
+       v_pack++) {
+    std::sort(v_pack->second.begin(), v_pack->second.end(), v_packOrder);
+  }
+}
+
+unsigned int LevelsCatalog::size() const {
+  return m_levels.size();
+}
+
+const LevelsCatalogEntry &LevelsCatalog::entry(unsigned int i) const {
+  return m_levels[i];
+}
+
+void LevelsCatalog::levelsByRange(const std::vector<unsigned int> &i_index,
+                                  bool i_quality,
+                                  float i_min,
+                                  float i_max,
+                                  std::vector<unsigned int> &o_levels) const {
+  unsigned int v_begin, v_end, v_middle;
+  float v_value;
+
+  o_levels.clear();
+
+  // first level with a value >= i_min
+  v_begin = 0;
+  v_end = i_index.size();
+  while (v_begin < v_end) {
+    v_middle = (v_begin + v_end) / 2;
+    v_value = i_quality ? m_levels[i_index[v_middle]].quality
+                        : m_levels[i_index[v_middle]].difficulty;
+    if (v_value < i_min) {
+      v_begin = v_middle + 1;
+    } else {
+      v_end = v_middle;
+    }
+  }
+
+  for (unsigned int i = v_begin; i < i_index.size(); i++) {
+    v_value = i_quality ? m_levels[i_index[i]].quality
+                        : m_levels[i_index[i]].difficulty;
+    if (v_value > i_max) {
+      break;
+    }
+    o_levels.push_back(i_index[i]);
+  }
+}
+
+void LevelsCatalog::levelsByQuality(float i_min,
+                                    float i_max,
+                                    std::vector<unsigned int> &o_levels) const {
+  levelsByRange(m_levelsByQuality, true, i_min, i_max, o_levels);
+}
+
+void LevelsCatalog::levelsByDifficulty(
+  float i_min,
+  float i_max,
+  std::vector<unsigned int> &o_levels) const {
+  levelsByRange(m_levelsByDifficulty, false, i_min, i_max, o_levels);
+}
+
+static bool isValueInFilter(bool i_value, levelPropertyRequiredValue i_filter) {
+  switch (i_filter) {
+    case lprv_yes:
+      return i_value;
+    case lprv_no:
+      return i_value == false;
+    case lprv_dontcare:
+      break;
+  }
+  return true;
+}
+
+bool LevelsCatalog::isInFilter(const LevelsCatalogEntry &i_level,
+                               const LevelsCatalogFilter &i_filter) {
+  bool v_useCrappy = XMSession::instance()->useCrappyPack();
+  bool v_useChildrenCompliant = XMSession::instance()->useChildrenCompliant();
+
+  if (i_filter.webPack != "" && i_level.packName != i_filter.webPack) {
+    return false;
+  }
+
+  // only the web knows the crappy and not children compliant levels
+  if ((i_filter.isCrappy == lprv_yes ||
+       i_filter.isChildrenCompliant == lprv_no) &&
+      i_level.isOnTheWeb == false) {
+    return false;
+  }
+
+  /* same as xm_userCrappy and xm_userChildrenCompliant */
+  if (i_filter.isCrappy == lprv_dontcare) {
+    if (v_useCrappy && i_level.isCrappy) {
+      return false;
+    }
+  } else if (isValueInFilter(i_level.isCrappy, i_filter.isCrappy) == false) {
+    return false;
+  }
+  if (v_useChildrenCompliant && i_level.isChildrenCompliant == false) {
+    return false;
+  }
+  if (isValueInFilter(i_level.isChildrenCompliant,
+                      i_filter.isChildrenCompliant) == false) {
+    return false;
+  }
+
+  return isValueInFilter(i_level.isScripted, i_filter.isScripted) &&
+         isValueInFilter(i_level.isPhysics, i_filter.isPhysics) &&
+         isValueInFilter(i_level.isBlacklisted, i_filter.isBlacklisted) &&
+         isValueInFilter(i_level.isToReload, i_filter.isToReload) &&
+         isValueInFilter(i_level.isFavorite, i_filter.isFavorite) &&
+         isValueInFilter(i_level.isFinished, i_filter.isFinished);
+}
+
+void LevelsCatalog::levelsByFilter(const LevelsCatalogFilter &i_filter,
+                                   std::vector<unsigned int> &o_levels) const {
+  std::map<std::string, std::vector<unsigned int>>::const_iterator v_pack;
+  const std::vector<unsigned int> *v_index;
+
+  o_levels.clear();
+
+  /* the smallest index containing the levels */
+  v_index = NULL;
+  if (i_filter.webPack != "") {
+    v_pack = m_levelsByPack.find(i_filter.webPack);
+    if (v_pack == m_levelsByPack.end()) {
+      return;
+    }
+    v_index = &(v_pack->second);
+  } else if (i_filter.isFavorite == lprv_yes) {
+    v_index = &m_favoriteLevels;
+  } else if (i_filter.isFinished == lprv_yes) {
+    v_index = &m_finishedLevels;
+  }
+
+  if (v_index != NULL) {
+    for (unsigned int i = 0; i < v_index->size(); i++) {
+      if (isInFilter(m_levels[(*v_index)[i]], i_filter)) {
+        o_levels.push_back((*v_index)[i]);
+      }
+    }
+    return;
+  }
+
+  for (unsigned int i = 0; i < m_levels.size(); i++) {
+    if (isInFilter(m_levels[i], i_filter)) {
+      o_levels.push_back(i);
+    }
+  }
+}
+
+const LevelsCatalogQuery &LevelsCatalog::levelsByQuery(
+  xmDatabase *i_db,
+  const std::string &i_sql) {
+  xmDatabaseStatement *v_stmt;
+  std::map<std::string, unsigned int>::iterator v_level;
+  std::set<unsigned int> v_levels;
+  std::string v_tablesVersions;
+  LevelsCatalogQuery *v_query;
+
+  v_tablesVersions = i_db->levels_packTablesVersions(i_sql);
+  v_query = &(m_queries[i_sql]);
+
+  if (v_query->tablesVersions != "" &&
+      v_query->tablesVersions == v_tablesVersions) {
+    return *v_query;
+  }
+
+  v_query->tablesVersions = "";
+  v_query->levels.clear();
+  v_query->names.clear();
+
+  v_stmt = i_db->prepare(i_sql);
+  while (v_stmt->next()) {
+    v_level = m_levelsById.find(v_stmt->getString(0));
+
+    // once per level, as the lists grouped by level
+    if (v_level != m_levelsById.end() &&
+        v_levels.insert(v_level->second).second) {
+      v_query->levels.push_back(v_level->second);
+      v_query->names.push_back(v_stmt->getString(1));
+    }
+  }
+  v_query->tablesVersions = v_tablesVersions;
+
+  return *v_query;
+}
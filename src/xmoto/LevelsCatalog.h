@@ -0,0 +1,154 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __LEVELSCATALOG_H__
+#define __LEVELSCATALOG_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+class xmDatabase;
+
+// when requesting for level, or values must be yes, or no, or yes or no, so 3
+// cases
+enum levelPropertyRequiredValue { lprv_yes, lprv_no, lprv_dontcare };
+
+struct LevelsCatalogEntry {
+  std::string id;
+  std::string name;
+  bool isScripted;
+  bool isPhysics;
+  bool isToReload;
+
+  // information from weblevels, only if isOnTheWeb
+  bool isOnTheWeb;
+  std::string packName;
+  std::string packNum;
+  float quality;
+  float difficulty;
+  bool isCrappy;
+  bool isChildrenCompliant; // true if the level is not on the web
+
+  // for the profile and the room of the catalog
+  bool isBlacklisted;
+  bool isFavorite;
+  bool isFinished;
+  int playerHighscore; // -1 if the level is not finished
+  int roomHighscore; // -1 if there is no highscore
+};
+
+/* the properties of the levels of a virtual pack, as in
+   LevelsManager::queryLevelsAsVirtualPack ; crappy and children compliant
+   follow the options of the session when they are lprv_dontcare */
+struct LevelsCatalogFilter {
+  LevelsCatalogFilter(levelPropertyRequiredValue i_isScripted,
+                      levelPropertyRequiredValue i_isPhysics,
+                      levelPropertyRequiredValue i_isCrappy,
+                      levelPropertyRequiredValue i_isChildrenCompliant,
+                      levelPropertyRequiredValue i_isBlacklisted,
+                      levelPropertyRequiredValue i_isToReload,
+                      levelPropertyRequiredValue i_isFavorite,
+                      levelPropertyRequiredValue i_isFinished,
+                      const std::string &i_webPack = "");
+
+  levelPropertyRequiredValue isScripted;
+  levelPropertyRequiredValue isPhysics;
+  levelPropertyRequiredValue isCrappy;
+  levelPropertyRequiredValue isChildrenCompliant;
+  levelPropertyRequiredValue isBlacklisted;
+  levelPropertyRequiredValue isToReload;
+  levelPropertyRequiredValue isFavorite;
+  levelPropertyRequiredValue isFinished;
+  std::string webPack; // only the levels of this pack if not empty
+};
+
+/* the levels of a pack which can't be filtered from the catalog, with their
+   names in this pack */
+struct LevelsCatalogQuery {
+  std::string tablesVersions;
+  std::vector<unsigned int> levels;
+  std::vector<std::string> names;
+};
+
+/*
+  the levels with the information used to filter them, kept in memory to not
+  run the queries at each interaction ; the catalog is loaded again only when
+  one of the tables it comes from changed (see xm_tablesVersions)
+*/
+class LevelsCatalog {
+public:
+  LevelsCatalog();
+  ~LevelsCatalog();
+
+  void update(xmDatabase *i_db,
+              const std::string &i_profile,
+              const std::string &i_id_room);
+
+  unsigned int size() const;
+  const LevelsCatalogEntry &entry(unsigned int i) const;
+
+  // web levels with i_min <= value <= i_max, sorted by value
+  void levelsByQuality(float i_min,
+                       float i_max,
+                       std::vector<unsigned int> &o_levels) const;
+  void levelsByDifficulty(float i_min,
+                          float i_max,
+                          std::vector<unsigned int> &o_levels) const;
+
+  // levels of the filter, sorted by name (by number in a web pack)
+  void levelsByFilter(const LevelsCatalogFilter &i_filter,
+                      std::vector<unsigned int> &o_levels) const;
+  static bool isInFilter(const LevelsCatalogEntry &i_level,
+                         const LevelsCatalogFilter &i_filter);
+
+  // levels returned by a query (id_level, name), which is run again only
+  // when its tables changed
+  const LevelsCatalogQuery &levelsByQuery(xmDatabase *i_db,
+                                          const std::string &i_sql);
+
+private:
+  void load(xmDatabase *i_db);
+  void makeIndexes();
+  // levels of the ids returned by the query, sorted as the catalog
+  void loadLevelsOfProfile(xmDatabase *i_db,
+                           const char *i_sql,
+                           std::vector<unsigned int> &o_levels);
+  void levelsByRange(const std::vector<unsigned int> &i_index,
+                     bool i_quality,
+                     float i_min,
+                     float i_max,
+                     std::vector<unsigned int> &o_levels) const;
+
+  std::vector<LevelsCatalogEntry> m_levels;
+  std::map<std::string, unsigned int> m_levelsById;
+  std::vector<unsigned int> m_levelsByQuality;
+  std::vector<unsigned int> m_levelsByDifficulty;
+  std::map<std::string, std::vector<unsigned int>> m_levelsByPack;
+  std::vector<unsigned int> m_favoriteLevels;
+  std::vector<unsigned int> m_finishedLevels;
+  std::map<std::string, LevelsCatalogQuery> m_queries;
+
+  std::string m_profile;
+  std::string m_idRoom;
+  std::string m_tablesVersions;
+};
+
+#endif
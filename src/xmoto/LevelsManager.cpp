@@ -24,10 +24,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "common/VFileIO.h"
 #include "common/VXml.h"
 #include "common/WWWAppInterface.h"
+#include "common/XMSession.h"
 #include "db/xmDatabase.h"
+#include "db/xmDatabasePool.h"
 #include "helpers/Log.h"
+#include "helpers/VMath.h"
 #include "sqlqueries.h"
+#include "thread/LevelsParsingPipeline.h"
+#include "thread/WorkersPool.h"
 #include <algorithm>
+#include <set>
 #include <sstream>
 #include <time.h>
 
@@ -39,43 +45,77 @@ LevelsPack::LevelsPack(std::string i_name,
   m_showWebTimes = true;
   m_sql_levels = i_sql;
   m_ascSort = i_ascSort;
+  m_catalogFilter = NULL;
   m_nbLevels = -1;
   m_nbFinishedLevels = -1;
 }
 
-LevelsPack::~LevelsPack() {}
+LevelsPack::~LevelsPack() {
+  if (m_catalogFilter != NULL) {
+    delete m_catalogFilter;
+  }
+}
 
 void LevelsPack::updateCount(xmDatabase *i_db, const std::string &i_profile) {
-  char **v_result;
-  unsigned int nrow;
+  xmDatabaseStatement *v_stmt;
+  std::string v_tablesVersions;
+  xmDatabase *v_cacheDb;
+  bool v_writerLocked = false;
+
+  /* nothing used by the pack changed since the last count */
+  v_tablesVersions = i_db->levels_packTablesVersions(m_sql_levels);
+  if (i_db->levels_getPackCount(m_sql_levels,
+                                i_profile,
+                                v_tablesVersions,
+                                m_nbLevels,
+                                m_nbFinishedLevels)) {
+    return;
+  }
 
   /* number of levels*/
-  v_result =
-    i_db->readDB("SELECT count(id_level) FROM (" + m_sql_levels + ");", nrow);
+  v_stmt =
+    i_db->prepare("SELECT count(id_level) FROM (" + m_sql_levels + ");");
 
-  if (i_db->getResult(v_result, 1, 0, 0) == NULL) {
-    i_db->read_DB_free(v_result);
+  if (v_stmt->next() == false || v_stmt->isNull(0)) {
+    v_stmt->reset();
     throw Exception("Unable to update level pack count");
   }
-
-  m_nbLevels = atoi(i_db->getResult(v_result, 1, 0, 0));
-  i_db->read_DB_free(v_result);
+  m_nbLevels = v_stmt->getInt(0);
+  v_stmt->reset();
 
   /* finished levels */
-  v_result = i_db->readDB(
+  v_stmt = i_db->prepare(
     "SELECT count(1) FROM (SELECT a.id_level FROM (" + m_sql_levels +
-      ") AS a INNER JOIN stats_profiles_levels AS b ON a.id_level=b.id_level "
-      "WHERE b.id_profile=\"" +
-      xmDatabase::protectString(i_profile) + "\" AND b.nbCompleted+0 > 0 "
-                                             "GROUP BY a.id_level);",
-    nrow);
+    ") AS a INNER JOIN stats_profiles_levels AS b ON a.id_level=b.id_level "
+    "WHERE b.id_profile=?1 AND b.nbCompleted+0 > 0 "
+    "GROUP BY a.id_level);");
+  v_stmt->bind(1, i_profile);
 
-  if (nrow != 1) {
-    i_db->read_DB_free(v_result);
+  if (v_stmt->next() == false) {
     throw Exception("Unable to update level pack count");
   }
-  m_nbFinishedLevels = atoi(i_db->getResult(v_result, 1, 0, 0));
-  i_db->read_DB_free(v_result);
+  m_nbFinishedLevels = v_stmt->getInt(0);
+  v_stmt->reset();
+
+  /* a reader saves the counts with the writer of the threads */
+  v_cacheDb = i_db;
+  try {
+    if (i_db->isReadOnly()) {
+      v_cacheDb = xmDatabasePool::instance()->lockWriter();
+      v_writerLocked = true;
+    }
+    v_cacheDb->levels_setPackCount(m_sql_levels,
+                                   i_profile,
+                                   v_tablesVersions,
+                                   m_nbLevels,
+                                   m_nbFinishedLevels);
+  } catch (Exception &e) {
+    /* it will be counted again next time */
+    LogWarning("Unable to save level pack count (%s)", e.getMsg().c_str());
+  }
+  if (v_writerLocked) {
+    xmDatabasePool::instance()->unlockWriter();
+  }
 }
 
 int LevelsPack::getNumberOfLevels() {
@@ -88,22 +128,19 @@ std::string LevelsPack::getLevelsQuery() const {
          ";";
 }
 
-std::string LevelsPack::getLevelsWithHighscoresQuery(
-  const std::string &i_profile,
-  const std::string &i_id_room) const {
-  return "SELECT a.id_level AS id_level, MIN(a.name) AS name, "
-         "MIN(c.finishTime+0), MIN(b.finishTime+0) "
-         "FROM (" +
-         m_sql_levels + ") AS a "
-                        "LEFT OUTER JOIN webhighscores AS b "
-                        "ON (a.id_level = b.id_level AND b.id_room=" +
-         i_id_room + ") "
-                     "LEFT OUTER JOIN profile_completedLevels AS c "
-                     "ON (a.id_level=c.id_level AND c.id_profile=\"" +
-         xmDatabase::protectString(i_profile) +
-         "\") "
-         "GROUP BY a.id_level ORDER BY MIN(a.sort_field) " +
-         std::string(m_ascSort ? "ASC" : "DESC") + ";";
+bool LevelsPack::isAscSort() const {
+  return m_ascSort;
+}
+
+void LevelsPack::setCatalogFilter(const LevelsCatalogFilter &i_filter) {
+  if (m_catalogFilter != NULL) {
+    delete m_catalogFilter;
+  }
+  m_catalogFilter = new LevelsCatalogFilter(i_filter);
+}
+
+const LevelsCatalogFilter *LevelsPack::catalogFilter() const {
+  return m_catalogFilter;
 }
 
 int LevelsPack::getNumberOfFinishedLevels() {
@@ -202,6 +239,15 @@ void LevelsManager::makePacks_add(const std::string &i_pack_name,
   m_levelsPacks.push_back(v_pack);
 }
 
+void LevelsManager::makePacks_add(const std::string &i_pack_name,
+                                  const std::string &i_sql,
+                                  const std::string &i_group_name,
+                                  const std::string &i_pack_description,
+                                  const LevelsCatalogFilter &i_filter) {
+  makePacks_add(i_pack_name, i_sql, i_group_name, i_pack_description);
+  m_levelsPacks.back()->setCatalogFilter(i_filter);
+}
+
 void LevelsManager::makePacks(const std::string &i_playerName,
                               const std::string &i_id_room,
                               bool i_bDebugMode,
@@ -236,6 +282,16 @@ void LevelsManager::makePacks(const std::string &i_playerName,
         "AND (b.children_compliant IS NULL OR "
         "xm_userChildrenCompliant(b.children_compliant)=1) "
         "AND c.id_level IS NULL");
+    v_pack->setCatalogFilter(
+      LevelsCatalogFilter(lprv_dontcare, // scripted
+                          lprv_dontcare, // physics
+                          lprv_dontcare, // crappy
+                          lprv_dontcare, // children compliant
+                          lprv_no, // blacklisted
+                          lprv_dontcare, // to reload
+                          lprv_dontcare, // favorite
+                          lprv_dontcare, // finished
+                          i_db->getResult(v_result, 1, i, 0)));
     v_pack->setGroup(GAMETEXT_PACK_STANDARD);
 
     snprintf(v_levelPackStr,
@@ -251,31 +307,87 @@ void LevelsManager::makePacks(const std::string &i_playerName,
   makePacks_add(VPACKAGENAME_ALL_LEVELS,
                 QUERY_LVL_ALL,
                 GAMETEXT_PACK_SPECIAL,
-                VPACKAGENAME_DESC_ALL_LEVELS);
+                VPACKAGENAME_DESC_ALL_LEVELS,
+                LevelsCatalogFilter(lprv_dontcare, // scripted
+                                    lprv_dontcare, // physics
+                                    lprv_dontcare, // crappy
+                                    lprv_dontcare, // children compliant
+                                    lprv_no, // blacklisted
+                                    lprv_dontcare, // to reload
+                                    lprv_dontcare, // favorite
+                                    lprv_dontcare)); // finished
   makePacks_add(VPACKAGENAME_MY_LEVELS,
                 QUERY_LVL_MY,
                 GAMETEXT_PACK_SPECIAL,
-                VPACKAGENAME_DESC_MY_LEVELS);
+                VPACKAGENAME_DESC_MY_LEVELS,
+                LevelsCatalogFilter(lprv_dontcare, // scripted
+                                    lprv_dontcare, // physics
+                                    lprv_dontcare, // crappy
+                                    lprv_dontcare, // children compliant
+                                    lprv_no, // blacklisted
+                                    lprv_yes, // to reload
+                                    lprv_dontcare, // favorite
+                                    lprv_dontcare)); // finished
   makePacks_add(VPACKAGENAME_FAVORITE_LEVELS,
                 QUERY_LVL_FAVORITES,
                 GAMETEXT_PACK_SPECIAL,
-                VPACKAGENAME_DESC_FAVORITE_LEVELS);
+                VPACKAGENAME_DESC_FAVORITE_LEVELS,
+                LevelsCatalogFilter(lprv_dontcare, // scripted
+                                    lprv_dontcare, // physics
+                                    lprv_dontcare, // crappy
+                                    lprv_dontcare, // children compliant
+                                    lprv_no, // blacklisted
+                                    lprv_dontcare, // to reload
+                                    lprv_yes, // favorite
+                                    lprv_dontcare)); // finished
   makePacks_add(VPACKAGENAME_BLACKLIST_LEVELS,
                 QUERY_LVL_BLACKLIST,
                 GAMETEXT_PACK_SPECIAL,
-                VPACKAGENAME_DESC_BLACKLIST_LEVELS);
+                VPACKAGENAME_DESC_BLACKLIST_LEVELS,
+                LevelsCatalogFilter(lprv_dontcare, // scripted
+                                    lprv_dontcare, // physics
+                                    lprv_dontcare, // crappy
+                                    lprv_dontcare, // children compliant
+                                    lprv_yes, // blacklisted
+                                    lprv_dontcare, // to reload
+                                    lprv_dontcare, // favorite
+                                    lprv_dontcare)); // finished
   makePacks_add(VPACKAGENAME_SCRIPTED,
                 QUERY_LVL_SCRIPTED,
                 GAMETEXT_PACK_SPECIAL,
-                VPACKAGENAME_DESC_SCRIPTED);
+                VPACKAGENAME_DESC_SCRIPTED,
+                LevelsCatalogFilter(lprv_yes, // scripted
+                                    lprv_dontcare, // physics
+                                    lprv_dontcare, // crappy
+                                    lprv_dontcare, // children compliant
+                                    lprv_no, // blacklisted
+                                    lprv_dontcare, // to reload
+                                    lprv_dontcare, // favorite
+                                    lprv_dontcare)); // finished
   makePacks_add(VPACKAGENAME_PHYSICS,
                 QUERY_LVL_PHYSICS,
                 GAMETEXT_PACK_SPECIAL,
-                VPACKAGENAME_DESC_PHYSICS);
+                VPACKAGENAME_DESC_PHYSICS,
+                LevelsCatalogFilter(lprv_dontcare, // scripted
+                                    lprv_yes, // physics
+                                    lprv_dontcare, // crappy
+                                    lprv_dontcare, // children compliant
+                                    lprv_no, // blacklisted
+                                    lprv_dontcare, // to reload
+                                    lprv_dontcare, // favorite
+                                    lprv_dontcare)); // finished
   makePacks_add(VPACKAGENAME_INCOMPLETED_LEVELS,
                 QUERY_LVL_INCOMPLETED,
                 GAMETEXT_PACK_SPECIAL,
-                VPACKAGENAME_DESC_INCOMPLETED_LEVELS);
+                VPACKAGENAME_DESC_INCOMPLETED_LEVELS,
+                LevelsCatalogFilter(lprv_dontcare, // scripted
+                                    lprv_dontcare, // physics
+                                    lprv_dontcare, // crappy
+                                    lprv_dontcare, // children compliant
+                                    lprv_no, // blacklisted
+                                    lprv_dontcare, // to reload
+                                    lprv_dontcare, // favorite
+                                    lprv_no)); // finished
   makePacks_add(VPACKAGENAME_NEW_LEVELS,
                 QUERY_LVL_NEW,
                 GAMETEXT_PACK_SPECIAL,
@@ -283,7 +395,15 @@ void LevelsManager::makePacks(const std::string &i_playerName,
   makePacks_add(VPACKAGENAME_CRAPPY_LEVELS,
                 QUERY_LVL_CRAPPY,
                 GAMETEXT_PACK_SPECIAL,
-                VPACKAGENAME_DESC_CRAPPY_LEVELS);
+                VPACKAGENAME_DESC_CRAPPY_LEVELS,
+                LevelsCatalogFilter(lprv_dontcare, // scripted
+                                    lprv_dontcare, // physics
+                                    lprv_yes, // crappy
+                                    lprv_dontcare, // children compliant
+                                    lprv_no, // blacklisted
+                                    lprv_dontcare, // to reload
+                                    lprv_dontcare, // favorite
+                                    lprv_dontcare)); // finished
   makePacks_add(VPACKAGENAME_LAST_LEVELS,
                 QUERY_LVL_LAST,
                 GAMETEXT_PACK_SPECIAL,
@@ -876,13 +996,60 @@ const std::vector<LevelsPack *> &LevelsManager::LevelsPacks() {
   return m_levelsPacks;
 }
 
+struct LevelsChecksumsJob {
+  const std::vector<std::string> *files;
+  std::vector<unsigned int> changedFiles;
+  std::vector<std::string> *checkSums;
+};
+
+static void computeLevelChecksum(void *i_data, unsigned int i_item) {
+  LevelsChecksumsJob *v_job = (LevelsChecksumsJob *)i_data;
+  unsigned int v_file = v_job->changedFiles[i_item];
+
+  (*v_job->checkSums)[v_file] =
+    XMFS::md5sum(FDT_DATA, (*v_job->files)[v_file]);
+}
+
+void LevelsManager::computeChangedLevelsChecksums(
+  xmDatabase *i_db,
+  const std::vector<std::string> &i_files,
+  bool i_isToReload,
+  std::vector<xmDatabaseLevelFileRows> &o_rows,
+  std::vector<std::string> &o_checkSums) {
+  LevelsChecksumsJob v_job;
+
+  o_rows.clear();
+  o_rows.resize(i_files.size());
+  o_checkSums.clear();
+  o_checkSums.resize(i_files.size());
+
+  v_job.files = &i_files;
+  v_job.checkSums = &o_checkSums;
+  for (unsigned int i = 0; i < i_files.size(); i++) {
+    i_db->levels_getFileRows(i_files[i], i_isToReload, o_rows[i]);
+    if (o_rows[i].needChecksum()) {
+      v_job.changedFiles.push_back(i);
+    }
+  }
+
+  if (v_job.changedFiles.size() > 0) {
+    LogInfo("Computing the checksum of %i changed level(s)",
+            (int)v_job.changedFiles.size());
+    WorkersPool::run(computeLevelChecksum, &v_job, v_job.changedFiles.size());
+  }
+}
+
 void LevelsManager::reloadExternalLevels(
   xmDatabase *i_db,
   bool i_loadMainLayerOnly,
   XMotoLoadLevelsInterface *i_loadLevelsInterface) {
   std::vector<std::string> LvlFiles =
     XMFS::findPhysFiles(FDT_DATA, "Levels/MyLevels/*.lvl", true);
+  std::vector<xmDatabaseLevelFileRows> v_rows;
+  std::vector<std::string> v_checkSums;
+  std::vector<std::string> v_toParse;
   std::string v_levelName;
+  unsigned int v_nbDone = 0;
 
   // main case : no external level
   if (LvlFiles.size() == 0) {
@@ -890,40 +1057,63 @@ void LevelsManager::reloadExternalLevels(
   }
 
   i_db->levels_add_begin(true);
+  computeChangedLevelsChecksums(i_db, LvlFiles, true, v_rows, v_checkSums);
   for (unsigned int i = 0; i < LvlFiles.size(); i++) {
     /* add the level from the unloaded levels if possible to make it faster */
-    if (i_db->levels_add_fast(LvlFiles[i], v_levelName, true) == false) {
-      Level *v_level = new Level();
+    if (i_db->levels_add_fast(
+          LvlFiles[i], v_rows[i], v_levelName, true, v_checkSums[i]) ==
+        false) {
+      v_toParse.push_back(LvlFiles[i]);
+      continue;
+    }
 
-      try {
-        v_level->setFileName(LvlFiles[i]);
-        v_level->loadReducedFromFile(i_loadMainLayerOnly);
+    v_nbDone++;
+    if (i_loadLevelsInterface != NULL) {
+      i_loadLevelsInterface->loadLevelHook(v_levelName,
+                                           (v_nbDone * 100) / LvlFiles.size());
+    }
+  }
 
-        v_levelName = v_level->Name();
+  /* the other ones are parsed in parallel, but added from this thread.
+     Adding them after the cached ones doesn't change which file wins on a
+     duplicate ID : the cached rows are already in the table (loaded=0)
+     and doesLevelExist() sees them, while the parsed levels are still
+     added in the findPhysFiles order. */
+  LevelsParsingPipeline v_pipeline(v_toParse, i_loadMainLayerOnly);
+  for (unsigned int i = 0; i < v_pipeline.size(); i++) {
+    std::string v_error;
+    Level *v_level = v_pipeline.takeLevel(i, v_error);
+
+    try {
+      if (v_error != "") {
+        throw Exception(v_error);
+      }
 
-        // Check for ID conflict
-        if (doesLevelExist(v_level->Id(), i_db)) {
-          throw Exception("Duplicate level ID");
-        }
-        i_db->levels_add(v_level->Id(),
-                         v_level->FileName(),
-                         v_level->Name(),
-                         v_level->Checksum(),
-                         v_level->Author(),
-                         v_level->Description(),
-                         v_level->Date(),
-                         v_level->Music(),
-                         v_level->isScripted(),
-                         v_level->isPhysics(),
-                         true);
-      } catch (Exception &e) {
+      v_levelName = v_level->Name();
+
+      // Check for ID conflict
+      if (doesLevelExist(v_level->Id(), i_db)) {
+        throw Exception("Duplicate level ID");
       }
-      delete v_level;
+      i_db->levels_add(v_level->Id(),
+                       v_level->FileName(),
+                       v_level->Name(),
+                       v_level->Checksum(),
+                       v_level->Author(),
+                       v_level->Description(),
+                       v_level->Date(),
+                       v_level->Music(),
+                       v_level->isScripted(),
+                       v_level->isPhysics(),
+                       true);
+    } catch (Exception &e) {
     }
+    delete v_level;
 
+    v_nbDone++;
     if (i_loadLevelsInterface != NULL) {
       i_loadLevelsInterface->loadLevelHook(v_levelName,
-                                           ((i + 1) * 100) / LvlFiles.size());
+                                           (v_nbDone * 100) / LvlFiles.size());
     }
   }
 
@@ -966,8 +1156,15 @@ void LevelsManager::reloadLevelsFromLvl(
   xmDatabase *i_db,
   bool i_loadMainLayerOnly,
   XMotoLoadLevelsInterface *i_loadLevelsInterface) {
-  reloadInternalLevels(i_db, i_loadMainLayerOnly, i_loadLevelsInterface);
-  reloadExternalLevels(i_db, i_loadMainLayerOnly, i_loadLevelsInterface);
+  i_db->setBulkLoad(true);
+  try {
+    reloadInternalLevels(i_db, i_loadMainLayerOnly, i_loadLevelsInterface);
+    reloadExternalLevels(i_db, i_loadMainLayerOnly, i_loadLevelsInterface);
+  } catch (Exception &e) {
+    i_db->setBulkLoad(false);
+    throw e;
+  }
+  i_db->setBulkLoad(false);
 }
 
 void LevelsManager::reloadInternalLevels(
@@ -976,55 +1173,80 @@ void LevelsManager::reloadInternalLevels(
   XMotoLoadLevelsInterface *i_loadLevelsInterface) {
   std::vector<std::string> LvlFiles =
     XMFS::findPhysFiles(FDT_DATA, "Levels/*.lvl", true);
+  std::vector<xmDatabaseLevelFileRows> v_rows;
+  std::vector<std::string> v_checkSums;
+  std::vector<std::string> v_toParse;
   std::string v_levelName;
+  unsigned int v_nbDone = 0;
 
   i_db->levels_add_begin(false);
+  computeChangedLevelsChecksums(i_db, LvlFiles, false, v_rows, v_checkSums);
 
   for (unsigned int i = 0; i < LvlFiles.size(); i++) {
     int v_isExternal;
 
     v_isExternal = LvlFiles[i].find("Levels/MyLevels/") != std::string::npos;
     if (v_isExternal) {
+      v_nbDone++;
       continue; // don't load external levels now
     }
 
     /* add the level from the unloaded levels if possible to make it faster */
-    if (i_db->levels_add_fast(LvlFiles[i], v_levelName, false) == false) {
-      Level *v_level = new Level();
+    if (i_db->levels_add_fast(
+          LvlFiles[i], v_rows[i], v_levelName, false, v_checkSums[i]) ==
+        false) {
+      v_toParse.push_back(LvlFiles[i]);
+      continue;
+    }
 
-      try {
-        v_level->setFileName(LvlFiles[i]);
-        v_level->loadReducedFromFile(i_loadMainLayerOnly);
+    v_nbDone++;
+    if (i_loadLevelsInterface != NULL) {
+      i_loadLevelsInterface->loadLevelHook(v_levelName,
+                                           (v_nbDone * 100) / LvlFiles.size());
+    }
+  }
 
-        // Check for ID conflict
-        if (doesLevelExist(v_level->Id(), i_db)) {
-          throw Exception("Duplicate level ID");
-        }
-        i_db->levels_add(v_level->Id(),
-                         v_level->FileName(),
-                         v_level->Name(),
-                         v_level->Checksum(),
-                         v_level->Author(),
-                         v_level->Description(),
-                         v_level->Date(),
-                         v_level->Music(),
-                         v_level->isScripted(),
-                         v_level->isPhysics(),
-                         false);
-      } catch (Exception &e) {
-        LogWarning("(just mean that the level has been updated if the level is "
-                   "in xmoto.bin) ** : %s (%s - %s)",
-                   e.getMsg().c_str(),
-                   v_level->Name().c_str(),
-                   v_level->FileName().c_str());
+  /* the other ones are parsed in parallel, but added from this thread ;
+     on a duplicate ID, see reloadExternalLevels() */
+  LevelsParsingPipeline v_pipeline(v_toParse, i_loadMainLayerOnly);
+  for (unsigned int i = 0; i < v_pipeline.size(); i++) {
+    std::string v_error;
+    Level *v_level = v_pipeline.takeLevel(i, v_error);
+
+    try {
+      if (v_error != "") {
+        throw Exception(v_error);
       }
-      v_levelName = v_level->Name();
-      delete v_level;
+
+      // Check for ID conflict
+      if (doesLevelExist(v_level->Id(), i_db)) {
+        throw Exception("Duplicate level ID");
+      }
+      i_db->levels_add(v_level->Id(),
+                       v_level->FileName(),
+                       v_level->Name(),
+                       v_level->Checksum(),
+                       v_level->Author(),
+                       v_level->Description(),
+                       v_level->Date(),
+                       v_level->Music(),
+                       v_level->isScripted(),
+                       v_level->isPhysics(),
+                       false);
+    } catch (Exception &e) {
+      LogWarning("(just mean that the level has been updated if the level is "
+                 "in xmoto.bin) ** : %s (%s - %s)",
+                 e.getMsg().c_str(),
+                 v_level->Name().c_str(),
+                 v_level->FileName().c_str());
     }
+    v_levelName = v_level->Name();
+    delete v_level;
 
+    v_nbDone++;
     if (i_loadLevelsInterface != NULL) {
       i_loadLevelsInterface->loadLevelHook(v_levelName,
-                                           ((i + 1) * 100) / LvlFiles.size());
+                                           (v_nbDone * 100) / LvlFiles.size());
     }
   }
 
@@ -1050,6 +1272,103 @@ void LevelsManager::cleanCache() {
   for (unsigned int i = 0; i < BlvFiles.size(); i++) {
     XMFS::deleteFile(FDT_CACHE, BlvFiles[i]);
   }
+
+  /* and the files left by interrupted writes (see Level::exportBinary()) */
+  std::vector<std::string> v_tmpFiles =
+    XMFS::findPhysFiles(FDT_CACHE, "LCache/*.tmp");
+  for (unsigned int i = 0; i < v_tmpFiles.size(); i++) {
+    XMFS::deleteFile(FDT_CACHE, v_tmpFiles[i]);
+  }
+}
+
+struct LevelsCacheJob {
+  std::vector<std::string> files;
+  std::vector<int> results; // 0 up to date, 1 rebuilt, 2 failed
+};
+
+static void rebuildLevelCache(void *i_data, unsigned int i_item) {
+  LevelsCacheJob *v_job = (LevelsCacheJob *)i_data;
+  Level v_level;
+  bool v_rebuilt;
+
+  v_job->results[i_item] = 2;
+  v_level.setFileName(v_job->files[i_item]);
+
+  // same steps as when the level is played ; the caches are replaced, never
+  // rewritten in place, the level played meanwhile can read them
+  v_rebuilt = v_level.loadReducedFromFile(false) == false;
+  if (v_level.isXMotoTooOld()) {
+    return;
+  }
+  if (v_level.loadFullyFromFile(false, true, false)) {
+    v_rebuilt = true;
+  }
+
+  v_job->results[i_item] = v_rebuilt ? 1 : 0;
+}
+
+void LevelsManager::rebuildCache(xmDatabase *i_db,
+                                 const std::vector<std::string> &i_files,
+                                 LevelsCacheSummary &o_summary) {
+  LevelsCacheJob v_job;
+  xmDatabaseStatement *v_stmt;
+
+  o_summary.nbLevels = 0;
+  o_summary.nbUpToDate = 0;
+  o_summary.nbRebuilt = 0;
+  o_summary.nbFailed = 0;
+  o_summary.nbRemoved = 0;
+
+  checkPrerequires();
+
+  if (i_files.empty()) {
+    std::set<std::string> v_names;
+    std::vector<std::string> v_blvFiles;
+    std::string v_name;
+
+    // names of the cache files (see Level::getNameInCache())
+    v_stmt = i_db->prepare("SELECT filepath, checkSum FROM levels;");
+    while (v_stmt->next()) {
+      v_name = v_stmt->getString(1) +
+               XMFS::getFileBaseName(v_stmt->getString(0));
+      v_names.insert(v_name + ".blv");
+      v_names.insert(v_name + "mlo.blv");
+      v_job.files.push_back(v_stmt->getString(0));
+    }
+
+    v_blvFiles = XMFS::findPhysFiles(FDT_CACHE, "LCache/*.blv");
+    for (unsigned int i = 0; i < v_blvFiles.size(); i++) {
+      if (v_names.find(XMFS::getFileBaseName(v_blvFiles[i]) + ".blv") ==
+          v_names.end()) {
+        XMFS::deleteFile(FDT_CACHE, v_blvFiles[i]);
+        o_summary.nbRemoved++;
+      }
+    }
+  } else {
+    v_job.files = i_files;
+  }
+
+  v_job.results.resize(v_job.files.size());
+  o_summary.nbLevels = v_job.files.size();
+  if (v_job.files.empty()) {
+    return;
+  }
+
+  WorkersPool::run(rebuildLevelCache, &v_job, v_job.files.size());
+
+  for (unsigned int i = 0; i < v_job.results.size(); i++) {
+    switch (v_job.results[i]) {
+      case 0:
+        o_summary.nbUpToDate++;
+        break;
+      case 1:
+        o_summary.nbRebuilt++;
+        break;
+      default:
+        LogWarning("Unable to build the cache of %s", v_job.files[i].c_str());
+        o_summary.nbFailed++;
+    }
+  }
 }
 
 std::string LevelsManager::LevelByFileName(const std::string &i_fileName,
@@ -1109,23 +1428,32 @@ void LevelsManager::updateLevelsFromLvl(
   WWWAppInterface *pCaller,
   xmDatabase *i_db) {
   Level *v_level;
+  std::string v_error;
   int current = 0;
   float total = 100.0 / (float)(NewLvl.size() + UpdatedLvl.size());
+  std::vector<std::string> v_files;
+
+  /* new levels first, then the updated ones */
+  v_files = NewLvl;
+  v_files.insert(v_files.end(), UpdatedLvl.begin(), UpdatedLvl.end());
+  LevelsParsingPipeline v_pipeline(v_files, i_loadMainLayerOnly);
 
+  i_db->setBulkLoad(true);
   try {
     i_db->levels_addToNew_begin();
     i_db->levels_cleanNew();
 
     /* new */
     for (unsigned int i = 0; i < NewLvl.size(); i++) {
-      v_level = new Level();
+      pCaller->setTaskProgress(current * total);
+      current++;
 
-      try {
-        pCaller->setTaskProgress(current * total);
-        current++;
+      v_level = v_pipeline.takeLevel(i, v_error);
 
-        v_level->setFileName(NewLvl[i]);
-        v_level->loadReducedFromFile(i_loadMainLayerOnly);
+      try {
+        if (v_error != "") {
+          throw Exception(v_error);
+        }
 
         // Check for ID conflict
         if (doesLevelExist(v_level->Id(), i_db)) {
@@ -1151,11 +1479,12 @@ void LevelsManager::updateLevelsFromLvl(
 
     /* updated */
     for (unsigned int i = 0; i < UpdatedLvl.size(); i++) {
-      v_level = new Level();
+      v_level = v_pipeline.takeLevel(NewLvl.size() + i, v_error);
 
       try {
-        v_level->setFileName(UpdatedLvl[i]);
-        v_level->loadReducedFromFile(i_loadMainLayerOnly);
+        if (v_error != "") {
+          throw Exception(v_error);
+        }
 
         pCaller->setTaskProgress(current * total);
         pCaller->setBeingDownloadedInformation(v_level->Name());
@@ -1182,8 +1511,10 @@ void LevelsManager::updateLevelsFromLvl(
     i_db->levels_addToNew_end();
   } catch (Exception &e) {
     i_db->levels_addToNew_end(); // commit what has been done even if it failed
+    i_db->setBulkLoad(false);
     throw e;
   }
+  i_db->setBulkLoad(false);
 }
 
 bool LevelsManager::isInFavorite(std::string i_profile,
@@ -1262,14 +1593,8 @@ void LevelsManager::delFromBlacklist(std::string i_profile,
   }
 }
 
-std::string LevelsManager::getQuickStartPackQuery(unsigned int i_qualityMIN,
-                                                  unsigned int i_difficultyMIN,
-                                                  unsigned int i_qualityMAX,
-                                                  unsigned int i_difficultyMAX,
-                                                  const std::string &i_profile,
-                                                  const std::string &i_id_room,
-                                                  xmDatabase *i_db) {
-  /* SELECT id_level, name, profile_best_finishTime, web_highscore */
+bool LevelsManager::isQuickStartForTutorials(const std::string &i_profile,
+                                             xmDatabase *i_db) {
   char **v_result;
   unsigned int nrow;
   char *v_res;
@@ -1293,135 +1618,151 @@ std::string LevelsManager::getQuickStartPackQuery(unsigned int i_qualityMIN,
   }
   i_db->read_DB_free(v_result);
 
-  if (v_tutorials) {
-    return "SELECT a.id_level, MIN(a.name), MIN(b.finishTime+0), "
-           "MIN(c.finishTime+0) "
-           "FROM levels AS a "
-           "INNER JOIN webhighscores AS b ON (a.id_level = b.id_level AND "
-           "b.id_room=" +
-           i_id_room + ") "
-                       "LEFT OUTER JOIN profile_completedLevels AS c "
-                       "ON (a.id_level=c.id_level AND c.id_profile=\"" +
-           xmDatabase::protectString(i_profile) +
-           "\") "
-           "WHERE b.packName=\"Tutorials\" "
-           "GROUP BY a.id_level "
-           "ORDER BY b.packNum || UPPER(a.name);";
-  }
-
-  /* run the query to check wether there are at least 5 levels, else, all levels
-   * randomly */
-  /* web quality and difficulty are >=1 and <=5 */
-  bool v_haveEnoughLevels;
-  std::ostringstream v_qualityMINStr;
-  std::ostringstream v_difficultyMINStr;
-  std::ostringstream v_qualityMAXStr;
-  std::ostringstream v_difficultyMAXStr;
+  return v_tutorials;
+}
+
+std::string LevelsManager::getQuickStartTutorialsQuery(
+  const std::string &i_profile,
+  const std::string &i_id_room) {
+  /* SELECT id_level, name, profile_best_finishTime, web_highscore */
+  return "SELECT a.id_level, MIN(a.name), MIN(c.finishTime+0), "
+         "MIN(b.finishTime+0) "
+         "FROM levels AS a "
+         "INNER JOIN webhighscores AS b ON (a.id_level = b.id_level AND "
+         "b.id_room=" +
+         i_id_room + ") "
+                     "LEFT OUTER JOIN profile_completedLevels AS c "
+                     "ON (a.id_level=c.id_level AND c.id_profile=\"" +
+         xmDatabase::protectString(i_profile) +
+         "\") "
+         "WHERE b.packName=\"Tutorials\" "
+         "GROUP BY a.id_level "
+         "ORDER BY b.packNum || UPPER(a.name);";
+}
 
+void LevelsManager::getQuickStartLevels(
+  unsigned int i_qualityMIN,
+  unsigned int i_difficultyMIN,
+  unsigned int i_qualityMAX,
+  unsigned int i_difficultyMAX,
+  const std::string &i_profile,
+  const std::string &i_id_room,
+  xmDatabase *i_db,
+  std::vector<const LevelsCatalogEntry *> &o_levels) {
+  std::vector<unsigned int> v_levels;
+  const LevelsCatalogEntry *v_level;
+  LevelsCatalogFilter v_filter(lprv_dontcare, // scripted
+                               lprv_dontcare, // physics
+                               lprv_dontcare, // crappy
+                               lprv_dontcare, // children compliant
+                               lprv_no, // blacklisted
+                               lprv_dontcare, // to reload
+                               lprv_dontcare, // favorite
+                               lprv_dontcare); // finished
+  float v_qualityMIN = i_qualityMIN;
+  float v_qualityMAX = i_qualityMAX;
+  float v_difficultyMIN = i_difficultyMIN;
+  float v_difficultyMAX = i_difficultyMAX;
+  unsigned int j;
+
+  m_levelsCatalog.update(i_db, i_profile, i_id_room);
+  o_levels.clear();
+
+  /* web quality and difficulty are >=1 and <=5 */
   // make ranges because statistics dont give round numbers anymore
-  if (i_qualityMIN == 5) {
-    i_qualityMIN = 4.5;
+  if (v_qualityMIN == 5) {
+    v_qualityMIN = 4.5;
   }
-  if (i_qualityMAX == 1) {
-    i_qualityMAX = 1.5;
+  if (v_qualityMAX == 1) {
+    v_qualityMAX = 1.5;
   }
-  if (i_qualityMIN == i_qualityMAX) {
-    i_qualityMIN -= 0.5;
-    i_qualityMAX += 0.5;
+  if (v_qualityMIN == v_qualityMAX) {
+    v_qualityMIN -= 0.5;
+    v_qualityMAX += 0.5;
   }
 
-  if (i_difficultyMIN == 5) {
-    i_difficultyMIN = 4.5;
+  if (v_difficultyMIN == 5) {
+    v_difficultyMIN = 4.5;
   }
-  if (i_difficultyMAX == 1) {
-    i_difficultyMAX = 1.5;
+  if (v_difficultyMAX == 1) {
+    v_difficultyMAX = 1.5;
   }
-  if (i_difficultyMIN == i_difficultyMAX) {
-    i_difficultyMIN -= 0.5;
-    i_difficultyMAX += 0.5;
+  if (v_difficultyMIN == v_difficultyMAX) {
+    v_difficultyMIN -= 0.5;
+    v_difficultyMAX += 0.5;
   }
 
-  v_qualityMINStr << i_qualityMIN;
-  v_difficultyMINStr << i_difficultyMIN;
-  v_qualityMAXStr << i_qualityMAX;
-  v_difficultyMAXStr << i_difficultyMAX;
+  m_levelsCatalog.levelsByQuality(v_qualityMIN, v_qualityMAX, v_levels);
+  for (unsigned int i = 0; i < v_levels.size(); i++) {
+    v_level = &(m_levelsCatalog.entry(v_levels[i]));
 
-  v_result = i_db->readDB(
-    "SELECT count(1) "
-    "FROM levels AS a "
-    "INNER JOIN weblevels AS b ON a.id_level = b.id_level "
-    "LEFT OUTER JOIN levels_blacklist AS c ON (a.id_level = c.id_level AND "
-    "c.id_profile = \"" +
-      xmDatabase::protectString(i_profile) + "\") "
-                                             "WHERE b.quality+0    <= " +
-      v_qualityMAXStr.str() + " "
-                              "AND   b.quality+0    >= " +
-      v_qualityMINStr.str() + " "
-                              "AND   b.difficulty+0 <= " +
-      v_difficultyMAXStr.str() + " "
-                                 "AND   b.difficulty+0 >= " +
-      v_difficultyMINStr.str() +
-      " "
-      "AND   xm_userCrappy(b.crappy)=0 "
-      "AND   xm_userChildrenCompliant(b.children_compliant)=1 "
-      "AND   c.id_level IS NULL "
-      "ORDER BY RANDOM();",
-    nrow);
-  v_res = i_db->getResult(v_result, 1, 0, 0);
-  v_haveEnoughLevels = atoi(v_res) >= 5; /* less than 5 levels ? */
-  i_db->read_DB_free(v_result);
+    if (v_level->difficulty >= v_difficultyMIN &&
+        v_level->difficulty <= v_difficultyMAX &&
+        LevelsCatalog::isInFilter(*v_level, v_filter)) {
+      o_levels.push_back(v_level);
+    }
+  }
 
-  if (v_haveEnoughLevels) {
-    return "SELECT a.id_level, MIN(a.name), MIN(c.finishTime+0), "
-           "MIN(d.finishTime+0) "
-           "FROM levels AS a "
-           "INNER JOIN weblevels AS b ON a.id_level = b.id_level "
-           "LEFT OUTER JOIN webhighscores AS c ON (a.id_level = c.id_level AND "
-           "c.id_room=" +
-           i_id_room + ") "
-                       "LEFT OUTER JOIN profile_completedLevels AS d "
-                       "ON (a.id_level=d.id_level AND d.id_profile=\"" +
-           xmDatabase::protectString(i_profile) +
-           "\") "
-           "LEFT OUTER JOIN levels_blacklist AS e ON (a.id_level = e.id_level "
-           "AND e.id_profile=\"" +
-           xmDatabase::protectString(i_profile) + "\") "
-                                                  "WHERE b.quality+0    <= " +
-           v_qualityMAXStr.str() + " "
-                                   "AND   b.quality+0    >= " +
-           v_qualityMINStr.str() + " "
-                                   "AND   b.difficulty+0 <= " +
-           v_difficultyMAXStr.str() + " "
-                                      "AND   b.difficulty+0 >= " +
-           v_difficultyMINStr.str() +
-           " "
-           "AND   xm_userCrappy(b.crappy)=0 "
-           "AND   xm_userChildrenCompliant(b.children_compliant)=1 "
-           "AND   e.id_level IS NULL "
-           "GROUP BY a.id_level ORDER BY RANDOM();";
-  } else {
-    /* all levels randomly */
+  /* less than 5 levels ? all levels randomly */
+  if (o_levels.size() < 5) {
     SysMessage::instance()->displayInformation(GAMETEXT_QUERY_WITHOUT_RESULT);
-    return "SELECT a.id_level, MIN(a.name), MIN(b.finishTime+0), "
-           "MIN(c.finishTime+0) "
-           "FROM levels AS a "
-           "LEFT OUTER JOIN webhighscores AS b ON (a.id_level = b.id_level AND "
-           "b.id_room=" +
-           i_id_room + ") "
-                       "LEFT OUTER JOIN profile_completedLevels AS c "
-                       "ON (a.id_level=c.id_level AND c.id_profile=\"" +
-           xmDatabase::protectString(i_profile) +
-           "\") "
-           "LEFT OUTER JOIN weblevels AS d ON (a.id_level=d.id_level) "
-           "LEFT OUTER JOIN levels_blacklist AS e ON (a.id_level = e.id_level "
-           "AND e.id_profile=\"" +
-           xmDatabase::protectString(i_profile) +
-           "\") "
-           "WHERE xm_userCrappy(d.crappy)=0 "
-           "AND xm_userChildrenCompliant(d.children_compliant)=1 "
-           "AND   e.id_level IS NULL "
-           "GROUP BY a.id_level ORDER BY RANDOM();";
+
+    m_levelsCatalog.levelsByFilter(v_filter, v_levels);
+    o_levels.clear();
+    for (unsigned int i = 0; i < v_levels.size(); i++) {
+      v_level = &(m_levelsCatalog.entry(v_levels[i]));
+
+      // the children compliance of the levels not on the web is unknown
+      if (v_level->isOnTheWeb ||
+          XMSession::instance()->useChildrenCompliant() == false) {
+        o_levels.push_back(v_level);
+      }
+    }
+  }
+
+  /* random order */
+  for (unsigned int i = o_levels.size(); i > 1; i--) {
+    j = randomIntNum(0, i);
+    std::swap(o_levels[i - 1], o_levels[j]);
+  }
+}
+
+void LevelsManager::getLevelsOfPack(
+  const LevelsPack *i_pack,
+  const std::string &i_profile,
+  const std::string &i_id_room,
+  xmDatabase *i_db,
+  std::vector<const LevelsCatalogEntry *> &o_levels,
+  std::vector<std::string> &o_names) {
+  std::vector<unsigned int> v_levels;
+  const LevelsCatalogEntry *v_level;
+
+  m_levelsCatalog.update(i_db, i_profile, i_id_room);
+  o_levels.clear();
+  o_names.clear();
+
+  /* the sql of the pack is run only for the packs which need other tables */
+  if (i_pack->catalogFilter() != NULL) {
+    m_levelsCatalog.levelsByFilter(*(i_pack->catalogFilter()), v_levels);
+    for (unsigned int i = 0; i < v_levels.size(); i++) {
+      v_level = &(m_levelsCatalog.entry(v_levels[i]));
+      o_levels.push_back(v_level);
+      o_names.push_back(v_level->name);
+    }
+
+    if (i_pack->isAscSort() == false) {
+      std::reverse(o_levels.begin(), o_levels.end());
+      std::reverse(o_names.begin(), o_names.end());
+    }
+    return;
+  }
+
+  const LevelsCatalogQuery &v_query =
+    m_levelsCatalog.levelsByQuery(i_db, i_pack->getLevelsQuery());
+  for (unsigned int i = 0; i < v_query.levels.size(); i++) {
+    o_levels.push_back(&(m_levelsCatalog.entry(v_query.levels[i])));
   }
+  o_names = v_query.names;
 }
 
 void LevelsManager::lockLevelsPacks() {
@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #ifndef __LEVELMANAGER_H__
 #define __LEVELMANAGER_H__
 
+#include "LevelsCatalog.h"
 #include "common/XMotoLoadLevelsInterface.h"
 #include "db/xmDatabase.h"
 #include "helpers/Singleton.h"
@@ -31,6 +32,14 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 class WWWAppInterface;
 
+struct LevelsCacheSummary {
+  unsigned int nbLevels;
+  unsigned int nbUpToDate;
+  unsigned int nbRebuilt;
+  unsigned int nbFailed;
+  unsigned int nbRemoved; // files of levels no more in the database
+};
+
 class LevelsPack {
 public:
   LevelsPack(std::string i_name,
@@ -50,8 +59,11 @@ public:
   std::string Group() const;
   void setGroup(std::string i_group);
   std::string getLevelsQuery() const;
-  std::string getLevelsWithHighscoresQuery(const std::string &i_profile,
-                                           const std::string &i_id_room) const;
+  bool isAscSort() const;
+  /* the levels of the pack are filtered from the levels catalog instead of
+     running the sql, when the filter has all the information required */
+  void setCatalogFilter(const LevelsCatalogFilter &i_filter);
+  const LevelsCatalogFilter *catalogFilter() const; // NULL if none
   int getNumberOfLevels();
   int getNumberOfFinishedLevels();
 
@@ -65,6 +77,7 @@ private:
   bool m_showTimes;
   bool m_showWebTimes;
   std::string m_description;
+  LevelsCatalogFilter *m_catalogFilter;
 
   int m_nbLevels, m_nbFinishedLevels;
 };
@@ -82,6 +95,11 @@ private:
                      const std::string &i_group_name,
                      const std::string &i_pack_description,
                      bool i_ascSort = true);
+  void makePacks_add(const std::string &i_pack_name,
+                     const std::string &i_sql,
+                     const std::string &i_group_name,
+                     const std::string &i_pack_description,
+                     const LevelsCatalogFilter &i_filter);
 
 public:
   LevelsPack &LevelsPackByName(const std::string &i_name);
@@ -120,6 +138,12 @@ public:
 
   static void checkPrerequires();
   static void cleanCache();
+  /* check and write again the cache of the levels, using all the cpus ;
+     without files, do it for all the levels, and remove the cache files of
+     the levels no more in the database */
+  static void rebuildCache(xmDatabase *i_db,
+                           const std::vector<std::string> &i_files,
+                           LevelsCacheSummary &o_summary);
 
   void printLevelsList(xmDatabase *i_db) const;
 
@@ -145,22 +169,32 @@ public:
                         const std::string &i_id_level,
                         xmDatabase *i_db);
 
-  static std::string getQuickStartPackQuery(unsigned int i_qualityMIN,
-                                            unsigned int i_difficultyMIN,
-                                            unsigned int i_qualityMAX,
-                                            unsigned int i_difficultyMAX,
-                                            const std::string &i_profile,
-                                            const std::string &i_id_room,
-                                            xmDatabase *i_db);
+  static bool isQuickStartForTutorials(const std::string &i_profile,
+                                       xmDatabase *i_db);
+  static std::string getQuickStartTutorialsQuery(const std::string &i_profile,
+                                                 const std::string &i_id_room);
+  /* random levels of the quick start, from the levels catalog */
+  void getQuickStartLevels(unsigned int i_qualityMIN,
+                           unsigned int i_difficultyMIN,
+                           unsigned int i_qualityMAX,
+                           unsigned int i_difficultyMAX,
+                           const std::string &i_profile,
+                           const std::string &i_id_room,
+                           xmDatabase *i_db,
+                           std::vector<const LevelsCatalogEntry *> &o_levels);
+  /* levels of the pack with their names in the pack, from the levels
+     catalog */
+  void getLevelsOfPack(const LevelsPack *i_pack,
+                       const std::string &i_profile,
+                       const std::string &i_id_room,
+                       xmDatabase *i_db,
+                       std::vector<const LevelsCatalogEntry *> &o_levels,
+                       std::vector<std::string> &o_names);
   void reloadExternalLevels(
     xmDatabase *i_db,
     bool i_loadMainLayerOnly,
     XMotoLoadLevelsInterface *i_loadLevelsInterface = NULL);
 
-  // when requesting for level, or values must be yes, or no, or yes or no, so 3
-  // cases
-  enum levelPropertyRequiredValue { lprv_yes, lprv_no, lprv_dontcare };
-
   static void writeDefaultPackagesSql(FileHandle *pfh,
                                       const std::string &i_sqlName,
                                       const std::string &i_sql);
@@ -190,9 +224,18 @@ private:
     xmDatabase *i_db,
     bool i_loadMainLayerOnly,
     XMotoLoadLevelsInterface *i_loadLevelsInterface = NULL);
+  // database rows of the files, and checksums of the files which changed
+  // since they were added, computed in parallel ; empty for the other files
+  void computeChangedLevelsChecksums(
+    xmDatabase *i_db,
+    const std::vector<std::string> &i_files,
+    bool i_isToReload,
+    std::vector<xmDatabaseLevelFileRows> &o_rows,
+    std::vector<std::string> &o_checkSums);
 
   std::vector<LevelsPack *> m_levelsPacks;
   SDL_mutex *m_levelsPackMutex;
+  LevelsCatalog m_levelsCatalog;
 };
 
 #endif /* __LEVELSMANAGER__ */
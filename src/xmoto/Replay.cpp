@@ -35,12 +35,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "Game.h"
 #include "GameEvents.h"
+#include "common/BinaryReader.h"
 #include "db/xmDatabase.h"
 #include "helpers/FileCompression.h"
 #include "helpers/Log.h"
 #include "helpers/SwapEndian.h"
+#include "thread/WorkersPool.h"
 #include "xmscene/Bike.h"
 #include "xmscene/Block.h"
+#include <unordered_map>
 
 // minimum value to consider a block has moved
 #define RMOVINGBLOCK_MIN_DIFFMOVE 0.1
@@ -308,40 +311,40 @@ void Replay::saveReplay_1(FileHandle *pfh) {
   }
 }
 
-void Replay::openReplay_3(FileHandle *pfh, bool bDisplayInformation) {
+void Replay::openReplay_3(BinaryReader &i_reader, bool bDisplayInformation) {
   DBuffer v_replay;
   int v_nDataSize;
-  char *v_pcData;
+  std::vector<char> v_data;
   int v_nCompressedDataSize;
-  char *v_pcCompressedData;
+  std::vector<char> v_compressedData;
 
   /* Little/big endian safety check */
-  if (XMFS::readInt_LE(pfh) != 0x12345678) {
+  if (i_reader.readInt_LE() != 0x12345678) {
     LogWarning("Sorry, the replay you're trying to open are not "
                "endian-compatible with your computer!");
     throw Exception("Unable to open the replay");
   }
 
   /* Header */
-  m_LevelID = XMFS::readString(pfh);
+  m_LevelID = i_reader.readString();
   if (bDisplayInformation) {
     printf("%-30s: %s\n", "Level Id", m_LevelID.c_str());
   }
 
-  m_PlayerName = XMFS::readString(pfh);
+  m_PlayerName = i_reader.readString();
   if (bDisplayInformation) {
     printf("%-30s: %s\n", "Player", m_PlayerName.c_str());
   }
 
-  m_fFrameRate = XMFS::readFloat_LE(pfh);
+  m_fFrameRate = i_reader.readFloat_LE();
 
-  m_nStateSize = XMFS::readInt_LE(pfh);
+  m_nStateSize = i_reader.readInt_LE();
   if (bDisplayInformation) {
     printf("%-30s: %i\n", "State size", m_nStateSize);
   }
 
-  m_bFinished = XMFS::readBool(pfh);
-  m_finishTime = GameApp::floatToTime(XMFS::readFloat_LE(pfh));
+  m_bFinished = i_reader.readBool();
+  m_finishTime = GameApp::floatToTime(i_reader.readFloat_LE());
   if (bDisplayInformation) {
     if (m_bFinished) {
       printf("%-30s: %.2f (%f)\n",
@@ -354,29 +357,23 @@ void Replay::openReplay_3(FileHandle *pfh, bool bDisplayInformation) {
   }
 
   /* zuncompressed */
-  v_nDataSize = XMFS::readInt_LE(pfh);
-  v_nCompressedDataSize = XMFS::readInt_LE(pfh);
+  v_nDataSize = i_reader.readInt_LE();
+  v_nCompressedDataSize = i_reader.readInt_LE();
 
-  v_pcData = (char *)malloc(v_nDataSize);
-  if (v_pcData == NULL) {
-    throw Exception("Unable to malloc for decompression");
-  }
-  v_pcCompressedData = (char *)malloc(v_nCompressedDataSize);
-  if (v_pcCompressedData == NULL) {
-    free(v_pcData);
-    throw Exception("Unable to malloc for decompression");
-  }
-  XMFS::readBuf(pfh, v_pcCompressedData, v_nCompressedDataSize);
-  try {
-    FileCompression::zuncompress(
-      v_pcCompressedData, v_nCompressedDataSize, v_pcData, v_nDataSize);
-  } catch (Exception &e) {
-    free(v_pcData);
-    free(v_pcCompressedData);
-    throw e;
+  if (v_nDataSize < 0 || v_nCompressedDataSize < 0 ||
+      v_nCompressedDataSize > i_reader.getLength() - i_reader.getOffset()) {
+    throw Exception("Unable to open the replay (invalid data size)");
   }
-  free(v_pcCompressedData);
-  v_replay.initInput(v_pcData, v_nDataSize);
+
+  /* the buffers are freed when an exception is thrown */
+  v_data.resize(v_nDataSize);
+  v_compressedData.resize(v_nCompressedDataSize);
+  i_reader.readBuf(v_compressedData.data(), v_nCompressedDataSize);
+  FileCompression::zuncompress(v_compressedData.data(),
+                               v_nCompressedDataSize,
+                               v_data.data(),
+                               v_nDataSize);
+  v_replay.initInput(v_data.data(), v_nDataSize);
 
   /* Events */
   v_replay >> m_nInputEventsDataSize;
@@ -396,7 +393,6 @@ void Replay::openReplay_3(FileHandle *pfh, bool bDisplayInformation) {
   if (nNumChunks == 0) {
     _FreeReplay();
     LogWarning("try to open a replay with no chunk");
-    free(v_pcData);
     throw Exception("Replay with no chunk !");
   }
 
@@ -405,7 +401,10 @@ void Replay::openReplay_3(FileHandle *pfh, bool bDisplayInformation) {
       printf("Chunk %02i\n", i);
     }
 
+    /* in the chunks before being read, to be freed with the replay */
     ReplayStateChunk *Chunk = new ReplayStateChunk();
+    Chunk->pcChunkData = NULL;
+    m_Chunks.push_back(Chunk);
     v_replay >> Chunk->nNumStates;
 
     if (bDisplayInformation) {
@@ -415,7 +414,6 @@ void Replay::openReplay_3(FileHandle *pfh, bool bDisplayInformation) {
     Chunk->pcChunkData = new char[Chunk->nNumStates * m_nStateSize];
 
     v_replay.readBuf(Chunk->pcChunkData, m_nStateSize * Chunk->nNumStates);
-    m_Chunks.push_back(Chunk);
   }
 
   /* moving blocks */
@@ -443,43 +441,42 @@ void Replay::openReplay_3(FileHandle *pfh, bool bDisplayInformation) {
         .states.push_back(s);
     }
   }
-  free(v_pcData);
 }
 
-void Replay::openReplay_1(FileHandle *pfh,
+void Replay::openReplay_1(BinaryReader &i_reader,
                           bool bDisplayInformation,
                           int nVersion) {
   /* Little/big endian safety check */
-  if (XMFS::readInt_LE(pfh) != 0x12345678) {
+  if (i_reader.readInt_LE() != 0x12345678) {
     LogWarning("Sorry, the replay you're trying to open are not "
                "endian-compatible with your computer!");
     throw Exception("Unable to open the replay");
   }
 
   /* Read level ID */
-  m_LevelID = XMFS::readString(pfh);
+  m_LevelID = i_reader.readString();
   if (bDisplayInformation) {
     printf("%-30s: %s\n", "Level Id", m_LevelID.c_str());
   }
 
   /* Read player name */
-  m_PlayerName = XMFS::readString(pfh);
+  m_PlayerName = i_reader.readString();
   if (bDisplayInformation) {
     printf("%-30s: %s\n", "Player", m_PlayerName.c_str());
   }
 
   /* Read replay frame rate */
-  m_fFrameRate = XMFS::readFloat_LE(pfh);
+  m_fFrameRate = i_reader.readFloat_LE();
 
   /* Read state size */
-  m_nStateSize = XMFS::readInt_LE(pfh);
+  m_nStateSize = i_reader.readInt_LE();
   if (bDisplayInformation) {
     printf("%-30s: %i\n", "State size", m_nStateSize);
   }
 
   /* Read finish time if any */
-  m_bFinished = XMFS::readBool(pfh);
-  m_finishTime = GameApp::floatToTime(XMFS::readFloat_LE(pfh));
+  m_bFinished = i_reader.readBool();
+  m_finishTime = GameApp::floatToTime(i_reader.readFloat_LE());
   if (bDisplayInformation) {
     if (m_bFinished) {
       printf("%-30s: %.2f (%f)\n",
@@ -494,45 +491,44 @@ void Replay::openReplay_1(FileHandle *pfh,
   /* Version 1 includes event data */
   if (nVersion == 1) {
     /* Read uncompressed size */
-    m_nInputEventsDataSize = XMFS::readInt_LE(pfh);
+    m_nInputEventsDataSize = i_reader.readInt_LE();
     if (bDisplayInformation) {
       printf("%-30s: %i\n", "Events data size", m_nInputEventsDataSize);
     }
     m_pcInputEventsData = new char[m_nInputEventsDataSize];
 
     /* Compressed? */
-    if (XMFS::readBool(pfh)) {
+    if (i_reader.readBool()) {
       /* Compressed */
-      int nCompressedEventsSize = XMFS::readInt_LE(pfh);
+      int nCompressedEventsSize = i_reader.readInt_LE();
       if (bDisplayInformation) {
         printf(
           "%-30s: %i\n", "Compressed events data size", nCompressedEventsSize);
       }
 
-      char *pcCompressedEvents = new char[nCompressedEventsSize];
-      XMFS::readBuf(pfh, pcCompressedEvents, nCompressedEventsSize);
+      if (nCompressedEventsSize < 0 ||
+          nCompressedEventsSize >
+            i_reader.getLength() - i_reader.getOffset()) {
+        throw Exception("Unable to open the replay (invalid data size)");
+      }
+      std::vector<char> pcCompressedEvents(nCompressedEventsSize);
+      i_reader.readBuf(pcCompressedEvents.data(), nCompressedEventsSize);
 
       /* Unpack */
       uLongf nDestLen = m_nInputEventsDataSize;
       uLongf nSrcLen = nCompressedEventsSize;
       int nZRet = uncompress((Bytef *)m_pcInputEventsData,
                              &nDestLen,
-                             (Bytef *)pcCompressedEvents,
+                             (Bytef *)pcCompressedEvents.data(),
                              nSrcLen);
       if (nZRet != Z_OK || nDestLen != m_nInputEventsDataSize) {
-        delete[] pcCompressedEvents;
-        delete[] m_pcInputEventsData;
-        m_pcInputEventsData = NULL;
         _FreeReplay();
         LogWarning("Failed to uncompress events in replay");
         throw Exception("Unable to open the replay");
       }
-
-      /* Clean up */
-      delete[] pcCompressedEvents;
     } else {
       /* Not compressed */
-      XMFS::readBuf(pfh, m_pcInputEventsData, m_nInputEventsDataSize);
+      i_reader.readBuf(m_pcInputEventsData, m_nInputEventsDataSize);
     }
 
     /* Set up input stream */
@@ -540,7 +536,7 @@ void Replay::openReplay_1(FileHandle *pfh,
   }
 
   /* Read chunks */
-  unsigned int nNumChunks = XMFS::readInt_LE(pfh);
+  unsigned int nNumChunks = i_reader.readInt_LE();
   if (bDisplayInformation) {
     printf("%-30s: %i\n", "Number of chunks", nNumChunks);
   }
@@ -555,8 +551,11 @@ void Replay::openReplay_1(FileHandle *pfh,
       printf("Chunk %02i\n", i);
     }
 
+    /* in the chunks before being read, to be freed with the replay */
     ReplayStateChunk *Chunk = new ReplayStateChunk();
-    Chunk->nNumStates = XMFS::readInt_LE(pfh);
+    Chunk->pcChunkData = NULL;
+    m_Chunks.push_back(Chunk);
+    Chunk->nNumStates = i_reader.readInt_LE();
 
     if (bDisplayInformation) {
       printf("   %-27s: %i\n", "Number of states", Chunk->nNumStates);
@@ -565,46 +564,45 @@ void Replay::openReplay_1(FileHandle *pfh,
     Chunk->pcChunkData = new char[Chunk->nNumStates * m_nStateSize];
 
     /* Compressed or not compressed? */
-    if (XMFS::readBool(pfh)) {
+    if (i_reader.readBool()) {
       if (bDisplayInformation) {
         printf("   %-27s: %s\n", "Compressed data", "true");
       }
 
       /* Compressed! - read compressed size */
-      int nCompressedSize = XMFS::readInt_LE(pfh);
+      int nCompressedSize = i_reader.readInt_LE();
       if (bDisplayInformation) {
         printf("   %-27s: %i\n", "Compressed states size", nCompressedSize);
       }
 
       /* Read compressed data */
-      unsigned char *pcCompressed = new unsigned char[nCompressedSize];
-      XMFS::readBuf(pfh, (char *)pcCompressed, nCompressedSize);
+      if (nCompressedSize < 0 ||
+          nCompressedSize > i_reader.getLength() - i_reader.getOffset()) {
+        throw Exception("Unable to open the replay (invalid data size)");
+      }
+      std::vector<char> pcCompressed(nCompressedSize);
+      i_reader.readBuf(pcCompressed.data(), nCompressedSize);
 
       /* Uncompress it */
       uLongf nDestLen = Chunk->nNumStates * m_nStateSize;
       uLongf nSrcLen = nCompressedSize;
-      int nZRet = uncompress(
-        (Bytef *)Chunk->pcChunkData, &nDestLen, (Bytef *)pcCompressed, nSrcLen);
+      int nZRet = uncompress((Bytef *)Chunk->pcChunkData,
+                             &nDestLen,
+                             (Bytef *)pcCompressed.data(),
+                             nSrcLen);
       if (nZRet != Z_OK || nDestLen != Chunk->nNumStates * m_nStateSize) {
-        LogWarning("Failed to uncompress chunk %d in replay");
-        delete[] pcCompressed;
-        Chunk->pcChunkData = NULL;
+        LogWarning("Failed to uncompress chunk %d in replay", i);
         _FreeReplay();
         throw Exception("Unable to open the replay");
       }
-
-      /* Clean up */
-      delete[] pcCompressed;
     } else {
       if (bDisplayInformation) {
         printf("   %-27s: %s\n", "Compressed data", "false");
       }
 
       /* Not compressed! */
-      XMFS::readBuf(pfh, Chunk->pcChunkData, m_nStateSize * Chunk->nNumStates);
+      i_reader.readBuf(Chunk->pcChunkData, m_nStateSize * Chunk->nNumStates);
     }
-
-    m_Chunks.push_back(Chunk);
   }
 }
 
@@ -612,15 +610,15 @@ std::string Replay::openReplay(const std::string &FileName,
                                std::string &Player,
                                bool bDisplayInformation) {
   /* Try opening as if it is a full path */
-  FileHandle *pfh = XMFS::openIFile(FDT_DATA, FileName, true);
-  if (pfh == NULL) {
+  BinaryReader v_reader;
+  if (v_reader.open(FDT_DATA, FileName, true) == false) {
     /* Open file for input */
-    pfh = XMFS::openIFile(FDT_DATA, std::string("Replays/") + FileName);
-    if (pfh == NULL) {
+    if (v_reader.open(FDT_DATA, std::string("Replays/") + FileName) ==
+        false) {
       /* Try adding a .rpl extension */
-      pfh = XMFS::openIFile(
-        FDT_DATA, std::string("Replays/") + FileName + std::string(".rpl"));
-      if (pfh == NULL) {
+      if (v_reader.open(FDT_DATA,
+                        std::string("Replays/") + FileName +
+                          std::string(".rpl")) == false) {
         LogWarning("Failed to open replay file for input: %s",
                    (std::string("Replays/") + FileName).c_str());
         throw Exception("Unable to open the replay");
@@ -629,7 +627,7 @@ std::string Replay::openReplay(const std::string &FileName,
   }
 
   /* Read header */
-  int nVersion = XMFS::readByte(pfh);
+  int nVersion = v_reader.readByte();
   if (bDisplayInformation) {
     printf("%-30s: %i\n", "Replay file version", nVersion);
   }
@@ -638,25 +636,14 @@ std::string Replay::openReplay(const std::string &FileName,
   switch (nVersion) {
     case 0:
     case 1:
-      try {
-        openReplay_1(pfh, bDisplayInformation, nVersion);
-      } catch (Exception &e) {
-        XMFS::closeFile(pfh);
-        throw e;
-      }
+      openReplay_1(v_reader, bDisplayInformation, nVersion);
       break;
 
     case 3:
-      try {
-        openReplay_3(pfh, bDisplayInformation);
-      } catch (Exception &e) {
-        XMFS::closeFile(pfh);
-        throw e;
-      }
+      openReplay_3(v_reader, bDisplayInformation);
       break;
 
     default:
-      XMFS::closeFile(pfh);
       LogWarning("Unsupported replay file version (%d): %s",
                  nVersion,
                  (std::string("Replays/") + FileName).c_str());
@@ -665,9 +652,6 @@ std::string Replay::openReplay(const std::string &FileName,
       break;
   }
 
-  /* Clean up */
-  XMFS::closeFile(pfh);
-
   Player = m_PlayerName;
 
   m_nCurChunk = 0;
@@ -1053,6 +1037,176 @@ ReplayInfo *Replay::getReplayInfos(const std::string p_ReplayName) {
   return pRpl;
 }
 
+#define REPLAYS_INDEX_FILE "replays.index"
+#define REPLAYS_INDEX_VERSION 1
+
+/* header of a replay file, valid while the file signature doesn't change */
+struct ReplayIndexEntry {
+  FileStatSignature signature;
+  bool isValid;
+  ReplayInfo infos;
+};
+
+struct ReplayFileInfos {
+  ReplayIndexEntry entry;
+  bool hasSignature; // the file can be indexed
+  bool fromIndex;
+};
+
+struct ReplaysInfosJob {
+  const std::vector<std::string> *names;
+  std::unordered_map<std::string, ReplayIndexEntry> index;
+  std::vector<ReplayFileInfos> files; // for each name
+};
+
+static void loadReplaysIndex(
+  std::unordered_map<std::string, ReplayIndexEntry> &o_index) {
+  BinaryReader v_reader;
+  int v_nb;
+
+  try {
+    if (v_reader.open(FDT_CACHE, REPLAYS_INDEX_FILE) == false ||
+        v_reader.readInt_LE() != REPLAYS_INDEX_VERSION) {
+      return;
+    }
+
+    v_nb = v_reader.readInt_LE();
+    for (int i = 0; i < v_nb; i++) {
+      std::string v_name = v_reader.readLongString();
+      ReplayIndexEntry &v_entry = o_index[v_name];
+
+      v_entry.signature.size = v_reader.readInt64_LE();
+      v_entry.signature.mtime = v_reader.readInt64_LE();
+      v_entry.signature.inode = v_reader.readInt64_LE();
+      v_entry.isValid = v_reader.readBool();
+      if (v_entry.isValid) {
+        v_entry.infos.Name = v_name;
+        v_entry.infos.Level = v_reader.readLongString();
+        v_entry.infos.Player = v_reader.readLongString();
+        v_entry.infos.IsFinished = v_reader.readBool();
+        v_entry.infos.finishTime = v_reader.readInt_LE();
+      }
+    }
+  } catch (Exception &e) {
+    LogWarning("Invalid replays index (%s)", e.getMsg().c_str());
+    o_index.clear();
+  }
+}
+
+static void saveReplaysIndex(const ReplaysInfosJob &i_job) {
+  FileHandle *pfh;
+  std::vector<unsigned int> v_entries;
+  long long v_now = (long long)time(NULL);
+
+  /* a file modified during the last seconds can still be modified without
+     its signature changing */
+  for (unsigned int i = 0; i < i_job.files.size(); i++) {
+    if (i_job.files[i].hasSignature &&
+        i_job.files[i].entry.signature.mtime < v_now - 1) {
+      v_entries.push_back(i);
+    }
+  }
+
+  pfh = XMFS::openOFile(FDT_CACHE, REPLAYS_INDEX_FILE);
+  if (pfh == NULL) {
+    LogWarning("Unable to save the replays index");
+    return;
+  }
+
+  try {
+    XMFS::writeInt_LE(pfh, REPLAYS_INDEX_VERSION);
+    XMFS::writeInt_LE(pfh, v_entries.size());
+    for (unsigned int i = 0; i < v_entries.size(); i++) {
+      const ReplayIndexEntry &v_entry = i_job.files[v_entries[i]].entry;
+
+      XMFS::writeLongString(pfh, (*i_job.names)[v_entries[i]]);
+      XMFS::writeInt64_LE(pfh, v_entry.signature.size);
+      XMFS::writeInt64_LE(pfh, v_entry.signature.mtime);
+      XMFS::writeInt64_LE(pfh, v_entry.signature.inode);
+      XMFS::writeBool(pfh, v_entry.isValid);
+      if (v_entry.isValid) {
+        XMFS::writeLongString(pfh, v_entry.infos.Level);
+        XMFS::writeLongString(pfh, v_entry.infos.Player);
+        XMFS::writeBool(pfh, v_entry.infos.IsFinished);
+        XMFS::writeInt_LE(pfh, v_entry.infos.finishTime);
+      }
+    }
+  } catch (Exception &e) {
+    LogWarning("Unable to save the replays index (%s)", e.getMsg().c_str());
+  }
+  XMFS::closeFile(pfh);
+}
+
+static void readReplayIndexEntry(void *i_job, unsigned int i_item) {
+  ReplaysInfosJob *v_job = (ReplaysInfosJob *)i_job;
+  const std::string &v_name = (*v_job->names)[i_item];
+  ReplayFileInfos &v_file = v_job->files[i_item];
+  ReplayIndexEntry &v_entry = v_file.entry;
+  std::unordered_map<std::string, ReplayIndexEntry>::const_iterator v_it;
+  ReplayInfo *v_infos;
+
+  if (XMFS::getFileStatSignature(
+        FDT_DATA, "Replays/" + v_name + ".rpl", v_entry.signature)) {
+    v_file.hasSignature = true;
+
+    v_it = v_job->index.find(v_name);
+    if (v_it != v_job->index.end() &&
+        v_it->second.signature.size == v_entry.signature.size &&
+        v_it->second.signature.mtime == v_entry.signature.mtime &&
+        v_it->second.signature.inode == v_entry.signature.inode) {
+      v_entry.isValid = v_it->second.isValid;
+      v_entry.infos = v_it->second.infos;
+      v_file.fromIndex = true;
+      return;
+    }
+  }
+
+  v_infos = Replay::getReplayInfos(v_name);
+  v_entry.isValid = v_infos != NULL;
+  if (v_infos != NULL) {
+    v_entry.infos = *v_infos;
+    delete v_infos;
+  }
+}
+
+void Replay::getReplaysInfos(const std::vector<std::string> &i_replayNames,
+                             std::vector<ReplayInfo *> &o_infos) {
+  ReplaysInfosJob v_job;
+  unsigned int v_nbRead = 0;
+
+  v_job.names = &i_replayNames;
+  v_job.files.resize(i_replayNames.size());
+  for (unsigned int i = 0; i < i_replayNames.size(); i++) {
+    v_job.files[i].hasSignature = false;
+    v_job.files[i].fromIndex = false;
+  }
+  loadReplaysIndex(v_job.index);
+
+  /* on the first run, or when the index is lost, all the replays are read */
+  WorkersPool::run(readReplayIndexEntry, &v_job, i_replayNames.size());
+
+  o_infos.clear();
+  for (unsigned int i = 0; i < v_job.files.size(); i++) {
+    const ReplayIndexEntry &v_entry = v_job.files[i].entry;
+
+    if (v_job.files[i].fromIndex == false) {
+      v_nbRead++;
+    }
+    if (v_entry.isValid) {
+      o_infos.push_back(new ReplayInfo(v_entry.infos));
+    } else {
+      o_infos.push_back(NULL);
+    }
+  }
+
+  if (v_nbRead > 0 || v_job.index.size() != i_replayNames.size()) {
+    LogInfo("%u replay(s) read, %u taken from the index",
+            v_nbRead,
+            (unsigned int)i_replayNames.size() - v_nbRead);
+    saveReplaysIndex(v_job);
+  }
+}
+
 void Replay::fastforward(int i_time) {
   /* How many states should we move forward? */
   int nNumStates = (int)((i_time * m_fFrameRate) / 100);
@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define STATES_PER_CHUNK 512
 
 class BikeState;
+class BinaryReader;
 class PhysicsSettings;
 
 /*===========================================================================
@@ -145,6 +146,11 @@ public:
 
   /* return NULL if the replay is not valid */
   static ReplayInfo *getReplayInfos(const std::string p_ReplayName);
+  /* infos of several replays, read in parallel ; the infos of the replays
+     unchanged since the last call are taken from an index kept in the cache
+     directory. o_infos[i] is NULL if the replay is not valid */
+  static void getReplaysInfos(const std::vector<std::string> &i_replayNames,
+                              std::vector<ReplayInfo *> &o_infos);
 
   void saveReplayIfNot(int i_format);
 
@@ -180,8 +186,10 @@ private:
   void saveReplay_1(FileHandle *pfh);
   void saveReplay_3(FileHandle *pfh);
 
-  void openReplay_1(FileHandle *pfh, bool bDisplayInformation, int nVersion);
-  void openReplay_3(FileHandle *pfh, bool bDisplayInformation);
+  void openReplay_1(BinaryReader &i_reader,
+                    bool bDisplayInformation,
+                    int nVersion);
+  void openReplay_3(BinaryReader &i_reader, bool bDisplayInformation);
 
   /* moving blocks (physics) */
   std::vector<rmblock> m_movingBlocksForSaving;
@@ -19,9 +19,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 =============================================================================*/
 
 #include "BikeGhost.h"
+#include "BikeStateBuffer.h"
 #include "Level.h"
 #include "common/Theme.h"
 #include "helpers/Text.h"
+#include "xmoto/Game.h"
 #include "xmoto/GameEvents.h"
 #include "xmoto/GameText.h"
 #include "xmoto/Replay.h"
@@ -467,12 +469,44 @@ NetGhost::NetGhost(PhysicsSettings *i_physicsSettings,
           i_theme,
           i_bikerTheme,
           i_colorFilter,
-          i_uglyColorFilter) {}
+          i_uglyColorFilter) {
+  m_bikeStateForUpdate = new BikeState(i_physicsSettings);
+  m_statesBuffer = new BikeStateBuffer(i_physicsSettings);
+  m_isStateInitialized = false;
+}
 
-NetGhost::~NetGhost() {}
+NetGhost::~NetGhost() {
+  delete m_bikeStateForUpdate;
+  delete m_statesBuffer;
+}
 
 void NetGhost::updateDiffToPlayer(std::vector<float> &i_lastToTakeEntities) {}
 
+void NetGhost::updateToTime(int i_time,
+                            int i_timeStep,
+                            CollisionSystem *i_collisionSystem,
+                            Vector2f i_gravity,
+                            Scene *i_motogame) {
+  Ghost::updateToTime(
+    i_time, i_timeStep, i_collisionSystem, i_gravity, i_motogame);
+
+  if (m_statesBuffer->getState(GameApp::getXMTimeInt(), m_bikeState)) {
+    m_isStateInitialized = true;
+  }
+}
+
+BikeState *NetGhost::getStateForUpdate() {
+  return m_bikeStateForUpdate;
+}
+
+void NetGhost::stateAfterExternalUpdated() {
+  m_statesBuffer->addState(*m_bikeStateForUpdate, GameApp::getXMTimeInt());
+}
+
+bool NetGhost::isStateInitialized() const {
+  return m_isStateInitialized;
+}
+
 std::string NetGhost::getVeryQuickDescription() const {
   return m_info;
 }
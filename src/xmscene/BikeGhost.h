@@ -23,6 +23,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "Bike.h"
 
+class BikeStateBuffer;
+
 class Ghost : public Biker {
 public:
   Ghost(PhysicsSettings *i_physicsSettings,
@@ -129,6 +131,14 @@ public:
 
   virtual bool diffToPlayerAvailable() const { return false; };
   virtual void updateDiffToPlayer(std::vector<float> &i_lastToTakeEntities);
+  virtual void updateToTime(int i_time,
+                            int i_timeStep,
+                            CollisionSystem *i_collisionSystem,
+                            Vector2f i_gravity,
+                            Scene *i_motogame);
+  virtual BikeState *getStateForUpdate();
+  virtual void stateAfterExternalUpdated();
+  virtual bool isStateInitialized() const;
   virtual bool isNetGhost() const { return true; };
   std::string getDescription() const;
   std::string getQuickDescription() const;
@@ -139,5 +149,9 @@ public:
   double getAngle();
 
 private:
+  /* received states */
+  BikeState *m_bikeStateForUpdate;
+  BikeStateBuffer *m_statesBuffer;
+  bool m_isStateInitialized;
 };
 #endif
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "BikeAnchors.h"
 #include "BikeController.h"
 #include "BikeParameters.h"
+#include "BikeStateBuffer.h"
 #include "PhysicsSettings.h"
 #include "Scene.h"
 #include "Zone.h"
@@ -36,7 +37,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 // autodisabler options
 #define PHYS_SLEEP_EPS 0.02 // 2006-04-23: changed from 0.008
 #define PHYS_SLEEP_FRAMES 20 // 150
-#define XM_MAX_EXTRAPOLATION_T 3.0
 
 #define PHYS_SUSP_SQUEEK_POINT 0.01
 
@@ -1665,26 +1665,15 @@ PlayerNetClient::PlayerNetClient(PhysicsSettings *i_physicsSettings,
   m_BikeC = new BikeControllerNet(0);
   initToPosition(i_position, i_direction, i_gravity);
 
-  m_previousBikeStatesInitialized = false;
-  m_previousBikeStates.push_back(new BikeState(i_physicsSettings));
-  m_previousBikeStates.push_back(new BikeState(i_physicsSettings));
-
   m_bikeStateForUpdate = new BikeState(m_physicsSettings);
-  m_stateExternallyUpdated = false;
+  m_statesBuffer = new BikeStateBuffer(m_physicsSettings);
   m_isStateInitialized = false;
-  m_lastExtrapolateBikeState = new BikeState(i_physicsSettings);
-  m_lastFrameTimeUpdate = 0;
 }
 
 PlayerNetClient::~PlayerNetClient() {
   delete m_BikeC;
-
-  for (unsigned int i = 0; i < m_previousBikeStates.size(); i++) {
-    delete m_previousBikeStates[i];
-  }
-
   delete m_bikeStateForUpdate;
-  delete m_lastExtrapolateBikeState;
+  delete m_statesBuffer;
 }
 
 bool PlayerNetClient::getRenderBikeFront() {
@@ -1740,127 +1729,24 @@ void PlayerNetClient::updateToTime(int i_time,
                                    CollisionSystem *i_collisionSystem,
                                    Vector2f i_gravity,
                                    Scene *i_motogame) {
-  float v_xpolation_value;
-  BikeState *v_tmp;
   Biker::updateToTime(
     i_time, i_timeStep, i_collisionSystem, i_gravity, i_motogame);
-  bool v_hasBeenExternallyUpdated = m_stateExternallyUpdated;
-
-  if (m_stateExternallyUpdated) {
-    m_stateExternallyUpdated = false;
-
-    // update states
-    *m_lastExtrapolateBikeState = *m_bikeState;
-    m_lastFrameTimeUpdate = GameApp::getXMTimeInt();
 
-    /* update previous states */
-    if (m_previousBikeStatesInitialized == false) {
-      *(m_previousBikeStates[0]) = *m_bikeStateForUpdate;
-      *(m_previousBikeStates[1]) = *m_bikeStateForUpdate;
-      *m_lastExtrapolateBikeState = *m_bikeStateForUpdate;
-      m_previousBikeStatesInitialized = true;
-    } else {
-      v_tmp = m_previousBikeStates[0];
-      m_previousBikeStates[0] = m_previousBikeStates[1];
-      m_previousBikeStates[1] = v_tmp;
-      *(m_previousBikeStates[1]) = *m_bikeStateForUpdate;
-    }
-  }
-
-  /* extrapolate frames */
-  if (m_previousBikeStatesInitialized == false) {
-    return;
+  /* display the state received from the server, delayed and interpolated by
+     the buffer to hide the network jitter */
+  if (m_statesBuffer->getState(GameApp::getXMTimeInt(), m_bikeState)) {
+    m_isStateInitialized = true;
   }
-
-  /* second version
-     objectiv : remove brutal frameX to frameX+1 change (at the end of
-  extrapolation in version 1)
-
-               F1 received               F2 received                  F3
-  received
-                    |                         |                           |
-                    AAABBBBBBBBBBBBBBBBBBBBBBBAAABBBBBBBBBBBBBBBBBBBBBBBBAAABBBBBB
-                                                 -
-                                             first B = F2
-
-  A: desextrapolate from last B extrapolation to Fx
-  B: extrapolate
-
-     In case of F3 happend while F2(AAA) :
-
-     F2        F3
-      |         |
-      AAAAAAAAAAAAAABBBB
-                 -> start to desinterpolate for last A to F3
-                    -
-                  first B = F3
-  */
-
-  /* it seems to give good result to desinterpolate 50% of the time of the two
-     last frames :
-     if fps = 1 => desinterpolate for 0,5 seconds (very bad case)
-     if fps = 10 => desinterpolate for 0,05 seconds (ok)
-  */
-
-  int v_deextrapolation_time =
-    (m_previousBikeStates[1]->GameTime -
-     m_previousBikeStates[0]
-       ->GameTime) /* / 2 -- without /2 it seems to give better results */;
-
-  if (m_previousBikeStatesInitialized &&
-      m_lastFrameTimeUpdate + (v_deextrapolation_time * 10) >
-        GameApp::getXMTimeInt()) {
-    // A
-    if (m_lastExtrapolateBikeState->Dir != m_previousBikeStates[1]->Dir ||
-        v_hasBeenExternallyUpdated ||
-        true // the inter/extra polation seems not to work correctly -- disabled
-        ) {
-      *m_bikeState = *(m_previousBikeStates[1]);
-    } else {
-      // interpolate from m_lastExtrapolateBikeState to m_previousBikeStates[1]
-      v_xpolation_value = (GameApp::getXMTimeInt() - m_lastFrameTimeUpdate) /
-                          ((float)(v_deextrapolation_time * 10));
-      v_tmp = m_previousBikeStates[0];
-      m_previousBikeStates[0] = m_lastExtrapolateBikeState;
-      BikeState::interpolateGameStateLinear(
-        m_previousBikeStates, m_bikeState, v_xpolation_value);
-      m_previousBikeStates[0] = v_tmp;
-    }
-  } else {
-    /// B
-    if (m_previousBikeStates[0]->Dir != m_previousBikeStates[1]->Dir ||
-        v_hasBeenExternallyUpdated ||
-        true // the inter/extra polation seems not to work correctly -- disabled
-        ) {
-      *m_bikeState = *(m_previousBikeStates[1]);
-    } else {
-      if (m_previousBikeStates[1]->GameTime >
-          m_previousBikeStates[0]->GameTime) {
-        v_xpolation_value = (((i_time - v_deextrapolation_time) -
-                              m_previousBikeStates[1]->GameTime) /
-                             ((float)(m_previousBikeStates[1]->GameTime -
-                                      m_previousBikeStates[0]->GameTime))) +
-                            1.0;
-
-        if (v_xpolation_value < XM_MAX_EXTRAPOLATION_T) {
-          BikeState::interpolateGameStateLinear(
-            m_previousBikeStates, m_bikeState, v_xpolation_value);
-        }
-      } else {
-        // cannot extrapolate
-        *m_bikeState = *(m_previousBikeStates[1]);
-      }
-    }
-  }
-
-  m_isStateInitialized = true;
 }
 
 BikeState *PlayerNetClient::getStateForUpdate() {
-  m_stateExternallyUpdated = true;
   return m_bikeStateForUpdate;
 }
 
+void PlayerNetClient::stateAfterExternalUpdated() {
+  m_statesBuffer->addState(*m_bikeStateForUpdate, GameApp::getXMTimeInt());
+}
+
 bool PlayerNetClient::isStateInitialized() const {
   return m_isStateInitialized;
 }
@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 class BikeController;
 class BikeControllerNet;
 class BikeControllerPlayer;
+class BikeStateBuffer;
 
 class ExternalForce {
 public:
@@ -233,6 +234,7 @@ public:
                             Vector2f i_gravity,
                             Scene *i_motogame);
   virtual BikeState *getStateForUpdate();
+  virtual void stateAfterExternalUpdated();
   virtual bool isStateInitialized() const;
 
   virtual void setLocalNetId(int i_value);
@@ -244,13 +246,9 @@ public:
 private:
   BikeControllerNet *m_BikeC;
 
-  /* previous states */
+  /* received states */
   BikeState *m_bikeStateForUpdate;
-  bool m_stateExternallyUpdated;
-  bool m_previousBikeStatesInitialized;
-  std::vector<BikeState *> m_previousBikeStates;
-  BikeState *m_lastExtrapolateBikeState;
-  int m_lastFrameTimeUpdate;
+  BikeStateBuffer *m_statesBuffer;
 
   bool m_isStateInitialized;
 };
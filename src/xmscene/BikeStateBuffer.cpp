@@ -0,0 +1,192 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#include "BikeStateBuffer.h"
+#include "Bike.h"
+
+#define XM_BSB_SIZE 8 // number of states kept
+#define XM_BSB_DELAY_FACTOR 1.5 // playback delay, in received intervals
+#define XM_BSB_MIN_DELAY 2.0 // 1/100s
+#define XM_BSB_MAX_DELAY 30.0 // 1/100s
+#define XM_BSB_MAX_EXTRAPOLATION_TIME 25.0 // 1/100s
+#define XM_BSB_MAX_INTERPOLATION_TIME 50 // 1/100s
+#define XM_BSB_MAX_INTERPOLATION_SPACE 5.0
+#define XM_BSB_RESYNC_TIME 100.0 // 1/100s
+#define XM_BSB_OFFSET_DRIFT 0.02
+
+BikeStateBuffer::BikeStateBuffer(PhysicsSettings *i_physicsSettings) {
+  for (unsigned int i = 0; i < XM_BSB_SIZE; i++) {
+    m_freeStates.push_back(new BikeState(i_physicsSettings));
+  }
+  m_xpolationStates.push_back(NULL);
+  m_xpolationStates.push_back(NULL);
+
+  m_clockOffsetInitialized = false;
+  m_clockOffset = 0.0;
+  m_meanInterval = 0.0;
+}
+
+BikeStateBuffer::~BikeStateBuffer() {
+  for (unsigned int i = 0; i < m_states.size(); i++) {
+    delete m_states[i];
+  }
+  for (unsigned int i = 0; i < m_freeStates.size(); i++) {
+    delete m_freeStates[i];
+  }
+}
+
+void BikeStateBuffer::clear() {
+  for (unsigned int i = 0; i < m_states.size(); i++) {
+    m_freeStates.push_back(m_states[i]);
+  }
+  m_states.clear();
+
+  m_clockOffsetInitialized = false;
+  m_clockOffset = 0.0;
+  m_meanInterval = 0.0;
+}
+
+bool BikeStateBuffer::isEmpty() const {
+  return m_states.empty();
+}
+
+void BikeStateBuffer::recycleOldest() {
+  m_freeStates.push_back(m_states[0]);
+  m_states.erase(m_states.begin());
+}
+
+void BikeStateBuffer::updateClockOffset(float i_sample) {
+  /* the state which traveled the fastest gives the best offset ; drift slowly
+     toward later samples to follow the latency when it increases */
+  if (m_clockOffsetInitialized == false || i_sample < m_clockOffset) {
+    m_clockOffset = i_sample;
+    m_clockOffsetInitialized = true;
+  } else {
+    m_clockOffset += (i_sample - m_clockOffset) * XM_BSB_OFFSET_DRIFT;
+  }
+}
+
+void BikeStateBuffer::addState(const BikeState &i_state, int i_localTime) {
+  float v_sample = i_localTime / 10.0 - i_state.GameTime;
+  BikeState *v_state;
+  unsigned int v_pos;
+
+  /* the sender restarted its level or was paused : forget the past */
+  if (m_states.empty() == false) {
+    if (v_sample - m_clockOffset > XM_BSB_RESYNC_TIME ||
+        m_clockOffset - v_sample > XM_BSB_RESYNC_TIME) {
+      clear();
+    }
+  }
+
+  if (m_states.empty() == false) {
+    /* too late */
+    if (m_states.size() == XM_BSB_SIZE &&
+        i_state.GameTime <= m_states[0]->GameTime) {
+      return;
+    }
+
+    /* already received (udp duplicate) */
+    for (unsigned int i = 0; i < m_states.size(); i++) {
+      if (m_states[i]->GameTime == i_state.GameTime) {
+        return;
+      }
+    }
+
+    if (i_state.GameTime > m_states[m_states.size() - 1]->GameTime) {
+      int v_interval =
+        i_state.GameTime - m_states[m_states.size() - 1]->GameTime;
+      if (m_meanInterval <= 0.0) {
+        m_meanInterval = v_interval;
+      } else {
+        m_meanInterval = m_meanInterval * 0.9 + v_interval * 0.1;
+      }
+    }
+  }
+
+  updateClockOffset(v_sample);
+
+  if (m_freeStates.empty()) {
+    recycleOldest();
+  }
+  v_state = m_freeStates[m_freeStates.size() - 1];
+  m_freeStates.pop_back();
+  *v_state = i_state;
+
+  /* packets can come unordered in udp */
+  v_pos = m_states.size();
+  while (v_pos > 0 && m_states[v_pos - 1]->GameTime > v_state->GameTime) {
+    v_pos--;
+  }
+  m_states.insert(m_states.begin() + v_pos, v_state);
+}
+
+bool BikeStateBuffer::getState(int i_localTime, BikeState *o_state) {
+  BikeState *pA, *pB;
+  float v_delay, v_time, v_t;
+
+  if (m_states.empty()) {
+    return false;
+  }
+
+  v_delay = m_meanInterval * XM_BSB_DELAY_FACTOR;
+  if (v_delay < XM_BSB_MIN_DELAY) {
+    v_delay = XM_BSB_MIN_DELAY;
+  }
+  if (v_delay > XM_BSB_MAX_DELAY) {
+    v_delay = XM_BSB_MAX_DELAY;
+  }
+
+  /* time of the sender to display */
+  v_time = i_localTime / 10.0 - m_clockOffset - v_delay;
+
+  /* keep only the state just before the displayed time and the next ones */
+  while (m_states.size() > 2 && m_states[1]->GameTime <= v_time) {
+    recycleOldest();
+  }
+
+  if (m_states.size() == 1 || v_time <= m_states[0]->GameTime) {
+    *o_state = *(m_states[0]);
+    return true;
+  }
+
+  pA = m_states[0];
+  pB = m_states[1];
+
+  /* when v_time is after pB, that's an extrapolation (no more state) */
+  if (v_time > pB->GameTime + XM_BSB_MAX_EXTRAPOLATION_TIME) {
+    v_time = pB->GameTime + XM_BSB_MAX_EXTRAPOLATION_TIME;
+  }
+  v_t = (v_time - pA->GameTime) / ((float)(pB->GameTime - pA->GameTime));
+
+  /* teleportation, direction change, ... don't try to guess */
+  if (pA->Dir != pB->Dir ||
+      pB->GameTime - pA->GameTime > XM_BSB_MAX_INTERPOLATION_TIME ||
+      (pB->CenterP - pA->CenterP).length() > XM_BSB_MAX_INTERPOLATION_SPACE) {
+    *o_state = v_t < 1.0 ? *pA : *pB;
+    return true;
+  }
+
+  m_xpolationStates[0] = pA;
+  m_xpolationStates[1] = pB;
+  BikeState::interpolateGameStateLinear(m_xpolationStates, o_state, v_t);
+
+  return true;
+}
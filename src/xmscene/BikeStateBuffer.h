@@ -0,0 +1,70 @@
+/*=============================================================================
+XMOTO
+
+This file is part of XMOTO.
+
+XMOTO is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+XMOTO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with XMOTO; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#ifndef __BIKESTATEBUFFER_H__
+#define __BIKESTATEBUFFER_H__
+
+#include <vector>
+
+class BikeState;
+class PhysicsSettings;
+
+/*
+  Jitter buffer for the bike states received from the network.
+
+  States are played back a bit late (about 1.5 times the interval between two
+  received frames), so that the two states surrounding the displayed time are
+  usually known and can be interpolated. When the buffer runs dry (packet
+  loss, late packet), the motion is extrapolated from the two last states for
+  a short time, then frozen until a new state comes.
+
+  Times given to the buffer are local times (GameApp::getXMTimeInt()) ; the
+  GameTime of the states are the times of the sender, the offset between both
+  clocks is estimated from the received states.
+*/
+class BikeStateBuffer {
+public:
+  BikeStateBuffer(PhysicsSettings *i_physicsSettings);
+  ~BikeStateBuffer();
+
+  /* store a copy of i_state, received at the local time i_localTime */
+  void addState(const BikeState &i_state, int i_localTime);
+
+  /* compute the state to display at the local time i_localTime ; return false
+   * if no state has been received yet */
+  bool getState(int i_localTime, BikeState *o_state);
+
+  void clear();
+  bool isEmpty() const;
+
+private:
+  void recycleOldest();
+  void updateClockOffset(float i_sample);
+
+  std::vector<BikeState *> m_states; /* sorted by GameTime */
+  std::vector<BikeState *> m_freeStates;
+  std::vector<BikeState *> m_xpolationStates; /* 2 states for interpolation */
+
+  bool m_clockOffsetInitialized;
+  float m_clockOffset; /* local time (1/100s) - sender GameTime */
+  float m_meanInterval; /* mean time between two received states (1/100s) */
+};
+
+#endif
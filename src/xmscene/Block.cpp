@@ -21,9 +21,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Block.h"
 #include "ChipmunkWorld.h"
 #include "PhysicsSettings.h"
+#include "common/BinaryReader.h"
 #include "common/Theme.h"
 #include "common/VFileIO.h"
-#include "common/VXml.h"
+#include "common/VXmlLight.h"
 #include "helpers/Log.h"
 #include "xmoto/BSP.h"
 #include "xmoto/Collision.h"
@@ -115,6 +116,8 @@ Block::Block(std::string i_id) {
   // colors if no edge material is
   // added
   m_sprite = NULL;
+  m_BSPComputed = false;
+  m_BSPErrors = 0;
 
   m_previousSavedPosition = DynamicPosition();
   m_previousSavedRotation = DynamicRotation();
@@ -142,6 +145,8 @@ Block::~Block() {
   }
   m_convexBlocks.clear();
 
+  clearBSP();
+
   /* delete collision lines */
   for (unsigned int i = 0; i < m_collisionLines.size(); i++) {
     delete m_collisionLines[i];
@@ -331,10 +336,12 @@ int Block::loadToPlay(CollisionSystem *io_collisionSystem,
   float tx = 0;
   float ty = 0;
 
-  /* Do the "convexifying" the BSP-way. It might be overkill, but we'll
-     probably appreciate it when the input data is very complex. It'll also
-     let us handle crossing edges, and other kinds of weird input. */
-  BSP v_BSPTree;
+  /* the polygons come from the level cache when it has them ; they must be
+     computed before the physics blocks are moved around their center */
+  if (i_loadBSP && m_BSPComputed == false) {
+    computeBSP();
+  }
+
   cpBody *myBody = NULL;
   cpVect *myVerts = NULL;
 
@@ -397,11 +404,6 @@ int Block::loadToPlay(CollisionSystem *io_collisionSystem,
       // collect vertice count to find middle
       tx += Vertices()[i]->Position().x;
       ty += Vertices()[i]->Position().y;
-    } else {
-      if (i_loadBSP) {
-        v_BSPTree.addLineDefinition(Vertices()[i]->Position(),
-                                    Vertices()[inext]->Position());
-      }
     }
   }
 
@@ -417,19 +419,6 @@ int Block::loadToPlay(CollisionSystem *io_collisionSystem,
                                           Vertices()[i]->Position().y - mdy));
     }
 
-    // then BSP-ify them
-    if (i_loadBSP) {
-      for (unsigned int i = 0; i < Vertices().size(); i++) {
-        unsigned int inext = i + 1;
-        if (inext == Vertices().size())
-          inext = 0;
-
-        /* Add line to BSP generator */
-        v_BSPTree.addLineDefinition(Vertices()[i]->Position(),
-                                    Vertices()[inext]->Position());
-      }
-    }
-
     // modify the object coords with the midpoint
     m_dynamicPosition.x += mdx;
     m_dynamicPosition.y += mdy;
@@ -456,12 +445,7 @@ int Block::loadToPlay(CollisionSystem *io_collisionSystem,
   //  layer.");
   //}
 
-  /* Compute */
-  std::vector<BSPPoly *> *v_BSPPolys;
-
-  if (i_loadBSP) {
-    v_BSPPolys = v_BSPTree.compute();
-  }
+  std::vector<BSPPoly *> *v_BSPPolys = &m_BSPPolys;
 
   float scale;
 
@@ -583,15 +567,84 @@ int Block::loadToPlay(CollisionSystem *io_collisionSystem,
   updateCollisionLines(true);
 
   if (i_loadBSP) {
-    if (v_BSPTree.getNumErrors() > 0) {
+    if (m_BSPErrors > 0) {
       LogError("Error due to the block %s", Id().c_str());
     }
-    return v_BSPTree.getNumErrors();
+    return m_BSPErrors;
   } else {
     return 0;
   }
 }
 
+int Block::computeBSP() {
+  return computeBSP(BSP_MAX_SPLITTERS);
+}
+
+int Block::computeBSP(unsigned int i_maxSplitters) {
+  /* Do the "convexifying" the BSP-way. It might be overkill, but we'll
+     probably appreciate it when the input data is very complex. It'll also
+     let us handle crossing edges, and other kinds of weird input. */
+  BSP v_BSPTree(i_maxSplitters);
+  float mdx = 0.0;
+  float mdy = 0.0;
+
+  clearBSP();
+
+  // physics blocks are played around the middle of their vertices (see
+  // loadToPlay()) ; compute it the same way
+  if (isPhysics()) {
+    float tx = 0;
+    float ty = 0;
+
+    for (unsigned int i = 0; i < Vertices().size(); i++) {
+      tx += Vertices()[i]->Position().x;
+      ty += Vertices()[i]->Position().y;
+    }
+    mdx = tx / Vertices().size();
+    mdy = ty / Vertices().size();
+  }
+
+  for (unsigned int i = 0; i < Vertices().size(); i++) {
+    unsigned int inext = i + 1;
+    if (inext == Vertices().size())
+      inext = 0;
+
+    /* Add line to BSP generator */
+    v_BSPTree.addLineDefinition(
+      Vector2f(Vertices()[i]->Position().x - mdx,
+               Vertices()[i]->Position().y - mdy),
+      Vector2f(Vertices()[inext]->Position().x - mdx,
+               Vertices()[inext]->Position().y - mdy));
+  }
+
+  /* Compute */
+  std::vector<BSPPoly *> *v_BSPPolys = v_BSPTree.compute();
+
+  /* some splitters can lead to degenerated splits which trying all of them
+     avoids */
+  if (v_BSPTree.getNumErrors() > 0 && i_maxSplitters != 0) {
+    return computeBSP(0);
+  }
+
+  m_BSPPolys.reserve(v_BSPPolys->size());
+  for (unsigned int i = 0; i < v_BSPPolys->size(); i++) {
+    m_BSPPolys.push_back(new BSPPoly(*(*v_BSPPolys)[i]));
+  }
+  m_BSPErrors = v_BSPTree.getNumErrors();
+  m_BSPComputed = true;
+
+  return m_BSPErrors;
+}
+
+void Block::clearBSP() {
+  for (unsigned int i = 0; i < m_BSPPolys.size(); i++) {
+    delete m_BSPPolys[i];
+  }
+  m_BSPPolys.clear();
+  m_BSPComputed = false;
+  m_BSPErrors = 0;
+}
+
 void Block::addPoly(BSPPoly *i_poly,
                     CollisionSystem *io_collisionSystem,
                     float scale) {
@@ -767,54 +820,60 @@ void BlockVertex::setColor(const TColor &i_color) {
   m_color = i_color;
 }
 
-bool Block::isPhysics_readFromXml(xmlNodePtr pElem) {
-  xmlNodePtr pPositionElem = XMLDocument::subElement(pElem, "position");
+bool Block::isPhysics_readFromXml(const XMLLightNode *pElem) {
+  const XMLLightNode *pPositionElem =
+    XMLLightDocument::subElement(pElem, "position");
 
   if (pPositionElem == NULL) {
     return false;
   }
 
-  return XMLDocument::getOption(pPositionElem, "physics", "false") == "true";
+  return XMLLightDocument::getOption(pPositionElem, "physics", "false") ==
+         "true";
 }
 
-Block *Block::readFromXml(xmlNodePtr pElem, bool i_loadMainLayerOnly) {
-  xmlNodePtr pPositionElem = XMLDocument::subElement(pElem, "position");
+Block *Block::readFromXml(const XMLLightNode *pElem, bool i_loadMainLayerOnly) {
+  const XMLLightNode *pPositionElem =
+    XMLLightDocument::subElement(pElem, "position");
   //
   if (i_loadMainLayerOnly) {
-    if (atoi(XMLDocument::getOption(pPositionElem, "layerid", "-1").c_str()) !=
-        -1) { // -1 is for the main layer
+    if (atoi(XMLLightDocument::getOption(pPositionElem, "layerid", "-1")
+               .c_str()) != -1) { // -1 is for the main layer
       return NULL;
     }
   }
 
-  xmlNodePtr pUseTextureElem = XMLDocument::subElement(pElem, "usetexture");
-  xmlNodePtr pPhysicsElem = XMLDocument::subElement(pElem, "physics");
-  xmlNodePtr pEdgeElem = XMLDocument::subElement(pElem, "edges");
-  xmlNodePtr pColElem = XMLDocument::subElement(pElem, "collision");
+  const XMLLightNode *pUseTextureElem =
+    XMLLightDocument::subElement(pElem, "usetexture");
+  const XMLLightNode *pPhysicsElem =
+    XMLLightDocument::subElement(pElem, "physics");
+  const XMLLightNode *pEdgeElem = XMLLightDocument::subElement(pElem, "edges");
+  const XMLLightNode *pColElem =
+    XMLLightDocument::subElement(pElem, "collision");
 
-  Block *pBlock = new Block(XMLDocument::getOption(pElem, "id"));
+  Block *pBlock = new Block(XMLLightDocument::getOption(pElem, "id"));
   pBlock->setTexture("default");
 
   if (pUseTextureElem != NULL) {
     pBlock->setTexture(
-      XMLDocument::getOption(pUseTextureElem, "id", "default"));
+      XMLLightDocument::getOption(pUseTextureElem, "id", "default"));
     pBlock->setTextureScale(
-      atof(XMLDocument::getOption(pUseTextureElem, "scale", "1").c_str()));
+      atof(XMLLightDocument::getOption(pUseTextureElem, "scale", "1").c_str()));
 
     /* Color blending for blocks */
     int blendColor_r = 255, blendColor_g = 255, blendColor_b = 255,
         blendColor_a = 255;
     std::string v_blendColor =
-      XMLDocument::getOption(pUseTextureElem, "color_r");
+      XMLLightDocument::getOption(pUseTextureElem, "color_r");
     if (v_blendColor != "")
       blendColor_r = atoi(v_blendColor.c_str());
-    v_blendColor = XMLDocument::getOption(pUseTextureElem, "color_g");
+    v_blendColor = XMLLightDocument::getOption(pUseTextureElem, "color_g");
     if (v_blendColor != "")
       blendColor_g = atoi(v_blendColor.c_str());
-    v_blendColor = XMLDocument::getOption(pUseTextureElem, "color_b");
+    v_blendColor = XMLLightDocument::getOption(pUseTextureElem, "color_b");
     if (v_blendColor != "")
       blendColor_b = atoi(v_blendColor.c_str());
-    v_blendColor = XMLDocument::getOption(pUseTextureElem, "color_a");
+    v_blendColor = XMLLightDocument::getOption(pUseTextureElem, "color_a");
     if (v_blendColor != "")
       blendColor_a = atoi(v_blendColor.c_str());
     pBlock->setBlendColor(
@@ -823,30 +882,32 @@ Block *Block::readFromXml(xmlNodePtr pElem, bool i_loadMainLayerOnly) {
 
   if (pPositionElem != NULL) {
     pBlock->setInitialPosition(
-      Vector2f(atof(XMLDocument::getOption(pPositionElem, "x", "0").c_str()),
-               atof(XMLDocument::getOption(pPositionElem, "y", "0").c_str())));
+      Vector2f(
+        atof(XMLLightDocument::getOption(pPositionElem, "x", "0").c_str()),
+        atof(XMLLightDocument::getOption(pPositionElem, "y", "0").c_str())));
 
-    pBlock->setBackground(
-      XMLDocument::getOption(pPositionElem, "background", "false") == "true");
+    pBlock->setBackground(XMLLightDocument::getOption(
+                            pPositionElem, "background", "false") == "true");
     pBlock->setDynamic(
-      XMLDocument::getOption(pPositionElem, "dynamic", "false") == "true");
+      XMLLightDocument::getOption(pPositionElem, "dynamic", "false") == "true");
     /* setDynamic must be done before setPhysics - physics implies dynamic */
     pBlock->setPhysics(
-      XMLDocument::getOption(pPositionElem, "physics", "false") == "true");
+      XMLLightDocument::getOption(pPositionElem, "physics", "false") == "true");
     pBlock->setIsLayer(
-      XMLDocument::getOption(pPositionElem, "islayer", "false") == "true");
+      XMLLightDocument::getOption(pPositionElem, "islayer", "false") == "true");
     pBlock->setLayer(
-      atoi(XMLDocument::getOption(pPositionElem, "layerid", "-1").c_str()));
+      atoi(XMLLightDocument::getOption(pPositionElem, "layerid", "-1")
+             .c_str()));
   }
 
   if (pPhysicsElem != NULL) {
     char str[16];
 
     pBlock->setGripPer20(
-      atof(XMLDocument::getOption(pPhysicsElem, "grip", "20.0").c_str()));
+      atof(XMLLightDocument::getOption(pPhysicsElem, "grip", "20.0").c_str()));
 
     snprintf(str, 16, "%f", XM_DEFAULT_PHYS_BLOCK_MASS);
-    std::string mass = XMLDocument::getOption(pPhysicsElem, "mass", str);
+    std::string mass = XMLLightDocument::getOption(pPhysicsElem, "mass", str);
     if (mass == "INFINITY") {
       // Chipmunk's INFINITY is too big (make blocks disapear), so put a big
       // value instead
@@ -857,11 +918,12 @@ Block *Block::readFromXml(xmlNodePtr pElem, bool i_loadMainLayerOnly) {
 
     snprintf(str, 16, "%f", XM_DEFAULT_PHYS_BLOCK_FRICTION);
     pBlock->setFriction(
-      atof(XMLDocument::getOption(pPhysicsElem, "friction", str).c_str()));
+      atof(XMLLightDocument::getOption(pPhysicsElem, "friction", str).c_str()));
 
     snprintf(str, 16, "%f", XM_DEFAULT_PHYS_BLOCK_ELASTICITY);
     pBlock->setElasticity(
-      atof(XMLDocument::getOption(pPhysicsElem, "elasticity", str).c_str()));
+      atof(XMLLightDocument::getOption(pPhysicsElem, "elasticity", str)
+             .c_str()));
   } else {
     pBlock->setGripPer20(20.0);
     pBlock->setMass(XM_DEFAULT_PHYS_BLOCK_MASS);
@@ -872,36 +934,39 @@ Block *Block::readFromXml(xmlNodePtr pElem, bool i_loadMainLayerOnly) {
   if (pEdgeElem != NULL) {
     // angle is the default one
     std::string methodStr =
-      XMLDocument::getOption(pEdgeElem, "drawmethod", "angle");
+      XMLLightDocument::getOption(pEdgeElem, "drawmethod", "angle");
     pBlock->setEdgeDrawMethod(pBlock->stringToEdge(methodStr));
     // 270 is the default one for the 'angle' edge draw method, not used for the
     // others
     pBlock->setEdgeAngle(
-      atof(XMLDocument::getOption(pEdgeElem, "angle", "270.0").c_str()));
+      atof(XMLLightDocument::getOption(pEdgeElem, "angle", "270.0").c_str()));
 
     // check for geoms assignments: blendColor, depth and scale
-    for (xmlNodePtr pSubElem = XMLDocument::subElement(pEdgeElem, "material");
+    for (const XMLLightNode *pSubElem =
+           XMLLightDocument::subElement(pEdgeElem, "material");
          pSubElem != NULL;
-         pSubElem = XMLDocument::nextElement(pSubElem)) {
+         pSubElem = XMLLightDocument::nextElement(pSubElem)) {
       std::string v_materialName =
-        XMLDocument::getOption(pSubElem, "name", "not_used").c_str();
+        XMLLightDocument::getOption(pSubElem, "name", "not_used").c_str();
       std::string v_materialTexture =
-        XMLDocument::getOption(pSubElem, "edge", "").c_str();
+        XMLLightDocument::getOption(pSubElem, "edge", "").c_str();
       int blendColor_r, blendColor_g, blendColor_b, blendColor_a;
       std::string v_blendColor =
-        XMLDocument::getOption(pSubElem, "color_r", "255");
+        XMLLightDocument::getOption(pSubElem, "color_r", "255");
       blendColor_r = atoi(v_blendColor.c_str());
-      v_blendColor = XMLDocument::getOption(pSubElem, "color_g", "255");
+      v_blendColor = XMLLightDocument::getOption(pSubElem, "color_g", "255");
       blendColor_g = atoi(v_blendColor.c_str());
-      v_blendColor = XMLDocument::getOption(pSubElem, "color_b", "255");
+      v_blendColor = XMLLightDocument::getOption(pSubElem, "color_b", "255");
       blendColor_b = atoi(v_blendColor.c_str());
-      v_blendColor = XMLDocument::getOption(pSubElem, "color_a", "255");
+      v_blendColor = XMLLightDocument::getOption(pSubElem, "color_a", "255");
       blendColor_a = atoi(v_blendColor.c_str());
 
-      float v_scale = atof(XMLDocument::getOption(pSubElem, "scale", "-1.0f")
-                             .c_str()); // set scale default alias -1
-      float v_depth = atof(XMLDocument::getOption(pSubElem, "depth", "-1.0f")
-                             .c_str()); // det depth default alias -1
+      float v_scale =
+        atof(XMLLightDocument::getOption(pSubElem, "scale", "-1.0f")
+               .c_str()); // set scale default alias -1
+      float v_depth =
+        atof(XMLLightDocument::getOption(pSubElem, "depth", "-1.0f")
+               .c_str()); // det depth default alias -1
       pBlock->addEdgeMaterial(
         v_materialName,
         v_materialTexture,
@@ -916,10 +981,11 @@ Block *Block::readFromXml(xmlNodePtr pElem, bool i_loadMainLayerOnly) {
   }
 
   if (pColElem != NULL) {
-    std::string methodStr = XMLDocument::getOption(pColElem, "type", "None");
+    std::string methodStr =
+      XMLLightDocument::getOption(pColElem, "type", "None");
     pBlock->setCollisionMethod(pBlock->stringToColMethod(methodStr));
     pBlock->setCollisionRadius(
-      atof(XMLDocument::getOption(pColElem, "radius", "0.0").c_str()));
+      atof(XMLLightDocument::getOption(pColElem, "radius", "0.0").c_str()));
   }
 
   float lastX = 0.0;
@@ -927,14 +993,15 @@ Block *Block::readFromXml(xmlNodePtr pElem, bool i_loadMainLayerOnly) {
   bool firstVertex = true;
 
   /* Get vertices */
-  for (xmlNodePtr pSubElem = XMLDocument::subElement(pElem, "vertex");
+  for (const XMLLightNode *pSubElem =
+         XMLLightDocument::subElement(pElem, "vertex");
        pSubElem != NULL;
-       pSubElem = XMLDocument::nextElement(pSubElem)) {
+       pSubElem = XMLLightDocument::nextElement(pSubElem)) {
     /* Alloc */
     BlockVertex *pVertex = new BlockVertex(
-      Vector2f(atof(XMLDocument::getOption(pSubElem, "x", "0").c_str()),
-               atof(XMLDocument::getOption(pSubElem, "y", "0").c_str())),
-      XMLDocument::getOption(pSubElem, "edge", ""));
+      Vector2f(atof(XMLLightDocument::getOption(pSubElem, "x", "0").c_str()),
+               atof(XMLLightDocument::getOption(pSubElem, "y", "0").c_str())),
+      XMLLightDocument::getOption(pSubElem, "edge", ""));
 
     if (firstVertex == true) {
       firstVertex = false;
@@ -1000,67 +1067,102 @@ void Block::saveBinary(FileHandle *i_pfh) {
     XMFS::writeFloat_LE(i_pfh, Vertices()[j]->Position().y);
     XMFS::writeString(i_pfh, Vertices()[j]->EdgeEffect());
   }
+
+  /* convex decomposition */
+  XMFS::writeBool(i_pfh, m_BSPComputed);
+  if (m_BSPComputed) {
+    XMFS::writeInt_LE(i_pfh, m_BSPErrors);
+    XMFS::writeInt_LE(i_pfh, m_BSPPolys.size());
+    for (unsigned int i = 0; i < m_BSPPolys.size(); i++) {
+      const std::vector<Vector2f> &v_vertices = m_BSPPolys[i]->Vertices();
+
+      XMFS::writeInt_LE(i_pfh, v_vertices.size());
+      for (unsigned int j = 0; j < v_vertices.size(); j++) {
+        XMFS::writeFloat_LE(i_pfh, v_vertices[j].x);
+        XMFS::writeFloat_LE(i_pfh, v_vertices[j].y);
+      }
+    }
+  }
 }
 
-Block *Block::readFromBinary(FileHandle *i_pfh) {
-  Block *pBlock = new Block(XMFS::readString(i_pfh));
+Block *Block::readFromBinary(BinaryReader &i_reader) {
+  Block *pBlock = new Block(i_reader.readString());
 
-  pBlock->setBackground(XMFS::readBool(i_pfh));
-  pBlock->setDynamic(XMFS::readBool(i_pfh));
-  pBlock->setPhysics(XMFS::readBool(i_pfh));
-  pBlock->setIsLayer(XMFS::readBool(i_pfh));
-  pBlock->setLayer(XMFS::readInt_LE(i_pfh));
-  pBlock->setTexture(XMFS::readString(i_pfh));
-  pBlock->setTextureScale(XMFS::readFloat_LE(i_pfh));
+  pBlock->setBackground(i_reader.readBool());
+  pBlock->setDynamic(i_reader.readBool());
+  pBlock->setPhysics(i_reader.readBool());
+  pBlock->setIsLayer(i_reader.readBool());
+  pBlock->setLayer(i_reader.readInt_LE());
+  pBlock->setTexture(i_reader.readString());
+  pBlock->setTextureScale(i_reader.readFloat_LE());
 
   TColor v_blendColor = TColor(255, 255, 255, 255);
-  v_blendColor.setRed(XMFS::readInt_LE(i_pfh));
-  v_blendColor.setGreen(XMFS::readInt_LE(i_pfh));
-  v_blendColor.setBlue(XMFS::readInt_LE(i_pfh));
-  v_blendColor.setAlpha(XMFS::readInt_LE(i_pfh));
+  v_blendColor.setRed(i_reader.readInt_LE());
+  v_blendColor.setGreen(i_reader.readInt_LE());
+  v_blendColor.setBlue(i_reader.readInt_LE());
+  v_blendColor.setAlpha(i_reader.readInt_LE());
   pBlock->setBlendColor(v_blendColor);
 
   Vector2f v_Position;
-  v_Position.x = XMFS::readFloat_LE(i_pfh);
-  v_Position.y = XMFS::readFloat_LE(i_pfh);
+  v_Position.x = i_reader.readFloat_LE();
+  v_Position.y = i_reader.readFloat_LE();
   pBlock->setInitialPosition(v_Position);
-  pBlock->setGripPer20(XMFS::readFloat_LE(i_pfh));
-  pBlock->setMass(XMFS::readFloat_LE(i_pfh));
-  pBlock->setFriction(XMFS::readFloat_LE(i_pfh));
-  pBlock->setElasticity(XMFS::readFloat_LE(i_pfh));
-  pBlock->setEdgeDrawMethod((EdgeDrawMethod)XMFS::readInt_LE(i_pfh));
-  pBlock->setEdgeAngle(XMFS::readFloat_LE(i_pfh));
+  pBlock->setGripPer20(i_reader.readFloat_LE());
+  pBlock->setMass(i_reader.readFloat_LE());
+  pBlock->setFriction(i_reader.readFloat_LE());
+  pBlock->setElasticity(i_reader.readFloat_LE());
+  pBlock->setEdgeDrawMethod((EdgeDrawMethod)i_reader.readInt_LE());
+  pBlock->setEdgeAngle(i_reader.readFloat_LE());
 
   int geomSize =
-    XMFS::readInt_LE(i_pfh); // get size of geoms and read out as many times
+    i_reader.readInt_LE(); // get size of geoms and read out as many times
   for (int i = 0; i < geomSize; i++) {
     EdgeMaterial v_geomMat;
-    v_geomMat.name = XMFS::readString(i_pfh);
-    v_geomMat.texture = XMFS::readString(i_pfh);
+    v_geomMat.name = i_reader.readString();
+    v_geomMat.texture = i_reader.readString();
     TColor v_edgeMatColor = TColor(255, 255, 255, 255);
-    v_edgeMatColor.setRed(XMFS::readInt_LE(i_pfh));
-    v_edgeMatColor.setGreen(XMFS::readInt_LE(i_pfh));
-    v_edgeMatColor.setBlue(XMFS::readInt_LE(i_pfh));
-    v_edgeMatColor.setAlpha(XMFS::readInt_LE(i_pfh));
+    v_edgeMatColor.setRed(i_reader.readInt_LE());
+    v_edgeMatColor.setGreen(i_reader.readInt_LE());
+    v_edgeMatColor.setBlue(i_reader.readInt_LE());
+    v_edgeMatColor.setAlpha(i_reader.readInt_LE());
     v_geomMat.color = v_edgeMatColor;
-    v_geomMat.scale = XMFS::readFloat_LE(i_pfh);
-    v_geomMat.depth = XMFS::readFloat_LE(i_pfh);
+    v_geomMat.scale = i_reader.readFloat_LE();
+    v_geomMat.depth = i_reader.readFloat_LE();
     pBlock->m_edgeMaterial.push_back(v_geomMat);
   }
 
-  pBlock->setCollisionMethod((CollisionMethod)XMFS::readInt_LE(i_pfh));
-  pBlock->setCollisionRadius(XMFS::readFloat_LE(i_pfh));
+  pBlock->setCollisionMethod((CollisionMethod)i_reader.readInt_LE());
+  pBlock->setCollisionRadius(i_reader.readFloat_LE());
 
-  int nNumVertices = XMFS::readShort_LE(i_pfh);
+  int nNumVertices = i_reader.readShort_LE();
   pBlock->Vertices().reserve(nNumVertices);
   for (int j = 0; j < nNumVertices; j++) {
     Vector2f v_Position;
-    v_Position.x = XMFS::readFloat_LE(i_pfh);
-    v_Position.y = XMFS::readFloat_LE(i_pfh);
-    std::string v_EdgeEffect = XMFS::readString(i_pfh);
+    v_Position.x = i_reader.readFloat_LE();
+    v_Position.y = i_reader.readFloat_LE();
+    std::string v_EdgeEffect = i_reader.readString();
     pBlock->Vertices().push_back(new BlockVertex(v_Position, v_EdgeEffect));
   }
 
+  /* convex decomposition */
+  if (i_reader.readBool()) {
+    pBlock->m_BSPErrors = i_reader.readInt_LE();
+    int nNumPolys = i_reader.readInt_LE();
+    pBlock->m_BSPPolys.reserve(nNumPolys);
+    for (int i = 0; i < nNumPolys; i++) {
+      int nNumPolyVertices = i_reader.readInt_LE();
+      BSPPoly *v_poly = new BSPPoly(nNumPolyVertices);
+      pBlock->m_BSPPolys.push_back(v_poly);
+      for (int j = 0; j < nNumPolyVertices; j++) {
+        Vector2f v_vertex;
+        v_vertex.x = i_reader.readFloat_LE();
+        v_vertex.y = i_reader.readFloat_LE();
+        v_poly->addVertice(v_vertex);
+      }
+    }
+    pBlock->m_BSPComputed = true;
+  }
+
   return pBlock;
 }
 
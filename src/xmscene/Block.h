@@ -25,13 +25,14 @@ class CollisionSystem;
 class Line;
 
 #include "common/VTexture.h"
-#include "common/VXml.h"
+#include "common/VXmlLight.h"
 #include "helpers/Color.h"
 #include "helpers/VMath.h"
 #include <vector>
 
+class BinaryReader;
 class FileHandle;
-class XMLDocument;
+class XMLLightDocument;
 class BSPPoly;
 class Block;
 class cpBody;
@@ -202,12 +203,19 @@ public:
                  bool i_loadBSP);
   void unloadToPlay();
 
+  /* convex decomposition of the block ; computed once, then saved with the
+     block in the level cache. return the number of errors */
+  int computeBSP();
+  int computeBSP(unsigned int i_maxSplitters); // see BSP_MAX_SPLITTERS
+  bool isBSPComputed() const { return m_BSPComputed; }
+  unsigned int nbBSPPolys() const { return m_BSPPolys.size(); }
+
   void saveBinary(FileHandle *i_pfh);
-  static bool isPhysics_readFromXml(xmlNodePtr pElem);
+  static bool isPhysics_readFromXml(const XMLLightNode *pElem);
   static Block *readFromXml(
-    xmlNodePtr pElem,
+    const XMLLightNode *pElem,
     bool i_loadMainLayerOnly); // return NULL if the block must not be loaded
-  static Block *readFromBinary(FileHandle *i_pfh);
+  static Block *readFromBinary(BinaryReader &i_reader);
   AABB &getAABB();
   BoundingCircle &getBCircle() { return m_BCircle; }
   std::vector<Line *> &getCollisionLines() { return m_collisionLines; }
@@ -273,6 +281,10 @@ private:
   std::vector<BlockVertex *> m_vertices;
   std::vector<ConvexBlock *> m_convexBlocks;
 
+  std::vector<BSPPoly *> m_BSPPolys;
+  bool m_BSPComputed;
+  int m_BSPErrors;
+
   std::vector<cpShape*> m_shapes;
   // one geom for each edge texture
   std::vector<Geom *> m_edgeGeoms;
@@ -320,6 +332,7 @@ private:
   void addPoly(BSPPoly *i_poly,
                CollisionSystem *io_collisionSystem,
                float scale);
+  void clearBSP();
   // dynamic background blocks only need to compute the collision lines once.
   void updateCollisionLines(bool setDirty = false, bool forceUpdate = false);
   void translateCollisionLines(float x, float y);
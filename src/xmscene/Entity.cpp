@@ -23,9 +23,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ChipmunkWorld.h"
 #include "Level.h"
 #include "PhysicsSettings.h"
+#include "common/BinaryReader.h"
 #include "common/Theme.h"
 #include "common/VFileIO.h"
-#include "common/VXml.h"
+#include "common/VXmlLight.h"
 #include "common/XMSession.h"
 #include "helpers/Log.h"
 #include "helpers/Random.h"
@@ -189,6 +190,31 @@ AABB &Entity::getAABB() {
   return m_BCircle.getAABB();
 }
 
+void Entity::loadSprites() {
+  switch (m_speciality) {
+    case ET_PARTICLES_SOURCE:
+      // hard coded particles effects
+      if (m_spriteName == "Smoke") {
+        // smoke has two sprites
+        ((ParticlesSourceSmoke *)this)
+          ->setSprite(loadSprite(std::string("Smoke1")), 0);
+        ((ParticlesSourceSmoke *)this)
+          ->setSprite(loadSprite(std::string("Smoke2")), 1);
+      } else if (m_spriteName == "Fire") {
+        setSprite(loadSprite(std::string("Fire1")));
+      } else if (m_spriteName == "Debris1") {
+        setSprite(loadSprite(std::string("Debris1")));
+      } else if (m_spriteName == "Sparkle") {
+        setSprite(loadSprite(std::string("Fire1")));
+      }
+      break;
+    case ET_JOINT:
+      break;
+    default:
+      setSprite(loadSprite());
+  }
+}
+
 void Entity::loadSpriteTextures() {
   // for playerStart, Joints, and level's theme remplacement
   if (getSprite() != NULL)
@@ -307,25 +333,11 @@ Entity *Entity::createEntity(const std::string &id,
   switch (speciality) {
     case ET_NONE:
       v_entity->setSpriteName(spriteName);
-      v_entity->setSprite(v_entity->loadSprite());
       break;
     case ET_PARTICLES_SOURCE:
       v_entity->setSpriteName(typeName);
-
-      // hard coded particles effects
-      if (typeName == "Smoke") {
-        // smoke has two sprites
-        ((ParticlesSourceSmoke *)v_entity)
-          ->setSprite(v_entity->loadSprite(std::string("Smoke1")), 0);
-        ((ParticlesSourceSmoke *)v_entity)
-          ->setSprite(v_entity->loadSprite(std::string("Smoke2")), 1);
-      } else if (typeName == "Fire") {
-        v_entity->setSprite(v_entity->loadSprite(std::string("Fire1")));
-      } else if (typeName == "Debris") {
-        v_entity->setSprite(v_entity->loadSprite(std::string("Debris1")));
+      if (typeName == "Debris") {
         v_entity->setSpriteName("Debris1");
-      } else if (typeName == "Sparkle") {
-        v_entity->setSprite(v_entity->loadSprite(std::string("Fire1")));
       }
       break;
     case ET_JOINT:
@@ -333,7 +345,6 @@ Entity *Entity::createEntity(const std::string &id,
     case ET_CHECKPOINT:
     default:
       v_entity->setSpriteName(typeId);
-      v_entity->setSprite(v_entity->loadSprite());
   }
   v_entity->setSpeciality(speciality);
   v_entity->setInitialPosition(position);
@@ -353,7 +364,7 @@ Entity *Entity::createEntity(const std::string &id,
   return v_entity;
 }
 
-Entity *Entity::readFromXml(xmlNodePtr pElem) {
+Entity *Entity::readFromXml(const XMLLightNode *pElem) {
   std::string v_id;
   std::string v_typeId;
   EntitySpeciality v_speciality;
@@ -368,33 +379,39 @@ Entity *Entity::readFromXml(xmlNodePtr pElem) {
   std::string v_typeName;
 
   /* read xml information */
-  v_id = XMLDocument::getOption(pElem, "id");
-  v_typeId = XMLDocument::getOption(pElem, "typeid");
+  v_id = XMLLightDocument::getOption(pElem, "id");
+  v_typeId = XMLLightDocument::getOption(pElem, "typeid");
   v_speciality = Entity::SpecialityFromStr(v_typeId);
 
-  xmlNodePtr pPosElem = XMLDocument::subElement(pElem, "position");
+  const XMLLightNode *pPosElem =
+    XMLLightDocument::subElement(pElem, "position");
   if (pPosElem != NULL) {
-    v_position.x = atof(XMLDocument::getOption(pPosElem, "x", "0").c_str());
-    v_position.y = atof(XMLDocument::getOption(pPosElem, "y", "0").c_str());
-    v_angle = atof(XMLDocument::getOption(pPosElem, "angle", "-1.0").c_str());
+    v_position.x =
+      atof(XMLLightDocument::getOption(pPosElem, "x", "0").c_str());
+    v_position.y =
+      atof(XMLLightDocument::getOption(pPosElem, "y", "0").c_str());
+    v_angle =
+      atof(XMLLightDocument::getOption(pPosElem, "angle", "-1.0").c_str());
     v_reversed =
-      XMLDocument::getOption(pPosElem, "reversed", "false") == "true";
+      XMLLightDocument::getOption(pPosElem, "reversed", "false") == "true";
   }
-  xmlNodePtr pSizeElem = XMLDocument::subElement(pElem, "size");
+  const XMLLightNode *pSizeElem = XMLLightDocument::subElement(pElem, "size");
   if (pSizeElem != NULL) {
-    v_size = (atof(XMLDocument::getOption(pSizeElem, "r", "0.2").c_str()));
-    v_width = atof(XMLDocument::getOption(pSizeElem, "width", "-1.0").c_str());
+    v_size = (atof(XMLLightDocument::getOption(pSizeElem, "r", "0.2").c_str()));
+    v_width =
+      atof(XMLLightDocument::getOption(pSizeElem, "width", "-1.0").c_str());
     v_height =
-      atof(XMLDocument::getOption(pSizeElem, "height", "-1.0").c_str());
+      atof(XMLLightDocument::getOption(pSizeElem, "height", "-1.0").c_str());
   }
   /* Get parameters */
   std::string v_paramName;
   std::string v_paramValue;
-  for (xmlNodePtr pSubElem = XMLDocument::subElement(pElem, "param");
+  for (const XMLLightNode *pSubElem =
+         XMLLightDocument::subElement(pElem, "param");
        pSubElem != NULL;
-       pSubElem = XMLDocument::nextElement(pSubElem)) {
-    v_paramName = XMLDocument::getOption(pSubElem, "name");
-    v_paramValue = XMLDocument::getOption(pSubElem, "value");
+       pSubElem = XMLLightDocument::nextElement(pSubElem)) {
+    v_paramName = XMLLightDocument::getOption(pSubElem, "name");
+    v_paramValue = XMLLightDocument::getOption(pSubElem, "value");
     if (v_paramName == "z") {
       v_z = (atof(v_paramValue.c_str()));
     } else if (v_paramName == "name") {
@@ -452,7 +469,7 @@ void Entity::saveBinary(FileHandle *i_pfh) {
   }
 }
 
-Entity *Entity::readFromBinary(FileHandle *i_pfh) {
+Entity *Entity::readFromBinary(BinaryReader &i_reader) {
   std::string v_id;
   std::string v_typeId;
   EntitySpeciality v_speciality;
@@ -467,22 +484,22 @@ Entity *Entity::readFromBinary(FileHandle *i_pfh) {
   std::string v_typeName;
 
   /* read values */
-  v_id = XMFS::readString(i_pfh);
-  v_typeId = XMFS::readString(i_pfh);
+  v_id = i_reader.readString();
+  v_typeId = i_reader.readString();
   v_speciality = Entity::SpecialityFromStr(v_typeId);
-  v_size = XMFS::readFloat_LE(i_pfh);
-  v_width = XMFS::readFloat_LE(i_pfh);
-  v_height = XMFS::readFloat_LE(i_pfh);
-  v_position.x = XMFS::readFloat_LE(i_pfh);
-  v_position.y = XMFS::readFloat_LE(i_pfh);
-  v_angle = XMFS::readFloat_LE(i_pfh);
-  v_reversed = XMFS::readBool(i_pfh);
+  v_size = i_reader.readFloat_LE();
+  v_width = i_reader.readFloat_LE();
+  v_height = i_reader.readFloat_LE();
+  v_position.x = i_reader.readFloat_LE();
+  v_position.y = i_reader.readFloat_LE();
+  v_angle = i_reader.readFloat_LE();
+  v_reversed = i_reader.readBool();
   std::string v_paramName;
   std::string v_paramValue;
-  int nNumParams = XMFS::readByte(i_pfh);
+  int nNumParams = i_reader.readByte();
   for (int j = 0; j < nNumParams; j++) {
-    v_paramName = XMFS::readString(i_pfh);
-    v_paramValue = XMFS::readString(i_pfh);
+    v_paramName = i_reader.readString();
+    v_paramValue = i_reader.readString();
 
     if (v_paramName == "z") {
       v_z = atof(v_paramValue.c_str());
@@ -547,13 +564,13 @@ void Joint::saveBinary(FileHandle *i_pfh) {
   XMFS::writeString(i_pfh, getEndBlockId());
 }
 
-void Joint::readFromBinary(FileHandle *i_pfh) {
+void Joint::readFromBinary(BinaryReader &i_reader) {
   std::string v_paramName;
   std::string v_paramValue;
-  int nNumParams = XMFS::readByte(i_pfh);
+  int nNumParams = i_reader.readByte();
   for (int j = 0; j < nNumParams; j++) {
-    v_paramName = XMFS::readString(i_pfh);
-    v_paramValue = XMFS::readString(i_pfh);
+    v_paramName = i_reader.readString();
+    v_paramValue = i_reader.readString();
 
     if (v_paramName == "type") {
       setJointType(jointTypeFromStr(v_paramValue));
@@ -565,15 +582,15 @@ void Joint::readFromBinary(FileHandle *i_pfh) {
   }
 }
 
-void Joint::readFromXml(xmlNodePtr pElem) {
-  xmlNodePtr pJointElem = XMLDocument::subElement(pElem, "joint");
+void Joint::readFromXml(const XMLLightNode *pElem) {
+  const XMLLightNode *pJointElem = XMLLightDocument::subElement(pElem, "joint");
 
   if (pJointElem != NULL) {
-    std::string v_type = XMLDocument::getOption(pJointElem, "type", "");
+    std::string v_type = XMLLightDocument::getOption(pJointElem, "type", "");
     std::string v_start =
-      XMLDocument::getOption(pJointElem, "connection-start", "");
+      XMLLightDocument::getOption(pJointElem, "connection-start", "");
     std::string v_end =
-      XMLDocument::getOption(pJointElem, "connection-end", "");
+      XMLLightDocument::getOption(pJointElem, "connection-end", "");
     if (v_type != "" && v_start != "" && v_end != "") {
       setJointType(Joint::jointTypeFromStr(v_type));
       setStartBlockId(v_start);
@@ -24,11 +24,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "../helpers/Color.h"
 #include "../helpers/VMath.h"
 #include "BasicSceneStructs.h"
-#include "common/VXml.h"
+#include "common/VXmlLight.h"
 #include <string>
 #include <vector>
 
 class EntityParticle;
+class BinaryReader;
 class FileHandle;
 class Sprite;
 class Block;
@@ -91,8 +92,8 @@ public:
   void setAlive(bool alive);
 
   void saveBinary(FileHandle *i_pfh);
-  static Entity *readFromXml(xmlNodePtr pElem);
-  static Entity *readFromBinary(FileHandle *i_pfh);
+  static Entity *readFromXml(const XMLLightNode *pElem);
+  static Entity *readFromBinary(BinaryReader &i_reader);
 
   static EntitySpeciality SpecialityFromStr(std::string &i_typeStr);
   static std::string SpecialityToStr(EntitySpeciality i_type);
@@ -109,6 +110,9 @@ public:
 
   AABB &getAABB();
 
+  /* sprites of the current theme ; not done while reading the entity, which
+     can be done out of the main thread while the theme is changed */
+  void loadSprites();
   void loadSpriteTextures();
 
 protected:
@@ -199,8 +203,8 @@ public:
   inline Block *getEndBlock() { return m_endBlock; }
 
   void saveBinary(FileHandle *i_pfh);
-  void readFromBinary(FileHandle *i_pfh);
-  void readFromXml(xmlNodePtr pElem);
+  void readFromBinary(BinaryReader &i_reader);
+  void readFromXml(const XMLLightNode *pElem);
 
   void loadToPlay(Level *i_level, ChipmunkWorld *i_chipmunkWorld);
   void unloadToPlay();
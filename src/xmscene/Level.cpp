@@ -32,14 +32,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Scene.h"
 #include "SkyApparence.h"
 #include "Zone.h"
+#include "common/BinaryReader.h"
 #include "common/Theme.h"
 #include "common/VFileIO.h"
-#include "common/VXml.h"
+#include "common/VXmlLight.h"
 #include "common/XMBuild.h"
 #include "db/xmDatabase.h"
 #include "helpers/Color.h"
 #include "helpers/Log.h"
 #include "helpers/Text.h"
+#include "include/xm_SDL.h"
+#include "thread/WorkersPool.h"
 #include "xmoto/Collision.h"
 #include <chipmunk.h>
 
@@ -362,7 +365,7 @@ void Level::updateToTime(Scene &i_scene,
 }
 
 void Level::loadXML(bool i_loadMainLayerOnly) {
-  XMLDocument v_xml;
+  XMLLightDocument v_xml;
 
   /* Load XML document */
   unloadLevelBody();
@@ -370,18 +373,18 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
   v_xml.readFromFile(FDT_DATA, m_fileName, true);
 
   /* Start the fantastic parsing by fetching the <level> element */
-  xmlNodePtr v_levelElt = v_xml.getRootNode("level");
+  const XMLLightNode *v_levelElt = v_xml.getRootNode("level");
   if (v_levelElt == NULL) {
     throw Exception("unable to analyze xml file");
   }
 
   /* Get level ID */
-  m_id = XMLDocument::getOption(v_levelElt, "id");
+  m_id = XMLLightDocument::getOption(v_levelElt, "id");
   if (m_id == "")
     throw Exception("no ID specified in level XML");
 
   /* Get required xmoto version */
-  m_requiredVersion = XMLDocument::getOption(v_levelElt, "rversion");
+  m_requiredVersion = XMLLightDocument::getOption(v_levelElt, "rversion");
   m_xmotoTooOld = false;
   /* Check version */
   if (compareVersionNumbers(XMBuild::getVersionString(), m_requiredVersion) <
@@ -417,38 +420,39 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
 
   if (m_xmotoTooOld == false) {
     /* Get level pack */
-    m_pack = XMLDocument::getOption(v_levelElt, "levelpack");
-    m_packNum = XMLDocument::getOption(v_levelElt, "levelpackNum");
+    m_pack = XMLLightDocument::getOption(v_levelElt, "levelpack");
+    m_packNum = XMLLightDocument::getOption(v_levelElt, "levelpackNum");
 
     /* Get level <info> element */
-    xmlNodePtr pInfoElem = XMLDocument::subElement(v_levelElt, "info");
+    const XMLLightNode *pInfoElem =
+      XMLLightDocument::subElement(v_levelElt, "info");
     if (pInfoElem != NULL) {
-      xmlNodePtr v_node;
+      const XMLLightNode *v_node;
 
       /* Name */
-      v_node = XMLDocument::subElement(pInfoElem, "name");
+      v_node = XMLLightDocument::subElement(pInfoElem, "name");
       if (v_node != NULL)
-        m_name = XMLDocument::getElementText(v_node);
+        m_name = XMLLightDocument::getElementText(v_node);
 
       /* Author */
-      v_node = XMLDocument::subElement(pInfoElem, "author");
+      v_node = XMLLightDocument::subElement(pInfoElem, "author");
       if (v_node != NULL)
-        m_author = XMLDocument::getElementText(v_node);
+        m_author = XMLLightDocument::getElementText(v_node);
 
       /* Description */
-      v_node = XMLDocument::subElement(pInfoElem, "description");
+      v_node = XMLLightDocument::subElement(pInfoElem, "description");
       if (v_node != NULL)
-        m_description = XMLDocument::getElementText(v_node);
+        m_description = XMLLightDocument::getElementText(v_node);
 
       /* Date */
-      v_node = XMLDocument::subElement(pInfoElem, "date");
+      v_node = XMLLightDocument::subElement(pInfoElem, "date");
       if (v_node != NULL)
-        m_date = XMLDocument::getElementText(v_node);
+        m_date = XMLLightDocument::getElementText(v_node);
 
       /* Sky */
-      v_node = XMLDocument::subElement(pInfoElem, "sky");
+      v_node = XMLLightDocument::subElement(pInfoElem, "sky");
       if (v_node != NULL) {
-        std::string v_sky = XMLDocument::getElementText(v_node);
+        std::string v_sky = XMLLightDocument::getElementText(v_node);
         if (v_sky != "") {
           m_sky->setTexture(v_sky);
           m_sky->setBlendTexture(v_sky);
@@ -457,32 +461,33 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
 
       /* advanced sky parameters ? */
       bool v_useAdvancedOptions = false;
-      xmlNodePtr pSkyElem = XMLDocument::subElement(pInfoElem, "sky");
+      const XMLLightNode *pSkyElem =
+        XMLLightDocument::subElement(pInfoElem, "sky");
 
       std::string v_skyValue;
       if (pSkyElem != NULL) {
-        v_skyValue = XMLDocument::getOption(pSkyElem, "zoom");
+        v_skyValue = XMLLightDocument::getOption(pSkyElem, "zoom");
         if (v_skyValue != "") {
           m_sky->setZoom(atof(v_skyValue.c_str()));
           v_useAdvancedOptions = true;
         }
-        v_skyValue = XMLDocument::getOption(pSkyElem, "offset");
+        v_skyValue = XMLLightDocument::getOption(pSkyElem, "offset");
         if (v_skyValue != "") {
           m_sky->setOffset(atof(v_skyValue.c_str()));
           v_useAdvancedOptions = true;
         }
 
         int v_r = -1, v_g = -1, v_b = -1, v_a = -1;
-        v_skyValue = XMLDocument::getOption(pSkyElem, "color_r");
+        v_skyValue = XMLLightDocument::getOption(pSkyElem, "color_r");
         if (v_skyValue != "")
           v_r = atoi(v_skyValue.c_str());
-        v_skyValue = XMLDocument::getOption(pSkyElem, "color_g");
+        v_skyValue = XMLLightDocument::getOption(pSkyElem, "color_g");
         if (v_skyValue != "")
           v_g = atoi(v_skyValue.c_str());
-        v_skyValue = XMLDocument::getOption(pSkyElem, "color_b");
+        v_skyValue = XMLLightDocument::getOption(pSkyElem, "color_b");
         if (v_skyValue != "")
           v_b = atoi(v_skyValue.c_str());
-        v_skyValue = XMLDocument::getOption(pSkyElem, "color_a");
+        v_skyValue = XMLLightDocument::getOption(pSkyElem, "color_a");
         if (v_skyValue != "")
           v_a = atoi(v_skyValue.c_str());
         if (v_r != -1 || v_g != -1 || v_b != -1 || v_a != -1) {
@@ -498,26 +503,26 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
           v_useAdvancedOptions = true;
         }
 
-        v_skyValue = XMLDocument::getOption(pSkyElem, "drifted");
+        v_skyValue = XMLLightDocument::getOption(pSkyElem, "drifted");
         if (v_skyValue == "true") {
           m_sky->setDrifted(true);
           v_useAdvancedOptions = true;
 
-          v_skyValue = XMLDocument::getOption(pSkyElem, "driftZoom");
+          v_skyValue = XMLLightDocument::getOption(pSkyElem, "driftZoom");
           if (v_skyValue != "")
             m_sky->setDriftZoom(atof(v_skyValue.c_str()));
 
           int v_r = -1, v_g = -1, v_b = -1, v_a = -1;
-          v_skyValue = XMLDocument::getOption(pSkyElem, "driftColor_r");
+          v_skyValue = XMLLightDocument::getOption(pSkyElem, "driftColor_r");
           if (v_skyValue != "")
             v_r = atoi(v_skyValue.c_str());
-          v_skyValue = XMLDocument::getOption(pSkyElem, "driftColor_g");
+          v_skyValue = XMLLightDocument::getOption(pSkyElem, "driftColor_g");
           if (v_skyValue != "")
             v_g = atoi(v_skyValue.c_str());
-          v_skyValue = XMLDocument::getOption(pSkyElem, "driftColor_b");
+          v_skyValue = XMLLightDocument::getOption(pSkyElem, "driftColor_b");
           if (v_skyValue != "")
             v_b = atoi(v_skyValue.c_str());
-          v_skyValue = XMLDocument::getOption(pSkyElem, "driftColor_a");
+          v_skyValue = XMLLightDocument::getOption(pSkyElem, "driftColor_a");
           if (v_skyValue != "")
             v_a = atoi(v_skyValue.c_str());
           if (v_r != -1 || v_g != -1 || v_b != -1 || v_a != -1) {
@@ -534,7 +539,7 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
         }
 
         /* Sky Blend texture */
-        v_skyValue = XMLDocument::getOption(pSkyElem, "BlendTexture");
+        v_skyValue = XMLLightDocument::getOption(pSkyElem, "BlendTexture");
         if (v_skyValue != "") {
           m_sky->setBlendTexture(v_skyValue.c_str());
           v_useAdvancedOptions = true;
@@ -547,15 +552,17 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
       }
 
       /* Border */
-      xmlNodePtr pBorderElem = XMLDocument::subElement(pInfoElem, "border");
+      const XMLLightNode *pBorderElem =
+        XMLLightDocument::subElement(pInfoElem, "border");
       if (pBorderElem != NULL) {
-        m_borderTexture = XMLDocument::getOption(pBorderElem, "texture");
+        m_borderTexture = XMLLightDocument::getOption(pBorderElem, "texture");
       }
 
       /* Music */
-      xmlNodePtr pMusicElem = XMLDocument::subElement(pInfoElem, "music");
+      const XMLLightNode *pMusicElem =
+        XMLLightDocument::subElement(pInfoElem, "music");
       if (pMusicElem != NULL) {
-        m_music = XMLDocument::getOption(pMusicElem, "name");
+        m_music = XMLLightDocument::getOption(pMusicElem, "name");
         if (m_music == "None") {
           m_music = "";
         }
@@ -563,35 +570,39 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
     }
 
     /* background level offsets */
-    xmlNodePtr pLayerOffsets =
-      XMLDocument::subElement(v_levelElt, "layeroffsets");
+    const XMLLightNode *pLayerOffsets =
+      XMLLightDocument::subElement(v_levelElt, "layeroffsets");
     if (pLayerOffsets == NULL || i_loadMainLayerOnly) {
       m_numberLayer = 0;
     } else {
-      for (xmlNodePtr pSubElem =
-             XMLDocument::subElement(pLayerOffsets, "layeroffset");
+      for (const XMLLightNode *pSubElem =
+             XMLLightDocument::subElement(pLayerOffsets, "layeroffset");
            pSubElem != NULL;
-           pSubElem = XMLDocument::nextElement(pSubElem)) {
+           pSubElem = XMLLightDocument::nextElement(pSubElem)) {
         Vector2f offset;
-        offset.x = atof(XMLDocument::getOption(pSubElem, "x").c_str());
-        offset.y = atof(XMLDocument::getOption(pSubElem, "y").c_str());
+        offset.x = atof(XMLLightDocument::getOption(pSubElem, "x").c_str());
+        offset.y = atof(XMLLightDocument::getOption(pSubElem, "y").c_str());
         m_numberLayer++;
         m_layerOffsets.push_back(offset);
         m_isLayerFront.push_back(
-          XMLDocument::getOption(pSubElem, "frontlayer", "false") == "true");
+          XMLLightDocument::getOption(pSubElem, "frontlayer", "false") ==
+          "true");
       }
     }
 
-    xmlNodePtr pThemeReplaceElem =
-      XMLDocument::subElement(v_levelElt, "theme_replacements");
+    const XMLLightNode *pThemeReplaceElem =
+      XMLLightDocument::subElement(v_levelElt, "theme_replacements");
     if (pThemeReplaceElem != NULL) {
       /* Get replacements  for sprites */
-      for (xmlNodePtr pSubElem =
-             XMLDocument::subElement(pThemeReplaceElem, "sprite_replacement");
+      for (const XMLLightNode *pSubElem =
+             XMLLightDocument::subElement(pThemeReplaceElem,
+                                          "sprite_replacement");
            pSubElem != NULL;
-           pSubElem = XMLDocument::nextElement(pSubElem)) {
-        std::string v_old_name = XMLDocument::getOption(pSubElem, "old_name");
-        std::string v_new_name = XMLDocument::getOption(pSubElem, "new_name");
+           pSubElem = XMLLightDocument::nextElement(pSubElem)) {
+        std::string v_old_name =
+          XMLLightDocument::getOption(pSubElem, "old_name");
+        std::string v_new_name =
+          XMLLightDocument::getOption(pSubElem, "new_name");
         /* for efficacity and before other are not required, only change main
          * ones */
         if (v_old_name == "Strawberry" && v_new_name != "") {
@@ -605,12 +616,15 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
         }
       }
       /* Get replacements  for sounds */
-      for (xmlNodePtr pSubElem =
-             XMLDocument::subElement(pThemeReplaceElem, "sound_replacement");
+      for (const XMLLightNode *pSubElem =
+             XMLLightDocument::subElement(pThemeReplaceElem,
+                                          "sound_replacement");
            pSubElem != NULL;
-           pSubElem = XMLDocument::nextElement(pSubElem)) {
-        std::string v_old_name = XMLDocument::getOption(pSubElem, "old_name");
-        std::string v_new_name = XMLDocument::getOption(pSubElem, "new_name");
+           pSubElem = XMLLightDocument::nextElement(pSubElem)) {
+        std::string v_old_name =
+          XMLLightDocument::getOption(pSubElem, "old_name");
+        std::string v_new_name =
+          XMLLightDocument::getOption(pSubElem, "new_name");
         /* for efficacity and before other are not required, only change main
          * ones */
         if (v_old_name == "PickUpStrawberry") {
@@ -622,53 +636,57 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
     }
 
     /* Get script */
-    xmlNodePtr pScriptElem = XMLDocument::subElement(v_levelElt, "script");
+    const XMLLightNode *pScriptElem =
+      XMLLightDocument::subElement(v_levelElt, "script");
 
     if (pScriptElem != NULL) {
       m_isScripted = true;
 
       /* External script file specified? */
-      m_scriptFileName = XMLDocument::getOption(pScriptElem, "source");
+      m_scriptFileName = XMLLightDocument::getOption(pScriptElem, "source");
 
       /* Specified libraries ? */
-      for (xmlNodePtr pSubElem =
-             XMLDocument::subElement(pScriptElem, "require_library");
+      for (const XMLLightNode *pSubElem =
+             XMLLightDocument::subElement(pScriptElem, "require_library");
            pSubElem != NULL;
-           pSubElem = XMLDocument::nextElement(pSubElem)) {
+           pSubElem = XMLLightDocument::nextElement(pSubElem)) {
         m_scriptLibraryFileNames.push_back(
-          XMLDocument::getOption(pSubElem, "name"));
+          XMLLightDocument::getOption(pSubElem, "name"));
       }
 
       /* Encapsulated script? */
-      m_scriptSource.append(XMLDocument::getElementText(pScriptElem));
+      m_scriptSource.append(XMLLightDocument::getElementText(pScriptElem));
     }
 
     /* Get level limits */
-    xmlNodePtr pLimitsElem = XMLDocument::subElement(v_levelElt, "limits");
+    const XMLLightNode *pLimitsElem =
+      XMLLightDocument::subElement(v_levelElt, "limits");
 
     if (pLimitsElem != NULL) {
       m_bottomLimit =
-        atof(XMLDocument::getOption(pLimitsElem, "bottom", "-50").c_str());
+        atof(XMLLightDocument::getOption(pLimitsElem, "bottom", "-50").c_str());
       m_leftLimit =
-        atof(XMLDocument::getOption(pLimitsElem, "left", "-50").c_str());
+        atof(XMLLightDocument::getOption(pLimitsElem, "left", "-50").c_str());
       m_topLimit =
-        atof(XMLDocument::getOption(pLimitsElem, "top", "50").c_str());
+        atof(XMLLightDocument::getOption(pLimitsElem, "top", "50").c_str());
       m_rightLimit =
-        atof(XMLDocument::getOption(pLimitsElem, "right", "50").c_str());
+        atof(XMLLightDocument::getOption(pLimitsElem, "right", "50").c_str());
     }
 
     /* Get zones */
-    for (xmlNodePtr pSubElem = XMLDocument::subElement(v_levelElt, "zone");
+    for (const XMLLightNode *pSubElem =
+           XMLLightDocument::subElement(v_levelElt, "zone");
          pSubElem != NULL;
-         pSubElem = XMLDocument::nextElement(pSubElem)) {
+         pSubElem = XMLLightDocument::nextElement(pSubElem)) {
       m_zones.push_back(Zone::readFromXml(pSubElem));
     }
 
     /* determine whether the levels is physics or not */
     /* Get blocks */
-    for (xmlNodePtr pSubElem = XMLDocument::subElement(v_levelElt, "block");
+    for (const XMLLightNode *pSubElem =
+           XMLLightDocument::subElement(v_levelElt, "block");
          pSubElem != NULL;
-         pSubElem = XMLDocument::nextElement(pSubElem)) {
+         pSubElem = XMLLightDocument::nextElement(pSubElem)) {
       Block *v_block = Block::readFromXml(pSubElem, i_loadMainLayerOnly);
       if (v_block != NULL) { // NULL means that the block should not be loaded
         // (for the server for example)
@@ -680,9 +698,10 @@ void Level::loadXML(bool i_loadMainLayerOnly) {
     }
 
     /* Get entities */
-    for (xmlNodePtr pSubElem = XMLDocument::subElement(v_levelElt, "entity");
+    for (const XMLLightNode *pSubElem =
+           XMLLightDocument::subElement(v_levelElt, "entity");
          pSubElem != NULL;
-         pSubElem = XMLDocument::nextElement(pSubElem)) {
+         pSubElem = XMLLightDocument::nextElement(pSubElem)) {
       Entity *v_entity = Entity::readFromXml(pSubElem);
       if (v_entity->Speciality() == ET_JOINT) {
         Joint *v_joint = (Joint *)v_entity;
@@ -810,8 +829,11 @@ void Level::exportBinary(FileDataType i_fdt,
   if (isXMotoTooOld())
     return;
 
-  /* Export binary... */
-  FileHandle *pfh = XMFS::openOFile(i_fdt, FileName);
+  /* Export binary... written aside, then renamed : the cache can be read
+     or written by an other thread meanwhile */
+  std::string v_tmpFileName =
+    FileName + "." + std::to_string(SDL_ThreadID()) + ".tmp";
+  FileHandle *pfh = XMFS::openOFile(i_fdt, v_tmpFileName);
   if (pfh == NULL) {
     LogWarning("Failed to export binary: %s", FileName.c_str());
   } else {
@@ -894,6 +916,13 @@ void Level::exportBinary(FileDataType i_fdt,
 
     /* clean up */
     XMFS::closeFile(pfh);
+
+    if (XMFS::replaceFile(i_fdt, v_tmpFileName, FileName) == false) {
+      LogWarning("Failed to export binary: %s", FileName.c_str());
+      try {
+        XMFS::deleteFile(i_fdt, v_tmpFileName);
+      } catch (Exception &e) {}
+    }
   }
 }
 
@@ -901,49 +930,113 @@ bool Level::isFullyLoaded() const {
   return m_isBodyLoaded;
 }
 
-void Level::loadFullyFromFile(bool i_loadMainLayerOnly) {
-  if (importBinary(FDT_CACHE,
-                   getNameInCache(i_loadMainLayerOnly),
-                   Checksum(),
-                   i_loadMainLayerOnly) == false) {
+bool Level::loadFullyFromFile(bool i_loadMainLayerOnly,
+                              bool i_loadBSP,
+                              bool i_loadSprites) {
+  bool v_cacheWritten = false;
+  bool v_cached = false;
+
+  try {
+    v_cached = importBinary(FDT_CACHE,
+                            getNameInCache(i_loadMainLayerOnly),
+                            Checksum(),
+                            i_loadMainLayerOnly);
+  } catch (Exception &e) {
+    LogWarning("Exception while loading binary level, will load "
+               "XML instead for '%s' (%s)",
+               FileName().c_str(),
+               e.getMsg().c_str());
+  }
+
+  if (v_cached == false) {
     loadXML(i_loadMainLayerOnly);
+    if (i_loadBSP) {
+      computeBSP();
+    }
     exportBinary(FDT_CACHE,
                  getNameInCache(i_loadMainLayerOnly),
                  m_checkSum,
                  i_loadMainLayerOnly);
+    v_cacheWritten = true;
+  } else {
+    /* the cache built while updating the levels list has no bsp */
+    if (i_loadBSP && computeBSP()) {
+      exportBinary(FDT_CACHE,
+                   getNameInCache(i_loadMainLayerOnly),
+                   m_checkSum,
+                   i_loadMainLayerOnly);
+      v_cacheWritten = true;
+    }
+  }
+  if (i_loadSprites) {
+    loadSprites();
+  }
+
+  return v_cacheWritten;
+}
+
+void Level::loadSprites() {
+  for (unsigned int i = 0; i < m_entities.size(); i++) {
+    m_entities[i]->loadSprites();
   }
   loadRemplacementSprites();
 }
 
-void Level::importBinaryHeader(FileHandle *pfh, bool i_loadMainLayerOnly) {
+static void computeBlockBSP(void *i_data, unsigned int i_item) {
+  std::vector<Block *> *v_blocks = (std::vector<Block *> *)i_data;
+
+  (*v_blocks)[i_item]->computeBSP();
+}
+
+bool Level::computeBSP() {
+  std::vector<Block *> v_blocks;
+
+  for (unsigned int i = 0; i < m_blocks.size(); i++) {
+    if (m_blocks[i]->isBSPComputed() == false) {
+      v_blocks.push_back(m_blocks[i]);
+    }
+  }
+
+  if (v_blocks.empty()) {
+    return false;
+  }
+
+  // the blocks are independent, each one keeps its own result
+  WorkersPool::run(computeBlockBSP, &v_blocks, v_blocks.size());
+
+  return true;
+}
+
+void Level::importBinaryHeader(BinaryReader &i_reader,
+                               bool i_loadMainLayerOnly) {
   unloadLevelBody();
 
   m_isBodyLoaded = false;
   m_playerStart = Vector2f(0.0, 0.0);
   m_xmotoTooOld = false;
 
-  int nFormat = XMFS::readInt_LE(pfh);
+  int nFormat = i_reader.readInt_LE();
 
   if (nFormat != CACHE_LEVEL_FORMAT_VERSION) {
     throw Exception("Old file format");
   }
 
-  bool v_loadMainLayerOnly = XMFS::readBool(pfh);
+  bool v_loadMainLayerOnly = i_reader.readBool();
   if (i_loadMainLayerOnly != v_loadMainLayerOnly) {
     throw Exception("Not the same main layer mode");
   }
 
-  m_checkSum = XMFS::readString(pfh);
-  m_id = XMFS::readString(pfh);
-  m_pack = XMFS::readString(pfh);
-  m_packNum = XMFS::readString(pfh);
-  m_name = XMFS::readString(pfh);
-  m_description = XMFS::readString(pfh);
-  m_author = XMFS::readString(pfh);
-  m_date = XMFS::readString(pfh);
-  m_music = XMFS::readString(pfh);
-  m_isScripted = XMFS::readBool(pfh);
-  m_isPhysics = XMFS::readBool(pfh);
+  m_checkSum = i_reader.readString();
+  m_id = i_reader.readString();
+  m_pack = i_reader.readString();
+  m_packNum = i_reader.readString();
+  m_name = i_reader.readString();
+  m_description = i_reader.readString();
+  m_author = i_reader.readString();
+  m_date = i_reader.readString();
+  m_music = i_reader.readString();
+  m_isScripted = i_reader.readBool();
+  m_isPhysics = i_reader.readBool();
 }
 
 void Level::importHeader(const std::string &i_id,
@@ -984,26 +1077,21 @@ bool Level::importBinaryHeaderFromFile(FileDataType i_fdt,
                                        const std::string &pSum,
                                        bool i_loadMainLayerOnly) {
   /* Import binary */
-  FileHandle *pfh = XMFS::openIFile(i_fdt, FileName, true);
-  if (pfh == NULL) {
+  BinaryReader v_reader;
+  if (v_reader.open(i_fdt, FileName, true) == false) {
     return false;
   }
 
   try {
-    importBinaryHeader(pfh, i_loadMainLayerOnly);
+    importBinaryHeader(v_reader, i_loadMainLayerOnly);
     if (m_checkSum != pSum) {
       LogWarning("CRC check failed, can't import: %s", FileName.c_str());
-      XMFS::closeFile(pfh);
       return false;
     }
   } catch (Exception &e) {
-    XMFS::closeFile(pfh);
     return false;
   }
 
-  /* clean up */
-  XMFS::closeFile(pfh);
-
   return true;
 }
 
@@ -1040,81 +1128,81 @@ bool Level::importBinary(FileDataType i_fdt,
   m_xmotoTooOld = false;
 
   /* Import binary */
-  FileHandle *pfh = XMFS::openIFile(i_fdt, FileName, true);
-  if (pfh == NULL) {
+  BinaryReader v_reader;
+  if (v_reader.open(i_fdt, FileName, true) == false) {
     return false;
   } else {
     /* Read tag - it tells something about the format */
-    int nFormat = XMFS::readInt_LE(pfh);
+    int nFormat = v_reader.readInt_LE();
 
     if (nFormat == CACHE_LEVEL_FORMAT_VERSION) { /* reject other formats */
       /* Read "format 1" / "format 2" binary level */
       /* Right */
 
-      bool v_loadMainLayerOnly = XMFS::readBool(pfh);
+      bool v_loadMainLayerOnly = v_reader.readBool();
       if (i_loadMainLayerOnly == v_loadMainLayerOnly) {
-        std::string md5sum = XMFS::readString(pfh);
+        std::string md5sum = v_reader.readString();
         if (md5sum != pSum) {
           LogWarning("CRC check failed, can't import: %s", FileName.c_str());
           bRet = false;
         } else {
           /* Read header */
-          m_id = XMFS::readString(pfh);
-          m_pack = XMFS::readString(pfh);
-          m_packNum = XMFS::readString(pfh);
-          m_name = XMFS::readString(pfh);
-          m_description = XMFS::readString(pfh);
-          m_author = XMFS::readString(pfh);
-          m_date = XMFS::readString(pfh);
-          m_music = XMFS::readString(pfh);
-          m_isScripted = XMFS::readBool(pfh);
-          m_isPhysics = XMFS::readBool(pfh);
+          m_id = v_reader.readString();
+          m_pack = v_reader.readString();
+          m_packNum = v_reader.readString();
+          m_name = v_reader.readString();
+          m_description = v_reader.readString();
+          m_author = v_reader.readString();
+          m_date = v_reader.readString();
+          m_music = v_reader.readString();
+          m_isScripted = v_reader.readBool();
+          m_isPhysics = v_reader.readBool();
 
           /* sky */
-          m_sky->setTexture(XMFS::readString(pfh));
-          m_sky->setZoom(XMFS::readFloat_LE(pfh));
-          m_sky->setOffset(XMFS::readFloat_LE(pfh));
+          m_sky->setTexture(v_reader.readString());
+          m_sky->setZoom(v_reader.readFloat_LE());
+          m_sky->setOffset(v_reader.readFloat_LE());
 
           int v_r, v_g, v_b, v_a;
-          v_r = XMFS::readInt_LE(pfh);
-          v_g = XMFS::readInt_LE(pfh);
-          v_b = XMFS::readInt_LE(pfh);
-          v_a = XMFS::readInt_LE(pfh);
+          v_r = v_reader.readInt_LE();
+          v_g = v_reader.readInt_LE();
+          v_b = v_reader.readInt_LE();
+          v_a = v_reader.readInt_LE();
           m_sky->setTextureColor(TColor(v_r, v_g, v_b, v_a));
 
-          m_sky->setDrifted(XMFS::readBool(pfh));
-          m_sky->setDriftZoom(XMFS::readFloat_LE(pfh));
+          m_sky->setDrifted(v_reader.readBool());
+          m_sky->setDriftZoom(v_reader.readFloat_LE());
 
-          v_r = XMFS::readInt_LE(pfh);
-          v_g = XMFS::readInt_LE(pfh);
-          v_b = XMFS::readInt_LE(pfh);
-          v_a = XMFS::readInt_LE(pfh);
+          v_r = v_reader.readInt_LE();
+          v_g = v_reader.readInt_LE();
+          v_b = v_reader.readInt_LE();
+          v_a = v_reader.readInt_LE();
           m_sky->setDriftTextureColor(TColor(v_r, v_g, v_b, v_a));
           /* *** */
-          m_sky->setBlendTexture(XMFS::readString(pfh));
-          m_borderTexture = XMFS::readString(pfh);
+          m_sky->setBlendTexture(v_reader.readString());
+          m_borderTexture = v_reader.readString();
 
-          unsigned int v_nbScriptLibraryFileNames = XMFS::readInt_LE(pfh);
+          unsigned int v_nbScriptLibraryFileNames = v_reader.readInt_LE();
           for (unsigned int i = 0; i < v_nbScriptLibraryFileNames; i++) {
-            m_scriptLibraryFileNames.push_back(XMFS::readString(pfh));
+            m_scriptLibraryFileNames.push_back(v_reader.readString());
           }
 
-          m_scriptFileName = XMFS::readString(pfh);
+          m_scriptFileName = v_reader.readString();
 
-          m_leftLimit = XMFS::readFloat_LE(pfh);
-          m_rightLimit = XMFS::readFloat_LE(pfh);
-          m_topLimit = XMFS::readFloat_LE(pfh);
-          m_bottomLimit = XMFS::readFloat_LE(pfh);
+          m_leftLimit = v_reader.readFloat_LE();
+          m_rightLimit = v_reader.readFloat_LE();
+          m_topLimit = v_reader.readFloat_LE();
+          m_bottomLimit = v_reader.readFloat_LE();
 
           /* theme replacements */
-          m_rSpriteForStrawberry = XMFS::readString(pfh);
-          m_rSpriteForFlower = XMFS::readString(pfh);
-          m_rSpriteForWecker = XMFS::readString(pfh);
-          m_rSpriteForStar = XMFS::readString(pfh);
-          m_rSpriteForCheckpointDown = XMFS::readString(pfh);
-          m_rSpriteForCheckpointUp = XMFS::readString(pfh);
-          m_rSoundForPickUpStrawberry = XMFS::readString(pfh);
-          m_rSoundForCheckpoint = XMFS::readString(pfh);
+          m_rSpriteForStrawberry = v_reader.readString();
+          m_rSpriteForFlower = v_reader.readString();
+          m_rSpriteForWecker = v_reader.readString();
+          m_rSpriteForStar = v_reader.readString();
+          m_rSpriteForCheckpointDown = v_reader.readString();
+          m_rSpriteForCheckpointUp = v_reader.readString();
+          m_rSoundForPickUpStrawberry = v_reader.readString();
+          m_rSoundForCheckpoint = v_reader.readString();
 
           if (m_rSpriteForStrawberry == "")
             m_rSpriteForStrawberry = "Strawberry";
@@ -1130,20 +1218,20 @@ bool Level::importBinary(FileDataType i_fdt,
             m_rSpriteForCheckpointUp = "Checkpoint_1";
 
           /* layers */
-          m_numberLayer = XMFS::readInt_LE(pfh);
+          m_numberLayer = v_reader.readInt_LE();
           for (int i = 0; i < m_numberLayer; i++) {
             Vector2f offset;
-            offset.x = XMFS::readFloat_LE(pfh);
-            offset.y = XMFS::readFloat_LE(pfh);
+            offset.x = v_reader.readFloat_LE();
+            offset.y = v_reader.readFloat_LE();
             m_layerOffsets.push_back(offset);
-            m_isLayerFront.push_back(XMFS::readBool(pfh));
+            m_isLayerFront.push_back(v_reader.readBool());
           }
 
           /* Read embedded script */
-          int nScriptSourceLen = XMFS::readInt_LE(pfh);
+          int nScriptSourceLen = v_reader.readInt_LE();
           if (nScriptSourceLen > 0) {
             char *pcTemp = new char[nScriptSourceLen + 1];
-            XMFS::readBuf(pfh, (char *)pcTemp, nScriptSourceLen);
+            v_reader.readBuf((char *)pcTemp, nScriptSourceLen);
             pcTemp[nScriptSourceLen] = '\0';
 
             m_scriptSource = pcTemp;
@@ -1153,19 +1241,19 @@ bool Level::importBinary(FileDataType i_fdt,
             m_scriptSource = "";
 
           /* Read blocks */
-          int nNumBlocks = XMFS::readInt_LE(pfh);
+          int nNumBlocks = v_reader.readInt_LE();
           m_blocks.reserve(nNumBlocks);
           for (int i = 0; i < nNumBlocks; i++) {
-            m_blocks.push_back(Block::readFromBinary(pfh));
+            m_blocks.push_back(Block::readFromBinary(v_reader));
           }
 
           /* Read entities */
-          int nNumEntities = XMFS::readInt_LE(pfh);
+          int nNumEntities = v_reader.readInt_LE();
           m_entities.reserve(nNumEntities); // we dont need that much reserved
           // space, since some strawberries
           // were eaten
           for (int i = 0; i < nNumEntities; i++) {
-            Entity *v_entity = Entity::readFromBinary(pfh);
+            Entity *v_entity = Entity::readFromBinary(v_reader);
             m_entities.push_back(v_entity);
           }
 
@@ -1176,20 +1264,20 @@ bool Level::importBinary(FileDataType i_fdt,
             m_playerStart = Vector2f(0.0, 0.0);
           }
 
-          int nNumJoints = XMFS::readInt_LE(pfh);
+          int nNumJoints = v_reader.readInt_LE();
           m_joints.reserve(nNumJoints);
           for (int i = 0; i < nNumJoints; i++) {
-            Entity *v_entity = Entity::readFromBinary(pfh);
+            Entity *v_entity = Entity::readFromBinary(v_reader);
             Joint *v_joint = (Joint *)v_entity;
-            v_joint->readFromBinary(pfh);
+            v_joint->readFromBinary(v_reader);
             m_joints.push_back(v_joint);
           }
 
           /* Read zones */
-          int nNumZones = XMFS::readInt_LE(pfh);
+          int nNumZones = v_reader.readInt_LE();
           m_zones.reserve(nNumZones);
           for (int i = 0; i < nNumZones; i++) {
-            m_zones.push_back(Zone::readFromBinary(pfh));
+            m_zones.push_back(Zone::readFromBinary(v_reader));
           }
         }
       } else {
@@ -1205,8 +1293,6 @@ bool Level::importBinary(FileDataType i_fdt,
       bRet = false;
     }
 
-    /* clean up */
-    XMFS::closeFile(pfh);
   }
 
   m_isBodyLoaded = bRet;
@@ -1303,6 +1389,12 @@ int Level::loadToPlay(ChipmunkWorld *i_chipmunkWorld,
                       bool i_loadBSP) {
   int v_nbErrors = 0;
 
+  /* decompositions not found in the cache are computed in parallel, then the
+     blocks are added one by one, in the level order */
+  if (i_loadBSP) {
+    computeBSP();
+  }
+
   /* preparing blocks */
   for (unsigned int i = 0; i < m_blocks.size(); i++) {
     try {
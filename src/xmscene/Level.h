@@ -21,7 +21,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #ifndef __LEVELSRC_H__
 #define __LEVELSRC_H__
 
-#define CACHE_LEVEL_FORMAT_VERSION 36
+#define CACHE_LEVEL_FORMAT_VERSION 37
 
 #include "BasicSceneStructs.h"
 #include "common/VFileIO_types.h"
@@ -34,11 +34,11 @@ class Entity;
 class Joint;
 class Scene;
 class xmDatabase;
+class BinaryReader;
 class FileHandle;
 class SkyApparence;
 class Zone;
 class CollisionSystem;
-class XMLDocument;
 class ChipmunkWorld;
 class Sprite;
 class PhysicsSettings;
@@ -54,10 +54,18 @@ public:
   ~Level();
 
   bool loadReducedFromFile(bool i_loadMainLayerOnly);
-  void loadFullyFromFile(bool i_loadMainLayerOnly);
+  /* i_loadBSP : the convex blocks will be required, compute them now to get
+     them in the cache. return true if the cache has been written
+     i_loadSprites : false out of the main thread, loadSprites() must then be
+     called by the main thread before playing */
+  bool loadFullyFromFile(bool i_loadMainLayerOnly,
+                         bool i_loadBSP = true,
+                         bool i_loadSprites = true);
+  /* entities and remplacement sprites of the current theme */
+  void loadSprites();
   bool isFullyLoaded() const;
   void exportBinaryHeader(FileHandle *pfh, bool i_loadMainLayerOnly);
-  void importBinaryHeader(FileHandle *pfh, bool i_loadMainLayerOnly);
+  void importBinaryHeader(BinaryReader &i_reader, bool i_loadMainLayerOnly);
   void importHeader(const std::string &i_id,
                     const std::string &i_checkSum,
                     const std::string &i_pack,
@@ -256,6 +264,8 @@ private:
                     const std::string &i_fileName,
                     const std::string &i_sum,
                     bool i_loadMainLayerOnly);
+  // compute the blocks decomposition missing ; return false if none was
+  bool computeBSP();
   bool importBinary(FileDataType i_fdt,
                     const std::string &i_fileName,
                     const std::string &i_sum,
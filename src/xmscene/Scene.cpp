@@ -115,6 +115,10 @@ void Scene::loadLevel(xmDatabase *i_db,
   }
 }
 
+void Scene::loadLevel(Level *i_level) {
+  m_pLevelSrc = i_level;
+}
+
 void Scene::cleanGhosts() {
   for (unsigned int i = 0; i < m_ghosts.size(); i++) {
     delete m_ghosts[i];
@@ -559,7 +563,7 @@ void Scene::prePlayLevel(DBuffer *i_recorder,
   m_playEvents = i_playEvents;
   /* load the level if not */
   if (m_pLevelSrc->isFullyLoaded() == false) {
-    m_pLevelSrc->loadFullyFromFile(i_loadMainLayerOnly);
+    m_pLevelSrc->loadFullyFromFile(i_loadMainLayerOnly, i_loadBSP);
   }
 
   /* Create Lua state */
@@ -146,6 +146,8 @@ public:
   void loadLevel(xmDatabase *i_db,
                  const std::string &i_id_level,
                  bool i_loadMainLayerOnly = false);
+  // take the ownership of a level already loaded
+  void loadLevel(Level *i_level);
   void prePlayLevel(DBuffer *i_eventRecorder,
                     bool i_playEvents,
                     bool i_loadMainLayerOnly = false,
@@ -19,8 +19,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 =============================================================================*/
 
 #include "Zone.h"
+#include "common/BinaryReader.h"
 #include "common/VFileIO.h"
-#include "common/VXml.h"
+#include "common/VXmlLight.h"
 #include <sstream>
 
 ZonePrim::ZonePrim() {}
@@ -107,13 +108,14 @@ bool Zone::doesCircleTouch(const Vector2f &i_cp, float i_cr) {
   return false;
 }
 
-Zone *Zone::readFromXml(xmlNodePtr pElem) {
-  Zone *v_zone = new Zone(XMLDocument::getOption(pElem, "id"));
+Zone *Zone::readFromXml(const XMLLightNode *pElem) {
+  Zone *v_zone = new Zone(XMLLightDocument::getOption(pElem, "id"));
 
   /* Get primitives */
-  for (xmlNodePtr pSubElem = XMLDocument::subElement(pElem, "box");
+  for (const XMLLightNode *pSubElem =
+         XMLLightDocument::subElement(pElem, "box");
        pSubElem != NULL;
-       pSubElem = XMLDocument::nextElement(pSubElem)) {
+       pSubElem = XMLLightDocument::nextElement(pSubElem)) {
     v_zone->m_prims.push_back(ZonePrimBox::readFromXml(pSubElem));
   }
 
@@ -137,18 +139,18 @@ void ZonePrimBox::saveBinary(FileHandle *i_pfh) {
   XMFS::writeFloat_LE(i_pfh, m_bottom);
 }
 
-Zone *Zone::readFromBinary(FileHandle *i_pfh) {
-  Zone *v_zone = new Zone(XMFS::readString(i_pfh));
+Zone *Zone::readFromBinary(BinaryReader &i_reader) {
+  Zone *v_zone = new Zone(i_reader.readString());
   ZonePrimType v_zonePrimType;
 
-  int nNumPrims = XMFS::readByte(i_pfh);
+  int nNumPrims = i_reader.readByte();
   v_zone->m_prims.reserve(nNumPrims);
   for (int j = 0; j < nNumPrims; j++) {
-    v_zonePrimType = (ZonePrimType)XMFS::readInt_LE(i_pfh);
+    v_zonePrimType = (ZonePrimType)i_reader.readInt_LE();
 
     switch (v_zonePrimType) {
       case LZPT_BOX:
-        v_zone->m_prims.push_back(ZonePrimBox::readFromBinary(i_pfh));
+        v_zone->m_prims.push_back(ZonePrimBox::readFromBinary(i_reader));
         break;
     }
   }
@@ -156,24 +158,24 @@ Zone *Zone::readFromBinary(FileHandle *i_pfh) {
   return v_zone;
 }
 
-ZonePrim *ZonePrimBox::readFromXml(xmlNodePtr pElem) {
+ZonePrim *ZonePrimBox::readFromXml(const XMLLightNode *pElem) {
   float v_bottom, v_top, v_left, v_right;
 
-  v_bottom = atof(XMLDocument::getOption(pElem, "bottom", "0").c_str());
-  v_top = atof(XMLDocument::getOption(pElem, "top", "0").c_str());
-  v_left = atof(XMLDocument::getOption(pElem, "left", "0").c_str());
-  v_right = atof(XMLDocument::getOption(pElem, "right", "0").c_str());
+  v_bottom = atof(XMLLightDocument::getOption(pElem, "bottom", "0").c_str());
+  v_top = atof(XMLLightDocument::getOption(pElem, "top", "0").c_str());
+  v_left = atof(XMLLightDocument::getOption(pElem, "left", "0").c_str());
+  v_right = atof(XMLLightDocument::getOption(pElem, "right", "0").c_str());
 
   return new ZonePrimBox(v_left, v_right, v_top, v_bottom);
 }
 
-ZonePrim *ZonePrimBox::readFromBinary(FileHandle *i_pfh) {
+ZonePrim *ZonePrimBox::readFromBinary(BinaryReader &i_reader) {
   float v_bottom, v_top, v_left, v_right;
 
-  v_left = XMFS::readFloat_LE(i_pfh);
-  v_right = XMFS::readFloat_LE(i_pfh);
-  v_top = XMFS::readFloat_LE(i_pfh);
-  v_bottom = XMFS::readFloat_LE(i_pfh);
+  v_left = i_reader.readFloat_LE();
+  v_right = i_reader.readFloat_LE();
+  v_top = i_reader.readFloat_LE();
+  v_bottom = i_reader.readFloat_LE();
 
   return new ZonePrimBox(v_left, v_right, v_top, v_bottom);
 }
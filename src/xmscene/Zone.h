@@ -22,10 +22,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define __ZONE_H__
 
 #include "BasicSceneStructs.h"
-#include "common/VXml.h"
+#include "common/VXmlLight.h"
 #include "helpers/VMath.h"
 #include <vector>
 
+class BinaryReader;
 class FileHandle;
 
 /*===========================================================================
@@ -39,7 +40,7 @@ public:
   virtual bool doesCircleTouch(const Vector2f &i_cp, float i_cr) = 0;
   virtual void saveBinary(FileHandle *i_pfh) = 0;
   virtual ZonePrimType Type() const = 0;
-  static ZonePrim *readFromBinary(FileHandle *i_pfh);
+  static ZonePrim *readFromBinary(BinaryReader &i_reader);
 };
 
 class ZonePrimBox : public ZonePrim {
@@ -50,8 +51,8 @@ public:
   virtual bool doesCircleTouch(const Vector2f &i_cp, float i_cr);
   virtual void saveBinary(FileHandle *i_pfh);
   virtual ZonePrimType Type() const;
-  static ZonePrim *readFromXml(xmlNodePtr pElem);
-  static ZonePrim *readFromBinary(FileHandle *i_pfh);
+  static ZonePrim *readFromXml(const XMLLightNode *pElem);
+  static ZonePrim *readFromBinary(BinaryReader &i_reader);
 
   float Left() const;
   float Right() const;
@@ -74,8 +75,8 @@ public:
 
   bool doesCircleTouch(const Vector2f &i_cp, float i_cr);
   void saveBinary(FileHandle *i_pfh);
-  static Zone *readFromXml(xmlNodePtr pElem);
-  static Zone *readFromBinary(FileHandle *i_pfh);
+  static Zone *readFromXml(const XMLLightNode *pElem);
+  static Zone *readFromBinary(BinaryReader &i_reader);
   AABB &getAABB() { return m_BBox; }
 
 private: